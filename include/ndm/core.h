@@ -79,8 +79,154 @@ enum ndm_core_cache_mode_t
 	NDM_CORE_MODE_NO_CACHE				//!< Do not cache a response
 };
 
+enum ndm_core_field_type_t
+{
+	NDM_CORE_FIELD_NODE,		//!< @c const @c ndm_xml_node_t pointer
+	NDM_CORE_FIELD_STR,			//!< @c const @c char pointer
+	NDM_CORE_FIELD_CHAR,		//!< @c char integer
+	NDM_CORE_FIELD_UCHAR,		//!< @c unsigned @c char integer
+	NDM_CORE_FIELD_SHORT,		//!< @c short integer
+	NDM_CORE_FIELD_USHORT,		//!< @c unsigned @c short integer
+	NDM_CORE_FIELD_INT,			//!< @c int integer
+	NDM_CORE_FIELD_UINT,		//!< @c unsigned @c int integer
+	NDM_CORE_FIELD_LONG,		//!< @c long integer
+	NDM_CORE_FIELD_ULONG,		//!< @c unsigned @c long integer
+	NDM_CORE_FIELD_LLONG,		//!< @c long @c long integer
+	NDM_CORE_FIELD_ULLONG,		//!< @c unsigned @c long @c long integer
+	NDM_CORE_FIELD_BOOL,		//!< @c bool parsed as a boolean value
+	NDM_CORE_FIELD_PRESENT		//!< @c bool set if a value is present
+};
+
+/**
+ * Descriptor of a field extracted by ndm_core_schema_extract().
+ */
+
+struct ndm_core_field_t
+{
+	const char *path;					//!< Node or attribute path
+	enum ndm_core_field_type_t type;	//!< Type of a destination value
+	size_t offset;						//!< Offset of a destination value
+};
+
+/**
+ * Callbacks of a streamed core response (see ndm_core_request_stream()).
+ * Any callback can be @c NULL. The @a depth argument is a nesting level
+ * of a node, the response root node has depth 1. Strings are valid only
+ * during a callback call.
+ */
+
+struct ndm_core_response_handler_t
+{
+	//! Called at an element start with its name and value
+	void (*node_start)(
+		void *user_data,
+		const size_t depth,
+		const char *const name,
+		const char *const value);
+
+	//! Called for every attribute of a started element
+	void (*attr)(
+		void *user_data,
+		const size_t depth,
+		const char *const name,
+		const char *const value);
+
+	//! Called for a text or CDATA node
+	void (*text)(
+		void *user_data,
+		const size_t depth,
+		const char *const text);
+
+	//! Called at an element end
+	void (*node_end)(
+		void *user_data,
+		const size_t depth);
+};
+
+/**
+ * Metrics of a single synchronous core request (see
+ * ndm_core_set_request_hook()). Time intervals are in nanoseconds.
+ */
+
+struct ndm_core_request_stats_t
+{
+	uint64_t serialize_nsec;	//!< Request serialization time
+	uint64_t send_nsec;			//!< Request sending time
+	uint64_t first_byte_nsec;	//!< Time from a sent request to a response
+	uint64_t receive_nsec;		//!< Response receiving time
+	uint64_t decode_nsec;		//!< Response decoding time
+	size_t bytes_sent;			//!< Size of a binary request
+	size_t bytes_received;		//!< Size of a binary response
+	size_t node_count;			//!< Number of decoded response nodes
+	bool cache_hit;				//!< A response is taken from the cache
+	bool failed;				//!< No response is returned
+};
+
+/**
+ * Accumulated metrics of synchronous core requests (see ndm_core_set_stats()).
+ */
+
+struct ndm_core_stats_t
+{
+	uint64_t requests;			//!< Number of requests
+	uint64_t cache_hits;		//!< Number of responses taken from the cache
+	uint64_t failures;			//!< Number of failed requests
+	uint64_t serialize_nsec;	//!< Total request serialization time
+	uint64_t send_nsec;			//!< Total request sending time
+	uint64_t first_byte_nsec;	//!< Total time to first response bytes
+	uint64_t receive_nsec;		//!< Total response receiving time
+	uint64_t decode_nsec;		//!< Total response decoding time
+	uint64_t bytes_sent;		//!< Total size of binary requests
+	uint64_t bytes_received;	//!< Total size of binary responses
+	uint64_t node_count;		//!< Total number of decoded response nodes
+};
+
+/**
+ * Response cache counters and limits (see ndm_core_cache_get_stats()).
+ */
+
+struct ndm_core_cache_stats_t
+{
+	uint64_t hits;				//!< Number of cache lookups found a response
+	uint64_t misses;			//!< Number of cache lookups found nothing
+	uint64_t evictions;			//!< Number of entries removed to free space
+	uint64_t expirations;		//!< Number of entries removed on TTL expiry
+	uint64_t coalesced;			//!< Number of responses shared in flight
+	size_t count;				//!< Number of cached responses
+	size_t size;				//!< Total size of cached responses
+	size_t max_size;			//!< Current cache size limit
+	int ttl_msec;				//!< Current cached response lifetime
+};
+
+/**
+ * A callback called after every synchronous core request.
+ */
+
+typedef void (*ndm_core_request_hook_t)(
+		void *user_data,
+		const struct ndm_core_request_stats_t *stats);
+
 struct ndm_core_t;
+struct ndm_core_pool_t;
 struct ndm_core_response_t;
+struct ndm_core_path_t;
+struct ndm_core_schema_t;
+
+/**
+ * A callback called for every cached response (see ndm_core_cache_foreach()).
+ */
+
+typedef void (*ndm_core_cache_entry_cb_t)(
+		void *user_data,
+		const struct ndm_core_response_t *response,
+		const uint64_t hits,
+		const size_t size);
+
+/**
+ * Identifier of a pipelined request (see ndm_core_request_submit()).
+ */
+
+typedef uint64_t ndm_core_response_id_t;
 
 struct ndm_core_event_t;
 struct ndm_core_event_connection_t;
@@ -135,18 +281,91 @@ int ndm_core_event_connection_fd(
 bool ndm_core_event_connection_has_events(
 		struct ndm_core_event_connection_t *connection) NDM_ATTR_WUR;
 
+/**
+ * Add an event class to a filter of the connection. While a filter is
+ * not empty, events of other classes are skipped, a header of an event
+ * is checked before decoding to avoid XML node allocations.
+ *
+ * @param connection Pointer to the connection instance.
+ * @param event_class Event class name or a class name prefix.
+ * @param prefix @c true if @a event_class is a prefix of class names,
+ * @c false if it is an exact class name.
+ *
+ * @returns @c true if successful, @c false — otherwise (@c errno is set).
+ */
+
+bool ndm_core_event_connection_filter_add(
+		struct ndm_core_event_connection_t *connection,
+		const char *const event_class,
+		const bool prefix) NDM_ATTR_WUR;
+
+/**
+ * Remove all classes from a filter of the connection, events of all
+ * classes are received after that.
+ *
+ * @param connection Pointer to the connection instance.
+ */
+
+void ndm_core_event_connection_filter_clear(
+		struct ndm_core_event_connection_t *connection);
+
 /**
  * Get the instance of core event.
  *
  * @param connection Pointer to the connection instance.
  *
  * @returns Pointer to the received instance of core event if successful,
- * @c NULL — otherwise.
+ * @c NULL — otherwise. If all received events are skipped by a class
+ * filter, @c NULL is returned and @c errno is set to @c ENOMSG.
  */
 
 struct ndm_core_event_t *ndm_core_event_connection_get(
 		struct ndm_core_event_connection_t *connection) NDM_ATTR_WUR;
 
+/**
+ * Get a batch of core events. The first event is waited for
+ * as in @c ndm_core_event_connection_get, next ones are taken only while
+ * the connection has already received data. A call does not wait for
+ * new events after the first one, but if only a part of a next event
+ * is received, it blocks until the rest of that event arrives or the
+ * connection timeout counted from the start of the call expires. Event
+ * instances are reused from a free list of the connection. Events
+ * skipped by a class filter are not counted, so @a count may be zero
+ * after a successful call.
+ *
+ * @param connection Pointer to the connection instance.
+ * @param events Array to store pointers to the received events.
+ * @param max_count Size of the @a events array, should be nonzero.
+ * @param count Pointer to the number of received events. On failure
+ * it is set to the number of events received before an error, these
+ * events are valid and should be released as well.
+ *
+ * @returns @c true if successful, @c false — otherwise (@c errno is set).
+ */
+
+bool ndm_core_event_connection_get_batch(
+		struct ndm_core_event_connection_t *connection,
+		struct ndm_core_event_t *events[],
+		const size_t max_count,
+		size_t *count) NDM_ATTR_WUR;
+
+/**
+ * Release events received by @c ndm_core_event_connection_get_batch
+ * or @c ndm_core_event_connection_get back to the free list
+ * of the connection. Released pointers are set to @c NULL.
+ * Events may be also released by @c ndm_core_event_free.
+ *
+ * @param connection Pointer to the connection instance.
+ * @param events Array of pointers to the events, @c NULL pointers
+ * are ignored.
+ * @param count Number of pointers in the @a events array.
+ */
+
+void ndm_core_event_connection_put_batch(
+		struct ndm_core_event_connection_t *connection,
+		struct ndm_core_event_t *events[],
+		const size_t count);
+
 /**
  * Get the 'event' root node of XML-description.
  *
@@ -228,6 +447,84 @@ struct ndm_core_t *ndm_core_open(
 bool ndm_core_close(
 		struct ndm_core_t **core);
 
+/**
+ * Open a pool of connections to the NDM core that can be used by several
+ * threads. All connections of the pool share one response cache.
+ * Concurrent cache misses of the same request are coalesced: one
+ * connection exchanges with the core and others wait for its response.
+ *
+ * @param agent Agent name to identify which application last modified
+ * the configuration of the system.
+ * @param size Number of connections in the pool.
+ * @param cache_ttl_msec Caching time for the core responses in milliseconds.
+ * @param cache_max_size Maximum size of the shared cache in bytes.
+ *
+ * @returns Pointer to the pool instance if all connections are opened,
+ * @c NULL — otherwise, @a errno stores an error code.
+ */
+
+struct ndm_core_pool_t *ndm_core_pool_open(
+		const char *const agent,
+		const size_t size,
+		const int cache_ttl_msec,
+		const size_t cache_max_size) NDM_ATTR_WUR;
+
+/**
+ * Close all connections of the pool and clear the shared cache. All
+ * connections should be checked in before.
+ *
+ * @param pool Pointer to the pool instance. The value can be @c NULL
+ * as well as NULL-pointer to pool instance.
+ *
+ * @returns @c true if all connections are closed, @c false — otherwise
+ * (@a errno contains error code). The pool is released in both cases.
+ */
+
+bool ndm_core_pool_close(
+		struct ndm_core_pool_t **pool);
+
+/**
+ * Get the number of connections in the pool.
+ *
+ * @param pool Pointer to the pool instance.
+ *
+ * @returns The number of connections.
+ */
+
+size_t ndm_core_pool_size(
+		const struct ndm_core_pool_t *pool) NDM_ATTR_WUR;
+
+/**
+ * Take a free connection from the pool for exclusive use by a calling
+ * thread. The function does not block.
+ *
+ * @param pool Pointer to the pool instance.
+ *
+ * @returns Pointer to the connection instance, @c NULL if all connections
+ * are in use (@a errno is set to @c EAGAIN). A pooled connection should not
+ * be closed by ndm_core_close().
+ */
+
+struct ndm_core_t *ndm_core_pool_checkout(
+		struct ndm_core_pool_t *pool) NDM_ATTR_WUR;
+
+/**
+ * Return a connection taken by ndm_core_pool_checkout() to the pool.
+ * All requests submitted with ndm_core_request_submit() should be
+ * completed before.
+ *
+ * @param pool Pointer to the pool instance.
+ * @param core Pointer to the connection instance.
+ *
+ * @returns @c true if the connection is returned, @c false — otherwise
+ * (@a errno is set to @c EINVAL if the connection does not belong
+ * to the pool or is already returned).
+ */
+
+bool ndm_core_pool_checkin(
+		struct ndm_core_pool_t *pool,
+		struct ndm_core_t *core);
+
 /**
  * Get the descriptor of the core connection.
  *
@@ -240,7 +537,9 @@ int ndm_core_fd(
 		const struct ndm_core_t *core) NDM_ATTR_WUR;
 
 /**
- * Forcibly clear the cache of the core connection.
+ * Forcibly clear the cache of the core connection. A lookup removes
+ * only an expired response it finds, other expired responses are
+ * removed when a new response is cached or by this call.
  *
  * @param core Pointer to the core connection instance.
  * @param remove_all If @c true — all content is to be removed, if @c false —
@@ -251,6 +550,130 @@ void ndm_core_cache_clear(
 		struct ndm_core_t *core,
 		const bool remove_all);
 
+/**
+ * Get response cache counters of the core connection. A pooled
+ * connection reports the cache shared by the pool.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param stats Pointer to the cache counters to fill.
+ */
+
+void ndm_core_cache_get_stats(
+		struct ndm_core_t *core,
+		struct ndm_core_cache_stats_t *stats);
+
+/**
+ * Reset response cache counters and per-entry hit counts.
+ *
+ * @param core Pointer to the core connection instance.
+ */
+
+void ndm_core_cache_clear_stats(
+		struct ndm_core_t *core);
+
+/**
+ * Call @a callback for every cached response from the most to the least
+ * recently used one. The cache is locked during the iteration, so
+ * the callback must not call other core functions.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param callback A callback called with a response, its hit count and
+ * its size in the cache.
+ * @param user_data User data passed to @a callback.
+ */
+
+void ndm_core_cache_foreach(
+		struct ndm_core_t *core,
+		ndm_core_cache_entry_cb_t callback,
+		void *user_data);
+
+/**
+ * Change the response cache size limit. Least recently used responses
+ * are evicted until the cache fits the new limit.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param max_size The maximum total size of cached responses in bytes.
+ */
+
+void ndm_core_cache_set_max_size(
+		struct ndm_core_t *core,
+		const size_t max_size);
+
+/**
+ * Change the cached response lifetime. Expiration times of already
+ * cached responses are moved by the lifetime difference.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param ttl_msec The lifetime of cached responses in milliseconds.
+ */
+
+void ndm_core_cache_set_ttl(
+		struct ndm_core_t *core,
+		const int ttl_msec);
+
+/**
+ * Enable or disable adaptive cache sizing. Every 256 lookups the cache
+ * doubles its size limit if responses were evicted and the hit ratio is
+ * below 90%, or halves the limit if no responses were evicted and less
+ * than a half of the cache is used. The limit is kept within
+ * [@a min_size, @a max_size].
+ *
+ * @param core Pointer to the core connection instance.
+ * @param adaptive @c true to enable adaptive sizing.
+ * @param min_size The lower bound of the cache size limit.
+ * @param max_size The upper bound of the cache size limit.
+ */
+
+void ndm_core_cache_set_adaptive(
+		struct ndm_core_t *core,
+		const bool adaptive,
+		const size_t min_size,
+		const size_t max_size);
+
+/**
+ * Enable or disable compaction of cached responses. A response entering
+ * the cache is copied into a compact read-only XML document that takes
+ * less memory, and cache hits return the compact copy. Already cached
+ * responses are kept as is.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param compact @c true to cache compact response copies.
+ */
+
+void ndm_core_cache_set_compact(
+		struct ndm_core_t *core,
+		const bool compact);
+
+/**
+ * Set a caching policy for commands starting with @a prefix. A prefix
+ * matches whole command words, the longest matching prefix is applied
+ * when a response is cached. Responses of other commands are cached
+ * with a connection lifetime. A policy for the same prefix is replaced.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param prefix A command prefix, for example @c "show version".
+ * @param cacheable If @c false — responses are never cached.
+ * @param ttl_msec The lifetime of cached responses in milliseconds.
+ *
+ * @returns @c true on success, @c false otherwise (@a errno is set
+ * to @c ENOMEM).
+ */
+
+bool ndm_core_cache_set_policy(
+		struct ndm_core_t *core,
+		const char *const prefix,
+		const bool cacheable,
+		const int ttl_msec) NDM_ATTR_WUR;
+
+/**
+ * Remove all caching policies, already cached responses are kept.
+ *
+ * @param core Pointer to the core connection instance.
+ */
+
+void ndm_core_cache_clear_policies(
+		struct ndm_core_t *core);
+
 /**
  * Set the timeout of data exchange through the connection.
  *
@@ -274,6 +697,83 @@ void ndm_core_set_timeout(
 int ndm_core_get_timeout(
 		const struct ndm_core_t *core) NDM_ATTR_WUR;
 
+/**
+ * Enable or disable zero-copy responses. When enabled, a response is
+ * received directly into a single frame and the strings of its nodes
+ * and attributes refer to the frame instead of being copied into
+ * the response document. Cached responses share the frame, it is freed
+ * with the last response reference.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param zero_copy @c true to decode responses in place, @c false
+ * to copy response strings (default).
+ */
+
+void ndm_core_set_zero_copy(
+		struct ndm_core_t *core,
+		const bool zero_copy);
+
+/**
+ * Get the zero-copy response mode of the core connection.
+ *
+ * @param core Pointer to the core connection instance.
+ *
+ * @returns @c true if responses are decoded in place, @c false — otherwise.
+ */
+
+bool ndm_core_get_zero_copy(
+		const struct ndm_core_t *core) NDM_ATTR_WUR;
+
+/**
+ * Enable or disable accumulation of request statistics. Statistics
+ * and a request hook cover synchronous requests only, pipelined
+ * and streamed requests are not measured. When both statistics and
+ * a request hook are disabled, requests are not measured at all,
+ * otherwise a response is received as a whole before decoding to measure
+ * socket and decoding times separately.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param enabled @c true to accumulate statistics, @c false — otherwise
+ * (default).
+ */
+
+void ndm_core_set_stats(
+		struct ndm_core_t *core,
+		const bool enabled);
+
+/**
+ * Get accumulated request statistics of the core connection.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param[out] stats Pointer to a statistics structure to fill.
+ */
+
+void ndm_core_get_stats(
+		const struct ndm_core_t *core,
+		struct ndm_core_stats_t *stats);
+
+/**
+ * Reset accumulated request statistics of the core connection.
+ *
+ * @param core Pointer to the core connection instance.
+ */
+
+void ndm_core_clear_stats(
+		struct ndm_core_t *core);
+
+/**
+ * Set a callback called with metrics of every synchronous request.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param hook Callback, or @c NULL to disable a hook.
+ * @param user_data Pointer passed to a callback.
+ */
+
+void ndm_core_set_request_hook(
+		struct ndm_core_t *core,
+		ndm_core_request_hook_t hook,
+		void *user_data);
+
 /**
  * ...
  *
@@ -351,6 +851,95 @@ struct ndm_core_response_t *ndm_core_request(
 		const char *const command_format,
 		...) NDM_ATTR_WUR NDM_ATTR_PRINTF(5, 6);
 
+/**
+ * Send a request to the core and pass its response to callbacks while
+ * it is decoded, without building a response document. A memory usage
+ * does not depend on a response size. Responses are not cached and
+ * the last message of the connection is reset.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param request_type Type of request (see ndm_core_request()).
+ * @param handler Pointer to the response callbacks.
+ * @param user_data Pointer passed to all callbacks.
+ * @param command_args An array of command arguments
+ * (see ndm_core_request()).
+ * @param command_format String template of command.
+ *
+ * @returns @c true if the whole response is received, @c false — otherwise
+ * (@a errno contains error code).
+ */
+
+bool ndm_core_request_stream(
+		struct ndm_core_t *core,
+		const enum ndm_core_request_type_t request_type,
+		const struct ndm_core_response_handler_t *handler,
+		void *user_data,
+		const char *const command_args[],
+		const char *const command_format,
+		...) NDM_ATTR_WUR NDM_ATTR_PRINTF(6, 7);
+
+/**
+ * Send a request to the core without waiting for a response. Several
+ * requests can be submitted one after another, their responses are
+ * received in the same order and matched by identifiers. Synchronous
+ * requests fail with @c EBUSY until all submitted requests are
+ * answered. A cache hit is completed immediately without sending.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param request_type Type of request (see ndm_core_request()).
+ * @param cache_mode Cache mode of the response.
+ * @param id Pointer to the identifier of the submitted request.
+ * @param command_args An array of command arguments
+ * (see ndm_core_request()).
+ * @param command_format String template of command.
+ *
+ * @returns @c true if the request is submitted, @c false — otherwise
+ * (@a errno contains error code).
+ */
+
+bool ndm_core_request_submit(
+		struct ndm_core_t *core,
+		const enum ndm_core_request_type_t request_type,
+		const enum ndm_core_cache_mode_t cache_mode,
+		ndm_core_response_id_t *id,
+		const char *const command_args[],
+		const char *const command_format,
+		...) NDM_ATTR_WUR NDM_ATTR_PRINTF(6, 7);
+
+/**
+ * Receive available responses to submitted requests without blocking.
+ * Should be called when the core connection descriptor
+ * (see ndm_core_fd()) is ready for reading.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param completed Pointer to the number of completed requests
+ * whose responses can be taken by ndm_core_request_complete()
+ * without blocking.
+ *
+ * @returns @c true if successful, @c false — otherwise (@a errno contains
+ * error code, the connection should be reopened).
+ */
+
+bool ndm_core_request_poll(
+		struct ndm_core_t *core,
+		size_t *completed) NDM_ATTR_WUR;
+
+/**
+ * Take a response to a submitted request. The function waits for
+ * the response if it was not received yet.
+ *
+ * @param core Pointer to the core connection instance.
+ * @param id The identifier of the submitted request.
+ *
+ * @returns Pointer to the received response in case of a successful
+ * exchange with the core, @c NULL — otherwise (@a errno contains error
+ * code, @c ENOENT means an unknown identifier).
+ */
+
+struct ndm_core_response_t *ndm_core_request_complete(
+		struct ndm_core_t *core,
+		const ndm_core_response_id_t id) NDM_ATTR_WUR;
+
 /**
  * Get additional description for the command.
  * The request of the following form is sent to the core:
@@ -455,6 +1044,342 @@ struct ndm_core_response_t *ndm_core_get_help(
 struct ndm_core_response_t *ndm_core_continue(
 		struct ndm_core_t *core) NDM_ATTR_WUR;
 
+/**
+ * Compile a response path to be used many times with @c ndm_core_path_first_*
+ * functions. A path has the same syntax as a path of
+ * @c ndm_core_response_first_* functions, but it is formatted and split
+ * into node names only once.
+ *
+ * @param path_format Path format.
+ *
+ * @returns Pointer to a compiled path if successful, @c NULL — otherwise
+ * (@c errno is set to @c EINVAL if an attribute reference is not at the end
+ * of a path).
+ */
+
+struct ndm_core_path_t *ndm_core_path_compile(
+		const char *const path_format,
+		...) NDM_ATTR_WUR NDM_ATTR_PRINTF(1, 2);
+
+/**
+ * Free a compiled path.
+ *
+ * @param path Pointer to a compiled path pointer. The value can be @c NULL
+ * as well as a pointer to a @c NULL path. A path pointer is set to @c NULL.
+ */
+
+void ndm_core_path_free(
+		struct ndm_core_path_t **path);
+
+/**
+ * Get the pointer to the first node that matches a compiled path.
+ *
+ * @param path Compiled path without an attribute reference.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Reference to the result node.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_node(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t **value) NDM_ATTR_WUR;
+
+/**
+ * Get the string value of the first node or attribute that matches
+ * a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting string pointer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_str(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const char **value) NDM_ATTR_WUR;
+
+/**
+ * Get the char integer value of the first node or attribute that matches
+ * a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting char integer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_char(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		char *value) NDM_ATTR_WUR;
+
+/**
+ * Get the unsigned char integer value of the first node or attribute
+ * that matches a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting unsigned char integer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_uchar(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		unsigned char *value) NDM_ATTR_WUR;
+
+/**
+ * Get the short integer value of the first node or attribute that matches
+ * a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting short integer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_short(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		short *value) NDM_ATTR_WUR;
+
+/**
+ * Get the unsigned short integer value of the first node or attribute
+ * that matches a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting unsigned short integer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_ushort(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		unsigned short *value) NDM_ATTR_WUR;
+
+/**
+ * Get the integer value of the first node or attribute that matches
+ * a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting integer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_int(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		int *value) NDM_ATTR_WUR;
+
+/**
+ * Get the unsigned integer value of the first node or attribute that matches
+ * a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting unsigned integer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_uint(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		unsigned int *value) NDM_ATTR_WUR;
+
+/**
+ * Get the long integer value of the first node or attribute that matches
+ * a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting long integer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_long(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		long *value) NDM_ATTR_WUR;
+
+/**
+ * Get the unsigned long integer value of the first node or attribute
+ * that matches a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting unsigned long integer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_ulong(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		unsigned long *value) NDM_ATTR_WUR;
+
+/**
+ * Get the long long integer value of the first node or attribute that matches
+ * a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting long long integer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_llong(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		long long *value) NDM_ATTR_WUR;
+
+/**
+ * Get the unsigned long long integer value of the first node or attribute
+ * that matches a compiled path.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[out] value Pointer to a resulting unsigned long long integer.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_ullong(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		unsigned long long *value) NDM_ATTR_WUR;
+
+/**
+ * Get the boolean value of the first node or attribute that matches
+ * a compiled path. Values are parsed as in ndm_core_response_first_bool().
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param parse_value @c true if a value should be parsed, @c false if you
+ * need to know about the presence or absence of the required value only.
+ * @param[out] value Resulting boolean value.
+ *
+ * @returns Result of a function of @b ndm_core_response_error_t type.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_first_bool(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const bool parse_value,
+		bool *value) NDM_ATTR_WUR;
+
+/**
+ * Iterate over all nodes that match a compiled path in a document order.
+ * A search is resumed from a previous match, so a whole loop makes a single
+ * depth-first traversal of a subtree.
+ * @code
+ * const struct ndm_xml_node_t *n = NULL;
+ *
+ * while (ndm_core_path_next_node(path, root, &n) ==
+ *        NDM_CORE_RESPONSE_ERROR_OK)
+ * {
+ *     ...
+ * }
+ * @endcode
+ *
+ * @param path Compiled path without an attribute reference.
+ * @param node Root node, relative to which a path is searched.
+ * @param[in,out] value @c NULL to get the first match, or a previous match
+ * found for the same @a path and @a node to get a next one.
+ *
+ * @returns @c NDM_CORE_RESPONSE_ERROR_OK if a next node is found,
+ * @c NDM_CORE_RESPONSE_ERROR_NOT_FOUND if there are no more matches
+ * (@a value is set to @c NULL).
+ */
+
+enum ndm_core_response_error_t ndm_core_path_next_node(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t **value) NDM_ATTR_WUR;
+
+/**
+ * Iterate over string values of all nodes or attributes that match
+ * a compiled path. Nodes without a referenced attribute are skipped.
+ *
+ * @param path Compiled path.
+ * @param node Root node, relative to which a path is searched.
+ * @param[in,out] cursor @c NULL to get the first value, or a cursor node
+ * from a previous call to get a next one.
+ * @param[out] value Pointer to a resulting string pointer.
+ *
+ * @returns @c NDM_CORE_RESPONSE_ERROR_OK if a next value is found,
+ * @c NDM_CORE_RESPONSE_ERROR_NOT_FOUND if there are no more matches.
+ */
+
+enum ndm_core_response_error_t ndm_core_path_next_str(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t **cursor,
+		const char **value) NDM_ATTR_WUR;
+
+/**
+ * Compile a schema to extract many fields of a response node in a single
+ * walk of its subtree. Fields with common path prefixes share lookups.
+ *
+ * @param fields Array of field descriptors, destination offsets are
+ * usually given by @c offsetof of a user structure members.
+ * @param field_count Number of field descriptors.
+ *
+ * @returns Pointer to a compiled schema if successful, @c NULL — otherwise
+ * (@c errno is set to @c EINVAL if a path is invalid or a node field refers
+ * to an attribute).
+ */
+
+struct ndm_core_schema_t *ndm_core_schema_compile(
+		const struct ndm_core_field_t *fields,
+		const size_t field_count) NDM_ATTR_WUR;
+
+/**
+ * Free a compiled schema.
+ *
+ * @param schema Pointer to a compiled schema pointer. The value can be
+ * @c NULL as well as a pointer to a @c NULL schema. A schema pointer is set
+ * to @c NULL.
+ */
+
+void ndm_core_schema_free(
+		struct ndm_core_schema_t **schema);
+
+/**
+ * Extract all schema fields of a node. Every path node is matched
+ * to the first child with the same name as ndm_core_response_first_*
+ * functions do, values are parsed in the same way. Fields that are not
+ * found or have an invalid format are left unchanged.
+ *
+ * @param schema Compiled schema.
+ * @param node Root node, relative to which field paths are searched.
+ * @param dest Destination structure, field values are stored at
+ * descriptor offsets.
+ * @param[out] errors Optional array of per field results, can be @c NULL.
+ *
+ * @returns @c NDM_CORE_RESPONSE_ERROR_OK if all fields are extracted,
+ * a result of the first failed field — otherwise.
+ */
+
+enum ndm_core_response_error_t ndm_core_schema_extract(
+		const struct ndm_core_schema_t *schema,
+		const struct ndm_xml_node_t *node,
+		void *dest,
+		enum ndm_core_response_error_t *errors) NDM_ATTR_WUR;
+
 /**
  * Send 'break' request to the core to stop the execution of an active
  * background command.
@@ -578,7 +1503,8 @@ ndm_code_t ndm_core_last_message_code(
 
 /**
  * Release the memory that response instance occupies. After completion assigns
- * @c NULL to @a response.
+ * @c NULL to @a response. Cached responses are shared between callers, so
+ * the memory is released when the last reference is dropped.
  *
  * @param response Pointer to the response instance. The value can be @c NULL
  * as well as NULL-pointer to response instance.
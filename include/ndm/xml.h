@@ -42,6 +42,15 @@ enum ndm_xml_document_parse_flags_t
 		NDM_XML_DOCUMENT_PARSE_FLAGS_CHECK_CLOSING_TAGS
 };
 
+enum ndm_xml_print_flags_t
+{
+	NDM_XML_PRINT_FLAGS_COMPACT							= 0x0001,
+	NDM_XML_PRINT_FLAGS_CRLF							= 0x0002,
+
+	NDM_XML_PRINT_FLAGS_DEFAULT							=
+		NDM_XML_PRINT_FLAGS_COMPACT
+};
+
 enum ndm_xml_document_parse_error_t
 {
 	NDM_XML_DOCUMENT_PARSE_ERROR_OK,
@@ -61,13 +70,38 @@ enum ndm_xml_document_parse_error_t
 	NDM_XML_DOCUMENT_PARSE_ERROR_LBRACKET_EXPECTED
 };
 
+typedef uint32_t ndm_xml_atom_t;
+
+#define NDM_XML_ATOM_NONE								0
+
 struct ndm_xml_node_t;
 struct ndm_xml_attr_t;
+struct ndm_xml_atoms_t;
 
 struct ndm_xml_document_t
 {
 	struct ndm_xml_node_t *__root;
 	struct ndm_pool_t __pool;
+	struct ndm_xml_atoms_t *__atoms;
+	bool __intern_names;
+};
+
+struct ndm_xml_document_parser_t
+{
+	struct ndm_xml_document_t *__doc;
+	struct ndm_xml_node_t *__node;
+	enum ndm_xml_document_parse_flags_t __flags;
+	enum ndm_xml_document_parse_error_t __error;
+	char *__buffer;
+	size_t __size;
+	size_t __capacity;
+	bool __started;
+	bool __markup;
+	int __kind;
+	size_t __match;
+	char __quote;
+	bool __after_eq;
+	int __depth;
 };
 
 #define NDM_XML_DOCUMENT_INITIALIZER(			\
@@ -80,6 +114,8 @@ struct ndm_xml_document_t
 			static_buffer,						\
 			static_buffer_size,					\
 			dynamic_buffer_size),				\
+		.__atoms = NULL,						\
+		.__intern_names = false					\
 	}
 
 /**
@@ -92,6 +128,13 @@ void ndm_xml_document_init(
 		const size_t static_buffer_size,
 		const size_t dynamic_buffer_size);
 
+bool ndm_xml_document_intern_names(
+		struct ndm_xml_document_t *doc) NDM_ATTR_WUR;
+
+ndm_xml_atom_t ndm_xml_document_atom(
+		const struct ndm_xml_document_t *doc,
+		const char *const name) NDM_ATTR_WUR;
+
 bool ndm_xml_document_copy(
 		struct ndm_xml_document_t *dest,
 		const struct ndm_xml_document_t *source) NDM_ATTR_WUR;
@@ -100,11 +143,83 @@ bool ndm_xml_document_is_equal(
 		const struct ndm_xml_document_t *doc,
 		const struct ndm_xml_document_t *other) NDM_ATTR_WUR;
 
+bool ndm_xml_document_compact(
+		struct ndm_xml_document_t *dest,
+		const struct ndm_xml_document_t *source) NDM_ATTR_WUR;
+
+bool ndm_xml_document_is_compact(
+		const struct ndm_xml_document_t *doc) NDM_ATTR_WUR;
+
+/**
+ * Parse a document in place. Parsed text is kept as a value of a data
+ * node, and the first text of an element becomes the element value
+ * unless @c NDM_XML_DOCUMENT_PARSE_FLAGS_NO_ELEMENT_VALUES is set.
+ * Earlier versions left both values empty.
+ */
+
 enum ndm_xml_document_parse_error_t ndm_xml_document_parse(
 		struct ndm_xml_document_t *doc,
 		char *text,
 		const enum ndm_xml_document_parse_flags_t flags) NDM_ATTR_WUR;
 
+/**
+ * Incremental XML document parser functions.
+ */
+
+void ndm_xml_document_parser_init(
+		struct ndm_xml_document_parser_t *parser,
+		struct ndm_xml_document_t *doc,
+		const enum ndm_xml_document_parse_flags_t flags);
+
+enum ndm_xml_document_parse_error_t ndm_xml_document_parser_feed(
+		struct ndm_xml_document_parser_t *parser,
+		const char *data,
+		const size_t size) NDM_ATTR_WUR;
+
+enum ndm_xml_document_parse_error_t ndm_xml_document_parser_finish(
+		struct ndm_xml_document_parser_t *parser) NDM_ATTR_WUR;
+
+void ndm_xml_document_parser_clear(
+		struct ndm_xml_document_parser_t *parser);
+
+/**
+ * XML printer functions.
+ */
+
+char *ndm_xml_document_print(
+		const struct ndm_xml_document_t *doc,
+		const enum ndm_xml_print_flags_t flags,
+		size_t *xml_size) NDM_ATTR_WUR;
+
+bool ndm_xml_document_print_buffer(
+		const struct ndm_xml_document_t *doc,
+		const enum ndm_xml_print_flags_t flags,
+		char *buffer,
+		const size_t buffer_size,
+		size_t *xml_size) NDM_ATTR_WUR;
+
+bool ndm_xml_document_print_fd(
+		const struct ndm_xml_document_t *doc,
+		const enum ndm_xml_print_flags_t flags,
+		const int fd) NDM_ATTR_WUR;
+
+char *ndm_xml_node_print(
+		const struct ndm_xml_node_t *node,
+		const enum ndm_xml_print_flags_t flags,
+		size_t *xml_size) NDM_ATTR_WUR;
+
+bool ndm_xml_node_print_buffer(
+		const struct ndm_xml_node_t *node,
+		const enum ndm_xml_print_flags_t flags,
+		char *buffer,
+		const size_t buffer_size,
+		size_t *xml_size) NDM_ATTR_WUR;
+
+bool ndm_xml_node_print_fd(
+		const struct ndm_xml_node_t *node,
+		const enum ndm_xml_print_flags_t flags,
+		const int fd) NDM_ATTR_WUR;
+
 void *ndm_xml_document_alloc(
 		struct ndm_xml_document_t *doc,
 		const size_t size) NDM_ATTR_WUR;
@@ -163,6 +278,9 @@ const char *ndm_xml_node_name(
 size_t ndm_xml_node_name_size(
 		const struct ndm_xml_node_t *node) NDM_ATTR_WUR;
 
+ndm_xml_atom_t ndm_xml_node_atom(
+		const struct ndm_xml_node_t *node) NDM_ATTR_WUR;
+
 const char *ndm_xml_node_value(
 		const struct ndm_xml_node_t *node) NDM_ATTR_WUR;
 
@@ -187,26 +305,71 @@ struct ndm_xml_node_t *ndm_xml_node_first_child(
 		const struct ndm_xml_node_t *node,
 		const char *const name) NDM_ATTR_WUR;
 
+struct ndm_xml_node_t *ndm_xml_node_first_child_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom) NDM_ATTR_WUR;
+
 struct ndm_xml_node_t *ndm_xml_node_last_child(
 		const struct ndm_xml_node_t *node,
 		const char *const name) NDM_ATTR_WUR;
 
+struct ndm_xml_node_t *ndm_xml_node_last_child_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom) NDM_ATTR_WUR;
+
+size_t ndm_xml_node_child_count(
+		const struct ndm_xml_node_t *node) NDM_ATTR_WUR;
+
+struct ndm_xml_node_t *ndm_xml_node_nth_child(
+		const struct ndm_xml_node_t *node,
+		const size_t n) NDM_ATTR_WUR;
+
+/**
+ * Index children of a wide node by names and positions to speed up
+ * @c ndm_xml_node_first_child() and @c ndm_xml_node_nth_child().
+ * Nodes are not indexed unless requested. An index follows later
+ * mutations of the node: it is grown by appends and inserts, and
+ * a lookup after a remove, an insert or a child rename rebuilds it
+ * in place, so index a node again only before sharing it between
+ * threads after it was modified. Returns @c false with @c errno set
+ * to @c ENOMEM if an index can not be allocated.
+ */
+
+bool ndm_xml_node_index_children(
+		struct ndm_xml_node_t *node) NDM_ATTR_WUR;
+
 struct ndm_xml_node_t *ndm_xml_node_next_sibling(
 		const struct ndm_xml_node_t *node,
 		const char *const name) NDM_ATTR_WUR;
 
+struct ndm_xml_node_t *ndm_xml_node_next_sibling_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom) NDM_ATTR_WUR;
+
 struct ndm_xml_node_t *ndm_xml_node_prev_sibling(
 		const struct ndm_xml_node_t *node,
 		const char *const name) NDM_ATTR_WUR;
 
+struct ndm_xml_node_t *ndm_xml_node_prev_sibling_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom) NDM_ATTR_WUR;
+
 struct ndm_xml_attr_t *ndm_xml_node_first_attr(
 		const struct ndm_xml_node_t *node,
 		const char *const name) NDM_ATTR_WUR;
 
+struct ndm_xml_attr_t *ndm_xml_node_first_attr_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom) NDM_ATTR_WUR;
+
 struct ndm_xml_attr_t *ndm_xml_node_last_attr(
 		const struct ndm_xml_node_t *node,
 		const char *const name) NDM_ATTR_WUR;
 
+struct ndm_xml_attr_t *ndm_xml_node_last_attr_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom) NDM_ATTR_WUR;
+
 void ndm_xml_node_prepend_child(
 		struct ndm_xml_node_t *node,
 		struct ndm_xml_node_t *child);
@@ -300,6 +463,9 @@ const char *ndm_xml_attr_name(
 size_t ndm_xml_attr_name_size(
 		const struct ndm_xml_attr_t *attr) NDM_ATTR_WUR;
 
+ndm_xml_atom_t ndm_xml_attr_atom(
+		const struct ndm_xml_attr_t *attr) NDM_ATTR_WUR;
+
 const char *ndm_xml_attr_value(
 		const struct ndm_xml_attr_t *attr) NDM_ATTR_WUR;
 
@@ -324,9 +490,17 @@ struct ndm_xml_attr_t *ndm_xml_attr_next(
 		const struct ndm_xml_attr_t *attr,
 		const char *const name) NDM_ATTR_WUR;
 
+struct ndm_xml_attr_t *ndm_xml_attr_next_atom(
+		const struct ndm_xml_attr_t *attr,
+		const ndm_xml_atom_t atom) NDM_ATTR_WUR;
+
 struct ndm_xml_attr_t *ndm_xml_attr_prev(
 		const struct ndm_xml_attr_t *attr,
 		const char *const name) NDM_ATTR_WUR;
 
+struct ndm_xml_attr_t *ndm_xml_attr_prev_atom(
+		const struct ndm_xml_attr_t *attr,
+		const ndm_xml_atom_t atom) NDM_ATTR_WUR;
+
 #endif	/* __NDM_XML__ */
 
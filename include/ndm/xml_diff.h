@@ -0,0 +1,60 @@
+#ifndef __NDM_XML_DIFF_H__
+#define __NDM_XML_DIFF_H__
+
+#include <stdbool.h>
+#include "xml.h"
+#include "attr.h"
+
+enum ndm_xml_diff_type_t
+{
+	NDM_XML_DIFF_TYPE_NODE_ADDED,
+	NDM_XML_DIFF_TYPE_NODE_REMOVED,
+	NDM_XML_DIFF_TYPE_NODE_CHANGED,
+	NDM_XML_DIFF_TYPE_ATTR_ADDED,
+	NDM_XML_DIFF_TYPE_ATTR_REMOVED,
+	NDM_XML_DIFF_TYPE_ATTR_CHANGED
+};
+
+/**
+ * A single difference between two documents (see ndm_xml_document_diff()).
+ * An added or removed node stands for its whole subtree. A changed node
+ * has the same type and name in both documents and a different value.
+ * An element value copied from a data child is reported by that child.
+ * Attribute differences refer to a pair of matched nodes, node
+ * differences have both attributes @c NULL.
+ */
+
+struct ndm_xml_diff_t
+{
+	enum ndm_xml_diff_type_t type;
+	const struct ndm_xml_node_t *old_node;	//!< @c NULL for an added node
+	const struct ndm_xml_node_t *new_node;	//!< @c NULL for a removed node
+	const struct ndm_xml_attr_t *old_attr;	//!< @c NULL for an added one
+	const struct ndm_xml_attr_t *new_attr;	//!< @c NULL for a removed one
+};
+
+/**
+ * A callback called for every difference, returns @c false to stop a diff.
+ */
+
+typedef bool (*ndm_xml_diff_cb_t)(
+		void *user_data,
+		const struct ndm_xml_diff_t *diff);
+
+/**
+ * XML diff functions.
+ */
+
+bool ndm_xml_document_diff(
+		const struct ndm_xml_document_t *old_doc,
+		const struct ndm_xml_document_t *new_doc,
+		ndm_xml_diff_cb_t cb,
+		void *user_data) NDM_ATTR_WUR;
+
+bool ndm_xml_node_diff(
+		const struct ndm_xml_node_t *old_node,
+		const struct ndm_xml_node_t *new_node,
+		ndm_xml_diff_cb_t cb,
+		void *user_data) NDM_ATTR_WUR;
+
+#endif	/* __NDM_XML_DIFF_H__ */
@@ -0,0 +1,62 @@
+#ifndef __NDM_XML_QUERY_H__
+#define __NDM_XML_QUERY_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "xml.h"
+#include "attr.h"
+
+#define NDM_XML_QUERY_MAX_STEPS					16
+
+struct ndm_xml_query_t;
+
+struct ndm_xml_query_iter_t
+{
+	const struct ndm_xml_query_t *__query;
+	struct ndm_xml_node_t *__start;
+	struct ndm_xml_node_t *__nodes[NDM_XML_QUERY_MAX_STEPS];
+	size_t __positions[NDM_XML_QUERY_MAX_STEPS];
+	struct ndm_xml_attr_t *__attr;
+	bool __started;
+	bool __finished;
+};
+
+/**
+ * XML query functions.
+ */
+
+struct ndm_xml_query_t *ndm_xml_query_alloc(
+		const char *const expr) NDM_ATTR_WUR;
+
+void ndm_xml_query_free(
+		struct ndm_xml_query_t **query);
+
+const char *ndm_xml_query_expr(
+		const struct ndm_xml_query_t *query) NDM_ATTR_WUR;
+
+bool ndm_xml_query_selects_attr(
+		const struct ndm_xml_query_t *query) NDM_ATTR_WUR;
+
+struct ndm_xml_node_t *ndm_xml_query_first(
+		const struct ndm_xml_query_t *query,
+		const struct ndm_xml_node_t *context) NDM_ATTR_WUR;
+
+/**
+ * XML query iterator functions.
+ */
+
+void ndm_xml_query_iter_init(
+		struct ndm_xml_query_iter_t *iter,
+		const struct ndm_xml_query_t *query,
+		const struct ndm_xml_node_t *context);
+
+bool ndm_xml_query_iter_next(
+		struct ndm_xml_query_iter_t *iter) NDM_ATTR_WUR;
+
+struct ndm_xml_node_t *ndm_xml_query_iter_node(
+		const struct ndm_xml_query_iter_t *iter) NDM_ATTR_WUR;
+
+struct ndm_xml_attr_t *ndm_xml_query_iter_attr(
+		const struct ndm_xml_query_iter_t *iter) NDM_ATTR_WUR;
+
+#endif	/* __NDM_XML_QUERY_H__ */
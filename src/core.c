@@ -2,6 +2,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <signal.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <stdarg.h>
 #include <stdlib.h>
@@ -14,6 +15,7 @@
 #include <ndm/sys.h>
 #include <ndm/xml.h>
 #include <ndm/core.h>
+#include <ndm/crc32.h>
 #include <ndm/time.h>
 #include <ndm/poll.h>
 #include <ndm/pool.h>
@@ -59,13 +61,30 @@
 #define NDM_CORE_RESPONSE_INITIAL_BUFFER_SIZE_			2048
 #define NDM_CORE_RESPONSE_DYNAMIC_BLOCK_SIZE_			4096
 
+#define NDM_CORE_CACHE_INITIAL_BUCKET_COUNT_			64
+#define NDM_CORE_CACHE_ADAPT_PERIOD_					256
+#define NDM_CORE_CACHE_ADAPT_HIT_RATIO_PERCENT_			90
+#define NDM_CORE_CACHE_INITIAL_HEAP_CAPACITY_			64
+
+#define NDM_CORE_POOL_EMPTY_							0
+#define NDM_CORE_POOL_MAX_SIZE_							1024
+
 #define NDM_CORE_RESPONSE_ID_INITIALIZER_				0
 
+#define NDM_CORE_RESPONSE_FRAME_INITIAL_SIZE_			8192
+#define NDM_CORE_RESPONSE_FRAME_NO_ROOT_				SIZE_MAX
+
+#define NDM_CORE_INPUT_NOT_REPLACED_					(-1)
+
 #define NDM_CORE_RESPONSE_STATIC_PATH_BUFFER_SIZE_		256
+#define NDM_CORE_SCHEMA_STATIC_MATCH_BUFFER_SIZE_		256
+#define NDM_CORE_SCHEMA_NO_NODE_						SIZE_MAX
 
 #define NDM_CORE_EVENT_CONNECTION_BUFFER_SIZE_			4096
 #define NDM_CORE_EVENT_INITIAL_BUFFER_SIZE_				1024
 #define NDM_CORE_EVENT_DYNAMIC_BLOCK_SIZE_				1024
+#define NDM_CORE_EVENT_FREE_LIST_MAX_SIZE_				64
+#define NDM_CORE_EVENT_FILTER_INITIAL_CAPACITY_			16
 
 #define NDM_CORE_FEEDBACK_DYNAMIC_BUFFER_SIZE_			1024
 #define NDM_CORE_FEEDBACK_BUFFER_SIZE_					256
@@ -92,7 +111,6 @@ NDM_BUILD_ASSERT(message_source_size, NDM_CORE_MESSAGE_SOURCE_MAX_SIZE_ > 0);
 
 typedef uint8_t ndm_core_ctrl_t;
 typedef uint32_t ndm_core_size_t;
-typedef uint64_t ndm_core_response_id_t;
 
 struct ndm_core_buffer_t
 {
@@ -102,23 +120,125 @@ struct ndm_core_buffer_t
 	uint8_t *putp;
 };
 
+struct ndm_core_input_t
+{
+	struct ndm_core_buffer_t *buffer;
+	int fd;
+	const struct timespec *intblock;
+	const struct timespec *deadline;
+	bool in_place;
+	int replaced;
+};
+
+struct ndm_core_frame_t
+{
+	size_t references;
+	size_t size;
+	uint8_t data[];
+};
+
+struct ndm_core_frame_scanner_t
+{
+	size_t depth;
+	size_t root_depth;
+	size_t ctrl_index;
+};
+
+struct ndm_core_output_t
+{
+	uint8_t *start;
+	uint8_t *bound;
+	uint8_t *putp;
+	uint8_t **dynamic_buffer;
+	size_t *dynamic_buffer_size;
+};
+
 struct ndm_core_cache_entry_t
 {
 	struct ndm_dlist_entry_t list;
+	struct ndm_dlist_entry_t bucket;
 	struct ndm_core_response_t *response;
 	struct timespec expiration_time;
 	struct ndm_core_cache_t *owner;
+	size_t heap_index;
+	uint64_t hits;
+	bool default_ttl;
+	uint32_t hash;
+	size_t request_size;
+	uint8_t request[];
+};
+
+struct ndm_core_cache_policy_t
+{
+	int ttl_msec;
+	bool cacheable;
+	size_t prefix_size;
+	char prefix[];
+};
+
+struct ndm_core_cache_flight_t
+{
+	struct ndm_dlist_entry_t list;
+	struct ndm_core_response_t *response;
+	int error;
+	bool done;
+	size_t waiters;
+	uint32_t hash;
 	size_t request_size;
 	uint8_t request[];
 };
 
 struct ndm_core_cache_t
 {
-	const int ttl_msec;
-	const size_t max_size;
-	struct timespec next_expiration_time;
+	int ttl_msec;
+	size_t max_size;
 	size_t size;
+	size_t count;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t expirations;
+	uint64_t coalesced;
+	bool adaptive;
+	size_t adaptive_min_size;
+	size_t adaptive_max_size;
+	uint64_t adapt_lookups;
+	uint64_t adapt_hits;
+	uint64_t adapt_evictions;
+	struct ndm_core_cache_policy_t **policies;
+	size_t policy_count;
 	struct ndm_dlist_entry_t entries;
+	struct ndm_dlist_entry_t *buckets;
+	size_t bucket_count;
+	struct ndm_core_cache_entry_t **heap;
+	size_t heap_capacity;
+	bool compact;
+	bool shared;
+	pthread_mutex_t lock;
+	pthread_cond_t flight_done;
+	struct ndm_dlist_entry_t flights;
+};
+
+struct ndm_core_pending_t
+{
+	struct ndm_dlist_entry_t list;
+	ndm_core_response_id_t id;
+	struct ndm_core_response_t *response;
+	int error;
+	size_t request_size;
+	uint8_t request[];
+};
+
+struct ndm_core_pipeline_t
+{
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+	size_t consumed;
+	size_t scanned;
+	struct ndm_core_frame_scanner_t scanner;
+	struct ndm_dlist_entry_t sent;
+	struct ndm_dlist_entry_t completed;
 };
 
 struct ndm_core_message_t
@@ -139,17 +259,108 @@ struct ndm_core_t
 	const char *agent;
 	uint8_t buffer_storage[NDM_CORE_CONNECTION_BUFFER_SIZE_];
 	struct ndm_core_buffer_t buffer;
-	struct ndm_core_cache_t cache;
+	uint8_t *request_buffer;
+	size_t request_buffer_size;
+	bool zero_copy;
+	bool stats_enabled;
+	struct ndm_core_stats_t stats;
+	ndm_core_request_hook_t request_hook;
+	void *request_hook_data;
+	struct ndm_core_cache_t cache_storage;
+	struct ndm_core_cache_t *cache;
+	struct ndm_core_pool_t *pool;
+	uint32_t pool_slot;
+	struct ndm_core_pipeline_t pipeline;
 	struct ndm_core_message_t last_message;
 	ndm_core_response_id_t response_id;
 };
 
+struct ndm_core_pool_slot_t
+{
+	struct ndm_core_t *core;
+	uint32_t next;
+	bool checked_out;
+};
+
+struct ndm_core_pool_t
+{
+	struct ndm_core_cache_t cache;
+	uint64_t free_head;
+	uint32_t size;
+	struct ndm_core_pool_slot_t slots[];
+};
+
 struct ndm_core_response_t
 {
 	uint8_t buffer[NDM_CORE_RESPONSE_INITIAL_BUFFER_SIZE_];
 	struct ndm_xml_document_t doc;
 	struct ndm_xml_node_t *root;
+	struct ndm_core_frame_t *frame;
 	ndm_core_response_id_t id;
+	size_t references;
+};
+
+/**
+ * A compiled path keeps node names as separate strings
+ * and an optional attribute name after them.
+ **/
+
+struct ndm_core_path_t
+{
+	const char *attr_name;
+	size_t segment_count;
+	const char *segments[];
+};
+
+/**
+ * Schema fields are grouped in a trie of path node names
+ * to be extracted in a single subtree walk.
+ **/
+
+struct ndm_core_schema_node_t
+{
+	const char *name;
+	size_t first_child;
+	size_t next_sibling;
+	size_t child_count;
+};
+
+struct ndm_core_schema_field_t
+{
+	struct ndm_core_path_t *path;
+	enum ndm_core_field_type_t type;
+	size_t offset;
+	size_t node;
+};
+
+struct ndm_core_schema_t
+{
+	struct ndm_core_schema_node_t *nodes;
+	size_t node_count;
+	size_t field_count;
+	struct ndm_core_schema_field_t fields[];
+};
+
+struct ndm_core_event_filter_entry_t
+{
+	uint32_t hash;
+	bool prefix;
+	size_t size;
+	char name[];
+};
+
+/**
+ * An open addressing hash set of event class names and prefixes,
+ * prefix entries are looked up for every distinct prefix length.
+ **/
+
+struct ndm_core_event_filter_t
+{
+	struct ndm_core_event_filter_entry_t **entries;
+	size_t capacity;
+	size_t count;
+	size_t *prefix_sizes;
+	size_t prefix_size_count;
 };
 
 struct ndm_core_event_connection_t
@@ -158,10 +369,14 @@ struct ndm_core_event_connection_t
 	int timeout;
 	uint8_t buffer_storage[NDM_CORE_EVENT_CONNECTION_BUFFER_SIZE_];
 	struct ndm_core_buffer_t buffer;
+	struct ndm_core_event_t *free_events;
+	size_t free_event_count;
+	struct ndm_core_event_filter_t filter;
 };
 
 struct ndm_core_event_t
 {
+	struct ndm_core_event_t *next;
 	uint8_t buffer[NDM_CORE_EVENT_INITIAL_BUFFER_SIZE_];
 	struct ndm_xml_document_t doc;
 	struct ndm_xml_node_t *root;
@@ -475,74 +690,92 @@ static inline bool __ndm_core_buffer_send_all(
 	return true;
 }
 
-static inline bool __ndm_core_buffer_recv_all(
-		struct ndm_core_buffer_t *buffer,
+/**
+ * Wait for incoming data and receive up to @a size bytes,
+ * returns a received size or -1 on an error.
+ **/
+
+static ssize_t __ndm_core_recv(
 		const int fd,
 		const struct timespec *intblock,
 		const struct timespec *deadline,
 		void *data,
-		const size_t data_size)
+		const size_t size)
 {
-	size_t size = 0;
+	for (;;) {
+		const int delay = (int) ndm_time_left_monotonic_msec(deadline);
 
-	while (size < data_size) {
-		if (__ndm_core_buffer_is_empty(buffer)) {
-			/* there is no data in a buffer */
-			buffer->putp = buffer->start;
-			buffer->getp = buffer->start;
+		if (delay <= 0) {
+			errno = ETIMEDOUT;
+
+			return -1;
+		}
 
-			const int delay = (int) ndm_time_left_monotonic_msec(deadline);
+		struct pollfd pfd =
+		{
+			.fd = fd,
+			.events = POLLIN,
+			.revents = 0
+		};
+		const int ib_delay = (int) ndm_time_left_monotonic_msec(intblock);
+		const int n = (ib_delay == 0) ?
+			ndm_poll(&pfd, 1, delay) :
+			poll(&pfd, 1, NDM_MIN(delay, ib_delay));
 
-			if (delay <= 0) {
-				errno = ETIMEDOUT;
+		if (n < 0) {
+			return -1;
+		}
 
-				return false;
-			}
+		if (n == 0) {
+			continue;
+		}
 
-			struct pollfd pfd =
-			{
-				.fd = fd,
-				.events = POLLIN,
-				.revents = 0
-			};
-			const int ib_delay =
-				(int) ndm_time_left_monotonic_msec(intblock);
-			const int n = (ib_delay == 0) ?
-				ndm_poll(&pfd, 1, delay) :
-				poll(&pfd, 1, NDM_MIN(delay, ib_delay));
-
-			if (n < 0) {
-				return false;
-			}
+		if (pfd.revents & POLLNVAL) {
+			errno = EINVAL;
 
-			if (n == 0) {
-				continue;
-			}
+			return -1;
+		}
 
-			if (pfd.revents & POLLNVAL) {
-				errno = EINVAL;
+		if (!(pfd.revents & (POLLIN | POLLHUP))) {
+			errno = EIO;
 
-				return false;
-			}
+			return -1;
+		}
 
-			if (!(pfd.revents & (POLLIN | POLLHUP))) {
-				errno = EIO;
+		/* a hungup state should be detected by @c recv() call
+		 * after reading all locally buffered data */
+		const ssize_t s = recv(fd, data, size, 0);
 
-				return false;
-			}
+		if (s == 0) {
+			errno = ECONNRESET;
 
-			/* a hungup state should be detected by @c recv() call
-			 * after reading all locally buffered data */
-			const ssize_t s = recv(fd, buffer->putp,
-				(size_t) (buffer->bound - buffer->start), 0);
+			return -1;
+		}
 
-			if (s < 0) {
-				return false;
-			}
+		return s;
+	}
+}
+
+static inline bool __ndm_core_buffer_recv_all(
+		struct ndm_core_buffer_t *buffer,
+		const int fd,
+		const struct timespec *intblock,
+		const struct timespec *deadline,
+		void *data,
+		const size_t data_size)
+{
+	size_t size = 0;
+
+	while (size < data_size) {
+		if (__ndm_core_buffer_is_empty(buffer)) {
+			/* there is no data in a buffer */
+			buffer->putp = buffer->start;
+			buffer->getp = buffer->start;
 
-			if (s == 0) {
-				errno = ECONNRESET;
+			const ssize_t s = __ndm_core_recv(fd, intblock, deadline,
+				buffer->putp, (size_t) (buffer->bound - buffer->start));
 
+			if (s < 0) {
 				return false;
 			}
 
@@ -561,61 +794,208 @@ static inline bool __ndm_core_buffer_recv_all(
 }
 
 /**
- * Common core functions.
+ * Take @a data_size bytes straight from a buffer while they are already
+ * received, a blocking @c __ndm_core_buffer_recv_all() call is used
+ * only for a record crossing a buffer boundary.
  **/
 
-static inline bool __ndm_core_read_ctrl(
+static inline bool __ndm_core_buffer_get(
 		struct ndm_core_buffer_t *buffer,
 		const int fd,
 		const struct timespec *intblock,
 		const struct timespec *deadline,
-		ndm_core_ctrl_t *ctrl,
-		enum ndm_xml_node_type_t *type)
+		void *data,
+		const size_t data_size)
 {
-	uint8_t data;
-	bool done = false;
+	if ((size_t) (buffer->putp - buffer->getp) < data_size) {
+		return __ndm_core_buffer_recv_all(
+			buffer, fd, intblock, deadline, data, data_size);
+	}
+
+	memcpy(data, buffer->getp, data_size);
+	buffer->getp += data_size;
+
+	return true;
+}
+
+/**
+ * Core input functions.
+ **/
+
+static void __ndm_core_input_init(
+		struct ndm_core_input_t *input,
+		struct ndm_core_buffer_t *buffer,
+		const int fd,
+		const struct timespec *intblock,
+		const struct timespec *deadline)
+{
+	input->buffer = buffer;
+	input->fd = fd;
+	input->intblock = intblock;
+	input->deadline = deadline;
+	input->in_place = false;
+	input->replaced = NDM_CORE_INPUT_NOT_REPLACED_;
+}
+
+/**
+ * An in place input reads a whole received frame, its strings are
+ * terminated inside the frame and the first byte of a next record
+ * is kept in @c replaced field.
+ **/
+
+static void __ndm_core_input_init_in_place(
+		struct ndm_core_input_t *input,
+		struct ndm_core_buffer_t *buffer,
+		struct ndm_core_frame_t *frame)
+{
+	__ndm_core_buffer_init(buffer, frame->data, frame->size);
+	buffer->putp = buffer->bound;
+
+	/* a frame is complete, no I/O expected */
+	__ndm_core_input_init(input, buffer, -1, NULL, NULL);
+	input->in_place = true;
+}
+
+static inline bool __ndm_core_input_get(
+		struct ndm_core_input_t *input,
+		void *data,
+		const size_t data_size)
+{
+	uint8_t *p = data;
+	size_t size = data_size;
+
+	if (input->replaced != NDM_CORE_INPUT_NOT_REPLACED_ && size > 0) {
+		/* restore a byte overwritten by a string terminator */
+		*p = (uint8_t) input->replaced;
+		input->replaced = NDM_CORE_INPUT_NOT_REPLACED_;
+		++input->buffer->getp;
+		++p;
+		--size;
+	}
 
-	if (__ndm_core_buffer_recv_all(
-			buffer, fd, intblock, deadline, &data, sizeof(data)))
+	if (input->fd < 0 &&
+		(size_t) (input->buffer->putp - input->buffer->getp) < size)
 	{
-		*ctrl = (ndm_core_ctrl_t) ((data >> 6) & 0x03);
-		*type = (enum ndm_xml_node_type_t) (data & 0x3f);
+		/* a frame is truncated */
+		errno = EBADMSG;
 
-		if (*type > NDM_XML_NODE_TYPE_PI) {
-			errno = EBADMSG;
+		return false;
+	}
+
+	return __ndm_core_buffer_get(
+		input->buffer, input->fd,
+		input->intblock, input->deadline, p, size);
+}
+
+static bool __ndm_core_input_skip(
+		struct ndm_core_input_t *input,
+		size_t size)
+{
+	uint8_t data[64];
+
+	while (size > 0) {
+		struct ndm_core_buffer_t *buffer = input->buffer;
+		const size_t buffered = (size_t) (buffer->putp - buffer->getp);
+		size_t skipped = NDM_MIN(size, buffered);
+
+		if (skipped > 0) {
+			buffer->getp += skipped;
 		} else {
-			done = true;
+			skipped = NDM_MIN(size, sizeof(data));
+
+			if (!__ndm_core_input_get(input, data, skipped)) {
+				return false;
+			}
 		}
+
+		size -= skipped;
 	}
 
-	return done;
+	return true;
+}
+
+/**
+ * Common core functions.
+ **/
+
+static inline bool __ndm_core_decode_ctrl(
+		const uint8_t data,
+		ndm_core_ctrl_t *ctrl,
+		enum ndm_xml_node_type_t *type)
+{
+	*ctrl = (ndm_core_ctrl_t) ((data >> 6) & 0x03);
+	*type = (enum ndm_xml_node_type_t) (data & 0x3f);
+
+	if (*type > NDM_XML_NODE_TYPE_PI) {
+		errno = EBADMSG;
+
+		return false;
+	}
+
+	return true;
+}
+
+static inline bool __ndm_core_read_ctrl(
+		struct ndm_core_input_t *input,
+		ndm_core_ctrl_t *ctrl,
+		enum ndm_xml_node_type_t *type)
+{
+	uint8_t data;
+
+	return
+		__ndm_core_input_get(input, &data, sizeof(data)) &&
+		__ndm_core_decode_ctrl(data, ctrl, type);
+}
+
+static bool __ndm_core_read_string_in_place(
+		struct ndm_core_input_t *input,
+		const ndm_core_size_t size,
+		const char **s)
+{
+	struct ndm_core_buffer_t *buffer = input->buffer;
+	char *p = (char *) buffer->getp;
+
+	if ((size_t) (buffer->putp - buffer->getp) < size) {
+		errno = EBADMSG;
+
+		return false;
+	}
+
+	buffer->getp += size;
+
+	if (buffer->getp < buffer->putp) {
+		input->replaced = *buffer->getp;
+	}
+
+	/* a frame always has a spare byte after its end */
+	*buffer->getp = '\0';
+	*s = p;
+
+	return true;
 }
 
 static bool __ndm_core_read_string(
-		struct ndm_core_buffer_t *buffer,
-		const int fd,
-		const struct timespec *intblock,
-		const struct timespec *deadline,
+		struct ndm_core_input_t *input,
 		struct ndm_xml_document_t *doc,
 		const char **s)
 {
 	bool done = false;
 	ndm_core_size_t size = 0;
 
-	if (__ndm_core_buffer_recv_all(
-			buffer, fd, intblock, deadline, &size, sizeof(size)))
-	{
+	if (__ndm_core_input_get(input, &size, sizeof(size))) {
 		size = ntohl(size);
 
 		if (size == 0) {
 			*s = "";
 			done = true;
+		} else
+		if (input->in_place) {
+			done = __ndm_core_read_string_in_place(input, size, s);
 		} else {
 			char *p = ndm_xml_document_alloc(doc, size + 1);
 
 			if (p != NULL &&
-				__ndm_core_buffer_recv_all(
-					buffer, fd, intblock, deadline, p, size))
+				__ndm_core_input_get(input, p, size))
 			{
 				p[size] = '\0';
 				*s = p;
@@ -628,10 +1008,7 @@ static bool __ndm_core_read_string(
 }
 
 static bool __ndm_core_read_xml_children(
-		const int fd,
-		struct ndm_core_buffer_t *buffer,
-		const struct timespec *intblock,
-		const struct timespec *deadline,
+		struct ndm_core_input_t *input,
 		struct ndm_xml_node_t *root_parent)
 {
 	struct ndm_xml_document_t *doc = ndm_xml_node_document(root_parent);
@@ -648,8 +1025,7 @@ static bool __ndm_core_read_xml_children(
 
 		++ctrl_index;
 
-		if (!__ndm_core_read_ctrl(
-				buffer, fd, intblock, deadline, &ctrl, &type)) {
+		if (!__ndm_core_read_ctrl(input, &ctrl, &type)) {
 			error = true;
 		} else
 		if (ctrl == NDM_CORE_CTRL_NODE_ || ctrl == NDM_CORE_CTRL_SIBL_) {
@@ -672,10 +1048,8 @@ static bool __ndm_core_read_xml_children(
 					errno = EBADMSG;
 					error = true;
 				} else
-				if (!__ndm_core_read_string(buffer,
-						fd, intblock, deadline, doc, &name) ||
-					!__ndm_core_read_string(buffer,
-						fd, intblock, deadline, doc, &value))
+				if (!__ndm_core_read_string(input, doc, &name) ||
+					!__ndm_core_read_string(input, doc, &value))
 				{
 					error = true;
 				} else {
@@ -688,10 +1062,8 @@ static bool __ndm_core_read_xml_children(
 				errno = EBADMSG;
 				error = true;
 			} else
-			if (!__ndm_core_read_string(
-					buffer, fd, intblock, deadline, doc, &name) ||
-				!__ndm_core_read_string(
-					buffer, fd, intblock, deadline, doc, &value) ||
+			if (!__ndm_core_read_string(input, doc, &name) ||
+				!__ndm_core_read_string(input, doc, &value) ||
 				(new_node = ndm_xml_document_alloc_node(
 					doc, type, name, value)) == NULL)
 			{
@@ -741,10 +1113,8 @@ static bool __ndm_core_read_xml_children(
 				const char *name;
 				const char *value;
 
-				if (!__ndm_core_read_string(
-						buffer, fd, intblock, deadline, doc, &name) ||
-					!__ndm_core_read_string(
-						buffer, fd, intblock, deadline, doc, &value) ||
+				if (!__ndm_core_read_string(input, doc, &name) ||
+					!__ndm_core_read_string(input, doc, &value) ||
 					(new_attr = ndm_xml_document_alloc_attr(
 						doc, name, value)) == NULL)
 				{
@@ -773,1515 +1143,5235 @@ static bool __ndm_core_read_xml_children(
 }
 
 /**
- * Core event connection functions.
+ * Core frame functions.
  **/
 
-struct ndm_core_event_connection_t *ndm_core_event_connection_open(
-		const int timeout)
+static struct ndm_core_frame_t *__ndm_core_frame_alloc(
+		const size_t capacity)
 {
-	struct ndm_core_event_connection_t *connection =
-		malloc(sizeof(*connection));
+	/* keep a spare byte for a terminator of the last string */
+	struct ndm_core_frame_t *frame = malloc(sizeof(*frame) + capacity + 1);
 
-	if (connection == NULL) {
+	if (frame == NULL) {
 		errno = ENOMEM;
 	} else {
-		bool connected = false;
-
-		if ((connection->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
-		{
-			/* failed to open a new UNIX domain socket */
+		frame->references = 1;
+		frame->size = 0;
+	}
 
-		} else {
-			struct sockaddr_un sa;
-			int len = 0;
+	return frame;
+}
 
-			sa.sun_family = AF_UNIX;
-			len = snprintf(sa.sun_path, sizeof(sa.sun_path), "%s",
-				NDM_CORE_EVENT_SOCKET_);
+static inline struct ndm_core_frame_t *__ndm_core_frame_retain(
+		struct ndm_core_frame_t *frame)
+{
+	__atomic_add_fetch(&frame->references, 1, __ATOMIC_RELAXED);
 
-			if (len < 0 || len >= sizeof(sa.sun_path)) {
-				errno = ENOBUFS;
-			} else {
-				len += (int)offsetof(struct sockaddr_un, sun_path) + 1;
+	return frame;
+}
 
-				if (connect(connection->fd,
-					(struct sockaddr *) &sa,
-					(socklen_t)len) == 0)
-				{
-					connected = true;
-					connection->timeout = timeout;
-					__ndm_core_buffer_init(&connection->buffer,
-						connection->buffer_storage,
-						sizeof(connection->buffer_storage));
-				}
-			}
-		}
+/**
+ * A frame is freed with its last reference.
+ **/
 
-		if (!connected) {
-			close(connection->fd);
-			free(connection);
-			connection = NULL;
-		}
+static void __ndm_core_frame_release(
+		struct ndm_core_frame_t **frame)
+{
+	if (*frame != NULL &&
+		__atomic_sub_fetch(&(*frame)->references, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		free(*frame);
 	}
 
-	return connection;
+	*frame = NULL;
 }
 
-bool ndm_core_event_connection_close(
-		struct ndm_core_event_connection_t **connection)
+/**
+ * A frame is resized only while it is being received,
+ * no strings refer to it yet.
+ **/
+
+static bool __ndm_core_frame_reserve(
+		struct ndm_core_frame_t **frame,
+		size_t *capacity,
+		const size_t size)
 {
-	int n = 0;
+	const size_t need = (*frame)->size + size;
 
-	if (connection != NULL && *connection != NULL) {
-		if (close((*connection)->fd) != 0 && errno != EINTR) {
-			n = errno;
+	if (need > *capacity) {
+		size_t new_capacity = *capacity;
+		struct ndm_core_frame_t *f = NULL;
+
+		while (new_capacity < need) {
+			new_capacity *= 2;
 		}
 
-		free(*connection);
-		*connection = NULL;
+		if ((f = realloc(*frame, sizeof(*f) + new_capacity + 1)) == NULL) {
+			errno = ENOMEM;
+
+			return false;
+		}
+
+		*frame = f;
+		*capacity = new_capacity;
 	}
 
-	return (n == 0) ? true : false;
+	return true;
 }
 
-int ndm_core_event_connection_fd(
-		const struct ndm_core_event_connection_t *connection)
-{
-	return connection->fd;
-}
+/**
+ * A frame scanner tracks a node depth to detect a document end
+ * in the same way as @c __ndm_core_read_xml_children() does.
+ **/
 
-bool ndm_core_event_connection_has_events(
-		struct ndm_core_event_connection_t *connection)
+static inline void __ndm_core_frame_scanner_init(
+		struct ndm_core_frame_scanner_t *scanner)
 {
-	return !__ndm_core_buffer_is_empty(&connection->buffer);
+	scanner->depth = 0;
+	scanner->root_depth = NDM_CORE_RESPONSE_FRAME_NO_ROOT_;
+	scanner->ctrl_index = 0;
 }
 
-struct ndm_core_event_t *ndm_core_event_connection_get(
-		struct ndm_core_event_connection_t *connection)
+static bool __ndm_core_frame_scanner_next(
+		struct ndm_core_frame_scanner_t *scanner,
+		const uint8_t data,
+		bool *has_strings,
+		bool *stopped)
 {
-	struct ndm_core_event_t *event = malloc(sizeof(*event));
+	ndm_core_ctrl_t ctrl = NDM_CORE_CTRL_END_;
+	enum ndm_xml_node_type_t type = NDM_XML_NODE_TYPE_ELEMENT;
 
-	if (event == NULL) {
-		errno = ENOMEM;
-	} else {
-		bool done = false;
-		struct timespec intblock;
-		struct timespec deadline;
-		struct ndm_xml_node_t *root = NULL;
+	*has_strings = false;
+	*stopped = false;
+	++scanner->ctrl_index;
 
-		ndm_time_get_monotonic_plus_msec(
-			&intblock, NDM_CORE_INTBLOCK_TIMEOUT_);
-		ndm_time_get_monotonic_plus_msec(&deadline, connection->timeout);
+	if (!__ndm_core_decode_ctrl(data, &ctrl, &type)) {
+		return false;
+	}
 
-		ndm_xml_document_init(
-			&event->doc, event->buffer, sizeof(event->buffer),
-			NDM_CORE_EVENT_DYNAMIC_BLOCK_SIZE_);
+	if (ctrl == NDM_CORE_CTRL_NODE_ || ctrl == NDM_CORE_CTRL_SIBL_) {
+		if (type == NDM_XML_NODE_TYPE_DOCUMENT) {
+			if (scanner->ctrl_index > 1 || ctrl != NDM_CORE_CTRL_NODE_) {
+				errno = EBADMSG;
 
-		/* read a whole document with a root node */
+				return false;
+			}
 
-		if ((root = ndm_xml_document_alloc_root(&event->doc)) != NULL &&
-			__ndm_core_read_xml_children(
-				connection->fd, &connection->buffer,
-				&intblock, &deadline, root))
-		{
-			struct ndm_xml_attr_t *event_type;
-			struct ndm_xml_attr_t *raise_time;
-
-			event->root = ndm_xml_node_first_child(
-				ndm_xml_document_root(&event->doc), "event");
-
-			if (event->root == NULL ||
-				(event_type = ndm_xml_node_first_attr(
-					event->root, "class")) == NULL ||
-				*(event->type = ndm_xml_attr_value(event_type)) == '\0' ||
-				(raise_time = ndm_xml_node_first_attr(
-					event->root, "raise_time")) == NULL ||
-				*ndm_xml_attr_value(raise_time) == '\0')
-			{
-				errno = EBADMSG;
-			} else {
-				const char *const raise_time_value =
-					ndm_xml_attr_value(raise_time);
-				char end;
-				long seconds = 0;
-				long milliseconds = 0;
-
-				if ((strchr(raise_time_value, '.') == NULL &&
-					 sscanf(raise_time_value, "%ld%c",
-						&seconds, &end) == 1) ||
-					 sscanf(raise_time_value, "%ld.%ld%c",
-						&seconds, &milliseconds, &end) == 2)
-				{
-					event->raise_time.tv_sec = (time_t) seconds;
-					event->raise_time.tv_nsec = milliseconds*NDM_TIME_MSEC;
+			scanner->root_depth = scanner->depth;
+		} else
+		if (ctrl == NDM_CORE_CTRL_SIBL_ && scanner->depth == 0) {
+			errno = EBADMSG;
 
-					done = true;
-				} else {
-					errno = EBADMSG;
-				}
+			return false;
+		} else {
+			if (ctrl == NDM_CORE_CTRL_NODE_) {
+				++scanner->depth;
+			}
+
+			if (scanner->root_depth == NDM_CORE_RESPONSE_FRAME_NO_ROOT_) {
+				scanner->root_depth = scanner->depth;
 			}
 		}
 
-		if (!done) {
-			ndm_core_event_free(&event);
+		*has_strings = true;
+	} else
+	if (ctrl == NDM_CORE_CTRL_ATTR_) {
+		if (scanner->depth == 0) {
+			errno = EBADMSG;
+
+			return false;
 		}
+
+		*has_strings = true;
+	} else {
+		*stopped =
+			scanner->root_depth == NDM_CORE_RESPONSE_FRAME_NO_ROOT_ ||
+			scanner->depth <= scanner->root_depth + 1;
+		--scanner->depth;
 	}
 
-	return event;
+	return true;
 }
 
-const struct ndm_xml_node_t *ndm_core_event_root(
-		const struct ndm_core_event_t *event)
-{
-	return event->root;
-}
+/**
+ * Scan complete records of @a data starting from @a scanned offset
+ * up to a document end. If the last record is incomplete,
+ * @a missing is set to a known number of its bytes not received yet.
+ **/
 
-const char *ndm_core_event_type(
-		const struct ndm_core_event_t *event)
+static bool __ndm_core_frame_scan(
+		struct ndm_core_frame_scanner_t *scanner,
+		const uint8_t *data,
+		const size_t size,
+		size_t *scanned,
+		size_t *missing,
+		bool *stopped)
 {
-	return event->type;
-}
+	*missing = 0;
+	*stopped = false;
+
+	while (!*stopped && *scanned < size) {
+		struct ndm_core_frame_scanner_t next = *scanner;
+		const uint8_t *p = data + *scanned;
+		const size_t left = size - *scanned;
+		size_t record_size = sizeof(ndm_core_ctrl_t);
+		bool has_strings = false;
+		bool last = false;
+
+		if (!__ndm_core_frame_scanner_next(&next, *p, &has_strings, &last)) {
+			return false;
+		}
 
-struct timespec ndm_core_event_raise_time(
-		const struct ndm_core_event_t *event)
-{
-	return event->raise_time;
-}
+		for (size_t i = 0; has_strings && *missing == 0 && i < 2; i++) {
+			ndm_core_size_t string_size = 0;
 
-void ndm_core_event_free(
-		struct ndm_core_event_t **event)
-{
-	if (event != NULL && *event != NULL) {
-		ndm_xml_document_clear(&(*event)->doc);
-		free(*event);
-		*event = NULL;
+			if (left - record_size < sizeof(string_size)) {
+				*missing = record_size + sizeof(string_size) - left;
+			} else {
+				memcpy(&string_size, p + record_size, sizeof(string_size));
+				record_size += sizeof(string_size) + ntohl(string_size);
+
+				if (left < record_size) {
+					*missing = record_size - left;
+				}
+			}
+		}
+
+		if (*missing > 0) {
+			/* wait for the rest of a record */
+			break;
+		}
+
+		*scanner = next;
+		*scanned += record_size;
+		*stopped = last;
 	}
+
+	return true;
 }
 
 /**
- * Core cache functions.
+ * Receive a whole binary XML document into a frame without decoding it.
+ * Data are received directly into the frame, a single receive call is
+ * limited by a connection buffer size beyond known record bytes,
+ * so data following the document always fit back into the buffer.
  **/
 
-static struct ndm_core_response_t *__ndm_core_response_copy(
-		const struct ndm_core_response_t *response) NDM_ATTR_WUR;
-
-static inline size_t __ndm_core_response_size(
-		const struct ndm_core_response_t *response) NDM_ATTR_WUR;
-
-static inline size_t __ndm_core_cache_entry_size(
-		const size_t request_size,
-		const struct ndm_core_response_t *response)
+static bool __ndm_core_read_frame(
+		struct ndm_core_input_t *input,
+		struct ndm_core_frame_t **frame)
 {
-	return
-		request_size +
-		sizeof(struct ndm_core_cache_entry_t) +
-		__ndm_core_response_size(response);
-}
+	struct ndm_core_buffer_t *buffer = input->buffer;
+	const size_t buffer_size = (size_t) (buffer->bound - buffer->start);
+	size_t buffered = (size_t) (buffer->putp - buffer->getp);
+	size_t capacity = NDM_MAX(NDM_CORE_RESPONSE_FRAME_INITIAL_SIZE_, buffered);
+	struct ndm_core_frame_scanner_t scanner;
+	size_t scanned = 0;
+	size_t missing = 0;
+	bool stopped = false;
 
-static void __ndm_core_cache_entry_remove(
-		struct ndm_core_cache_entry_t *e)
-{
-	ndm_dlist_remove(&e->list);
-	e->owner->size -=
-		__ndm_core_cache_entry_size(e->request_size, e->response);
-	ndm_core_response_free(&e->response);
-	free(e);
-}
+	if ((*frame = __ndm_core_frame_alloc(capacity)) == NULL) {
+		return false;
+	}
 
-static void __ndm_core_cache_init(
-		struct ndm_core_cache_t *cache,
-		const int ttl_msec,
-		const size_t max_size)
-{
-	*((int *) &cache->ttl_msec) = ttl_msec;
-	*((size_t *) &cache->max_size) = max_size;
-	ndm_time_get_max(&cache->next_expiration_time);
-	cache->size = 0;
-	ndm_dlist_init(&cache->entries);
-}
+	/* take data already received into a connection buffer */
+	memcpy((*frame)->data, buffer->getp, buffered);
+	(*frame)->size = buffered;
+	buffer->getp = buffer->start;
+	buffer->putp = buffer->start;
 
-static inline void __ndm_core_cache_remove_last(
-		struct ndm_core_cache_t *cache)
-{
-	__ndm_core_cache_entry_remove(
-		ndm_dlist_entry(cache->entries.prev,
-			struct ndm_core_cache_entry_t, list));
-}
+	__ndm_core_frame_scanner_init(&scanner);
 
-void ndm_core_cache_clear(
-		struct ndm_core_t *core,
-		const bool remove_all)
-{
-	struct ndm_core_cache_t *cache = &core->cache;
+	while (__ndm_core_frame_scan(&scanner, (*frame)->data, (*frame)->size,
+			&scanned, &missing, &stopped) && !stopped)
+	{
+		const size_t wanted = missing + buffer_size;
+		ssize_t s = 0;
 
-	if (remove_all) {
-		while (!ndm_dlist_is_empty(&cache->entries)) {
-			__ndm_core_cache_remove_last(cache);
+		if (!__ndm_core_frame_reserve(frame, &capacity, wanted) ||
+			(s = __ndm_core_recv(input->fd, input->intblock,
+				input->deadline, (*frame)->data + (*frame)->size,
+				wanted)) < 0)
+		{
+			break;
 		}
 
-		ndm_time_get_max(&cache->next_expiration_time);
-	} else {
-		/* remove expired entries only */
-		struct timespec now;
+		(*frame)->size += (size_t) s;
+	}
 
-		ndm_time_get_monotonic(&now);
+	if (!stopped) {
+		__ndm_core_frame_release(frame);
 
-		if (ndm_time_less(&cache->next_expiration_time, &now)) {
-			struct ndm_core_cache_entry_t *e;
-			struct ndm_core_cache_entry_t *n;
+		return false;
+	}
 
-			ndm_time_get_max(&cache->next_expiration_time);
+	/* keep data of a next document in a connection buffer */
+	buffered = (*frame)->size - scanned;
+	memcpy(buffer->start, (*frame)->data + scanned, buffered);
+	buffer->putp += buffered;
+	(*frame)->size = scanned;
 
-			ndm_dlist_foreach_entry_safe(e,
-				struct ndm_core_cache_entry_t,
-				list, &cache->entries, n)
-			{
-				if (ndm_time_less(&e->expiration_time, &now)) {
-					__ndm_core_cache_entry_remove(e);
-				} else
-				if (ndm_time_greater(
-						&cache->next_expiration_time,
-						&e->expiration_time))
-				{
-					cache->next_expiration_time = e->expiration_time;
-				}
-			}
+	if (scanned < capacity) {
+		/* release unused space, a spare byte is kept */
+		struct ndm_core_frame_t *f =
+			realloc(*frame, sizeof(*f) + scanned + 1);
+
+		if (f != NULL) {
+			*frame = f;
 		}
 	}
+
+	return true;
 }
 
-static bool __ndm_core_cache_get(
-		struct ndm_core_cache_t *cache,
-		const uint8_t *request,
-		const size_t request_size,
-		const bool copy_cached_response,
-		bool *response_copied,
-		struct ndm_core_response_t **response)
+/**
+ * Skip a whole binary XML document without decoding it.
+ **/
+
+static bool __ndm_core_skip_xml_children(
+		struct ndm_core_input_t *input)
 {
-	struct ndm_core_cache_entry_t *i;
-	struct ndm_core_cache_entry_t *n;
-	struct ndm_core_cache_entry_t *e = NULL;
-	struct timespec now;
+	struct ndm_core_frame_scanner_t scanner;
 	bool error = false;
+	bool stopped = false;
 
-	ndm_time_get_monotonic(&now);
+	__ndm_core_frame_scanner_init(&scanner);
 
-	ndm_dlist_foreach_entry_safe(i,
-		struct ndm_core_cache_entry_t,
-		list, &cache->entries, n)
-	{
-		if (ndm_time_less(&i->expiration_time, &now)) {
-			/* remove and free an expired entry */
-			__ndm_core_cache_entry_remove(i);
-		} else
-		if (i->request_size == request_size &&
-			memcmp(i->request, request, request_size) == 0)
+	do {
+		uint8_t data;
+		bool has_strings = false;
+
+		if (!__ndm_core_input_get(input, &data, sizeof(data)) ||
+			!__ndm_core_frame_scanner_next(
+				&scanner, data, &has_strings, &stopped))
 		{
-			e = i;
+			error = true;
+		} else
+		if (has_strings) {
+			unsigned int i;
 
-			break;
+			for (i = 0; i < 2 && !error; i++) {
+				ndm_core_size_t size = 0;
+
+				error =
+					!__ndm_core_input_get(input, &size, sizeof(size)) ||
+					!__ndm_core_input_skip(input, ntohl(size));
+			}
 		}
-	}
+	} while (!error && !stopped);
 
-	*response = NULL;
+	return !error;
+}
 
-	if (response_copied != NULL) {
-		*response_copied = false;
-	}
+/**
+ * Core event connection functions.
+ **/
 
-	if (e != NULL) {
-		/* cache hit */
+static void __ndm_core_event_filter_init(
+		struct ndm_core_event_filter_t *filter)
+{
+	filter->entries = NULL;
+	filter->capacity = 0;
+	filter->count = 0;
+	filter->prefix_sizes = NULL;
+	filter->prefix_size_count = 0;
+}
 
-		/* move a found entry to a head of a list */
-		ndm_dlist_remove(&e->list);
-		ndm_dlist_insert_after(&cache->entries, &e->list);
-
-		if (copy_cached_response) {
-			*response = __ndm_core_response_copy(e->response);
-
-			if (*response == NULL) {
-				error = true;
-			}
+static void __ndm_core_event_filter_clear(
+		struct ndm_core_event_filter_t *filter)
+{
+	size_t i;
 
-			if (response_copied != NULL) {
-				*response_copied = (*response != NULL);
-			}
-		} else {
-			/* no real response copy */
-			*response = e->response;
-		}
+	for (i = 0; i < filter->capacity; i++) {
+		free(filter->entries[i]);
 	}
 
-	return !error;
+	free(filter->entries);
+	free(filter->prefix_sizes);
+	__ndm_core_event_filter_init(filter);
 }
 
-static void __ndm_core_cache(
-		struct ndm_core_cache_t *cache,
-		const uint8_t *request,
-		const size_t request_size,
-		const struct ndm_core_response_t *response)
+static inline uint32_t __ndm_core_event_filter_hash(
+		const char *const name,
+		const size_t size)
 {
-	/* there is no check of duplicating entries here due to performance
-	 * reasons; make sure that this function called only
-	 * when __ndm_core_cache_get() failed because of a cache miss */
-
-	/* try to add a new entry */
-	const size_t need_size =
-		__ndm_core_cache_entry_size(request_size, response);
-
-	if (cache->max_size >= need_size) {
-		/* the response can be cached */
-		struct ndm_core_cache_entry_t *e = NULL;
-
-		while (cache->max_size - cache->size < need_size) {
-			__ndm_core_cache_remove_last(cache);
-		}
+	struct ndm_crc32_t crc32 = NDM_CRC32_INITIALIZER;
 
-		e = malloc(sizeof(*e) + request_size);
+	ndm_crc32_update(&crc32, name, size);
 
-		if (e != NULL) {
-			if ((e->response = __ndm_core_response_copy(response)) == NULL) {
-				/* failed to cache */
-				free(e);
-			} else {
-				ndm_dlist_init(&e->list);
-				e->owner = cache;
-				e->request_size = request_size;
-				memcpy(e->request, request, request_size);
+	return ndm_crc32_digest(&crc32);
+}
 
-				ndm_time_get_monotonic(&e->expiration_time);
-				ndm_time_add_msec(&e->expiration_time, cache->ttl_msec);
+static inline bool __ndm_core_event_filter_is_empty(
+		const struct ndm_core_event_filter_t *filter)
+{
+	return filter->count == 0;
+}
 
-				e->owner->size += need_size;
+static struct ndm_core_event_filter_entry_t **__ndm_core_event_filter_slot(
+		struct ndm_core_event_filter_entry_t **entries,
+		const size_t capacity,
+		const uint32_t hash,
+		const char *const name,
+		const size_t size,
+		const bool prefix)
+{
+	/* a capacity is always a power of two and a set is never full */
+	size_t i = hash & (capacity - 1);
 
-				if (ndm_dlist_is_empty(&cache->entries)) {
-					cache->next_expiration_time = e->expiration_time;
-				}
+	while (entries[i] != NULL) {
+		const struct ndm_core_event_filter_entry_t *e = entries[i];
 
-				ndm_dlist_insert_after(&cache->entries, &e->list);
-			}
+		if (e->hash == hash &&
+			e->prefix == prefix &&
+			e->size == size &&
+			memcmp(e->name, name, size) == 0)
+		{
+			break;
 		}
+
+		i = (i + 1) & (capacity - 1);
 	}
-}
 
-/**
- * Core connection functions.
- **/
+	return &entries[i];
+}
 
-struct ndm_core_t *ndm_core_open(
-		const char *const agent,
-		const int cache_ttl_msec,
-		const size_t cache_max_size)
+static bool __ndm_core_event_filter_reserve(
+		struct ndm_core_event_filter_t *filter)
 {
-	struct ndm_core_t *core = malloc(sizeof(*core));
-	const char *current_agent =
-		((agent == NULL) || (*agent == '\0')) ?
-		NDM_CORE_DEFAULT_AGENT_ : agent;
+	const size_t capacity = (filter->capacity == 0) ?
+		NDM_CORE_EVENT_FILTER_INITIAL_CAPACITY_ :
+		filter->capacity*2;
+	struct ndm_core_event_filter_entry_t **entries;
+	size_t i;
+
+	if ((filter->count + 1)*2 <= filter->capacity) {
+		return true;
+	}
 
-	if (core == NULL) {
+	if ((entries = calloc(capacity, sizeof(*entries))) == NULL) {
 		errno = ENOMEM;
-	} else {
-		bool connected = false;
-
-		__ndm_core_buffer_init(
-			&core->buffer,
-			core->buffer_storage,
-			sizeof(core->buffer_storage));
-
-		__ndm_core_cache_init(&core->cache, cache_ttl_msec, cache_max_size);
-		__ndm_core_message_init(&core->last_message);
-
-		if ((core->agent = ndm_string_dup(current_agent)) == NULL) {
-			errno = ENOMEM;
-		} else {
-			if ((core->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
-				/* failed to open a new UNIX stream socket */
-			} else {
-				struct sockaddr_un sa;
-				int len = 0;
-
-				sa.sun_family = AF_UNIX;
-				len = snprintf(sa.sun_path, sizeof(sa.sun_path), "%s",
-					NDM_CORE_SOCKET_);
 
-				if (len < 0 || len >= sizeof(sa.sun_path)) {
-					errno = ENOBUFS;
-					close(core->fd);
-					core->fd = -1;
-				} else {
-					len += (int)offsetof(struct sockaddr_un, sun_path) + 1;
+		return false;
+	}
 
-					if (connect(core->fd,
-						(struct sockaddr *) &sa,
-						(socklen_t)len) != 0) {
-						/* failed to parse a defined core address or connect */
-						close(core->fd);
-						core->fd = -1;
-					} else {
-						connected = true;
-						core->timeout = NDM_CORE_DEFAULT_TIMEOUT;
-						core->response_id = NDM_CORE_RESPONSE_ID_INITIALIZER_;
-					}
-				}
-			}
-		}
+	for (i = 0; i < filter->capacity; i++) {
+		struct ndm_core_event_filter_entry_t *e = filter->entries[i];
 
-		if (!connected) {
-			ndm_core_close(&core);
+		if (e != NULL) {
+			*__ndm_core_event_filter_slot(entries, capacity,
+				e->hash, e->name, e->size, e->prefix) = e;
 		}
 	}
 
-	return core;
+	free(filter->entries);
+	filter->entries = entries;
+	filter->capacity = capacity;
+
+	return true;
 }
 
-bool ndm_core_close(
-		struct ndm_core_t **core)
+static bool __ndm_core_event_filter_add_prefix_size(
+		struct ndm_core_event_filter_t *filter,
+		const size_t size)
 {
-	int n = 0;
+	size_t *prefix_sizes;
+	size_t i = 0;
 
-	if (core != NULL && *core != NULL) {
-		struct ndm_core_t *c = *core;
+	while (i < filter->prefix_size_count && filter->prefix_sizes[i] < size) {
+		++i;
+	}
 
-		if (c->fd >= 0) {
-			if (close(c->fd) != 0 && errno != EINTR) {
-				n = errno;
-			}
-		}
+	if (i < filter->prefix_size_count && filter->prefix_sizes[i] == size) {
+		return true;
+	}
 
-		ndm_core_cache_clear(c, true);
-		free((void *) c->agent);
-		free(c);
-		*core = NULL;
+	if ((prefix_sizes = realloc(filter->prefix_sizes,
+			(filter->prefix_size_count + 1)*sizeof(*prefix_sizes))) == NULL)
+	{
+		errno = ENOMEM;
+
+		return false;
 	}
 
-	return (n == 0) ? true : false;
-}
+	/* prefix sizes are sorted to hash a class name incrementally */
+	memmove(prefix_sizes + i + 1, prefix_sizes + i,
+		(filter->prefix_size_count - i)*sizeof(*prefix_sizes));
+	prefix_sizes[i] = size;
+	filter->prefix_sizes = prefix_sizes;
+	filter->prefix_size_count++;
 
-int ndm_core_fd(
-		const struct ndm_core_t *core)
-{
-	return core->fd;
+	return true;
 }
 
-void ndm_core_set_timeout(
-		struct ndm_core_t *core,
-		const int timeout)
+static bool __ndm_core_event_filter_add(
+		struct ndm_core_event_filter_t *filter,
+		const char *const name,
+		const bool prefix)
 {
-	core->timeout = timeout;
-}
+	const size_t size = strlen(name);
+	const uint32_t hash = __ndm_core_event_filter_hash(name, size);
+	struct ndm_core_event_filter_entry_t **slot;
+	struct ndm_core_event_filter_entry_t *e;
 
-int ndm_core_get_timeout(
-		const struct ndm_core_t *core)
-{
-	return core->timeout;
-}
+	if (!__ndm_core_event_filter_reserve(filter)) {
+		return false;
+	}
 
-const char *ndm_core_agent(
-		const struct ndm_core_t *core)
-{
-	return core->agent;
-}
+	slot = __ndm_core_event_filter_slot(
+		filter->entries, filter->capacity, hash, name, size, prefix);
 
-static inline size_t __ndm_core_request_store_ctrl(
-		uint8_t **p,
-		const uint8_t *end,
-		const ndm_core_ctrl_t ctrl,
-		const enum ndm_xml_node_type_t node_type)
-{
-	size_t size = sizeof(ndm_core_ctrl_t);
+	if (*slot != NULL) {
+		return true;
+	}
 
-	if (p != NULL) {
-		if (*p == NULL || end - *p < size) {
-			size = 0;
-			*p = NULL;
-		} else {
-			*((ndm_core_ctrl_t *) *p) = (ndm_core_ctrl_t)
-				((ctrl << 6) | ((ndm_core_ctrl_t) node_type));
-			(*p)++;
-		}
+	if ((prefix && !__ndm_core_event_filter_add_prefix_size(filter, size)) ||
+		(e = malloc(sizeof(*e) + size)) == NULL)
+	{
+		errno = ENOMEM;
+
+		return false;
 	}
 
-	return size;
+	e->hash = hash;
+	e->prefix = prefix;
+	e->size = size;
+	memcpy(e->name, name, size);
+
+	*slot = e;
+	filter->count++;
+
+	return true;
 }
 
-static inline size_t __ndm_core_request_store_str(
-		uint8_t **p,
-		const uint8_t *end,
-		const char *const str,
-		const size_t str_size)
+static bool __ndm_core_event_filter_matches(
+		struct ndm_core_event_filter_t *filter,
+		const char *const name,
+		const size_t size)
 {
-	size_t size = sizeof(ndm_core_size_t) + str_size;
+	struct ndm_crc32_t crc32 = NDM_CRC32_INITIALIZER;
+	size_t hashed = 0;
+	size_t i;
+
+	if (__ndm_core_event_filter_is_empty(filter) ||
+		*__ndm_core_event_filter_slot(filter->entries, filter->capacity,
+			__ndm_core_event_filter_hash(name, size),
+			name, size, false) != NULL)
+	{
+		return true;
+	}
 
-	if (p != NULL) {
-		if (*p == NULL || end - *p < size) {
-			size = 0;
-			*p = NULL;
-		} else {
-			*((ndm_core_size_t *) (*p)) =
-				(ndm_core_size_t) htonl((uint32_t) str_size);
-			(*p) += sizeof(ndm_core_size_t);
-			memcpy(*p, str, str_size);
-			(*p) += str_size;
+	for (i = 0; i < filter->prefix_size_count; i++) {
+		const size_t prefix_size = filter->prefix_sizes[i];
+
+		if (prefix_size > size) {
+			break;
+		}
+
+		ndm_crc32_update(&crc32, name + hashed, prefix_size - hashed);
+		hashed = prefix_size;
+
+		if (*__ndm_core_event_filter_slot(filter->entries, filter->capacity,
+				ndm_crc32_digest(&crc32), name, prefix_size, true) != NULL)
+		{
+			return true;
 		}
 	}
 
-	return size;
+	return false;
 }
 
-static inline size_t __ndm_core_request_store_base(
-		uint8_t **p,
-		const uint8_t *end,
-		const ndm_core_ctrl_t ctrl,
-		const enum ndm_xml_node_type_t node_type,
-		const char *const name,
-		const size_t name_size,
-		const char *const value,
-		const size_t value_size)
-{
-	return
-		__ndm_core_request_store_ctrl(p, end, ctrl, node_type) +
-		__ndm_core_request_store_str(p, end, name, name_size) +
-		__ndm_core_request_store_str(p, end, value, value_size);
-}
+/**
+ * Find a class of an event which header records are already received
+ * without consuming them, @c false is returned if a class is not
+ * in a buffer yet or a header layout is unusual.
+ **/
 
-static size_t __ndm_core_request_store_node(
-		const struct ndm_xml_node_t *node,
-		const ndm_core_ctrl_t node_ctrl,
-		uint8_t **p,
-		const uint8_t *end,
-		const size_t level)
+static bool __ndm_core_event_peek_string(
+		const uint8_t **p,
+		const uint8_t *const end,
+		const char **s,
+		size_t *size)
 {
-	size_t size = __ndm_core_request_store_base(
-		p, end, node_ctrl, ndm_xml_node_type(node),
-		ndm_xml_node_name(node), ndm_xml_node_name_size(node),
-		ndm_xml_node_value(node), ndm_xml_node_value_size(node));
-	struct ndm_xml_attr_t *attr = ndm_xml_node_first_attr(node, NULL);
-	struct ndm_xml_node_t *child = ndm_xml_node_first_child(node, NULL);
-	struct ndm_xml_node_t *first_child = child;
+	ndm_core_size_t n = 0;
 
-	while (attr != NULL) {
-		size += __ndm_core_request_store_base(
-			p, end, NDM_CORE_CTRL_ATTR_, 0,
-			ndm_xml_attr_name(attr), ndm_xml_attr_name_size(attr),
-			ndm_xml_attr_value(attr), ndm_xml_attr_value_size(attr));
-		attr = ndm_xml_attr_next(attr, NULL);
+	if ((size_t) (end - *p) < sizeof(n)) {
+		return false;
 	}
 
-	while (child != NULL) {
-		size += __ndm_core_request_store_node(child,
-			(ndm_core_ctrl_t) ((child == first_child) ?
-			NDM_CORE_CTRL_NODE_ : NDM_CORE_CTRL_SIBL_),
-			p, end, level + 1);
-		child = ndm_xml_node_next_sibling(child, NULL);
-	}
+	memcpy(&n, *p, sizeof(n));
+	*p += sizeof(n);
+	n = ntohl(n);
 
-	if (first_child != NULL || level == 0) {
-		size += __ndm_core_request_store_ctrl(p, end, NDM_CORE_CTRL_END_, 0);
+	if ((size_t) (end - *p) < n) {
+		return false;
 	}
 
-	return size;
+	*s = (const char *) *p;
+	*size = n;
+	*p += n;
+
+	return true;
 }
 
-static size_t __ndm_core_request_store(
-		const struct ndm_xml_node_t *root,
-		uint8_t *buffer,
-		const size_t buffer_size)
+static bool __ndm_core_event_peek_class(
+		const struct ndm_core_buffer_t *buffer,
+		const char **event_class,
+		size_t *event_class_size)
 {
-	size_t size = 0;
-	uint8_t *start = buffer;
-	uint8_t **p = (start == NULL) ? NULL : &start;
+	const uint8_t *p = buffer->getp;
+	const uint8_t *const end = buffer->putp;
+	size_t ctrl_index = 0;
+	bool event_node = false;
 
-	if (root != NULL) {
-		size = __ndm_core_request_store_node(
-			root, NDM_CORE_CTRL_NODE_,
-			p, start + buffer_size, 0);
+	while (p < end) {
+		ndm_core_ctrl_t ctrl = NDM_CORE_CTRL_END_;
+		enum ndm_xml_node_type_t type = NDM_XML_NODE_TYPE_ELEMENT;
+		const char *name;
+		const char *value;
+		size_t name_size;
+		size_t value_size;
+
+		++ctrl_index;
+
+		if (!__ndm_core_decode_ctrl(*p++, &ctrl, &type) ||
+			ctrl == NDM_CORE_CTRL_END_ ||
+			!__ndm_core_event_peek_string(&p, end, &name, &name_size) ||
+			!__ndm_core_event_peek_string(&p, end, &value, &value_size))
+		{
+			return false;
+		}
+
+		if (!event_node) {
+			if (ctrl_index == 1 &&
+				ctrl == NDM_CORE_CTRL_NODE_ &&
+				type == NDM_XML_NODE_TYPE_DOCUMENT)
+			{
+				continue;
+			}
+
+			if (ctrl != NDM_CORE_CTRL_NODE_ ||
+				type != NDM_XML_NODE_TYPE_ELEMENT ||
+				name_size != sizeof("event") - 1 ||
+				memcmp(name, "event", name_size) != 0)
+			{
+				return false;
+			}
+
+			event_node = true;
+		} else
+		if (ctrl != NDM_CORE_CTRL_ATTR_) {
+			/* no class attribute */
+			return false;
+		} else
+		if (name_size == sizeof("class") - 1 &&
+			memcmp(name, "class", name_size) == 0)
+		{
+			*event_class = value;
+			*event_class_size = value_size;
 
-		if (p != NULL && *p == NULL) {
-			/* internal error */
-			size = 0;
+			return true;
 		}
 	}
 
-	return size;
+	return false;
 }
 
-static struct ndm_core_response_t *__ndm_core_do_request(
-		struct ndm_core_t *core,
-		const enum ndm_core_cache_mode_t cache_mode,
-		const bool copy_cached_response,
-		struct ndm_xml_node_t *request,
-		bool *response_copied)
+struct ndm_core_event_connection_t *ndm_core_event_connection_open(
+		const int timeout)
 {
-	struct timespec intblock;
-	struct timespec deadline;
-	const size_t request_size = __ndm_core_request_store(request, NULL, 0);
-	uint8_t request_static_buffer[NDM_CORE_REQUEST_BINARY_STATIC_SIZE_];
-	uint8_t *buffer = request_static_buffer;
-	struct ndm_core_response_t *response = NULL;
-
-	request_static_buffer[0] = 0;
-	ndm_time_get_monotonic_plus_msec(&intblock, NDM_CORE_INTBLOCK_TIMEOUT_);
-	ndm_time_get_monotonic_plus_msec(&deadline, core->timeout);
+	struct ndm_core_event_connection_t *connection =
+		malloc(sizeof(*connection));
 
-	if (request_size == 0) {
-		/* empty request */
-		errno = EBADMSG;
-	} else
-	if (request_size > sizeof(request_static_buffer) &&
-		(buffer = malloc(request_size)) == NULL)
-	{
+	if (connection == NULL) {
 		errno = ENOMEM;
-	} else
-	if (__ndm_core_request_store(
-			request, buffer, request_size) != request_size)
-	{
-		/* internal error occurred */
-		errno = EILSEQ;
 	} else {
-		/* a request sequence is ready */
+		bool connected = false;
 
-		if (cache_mode == NDM_CORE_MODE_CACHE &&
-			!__ndm_core_cache_get(&core->cache, buffer,
-				request_size, copy_cached_response,
-				response_copied, &response))
+		if ((connection->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
 		{
-			/* failed to copy a response from a cache */
-			errno = ENOMEM;
-		} else
-		if (response == NULL) {
-			/* cache miss or noncached mode */
-			struct ndm_core_buffer_t core_buffer;
+			/* failed to open a new UNIX domain socket */
 
-			__ndm_core_buffer_init(&core_buffer, buffer, request_size);
-			core_buffer.putp = core_buffer.bound;
+		} else {
+			struct sockaddr_un sa;
+			int len = 0;
 
-			if (__ndm_core_buffer_send_all(
-					&core_buffer, core->fd, &intblock, &deadline))
-			{
-				/* the request sequence was sent */
-				if ((response = malloc(sizeof(*response))) == NULL) {
-					errno = ENOMEM;
-				} else {
-					struct ndm_xml_node_t *root = NULL;
-
-					ndm_xml_document_init(&response->doc,
-						response->buffer, sizeof(response->buffer),
-						NDM_CORE_RESPONSE_DYNAMIC_BLOCK_SIZE_);
-
-					if ((root = ndm_xml_document_alloc_root(
-							&response->doc)) == NULL ||
-						!__ndm_core_read_xml_children(
-							core->fd, &core->buffer,
-							&intblock, &deadline, root) ||
-						(response->root = ndm_xml_node_first_child(
-							root, "response")) == NULL)
-					{
-						ndm_core_response_free(&response);
-					} else {
-						response->id = ++core->response_id;
+			sa.sun_family = AF_UNIX;
+			len = snprintf(sa.sun_path, sizeof(sa.sun_path), "%s",
+				NDM_CORE_EVENT_SOCKET_);
 
-						if (cache_mode == NDM_CORE_MODE_CACHE &&
-							!ndm_core_response_is_continued(response))
-						{
-							__ndm_core_cache(&core->cache,
-								buffer, request_size, response);
-						}
+			if (len < 0 || len >= sizeof(sa.sun_path)) {
+				errno = ENOBUFS;
+			} else {
+				len += (int)offsetof(struct sockaddr_un, sun_path) + 1;
 
-						/* this allocated response copy should be freed */
-						if (response_copied != NULL) {
-							*response_copied = true;
-						}
-					}
+				if (connect(connection->fd,
+					(struct sockaddr *) &sa,
+					(socklen_t)len) == 0)
+				{
+					connected = true;
+					connection->timeout = timeout;
+					connection->free_events = NULL;
+					connection->free_event_count = 0;
+					__ndm_core_event_filter_init(&connection->filter);
+					__ndm_core_buffer_init(&connection->buffer,
+						connection->buffer_storage,
+						sizeof(connection->buffer_storage));
 				}
 			}
 		}
 
-		if (response != NULL) {
-			__ndm_core_message_update(&core->last_message, response);
+		if (!connected) {
+			close(connection->fd);
+			free(connection);
+			connection = NULL;
 		}
 	}
 
-	if (response == NULL) {
-		__ndm_core_message_init(&core->last_message);
-	}
-
-	if (buffer != request_static_buffer) {
-		free(buffer);
-	}
-
-	return response;
+	return connection;
 }
 
-static struct ndm_xml_node_t *__ndm_core_request_document_init(
-		struct ndm_xml_document_t *doc,
-		uint8_t *buffer,
-		const size_t buffer_size,
-		const char *const agent)
+bool ndm_core_event_connection_close(
+		struct ndm_core_event_connection_t **connection)
 {
-	struct ndm_xml_node_t *root = NULL;
-	struct ndm_xml_node_t *request_node = NULL;
+	int n = 0;
 
-	ndm_xml_document_init(doc, buffer, buffer_size,
-		NDM_CORE_REQUEST_DYNAMIC_BLOCK_SIZE_);
+	if (connection != NULL && *connection != NULL) {
+		if (close((*connection)->fd) != 0 && errno != EINTR) {
+			n = errno;
+		}
 
-	if ((root = ndm_xml_document_alloc_root(doc)) == NULL ||
-		(request_node = ndm_xml_node_append_child_str(
-			root, "request", NULL)) == NULL ||
-		ndm_xml_node_append_attr_str(request_node, "agent", agent) == NULL)
-	{
-		ndm_xml_document_clear(doc);
-		request_node = NULL;
+		while ((*connection)->free_events != NULL) {
+			struct ndm_core_event_t *event = (*connection)->free_events;
+
+			(*connection)->free_events = event->next;
+			free(event);
+		}
+
+		__ndm_core_event_filter_clear(&(*connection)->filter);
+		free(*connection);
+		*connection = NULL;
 	}
 
-	return request_node;
+	return (n == 0) ? true : false;
 }
 
-bool ndm_core_authenticate(
-		struct ndm_core_t *core,
-		const char *const user,
-		const char *const password,
-		const char *const tag,
-		bool *authenticated)
+int ndm_core_event_connection_fd(
+		const struct ndm_core_event_connection_t *connection)
 {
-	bool done = false;
-	uint8_t request_buffer[NDM_CORE_REQUEST_STATIC_SIZE_];
-	struct ndm_xml_document_t request;
-	struct ndm_xml_node_t *hello_node = NULL;
-	struct ndm_xml_node_t *request_node =
-		__ndm_core_request_document_init(&request,
-			request_buffer, sizeof(request_buffer),
-			core->agent);
+	return connection->fd;
+}
 
-	*authenticated = false;
+bool ndm_core_event_connection_has_events(
+		struct ndm_core_event_connection_t *connection)
+{
+	return !__ndm_core_buffer_is_empty(&connection->buffer);
+}
 
-	if (request_node != NULL &&
-		(hello_node = ndm_xml_node_append_child_str(
-			request_node, "hello", password)) != NULL &&
-		ndm_xml_node_append_attr_str(hello_node, "name", user) != NULL &&
-		ndm_xml_node_append_attr_str(hello_node, "tag", tag) != NULL)
-	{
-		struct ndm_core_response_t *response = __ndm_core_do_request(
-			core, NDM_CORE_MODE_NO_CACHE, true, request_node, NULL);
+static bool __ndm_core_event_parse_raise_time(
+		const char *const value,
+		struct timespec *raise_time)
+{
+	char *end = NULL;
+	const char *milliseconds_value = NULL;
+	const long seconds = strtol(value, &end, 10);
+	long milliseconds = 0;
 
-		if (response != NULL) {
-			const struct ndm_xml_node_t *response_node =
-				ndm_core_response_root(response);
+	if (end == value) {
+		return false;
+	}
 
-			*authenticated =
-				(ndm_xml_node_first_child(response_node, "prompt") != NULL);
+	if (*end == '.') {
+		milliseconds_value = end + 1;
+		milliseconds = strtol(milliseconds_value, &end, 10);
 
-			ndm_core_response_free(&response);
-			done = true;
+		if (end == milliseconds_value) {
+			return false;
 		}
 	}
 
-	ndm_xml_document_clear(&request);
+	if (*end != '\0') {
+		return false;
+	}
 
-	return done;
+	raise_time->tv_sec = (time_t) seconds;
+	raise_time->tv_nsec = milliseconds*NDM_TIME_MSEC;
+
+	return true;
 }
 
-bool ndm_core_find_command(
-		struct ndm_core_t *core,
-		const char *const command,
-		bool* found)
+bool ndm_core_event_connection_filter_add(
+		struct ndm_core_event_connection_t *connection,
+		const char *const event_class,
+		const bool prefix)
 {
-	bool done = false;
-	uint8_t request_buffer[NDM_CORE_REQUEST_STATIC_SIZE_];
-	struct ndm_xml_document_t request;
-	struct ndm_xml_node_t *probe_node = NULL;
-	struct ndm_xml_node_t *request_node =
-		__ndm_core_request_document_init(&request,
-			request_buffer, sizeof(request_buffer),
-			core->agent);
+	if (!prefix && *event_class == '\0') {
+		errno = EINVAL;
 
-	*found = false;
+		return false;
+	}
 
-	if (request_node != NULL &&
-		(probe_node = ndm_xml_node_append_child_str(
-			request_node, "probe", NULL)) != NULL &&
-		ndm_xml_node_append_attr_str(probe_node, "name", command) != NULL)
+	return __ndm_core_event_filter_add(
+		&connection->filter, event_class, prefix);
+}
+
+void ndm_core_event_connection_filter_clear(
+		struct ndm_core_event_connection_t *connection)
+{
+	__ndm_core_event_filter_clear(&connection->filter);
+}
+
+/**
+ * Read a next event to @c event, a document of the event is cleared
+ * and @c skipped is set if the event class does not match a filter.
+ **/
+
+static bool __ndm_core_event_read(
+		struct ndm_core_event_connection_t *connection,
+		struct ndm_core_event_t *event,
+		const struct timespec *intblock,
+		const struct timespec *deadline,
+		bool *skipped)
+{
+	struct ndm_core_input_t input;
+	struct ndm_xml_node_t *root = NULL;
+	struct ndm_xml_attr_t *event_type;
+	struct ndm_xml_attr_t *raise_time;
+	const char *event_class;
+	size_t event_class_size;
+
+	*skipped = false;
+
+	__ndm_core_input_init(&input, &connection->buffer,
+		connection->fd, intblock, deadline);
+
+	ndm_xml_document_init(
+		&event->doc, event->buffer, sizeof(event->buffer),
+		NDM_CORE_EVENT_DYNAMIC_BLOCK_SIZE_);
+
+	if (!__ndm_core_event_filter_is_empty(&connection->filter) &&
+		__ndm_core_event_peek_class(&connection->buffer,
+			&event_class, &event_class_size) &&
+		!__ndm_core_event_filter_matches(&connection->filter,
+			event_class, event_class_size))
 	{
-		struct ndm_core_response_t *response = __ndm_core_do_request(
-			core, NDM_CORE_MODE_NO_CACHE, true, request_node, NULL);
+		/* a filtered out event is skipped without decoding */
+		*skipped = true;
 
-		if (response != NULL) {
-			const struct ndm_xml_node_t *response_node =
-				ndm_core_response_root(response);
-			const struct ndm_xml_node_t *probe_resp_node =
-				ndm_xml_node_first_child(response_node, "probe");
-			struct ndm_xml_attr_t *found_attr = NULL;
+		return __ndm_core_skip_xml_children(&input);
+	}
 
-			if ( probe_resp_node == NULL ||
-				(found_attr = ndm_xml_node_first_attr(
-					probe_resp_node, "found")) == NULL)
-			{
-				errno = EBADMSG;
-			} else {
-				const char *const found_val = ndm_xml_attr_value(found_attr);
+	/* read a whole document with a root node */
 
-				if (strcasecmp(found_val, "yes") == 0) {
-					done = true;
-					*found = true;
-				} else
-				if (strcasecmp(found_val, "no") == 0) {
-					done = true;
-				} else {
-					errno = EBADMSG;
-				}
-			}
+	if ((root = ndm_xml_document_alloc_root(&event->doc)) == NULL ||
+		!__ndm_core_read_xml_children(&input, root))
+	{
+		return false;
+	}
 
-			ndm_core_response_free(&response);
-		}
+	event->root = ndm_xml_node_first_child(
+		ndm_xml_document_root(&event->doc), "event");
+
+	if (event->root == NULL ||
+		(event_type = ndm_xml_node_first_attr(
+			event->root, "class")) == NULL ||
+		*(event->type = ndm_xml_attr_value(event_type)) == '\0' ||
+		(raise_time = ndm_xml_node_first_attr(
+			event->root, "raise_time")) == NULL ||
+		!__ndm_core_event_parse_raise_time(
+			ndm_xml_attr_value(raise_time), &event->raise_time))
+	{
+		errno = EBADMSG;
+
+		return false;
 	}
 
-	ndm_xml_document_clear(&request);
+	if (!__ndm_core_event_filter_matches(&connection->filter,
+			event->type, strlen(event->type)))
+	{
+		/* an event header was not received completely
+		 * to be checked before decoding */
+		ndm_xml_document_clear(&event->doc);
+		*skipped = true;
+	}
 
-	return done;
+	return true;
 }
 
-static struct ndm_core_response_t *__ndm_core_request(
-		struct ndm_core_t *core,
-		const enum ndm_core_request_type_t request_type,
-		const enum ndm_core_cache_mode_t cache_mode,
-		const bool copy_cached_response,
-		bool *response_copied,
-		const char *const command_args[],
-		const char *const command_format,
-		va_list ap)
+struct ndm_core_event_t *ndm_core_event_connection_get(
+		struct ndm_core_event_connection_t *connection)
 {
-	uint8_t request_buffer[NDM_CORE_REQUEST_STATIC_SIZE_];
-	struct ndm_xml_document_t request;
-	struct ndm_xml_node_t *request_node =
-		__ndm_core_request_document_init(&request,
-			request_buffer, sizeof(request_buffer),
-			core->agent);
-	struct ndm_core_response_t *response = NULL;
+	struct ndm_core_event_t *event = malloc(sizeof(*event));
 
-	if (request_node != NULL) {
-		char command_buffer[NDM_CORE_REQUEST_STATIC_COMMAND_BUFFER_SIZE_];
-		char *command = command_buffer;
-		va_list aq;
+	if (event == NULL) {
+		errno = ENOMEM;
+	} else {
+		struct timespec intblock;
+		struct timespec deadline;
+		bool skipped = false;
 
-		va_copy(aq, ap);
-		ndm_vabsprintf(
-			command_buffer, sizeof(command_buffer),
-			&command, command_format, aq);
-		va_end(aq);
+		ndm_time_get_monotonic_plus_msec(
+			&intblock, NDM_CORE_INTBLOCK_TIMEOUT_);
+		ndm_time_get_monotonic_plus_msec(&deadline, connection->timeout);
 
-		if (command != NULL) {
-			if (request_type != NDM_CORE_REQUEST_CONFIG  &&
-				request_type != NDM_CORE_REQUEST_EXECUTE &&
-				request_type != NDM_CORE_REQUEST_PARSE)
+		do {
+			if (!__ndm_core_event_read(connection, event,
+					&intblock, &deadline, &skipped))
 			{
-				errno = EINVAL;
-			} else {
+				ndm_core_event_free(&event);
+			}
+		} while (
+			event != NULL &&
+			skipped &&
+			!__ndm_core_buffer_is_empty(&connection->buffer));
+
+		if (event != NULL && skipped) {
+			ndm_core_event_free(&event);
+			errno = ENOMSG;
+		}
+	}
+
+	return event;
+}
+
+bool ndm_core_event_connection_get_batch(
+		struct ndm_core_event_connection_t *connection,
+		struct ndm_core_event_t *events[],
+		const size_t max_count,
+		size_t *count)
+{
+	struct timespec intblock;
+	struct timespec deadline;
+
+	*count = 0;
+
+	if (max_count == 0) {
+		errno = EINVAL;
+
+		return false;
+	}
+
+	ndm_time_get_monotonic_plus_msec(&intblock, NDM_CORE_INTBLOCK_TIMEOUT_);
+	ndm_time_get_monotonic_plus_msec(&deadline, connection->timeout);
+
+	/**
+	 * The first event may be waited for, all next ones are taken
+	 * only while the connection buffer still has received data.
+	 **/
+
+	do {
+		struct ndm_core_event_t *event = connection->free_events;
+		bool skipped = false;
+
+		if (event != NULL) {
+			connection->free_events = event->next;
+			connection->free_event_count--;
+		} else
+		if ((event = malloc(sizeof(*event))) == NULL) {
+			errno = ENOMEM;
+
+			return false;
+		}
+
+		if (!__ndm_core_event_read(connection, event,
+				&intblock, &deadline, &skipped))
+		{
+			const int error = errno;
+
+			ndm_core_event_connection_put_batch(connection, &event, 1);
+			errno = error;
+
+			return false;
+		}
+
+		if (skipped) {
+			ndm_core_event_connection_put_batch(connection, &event, 1);
+		} else {
+			events[(*count)++] = event;
+		}
+	} while (
+		*count < max_count &&
+		!__ndm_core_buffer_is_empty(&connection->buffer));
+
+	return true;
+}
+
+void ndm_core_event_connection_put_batch(
+		struct ndm_core_event_connection_t *connection,
+		struct ndm_core_event_t *events[],
+		const size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		struct ndm_core_event_t *event = events[i];
+
+		if (event == NULL) {
+			continue;
+		}
+
+		ndm_xml_document_clear(&event->doc);
+
+		if (connection->free_event_count <
+				NDM_CORE_EVENT_FREE_LIST_MAX_SIZE_)
+		{
+			event->next = connection->free_events;
+			connection->free_events = event;
+			connection->free_event_count++;
+		} else {
+			free(event);
+		}
+
+		events[i] = NULL;
+	}
+}
+
+const struct ndm_xml_node_t *ndm_core_event_root(
+		const struct ndm_core_event_t *event)
+{
+	return event->root;
+}
+
+const char *ndm_core_event_type(
+		const struct ndm_core_event_t *event)
+{
+	return event->type;
+}
+
+struct timespec ndm_core_event_raise_time(
+		const struct ndm_core_event_t *event)
+{
+	return event->raise_time;
+}
+
+void ndm_core_event_free(
+		struct ndm_core_event_t **event)
+{
+	if (event != NULL && *event != NULL) {
+		ndm_xml_document_clear(&(*event)->doc);
+		free(*event);
+		*event = NULL;
+	}
+}
+
+/**
+ * Core cache functions.
+ **/
+
+static inline struct ndm_core_response_t *__ndm_core_response_ref(
+		struct ndm_core_response_t *response)
+{
+	__atomic_add_fetch(&response->references, 1, __ATOMIC_RELAXED);
+
+	return response;
+}
+
+static inline size_t __ndm_core_response_size(
+		const struct ndm_core_response_t *response) NDM_ATTR_WUR;
+
+static inline size_t __ndm_core_cache_entry_size(
+		const size_t request_size,
+		const struct ndm_core_response_t *response)
+{
+	return
+		request_size +
+		sizeof(struct ndm_core_cache_entry_t) +
+		__ndm_core_response_size(response);
+}
+
+static inline uint32_t __ndm_core_cache_hash(
+		const uint8_t *request,
+		const size_t request_size)
+{
+	struct ndm_crc32_t crc32 = NDM_CRC32_INITIALIZER;
+
+	ndm_crc32_update(&crc32, request, request_size);
+
+	return ndm_crc32_digest(&crc32);
+}
+
+static inline struct ndm_dlist_entry_t *__ndm_core_cache_bucket(
+		const struct ndm_core_cache_t *cache,
+		const uint32_t hash)
+{
+	/* a bucket count is always a power of two */
+	return &cache->buckets[hash & (cache->bucket_count - 1)];
+}
+
+/**
+ * An expiration min-heap, entries know their heap positions
+ * to be removed from the middle of a heap in a logarithmic time.
+ **/
+
+static inline void __ndm_core_cache_heap_set(
+		struct ndm_core_cache_t *cache,
+		const size_t index,
+		struct ndm_core_cache_entry_t *e)
+{
+	cache->heap[index] = e;
+	e->heap_index = index;
+}
+
+static void __ndm_core_cache_heap_up(
+		struct ndm_core_cache_t *cache,
+		size_t index)
+{
+	struct ndm_core_cache_entry_t *e = cache->heap[index];
+
+	while (index > 0) {
+		const size_t parent = (index - 1) / 2;
+
+		if (!ndm_time_less(&e->expiration_time,
+				&cache->heap[parent]->expiration_time))
+		{
+			break;
+		}
+
+		__ndm_core_cache_heap_set(cache, index, cache->heap[parent]);
+		index = parent;
+	}
+
+	__ndm_core_cache_heap_set(cache, index, e);
+}
+
+static void __ndm_core_cache_heap_down(
+		struct ndm_core_cache_t *cache,
+		size_t index)
+{
+	struct ndm_core_cache_entry_t *e = cache->heap[index];
+
+	for (;;) {
+		size_t child = 2 * index + 1;
+
+		if (child >= cache->count) {
+			break;
+		}
+
+		if (child + 1 < cache->count &&
+			ndm_time_less(
+				&cache->heap[child + 1]->expiration_time,
+				&cache->heap[child]->expiration_time))
+		{
+			++child;
+		}
+
+		if (!ndm_time_less(&cache->heap[child]->expiration_time,
+				&e->expiration_time))
+		{
+			break;
+		}
+
+		__ndm_core_cache_heap_set(cache, index, cache->heap[child]);
+		index = child;
+	}
+
+	__ndm_core_cache_heap_set(cache, index, e);
+}
+
+static void __ndm_core_cache_heap_remove(
+		struct ndm_core_cache_t *cache,
+		struct ndm_core_cache_entry_t *e)
+{
+	const size_t index = e->heap_index;
+	struct ndm_core_cache_entry_t *last = cache->heap[--cache->count];
+
+	if (last != e) {
+		__ndm_core_cache_heap_set(cache, index, last);
+		__ndm_core_cache_heap_up(cache, index);
+		__ndm_core_cache_heap_down(cache, last->heap_index);
+	}
+}
+
+static void __ndm_core_cache_entry_remove(
+		struct ndm_core_cache_entry_t *e)
+{
+	ndm_dlist_remove(&e->list);
+	ndm_dlist_remove(&e->bucket);
+	__ndm_core_cache_heap_remove(e->owner, e);
+	e->owner->size -=
+		__ndm_core_cache_entry_size(e->request_size, e->response);
+	ndm_core_response_free(&e->response);
+	free(e);
+}
+
+static void __ndm_core_cache_init(
+		struct ndm_core_cache_t *cache,
+		const int ttl_msec,
+		const size_t max_size)
+{
+	cache->ttl_msec = ttl_msec;
+	cache->max_size = max_size;
+	cache->size = 0;
+	cache->count = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->evictions = 0;
+	cache->expirations = 0;
+	cache->coalesced = 0;
+	cache->adaptive = false;
+	cache->adaptive_min_size = max_size;
+	cache->adaptive_max_size = max_size;
+	cache->adapt_lookups = 0;
+	cache->adapt_hits = 0;
+	cache->adapt_evictions = 0;
+	cache->policies = NULL;
+	cache->policy_count = 0;
+	ndm_dlist_init(&cache->entries);
+	cache->buckets = NULL;
+	cache->bucket_count = 0;
+	cache->heap = NULL;
+	cache->heap_capacity = 0;
+	cache->compact = false;
+	cache->shared = false;
+	ndm_dlist_init(&cache->flights);
+}
+
+/**
+ * A cache shared by pooled connections is locked, a private
+ * connection cache is used without locking.
+ **/
+
+static inline void __ndm_core_cache_lock(
+		struct ndm_core_cache_t *cache)
+{
+	if (cache->shared) {
+		pthread_mutex_lock(&cache->lock);
+	}
+}
+
+static inline void __ndm_core_cache_unlock(
+		struct ndm_core_cache_t *cache)
+{
+	if (cache->shared) {
+		pthread_mutex_unlock(&cache->lock);
+	}
+}
+
+static inline void __ndm_core_cache_remove_last(
+		struct ndm_core_cache_t *cache)
+{
+	__ndm_core_cache_entry_remove(
+		ndm_dlist_entry(cache->entries.prev,
+			struct ndm_core_cache_entry_t, list));
+}
+
+static void __ndm_core_cache_remove_expired(
+		struct ndm_core_cache_t *cache,
+		const struct timespec *now)
+{
+	while (cache->count > 0 &&
+		ndm_time_less(&cache->heap[0]->expiration_time, now))
+	{
+		__ndm_core_cache_entry_remove(cache->heap[0]);
+		cache->expirations++;
+	}
+}
+
+static void __ndm_core_cache_policies_clear(
+		struct ndm_core_cache_t *cache)
+{
+	size_t i;
+
+	for (i = 0; i < cache->policy_count; i++) {
+		free(cache->policies[i]);
+	}
+
+	free(cache->policies);
+	cache->policies = NULL;
+	cache->policy_count = 0;
+}
+
+static void __ndm_core_cache_destroy(
+		struct ndm_core_cache_t *cache)
+{
+	while (!ndm_dlist_is_empty(&cache->entries)) {
+		__ndm_core_cache_remove_last(cache);
+	}
+
+	__ndm_core_cache_policies_clear(cache);
+
+	free(cache->buckets);
+	free(cache->heap);
+	cache->buckets = NULL;
+	cache->bucket_count = 0;
+	cache->heap = NULL;
+	cache->heap_capacity = 0;
+}
+
+/**
+ * Grow an index to keep a load factor not greater than one.
+ * An old index is kept on a failure, lookups stay correct
+ * with longer bucket chains.
+ **/
+
+static bool __ndm_core_cache_reserve(
+		struct ndm_core_cache_t *cache)
+{
+	const size_t count = cache->count + 1;
+
+	if (count > cache->heap_capacity) {
+		const size_t capacity = (cache->heap_capacity == 0) ?
+			NDM_CORE_CACHE_INITIAL_HEAP_CAPACITY_ :
+			cache->heap_capacity * 2;
+		struct ndm_core_cache_entry_t **heap =
+			realloc(cache->heap, capacity * sizeof(*heap));
+
+		if (heap == NULL) {
+			errno = ENOMEM;
+
+			return false;
+		}
+
+		cache->heap = heap;
+		cache->heap_capacity = capacity;
+	}
+
+	if (count > cache->bucket_count) {
+		const size_t bucket_count = (cache->bucket_count == 0) ?
+			NDM_CORE_CACHE_INITIAL_BUCKET_COUNT_ :
+			cache->bucket_count * 2;
+		struct ndm_dlist_entry_t *buckets =
+			malloc(bucket_count * sizeof(*buckets));
+
+		if (buckets == NULL) {
+			if (cache->buckets == NULL) {
+				errno = ENOMEM;
+
+				return false;
+			}
+		} else {
+			struct ndm_core_cache_entry_t *e;
+
+			for (size_t i = 0; i < bucket_count; i++) {
+				ndm_dlist_init(&buckets[i]);
+			}
+
+			free(cache->buckets);
+			cache->buckets = buckets;
+			cache->bucket_count = bucket_count;
+
+			ndm_dlist_foreach_entry(e,
+				struct ndm_core_cache_entry_t,
+				list, &cache->entries)
+			{
+				ndm_dlist_init(&e->bucket);
+				ndm_dlist_insert_after(
+					__ndm_core_cache_bucket(cache, e->hash), &e->bucket);
+			}
+		}
+	}
+
+	return true;
+}
+
+static void __ndm_core_cache_set_max_size(
+		struct ndm_core_cache_t *cache,
+		const size_t max_size)
+{
+	cache->max_size = max_size;
+
+	while (cache->size > cache->max_size) {
+		__ndm_core_cache_remove_last(cache);
+		cache->evictions++;
+	}
+}
+
+/**
+ * An adaptive cache grows while entries are evicted and a hit ratio
+ * is low, and shrinks while a half of it is unused.
+ **/
+
+static void __ndm_core_cache_adapt(
+		struct ndm_core_cache_t *cache)
+{
+	const uint64_t lookups =
+		cache->hits + cache->misses - cache->adapt_lookups;
+	const uint64_t hits = cache->hits - cache->adapt_hits;
+	const uint64_t evictions = cache->evictions - cache->adapt_evictions;
+	size_t max_size = cache->max_size;
+
+	if (evictions > 0 &&
+		hits*100 < lookups*NDM_CORE_CACHE_ADAPT_HIT_RATIO_PERCENT_)
+	{
+		max_size = (max_size > cache->adaptive_max_size/2) ?
+			cache->adaptive_max_size : max_size*2;
+	} else
+	if (evictions == 0 && cache->size < max_size/2) {
+		max_size = (max_size/2 < cache->adaptive_min_size) ?
+			cache->adaptive_min_size : max_size/2;
+	}
+
+	cache->adapt_lookups = cache->hits + cache->misses;
+	cache->adapt_hits = cache->hits;
+	cache->adapt_evictions = cache->evictions;
+
+	if (max_size != cache->max_size) {
+		__ndm_core_cache_set_max_size(cache, max_size);
+		cache->adapt_evictions = cache->evictions;
+	}
+}
+
+void ndm_core_cache_clear(
+		struct ndm_core_t *core,
+		const bool remove_all)
+{
+	struct ndm_core_cache_t *cache = core->cache;
+
+	__ndm_core_cache_lock(cache);
+
+	if (remove_all) {
+		while (!ndm_dlist_is_empty(&cache->entries)) {
+			__ndm_core_cache_remove_last(cache);
+		}
+	} else {
+		/* remove expired entries only */
+		struct timespec now;
+
+		ndm_time_get_monotonic(&now);
+		__ndm_core_cache_remove_expired(cache, &now);
+	}
+
+	__ndm_core_cache_unlock(cache);
+}
+
+void ndm_core_cache_get_stats(
+		struct ndm_core_t *core,
+		struct ndm_core_cache_stats_t *stats)
+{
+	struct ndm_core_cache_t *cache = core->cache;
+
+	__ndm_core_cache_lock(cache);
+
+	stats->hits = cache->hits;
+	stats->misses = cache->misses;
+	stats->evictions = cache->evictions;
+	stats->expirations = cache->expirations;
+	stats->coalesced = cache->coalesced;
+	stats->count = cache->count;
+	stats->size = cache->size;
+	stats->max_size = cache->max_size;
+	stats->ttl_msec = cache->ttl_msec;
+
+	__ndm_core_cache_unlock(cache);
+}
+
+void ndm_core_cache_clear_stats(
+		struct ndm_core_t *core)
+{
+	struct ndm_core_cache_t *cache = core->cache;
+	struct ndm_core_cache_entry_t *e;
+
+	__ndm_core_cache_lock(cache);
+
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->evictions = 0;
+	cache->expirations = 0;
+	cache->coalesced = 0;
+	cache->adapt_lookups = 0;
+	cache->adapt_hits = 0;
+	cache->adapt_evictions = 0;
+
+	ndm_dlist_foreach_entry(e,
+		struct ndm_core_cache_entry_t,
+		list, &cache->entries)
+	{
+		e->hits = 0;
+	}
+
+	__ndm_core_cache_unlock(cache);
+}
+
+void ndm_core_cache_foreach(
+		struct ndm_core_t *core,
+		ndm_core_cache_entry_cb_t callback,
+		void *user_data)
+{
+	struct ndm_core_cache_t *cache = core->cache;
+	struct ndm_core_cache_entry_t *e;
+
+	__ndm_core_cache_lock(cache);
+
+	ndm_dlist_foreach_entry(e,
+		struct ndm_core_cache_entry_t,
+		list, &cache->entries)
+	{
+		callback(user_data, e->response, e->hits,
+			__ndm_core_cache_entry_size(e->request_size, e->response));
+	}
+
+	__ndm_core_cache_unlock(cache);
+}
+
+void ndm_core_cache_set_max_size(
+		struct ndm_core_t *core,
+		const size_t max_size)
+{
+	struct ndm_core_cache_t *cache = core->cache;
+
+	__ndm_core_cache_lock(cache);
+	__ndm_core_cache_set_max_size(cache, max_size);
+	__ndm_core_cache_unlock(cache);
+}
+
+void ndm_core_cache_set_ttl(
+		struct ndm_core_t *core,
+		const int ttl_msec)
+{
+	struct ndm_core_cache_t *cache = core->cache;
+	size_t i;
+
+	__ndm_core_cache_lock(cache);
+
+	/* entries cached with a policy lifetime are not shifted,
+	 * so a heap is rebuilt */
+	for (i = 0; i < cache->count; i++) {
+		struct ndm_core_cache_entry_t *e = cache->heap[i];
+
+		if (e->default_ttl) {
+			ndm_time_sub_msec(&e->expiration_time, cache->ttl_msec);
+			ndm_time_add_msec(&e->expiration_time, ttl_msec);
+		}
+	}
+
+	for (i = cache->count / 2; i > 0; i--) {
+		__ndm_core_cache_heap_down(cache, i - 1);
+	}
+
+	cache->ttl_msec = ttl_msec;
+
+	__ndm_core_cache_unlock(cache);
+}
+
+void ndm_core_cache_set_adaptive(
+		struct ndm_core_t *core,
+		const bool adaptive,
+		const size_t min_size,
+		const size_t max_size)
+{
+	struct ndm_core_cache_t *cache = core->cache;
+
+	__ndm_core_cache_lock(cache);
+
+	cache->adaptive = adaptive;
+
+	if (adaptive) {
+		cache->adaptive_min_size = min_size;
+		cache->adaptive_max_size = (max_size < min_size) ? min_size : max_size;
+		cache->adapt_lookups = cache->hits + cache->misses;
+		cache->adapt_hits = cache->hits;
+		cache->adapt_evictions = cache->evictions;
+
+		if (cache->max_size < cache->adaptive_min_size) {
+			cache->max_size = cache->adaptive_min_size;
+		} else
+		if (cache->max_size > cache->adaptive_max_size) {
+			__ndm_core_cache_set_max_size(cache, cache->adaptive_max_size);
+		}
+	}
+
+	__ndm_core_cache_unlock(cache);
+}
+
+void ndm_core_cache_set_compact(
+		struct ndm_core_t *core,
+		const bool compact)
+{
+	__atomic_store_n(&core->cache->compact, compact, __ATOMIC_RELAXED);
+}
+
+bool ndm_core_cache_set_policy(
+		struct ndm_core_t *core,
+		const char *const prefix,
+		const bool cacheable,
+		const int ttl_msec)
+{
+	struct ndm_core_cache_t *cache = core->cache;
+	const size_t prefix_size = strlen(prefix);
+	struct ndm_core_cache_policy_t *policy =
+		malloc(sizeof(*policy) + prefix_size + 1);
+	struct ndm_core_cache_policy_t **policies = NULL;
+	size_t i;
+
+	if (policy == NULL) {
+		errno = ENOMEM;
+
+		return false;
+	}
+
+	policy->ttl_msec = ttl_msec;
+	policy->cacheable = cacheable;
+	policy->prefix_size = prefix_size;
+	memcpy(policy->prefix, prefix, prefix_size + 1);
+
+	__ndm_core_cache_lock(cache);
+
+	for (i = 0; i < cache->policy_count; i++) {
+		if (cache->policies[i]->prefix_size == prefix_size &&
+			memcmp(cache->policies[i]->prefix, prefix, prefix_size) == 0)
+		{
+			/* replace an existing policy */
+			free(cache->policies[i]);
+			cache->policies[i] = policy;
+			__ndm_core_cache_unlock(cache);
+
+			return true;
+		}
+	}
+
+	policies = realloc(cache->policies,
+		(cache->policy_count + 1) * sizeof(*policies));
+
+	if (policies == NULL) {
+		__ndm_core_cache_unlock(cache);
+		free(policy);
+		errno = ENOMEM;
+
+		return false;
+	}
+
+	/* keep a descending prefix length order */
+	i = cache->policy_count;
+
+	while (i > 0 && policies[i - 1]->prefix_size < prefix_size) {
+		policies[i] = policies[i - 1];
+		--i;
+	}
+
+	policies[i] = policy;
+	cache->policies = policies;
+	cache->policy_count++;
+
+	__ndm_core_cache_unlock(cache);
+
+	return true;
+}
+
+void ndm_core_cache_clear_policies(
+		struct ndm_core_t *core)
+{
+	struct ndm_core_cache_t *cache = core->cache;
+
+	__ndm_core_cache_lock(cache);
+	__ndm_core_cache_policies_clear(cache);
+	__ndm_core_cache_unlock(cache);
+}
+
+static struct ndm_core_cache_entry_t *__ndm_core_cache_find(
+		struct ndm_core_cache_t *cache,
+		const uint8_t *request,
+		const size_t request_size)
+{
+	if (cache->count > 0) {
+		const uint32_t hash = __ndm_core_cache_hash(request, request_size);
+		struct ndm_core_cache_entry_t *e;
+
+		ndm_dlist_foreach_entry(e,
+			struct ndm_core_cache_entry_t,
+			bucket, __ndm_core_cache_bucket(cache, hash))
+		{
+			if (e->hash == hash &&
+				e->request_size == request_size &&
+				memcmp(e->request, request, request_size) == 0)
+			{
+				return e;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static void __ndm_core_cache_get(
+		struct ndm_core_cache_t *cache,
+		const uint8_t *request,
+		const size_t request_size,
+		const bool copy_cached_response,
+		bool *response_copied,
+		struct ndm_core_response_t **response)
+{
+	struct ndm_core_cache_entry_t *e =
+		__ndm_core_cache_find(cache, request, request_size);
+
+	*response = NULL;
+
+	if (e != NULL) {
+		struct timespec now;
+
+		ndm_time_get_monotonic(&now);
+
+		if (ndm_time_less(&e->expiration_time, &now)) {
+			/* other expired entries are removed on insertion */
+			__ndm_core_cache_entry_remove(e);
+			cache->expirations++;
+			e = NULL;
+		}
+	}
+
+	if (response_copied != NULL) {
+		*response_copied = false;
+	}
+
+	if (e == NULL) {
+		cache->misses++;
+	} else {
+		/* cache hit */
+		cache->hits++;
+		e->hits++;
+
+		/* move a found entry to a head of a list */
+		ndm_dlist_remove(&e->list);
+		ndm_dlist_insert_after(&cache->entries, &e->list);
+
+		if (copy_cached_response || cache->shared) {
+			/* a cached response is immutable, share it;
+			 * a shared cache entry may be removed by another thread,
+			 * so a reference is always taken */
+			*response = __ndm_core_response_ref(e->response);
+
+			if (response_copied != NULL) {
+				*response_copied = true;
+			}
+		} else {
+			/* no real response copy */
+			*response = e->response;
+		}
+	}
+
+	if (cache->adaptive &&
+		cache->hits + cache->misses - cache->adapt_lookups >=
+			NDM_CORE_CACHE_ADAPT_PERIOD_)
+	{
+		__ndm_core_cache_adapt(cache);
+	}
+}
+
+/**
+ * A cached request key is a binary request sequence:
+ * <request agent="..."> with a first <parse> child holding
+ * a command as a value, or a <command> or <config> child
+ * with a command in a "name" attribute.
+ **/
+
+static bool __ndm_core_cache_key_str(
+		const uint8_t **p,
+		const uint8_t *const end,
+		const char **str,
+		size_t *str_size)
+{
+	ndm_core_size_t size;
+
+	if ((size_t) (end - *p) < sizeof(size)) {
+		return false;
+	}
+
+	/* a size field is not aligned in a binary stream */
+	memcpy(&size, *p, sizeof(size));
+	*p += sizeof(size);
+	size = (ndm_core_size_t) ntohl(size);
+
+	if ((size_t) (end - *p) < size) {
+		return false;
+	}
+
+	*str = (const char *) *p;
+	*str_size = size;
+	*p += size;
+
+	return true;
+}
+
+static bool __ndm_core_cache_key_entry(
+		const uint8_t **p,
+		const uint8_t *const end,
+		ndm_core_ctrl_t *ctrl,
+		const char **name,
+		size_t *name_size,
+		const char **value,
+		size_t *value_size)
+{
+	if (*p >= end) {
+		return false;
+	}
+
+	*ctrl = (ndm_core_ctrl_t) (**p >> 6);
+	++(*p);
+
+	return
+		*ctrl == NDM_CORE_CTRL_END_ || (
+		__ndm_core_cache_key_str(p, end, name, name_size) &&
+		__ndm_core_cache_key_str(p, end, value, value_size));
+}
+
+static bool __ndm_core_cache_key_command(
+		const uint8_t *request,
+		const size_t request_size,
+		const char **command,
+		size_t *command_size)
+{
+	const uint8_t *p = request;
+	const uint8_t *const end = request + request_size;
+	ndm_core_ctrl_t ctrl;
+	const char *name;
+	size_t name_size;
+	const char *value;
+	size_t value_size;
+
+	/* the <request> node */
+	if (!__ndm_core_cache_key_entry(&p, end, &ctrl,
+			&name, &name_size, &value, &value_size) ||
+		ctrl != NDM_CORE_CTRL_NODE_)
+	{
+		return false;
+	}
+
+	/* skip request attributes up to the first child */
+	do {
+		if (!__ndm_core_cache_key_entry(&p, end, &ctrl,
+				&name, &name_size, &value, &value_size))
+		{
+			return false;
+		}
+	} while (ctrl == NDM_CORE_CTRL_ATTR_);
+
+	if (ctrl != NDM_CORE_CTRL_NODE_) {
+		return false;
+	}
+
+	if (name_size == sizeof("parse") - 1 &&
+		memcmp(name, "parse", name_size) == 0)
+	{
+		*command = value;
+		*command_size = value_size;
+
+		return true;
+	}
+
+	while (__ndm_core_cache_key_entry(&p, end, &ctrl,
+			&name, &name_size, &value, &value_size) &&
+		ctrl == NDM_CORE_CTRL_ATTR_)
+	{
+		if (name_size == sizeof(NDM_CORE_REQUEST_ATTR_NAME_) - 1 &&
+			memcmp(name, NDM_CORE_REQUEST_ATTR_NAME_, name_size) == 0)
+		{
+			*command = value;
+			*command_size = value_size;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Policies are sorted by a descending prefix length,
+ * so the first matching policy is the most specific one.
+ **/
+
+static const struct ndm_core_cache_policy_t *__ndm_core_cache_policy(
+		const struct ndm_core_cache_t *cache,
+		const uint8_t *request,
+		const size_t request_size)
+{
+	const char *command;
+	size_t command_size;
+	size_t i;
+
+	if (cache->policy_count == 0 ||
+		!__ndm_core_cache_key_command(request, request_size,
+			&command, &command_size))
+	{
+		return NULL;
+	}
+
+	for (i = 0; i < cache->policy_count; i++) {
+		const struct ndm_core_cache_policy_t *policy = cache->policies[i];
+
+		/* a prefix matches whole command words only */
+		if (policy->prefix_size <= command_size &&
+			memcmp(policy->prefix, command, policy->prefix_size) == 0 &&
+			(policy->prefix_size == command_size ||
+			 policy->prefix_size == 0 ||
+			 command[policy->prefix_size] == ' ' ||
+			 policy->prefix[policy->prefix_size - 1] == ' '))
+		{
+			return policy;
+		}
+	}
+
+	return NULL;
+}
+
+static void __ndm_core_cache(
+		struct ndm_core_cache_t *cache,
+		const uint8_t *request,
+		const size_t request_size,
+		struct ndm_core_response_t *response)
+{
+	/* there is no check of duplicating entries here due to performance
+	 * reasons; make sure that this function called only
+	 * when __ndm_core_cache_get() failed because of a cache miss */
+
+	/* try to add a new entry */
+	const size_t need_size =
+		__ndm_core_cache_entry_size(request_size, response);
+	const struct ndm_core_cache_policy_t *policy =
+		__ndm_core_cache_policy(cache, request, request_size);
+	struct timespec now;
+
+	if (policy != NULL && !policy->cacheable) {
+		return;
+	}
+
+	/* expired entries are freed before live ones are evicted */
+	ndm_time_get_monotonic(&now);
+	__ndm_core_cache_remove_expired(cache, &now);
+
+	if (cache->max_size >= need_size) {
+		/* the response can be cached */
+		struct ndm_core_cache_entry_t *e = NULL;
+
+		while (cache->max_size - cache->size < need_size) {
+			__ndm_core_cache_remove_last(cache);
+			cache->evictions++;
+		}
+
+		if (__ndm_core_cache_reserve(cache) &&
+			(e = malloc(sizeof(*e) + request_size)) != NULL)
+		{
+			e->response = __ndm_core_response_ref(response);
+
+			ndm_dlist_init(&e->list);
+			ndm_dlist_init(&e->bucket);
+			e->owner = cache;
+			e->hits = 0;
+			e->default_ttl = (policy == NULL);
+			e->request_size = request_size;
+			memcpy(e->request, request, request_size);
+			e->hash = __ndm_core_cache_hash(request, request_size);
+
+			e->expiration_time = now;
+			ndm_time_add_msec(&e->expiration_time,
+				(policy == NULL) ? cache->ttl_msec : policy->ttl_msec);
+
+			e->owner->size += need_size;
+
+			ndm_dlist_insert_after(&cache->entries, &e->list);
+			ndm_dlist_insert_after(
+				__ndm_core_cache_bucket(cache, e->hash), &e->bucket);
+			cache->heap[cache->count] = e;
+			__ndm_core_cache_heap_up(cache, cache->count++);
+		}
+	}
+}
+
+static struct ndm_core_response_t *__ndm_core_response_compact(
+		const struct ndm_core_response_t *response) NDM_ATTR_WUR;
+
+/**
+ * A compacting cache stores a compact copy of a response,
+ * it is made before a shared cache is locked. An original
+ * response is cached if a copy can not be made.
+ **/
+
+static struct ndm_core_response_t *__ndm_core_cache_compact(
+		struct ndm_core_cache_t *cache,
+		const uint8_t *request,
+		const size_t request_size,
+		const struct ndm_core_response_t *response)
+{
+	const struct ndm_core_cache_policy_t *policy;
+	bool cacheable;
+
+	if (response == NULL ||
+		!__atomic_load_n(&cache->compact, __ATOMIC_RELAXED))
+	{
+		return NULL;
+	}
+
+	__ndm_core_cache_lock(cache);
+	policy = __ndm_core_cache_policy(cache, request, request_size);
+	cacheable = (policy == NULL || policy->cacheable);
+	__ndm_core_cache_unlock(cache);
+
+	return cacheable ? __ndm_core_response_compact(response) : NULL;
+}
+
+/**
+ * Pipelined or concurrent misses of the same request
+ * are cached only once.
+ **/
+
+static void __ndm_core_cache_store(
+		struct ndm_core_cache_t *cache,
+		const uint8_t *request,
+		const size_t request_size,
+		struct ndm_core_response_t *response)
+{
+	struct ndm_core_response_t *compact =
+		__ndm_core_cache_compact(cache, request, request_size, response);
+
+	__ndm_core_cache_lock(cache);
+
+	if (__ndm_core_cache_find(cache, request, request_size) == NULL) {
+		__ndm_core_cache(cache, request, request_size,
+			(compact == NULL) ? response : compact);
+	}
+
+	__ndm_core_cache_unlock(cache);
+	ndm_core_response_free(&compact);
+}
+
+/**
+ * Coalesced request waiters use monotonic request deadlines.
+ **/
+
+#ifdef __MACH__
+
+/* no pthread_condattr_setclock(), a deadline is converted on every wait */
+static int __ndm_core_cond_init_monotonic(
+		pthread_cond_t *cond)
+{
+	return pthread_cond_init(cond, NULL);
+}
+
+static int __ndm_core_cond_timedwait_monotonic(
+		pthread_cond_t *cond,
+		pthread_mutex_t *mutex,
+		const struct timespec *deadline)
+{
+	struct timespec now;
+	struct timespec realtime_deadline = *deadline;
+
+	ndm_time_get_monotonic(&now);
+	ndm_time_sub(&realtime_deadline, &now);
+	ndm_time_get(&now);
+	ndm_time_add(&realtime_deadline, &now);
+
+	return pthread_cond_timedwait(cond, mutex, &realtime_deadline);
+}
+
+#else  // __MACH__
+
+static int __ndm_core_cond_init_monotonic(
+		pthread_cond_t *cond)
+{
+	pthread_condattr_t attr;
+	int error = pthread_condattr_init(&attr);
+
+	if (error == 0) {
+		if ((error = pthread_condattr_setclock(
+				&attr, CLOCK_MONOTONIC)) == 0)
+		{
+			error = pthread_cond_init(cond, &attr);
+		}
+
+		pthread_condattr_destroy(&attr);
+	}
+
+	return error;
+}
+
+static int __ndm_core_cond_timedwait_monotonic(
+		pthread_cond_t *cond,
+		pthread_mutex_t *mutex,
+		const struct timespec *deadline)
+{
+	return pthread_cond_timedwait(cond, mutex, deadline);
+}
+
+#endif // __MACH__
+
+/**
+ * Concurrent misses of the same request on a shared cache are
+ * coalesced: a first caller exchanges with the core while others
+ * wait for its response.
+ **/
+
+static struct ndm_core_cache_flight_t *__ndm_core_cache_flight_find(
+		struct ndm_core_cache_t *cache,
+		const uint8_t *request,
+		const size_t request_size,
+		const uint32_t hash)
+{
+	struct ndm_core_cache_flight_t *f;
+
+	ndm_dlist_foreach_entry(f,
+		struct ndm_core_cache_flight_t,
+		list, &cache->flights)
+	{
+		if (f->hash == hash &&
+			f->request_size == request_size &&
+			memcmp(f->request, request, request_size) == 0)
+		{
+			return f;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Called with a locked cache after a cache miss. Returns @c true
+ * if a response of another in-flight request is taken, @c false
+ * if a caller should send a request itself; @a flight is set
+ * to a new in-flight request to be finished by the caller.
+ **/
+
+static bool __ndm_core_cache_flight_join(
+		struct ndm_core_cache_t *cache,
+		const uint8_t *request,
+		const size_t request_size,
+		const struct timespec *deadline,
+		struct ndm_core_response_t **response,
+		struct ndm_core_cache_flight_t **flight)
+{
+	const uint32_t hash = __ndm_core_cache_hash(request, request_size);
+	struct ndm_core_cache_flight_t *f =
+		__ndm_core_cache_flight_find(cache, request, request_size, hash);
+	int error = 0;
+
+	*flight = NULL;
+
+	if (f == NULL) {
+		if ((f = malloc(sizeof(*f) + request_size)) != NULL) {
+			/* no coalescing on an allocation failure */
+			ndm_dlist_init(&f->list);
+			f->response = NULL;
+			f->error = 0;
+			f->done = false;
+			f->waiters = 0;
+			f->hash = hash;
+			f->request_size = request_size;
+			memcpy(f->request, request, request_size);
+			ndm_dlist_insert_before(&cache->flights, &f->list);
+			*flight = f;
+		}
+
+		return false;
+	}
+
+	f->waiters++;
+
+	while (!f->done && error == 0) {
+		error = __ndm_core_cond_timedwait_monotonic(
+			&cache->flight_done, &cache->lock, deadline);
+	}
+
+	if (!f->done) {
+		*response = NULL;
+		errno = error;
+	} else
+	if (f->response == NULL) {
+		*response = NULL;
+		errno = f->error;
+	} else {
+		*response = __ndm_core_response_ref(f->response);
+		cache->coalesced++;
+	}
+
+	if (--f->waiters == 0 && f->done) {
+		ndm_core_response_free(&f->response);
+		free(f);
+	}
+
+	return true;
+}
+
+static void __ndm_core_cache_flight_finish(
+		struct ndm_core_cache_t *cache,
+		struct ndm_core_cache_flight_t *flight,
+		struct ndm_core_response_t *response,
+		const bool store)
+{
+	const int error = errno;
+	struct ndm_core_response_t *compact = !store ? NULL :
+		__ndm_core_cache_compact(cache,
+			flight->request, flight->request_size, response);
+
+	__ndm_core_cache_lock(cache);
+
+	if (store &&
+		__ndm_core_cache_find(cache,
+			flight->request, flight->request_size) == NULL)
+	{
+		__ndm_core_cache(cache,
+			flight->request, flight->request_size,
+			(compact == NULL) ? response : compact);
+	}
+
+	ndm_dlist_remove(&flight->list);
+	flight->done = true;
+
+	if (flight->waiters == 0) {
+		free(flight);
+	} else {
+		flight->response = (response == NULL) ?
+			NULL : __ndm_core_response_ref(response);
+		flight->error = (error == 0) ? EBADMSG : error;
+		pthread_cond_broadcast(&cache->flight_done);
+	}
+
+	__ndm_core_cache_unlock(cache);
+	ndm_core_response_free(&compact);
+
+	errno = error;
+}
+
+/**
+ * Core request pipeline functions.
+ **/
+
+static void __ndm_core_pipeline_init(
+		struct ndm_core_pipeline_t *pipeline)
+{
+	pipeline->data = NULL;
+	pipeline->size = 0;
+	pipeline->capacity = 0;
+	pipeline->consumed = 0;
+	pipeline->scanned = 0;
+	__ndm_core_frame_scanner_init(&pipeline->scanner);
+	ndm_dlist_init(&pipeline->sent);
+	ndm_dlist_init(&pipeline->completed);
+}
+
+static void __ndm_core_pending_free(
+		struct ndm_core_pending_t *pending)
+{
+	ndm_dlist_remove(&pending->list);
+	ndm_core_response_free(&pending->response);
+	free(pending);
+}
+
+static void __ndm_core_pipeline_destroy(
+		struct ndm_core_pipeline_t *pipeline)
+{
+	while (!ndm_dlist_is_empty(&pipeline->sent)) {
+		__ndm_core_pending_free(
+			ndm_dlist_entry(pipeline->sent.next,
+				struct ndm_core_pending_t, list));
+	}
+
+	while (!ndm_dlist_is_empty(&pipeline->completed)) {
+		__ndm_core_pending_free(
+			ndm_dlist_entry(pipeline->completed.next,
+				struct ndm_core_pending_t, list));
+	}
+
+	free(pipeline->data);
+	__ndm_core_pipeline_init(pipeline);
+}
+
+/**
+ * Core connection functions.
+ **/
+
+static struct ndm_core_t *__ndm_core_open(
+		const char *const agent,
+		const int cache_ttl_msec,
+		const size_t cache_max_size,
+		struct ndm_core_cache_t *shared_cache)
+{
+	struct ndm_core_t *core = malloc(sizeof(*core));
+	const char *current_agent =
+		((agent == NULL) || (*agent == '\0')) ?
+		NDM_CORE_DEFAULT_AGENT_ : agent;
+
+	if (core == NULL) {
+		errno = ENOMEM;
+	} else {
+		bool connected = false;
+
+		__ndm_core_buffer_init(
+			&core->buffer,
+			core->buffer_storage,
+			sizeof(core->buffer_storage));
+
+		core->fd = -1;
+		core->request_buffer = NULL;
+		core->request_buffer_size = 0;
+		core->zero_copy = false;
+		core->stats_enabled = false;
+		memset(&core->stats, 0, sizeof(core->stats));
+		core->request_hook = NULL;
+		core->request_hook_data = NULL;
+		core->pool = NULL;
+		core->pool_slot = 0;
+
+		if (shared_cache == NULL) {
+			__ndm_core_cache_init(&core->cache_storage,
+				cache_ttl_msec, cache_max_size);
+			core->cache = &core->cache_storage;
+		} else {
+			/* a private cache of a pooled connection is never used */
+			core->cache = shared_cache;
+		}
+
+		__ndm_core_pipeline_init(&core->pipeline);
+		__ndm_core_message_init(&core->last_message);
+
+		if ((core->agent = ndm_string_dup(current_agent)) == NULL) {
+			errno = ENOMEM;
+		} else {
+			if ((core->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+				/* failed to open a new UNIX stream socket */
+			} else {
+				struct sockaddr_un sa;
+				int len = 0;
+
+				sa.sun_family = AF_UNIX;
+				len = snprintf(sa.sun_path, sizeof(sa.sun_path), "%s",
+					NDM_CORE_SOCKET_);
+
+				if (len < 0 || len >= sizeof(sa.sun_path)) {
+					errno = ENOBUFS;
+					close(core->fd);
+					core->fd = -1;
+				} else {
+					len += (int)offsetof(struct sockaddr_un, sun_path) + 1;
+
+					if (connect(core->fd,
+						(struct sockaddr *) &sa,
+						(socklen_t)len) != 0) {
+						/* failed to parse a defined core address or connect */
+						close(core->fd);
+						core->fd = -1;
+					} else {
+						connected = true;
+						core->timeout = NDM_CORE_DEFAULT_TIMEOUT;
+						core->response_id = NDM_CORE_RESPONSE_ID_INITIALIZER_;
+					}
+				}
+			}
+		}
+
+		if (!connected) {
+			ndm_core_close(&core);
+		}
+	}
+
+	return core;
+}
+
+struct ndm_core_t *ndm_core_open(
+		const char *const agent,
+		const int cache_ttl_msec,
+		const size_t cache_max_size)
+{
+	return __ndm_core_open(agent, cache_ttl_msec, cache_max_size, NULL);
+}
+
+bool ndm_core_close(
+		struct ndm_core_t **core)
+{
+	int n = 0;
+
+	if (core != NULL && *core != NULL && (*core)->pool != NULL) {
+		/* a pooled connection is closed by ndm_core_pool_close() */
+		errno = EBUSY;
+		n = EBUSY;
+	} else
+	if (core != NULL && *core != NULL) {
+		struct ndm_core_t *c = *core;
+
+		if (c->fd >= 0) {
+			if (close(c->fd) != 0 && errno != EINTR) {
+				n = errno;
+			}
+		}
+
+		__ndm_core_pipeline_destroy(&c->pipeline);
+
+		if (c->cache == &c->cache_storage) {
+			__ndm_core_cache_destroy(&c->cache_storage);
+		}
+
+		free(c->request_buffer);
+		free((void *) c->agent);
+		free(c);
+		*core = NULL;
+	}
+
+	return (n == 0) ? true : false;
+}
+
+/**
+ * Core connection pool functions.
+ *
+ * Free connections are kept in a lock-free stack of slot indices,
+ * a stack head contains a slot index incremented by one in low
+ * 32 bits and a modification counter in high 32 bits to avoid
+ * an ABA problem.
+ **/
+
+static inline uint64_t __ndm_core_pool_head(
+		const uint64_t head,
+		const uint32_t index)
+{
+	return (((head >> 32) + 1) << 32) | index;
+}
+
+struct ndm_core_pool_t *ndm_core_pool_open(
+		const char *const agent,
+		const size_t size,
+		const int cache_ttl_msec,
+		const size_t cache_max_size)
+{
+	struct ndm_core_pool_t *pool = NULL;
+
+	if (size == 0 || size > NDM_CORE_POOL_MAX_SIZE_) {
+		errno = EINVAL;
+	} else
+	if ((pool = malloc(sizeof(*pool) + size * sizeof(pool->slots[0]))) ==
+			NULL)
+	{
+		errno = ENOMEM;
+	} else {
+		int error = 0;
+
+		__ndm_core_cache_init(&pool->cache, cache_ttl_msec, cache_max_size);
+		pool->free_head = NDM_CORE_POOL_EMPTY_;
+		pool->size = 0;
+
+		if ((error = pthread_mutex_init(&pool->cache.lock, NULL)) != 0) {
+			errno = error;
+			free(pool);
+			pool = NULL;
+		} else
+		if ((error = __ndm_core_cond_init_monotonic(
+				&pool->cache.flight_done)) != 0)
+		{
+			pthread_mutex_destroy(&pool->cache.lock);
+			errno = error;
+			free(pool);
+			pool = NULL;
+		} else {
+			pool->cache.shared = true;
+
+			while (pool->size < size) {
+				const uint32_t slot = pool->size;
+				struct ndm_core_t *core = __ndm_core_open(
+					agent, cache_ttl_msec, cache_max_size, &pool->cache);
+
+				if (core == NULL) {
+					break;
+				}
+
+				core->pool = pool;
+				core->pool_slot = slot;
+				pool->slots[slot].core = core;
+				pool->slots[slot].next = (uint32_t) pool->free_head;
+				pool->slots[slot].checked_out = false;
+				pool->free_head = slot + 1;
+				++pool->size;
+			}
+
+			if (pool->size < size) {
+				const int open_error = errno;
+
+				ndm_core_pool_close(&pool);
+				errno = open_error;
+			}
+		}
+	}
+
+	return pool;
+}
+
+bool ndm_core_pool_close(
+		struct ndm_core_pool_t **pool)
+{
+	bool closed = true;
+
+	if (pool != NULL && *pool != NULL) {
+		struct ndm_core_pool_t *p = *pool;
+		int error = 0;
+
+		for (uint32_t i = 0; i < p->size; i++) {
+			struct ndm_core_t *core = p->slots[i].core;
+
+			core->pool = NULL;
+
+			if (!ndm_core_close(&core)) {
+				error = errno;
+			}
+		}
+
+		__ndm_core_cache_destroy(&p->cache);
+		pthread_cond_destroy(&p->cache.flight_done);
+		pthread_mutex_destroy(&p->cache.lock);
+		free(p);
+		*pool = NULL;
+
+		if (error != 0) {
+			errno = error;
+			closed = false;
+		}
+	}
+
+	return closed;
+}
+
+size_t ndm_core_pool_size(
+		const struct ndm_core_pool_t *pool)
+{
+	return pool->size;
+}
+
+struct ndm_core_t *ndm_core_pool_checkout(
+		struct ndm_core_pool_t *pool)
+{
+	uint64_t head = __atomic_load_n(&pool->free_head, __ATOMIC_ACQUIRE);
+	uint32_t index = NDM_CORE_POOL_EMPTY_;
+
+	do {
+		index = (uint32_t) head;
+
+		if (index == NDM_CORE_POOL_EMPTY_) {
+			errno = EAGAIN;
+
+			return NULL;
+		}
+	} while (!__atomic_compare_exchange_n(
+		&pool->free_head, &head,
+		__ndm_core_pool_head(head,
+			__atomic_load_n(&pool->slots[index - 1].next, __ATOMIC_RELAXED)),
+		true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	__atomic_store_n(&pool->slots[index - 1].checked_out, true,
+		__ATOMIC_RELAXED);
+
+	return pool->slots[index - 1].core;
+}
+
+bool ndm_core_pool_checkin(
+		struct ndm_core_pool_t *pool,
+		struct ndm_core_t *core)
+{
+	struct ndm_core_pool_slot_t *slot = NULL;
+	uint64_t head = 0;
+
+	if (core->pool != pool) {
+		errno = EINVAL;
+
+		return false;
+	}
+
+	slot = &pool->slots[core->pool_slot];
+
+	/* a repeated checkin would push a slot onto a free stack twice */
+	if (!__atomic_exchange_n(&slot->checked_out, false, __ATOMIC_RELAXED)) {
+		errno = EINVAL;
+
+		return false;
+	}
+
+	head = __atomic_load_n(&pool->free_head, __ATOMIC_RELAXED);
+
+	do {
+		__atomic_store_n(&slot->next, (uint32_t) head, __ATOMIC_RELAXED);
+	} while (!__atomic_compare_exchange_n(
+		&pool->free_head, &head,
+		__ndm_core_pool_head(head, core->pool_slot + 1),
+		true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	return true;
+}
+
+int ndm_core_fd(
+		const struct ndm_core_t *core)
+{
+	return core->fd;
+}
+
+void ndm_core_set_timeout(
+		struct ndm_core_t *core,
+		const int timeout)
+{
+	core->timeout = timeout;
+}
+
+int ndm_core_get_timeout(
+		const struct ndm_core_t *core)
+{
+	return core->timeout;
+}
+
+void ndm_core_set_zero_copy(
+		struct ndm_core_t *core,
+		const bool zero_copy)
+{
+	core->zero_copy = zero_copy;
+}
+
+bool ndm_core_get_zero_copy(
+		const struct ndm_core_t *core)
+{
+	return core->zero_copy;
+}
+
+void ndm_core_set_stats(
+		struct ndm_core_t *core,
+		const bool enabled)
+{
+	core->stats_enabled = enabled;
+}
+
+void ndm_core_get_stats(
+		const struct ndm_core_t *core,
+		struct ndm_core_stats_t *stats)
+{
+	*stats = core->stats;
+}
+
+void ndm_core_clear_stats(
+		struct ndm_core_t *core)
+{
+	memset(&core->stats, 0, sizeof(core->stats));
+}
+
+void ndm_core_set_request_hook(
+		struct ndm_core_t *core,
+		ndm_core_request_hook_t hook,
+		void *user_data)
+{
+	core->request_hook = hook;
+	core->request_hook_data = user_data;
+}
+
+const char *ndm_core_agent(
+		const struct ndm_core_t *core)
+{
+	return core->agent;
+}
+
+static void __ndm_core_output_init(
+		struct ndm_core_output_t *output,
+		uint8_t *static_buffer,
+		const size_t static_buffer_size,
+		uint8_t **dynamic_buffer,
+		size_t *dynamic_buffer_size)
+{
+	output->start = static_buffer;
+	output->bound = static_buffer + static_buffer_size;
+	output->putp = static_buffer;
+	output->dynamic_buffer = dynamic_buffer;
+	output->dynamic_buffer_size = dynamic_buffer_size;
+}
+
+static inline size_t __ndm_core_output_size(
+		const struct ndm_core_output_t *output)
+{
+	return (size_t) (output->putp - output->start);
+}
+
+static bool __ndm_core_output_grow(
+		struct ndm_core_output_t *output,
+		const size_t size)
+{
+	const size_t used = __ndm_core_output_size(output);
+	const size_t capacity = (size_t) (output->bound - output->start);
+	size_t new_capacity =
+		NDM_MAX(capacity, NDM_CORE_REQUEST_DYNAMIC_BLOCK_SIZE_);
+
+	while (new_capacity - used < size) {
+		new_capacity *= 2;
+	}
+
+	if (*output->dynamic_buffer_size < new_capacity) {
+		/* a reusable dynamic buffer is too small, expand it;
+		 * its contents are valid only if the output uses it already */
+		uint8_t *p = (output->start == *output->dynamic_buffer) ?
+			realloc(*output->dynamic_buffer, new_capacity) :
+			malloc(new_capacity);
+
+		if (p == NULL) {
+			errno = ENOMEM;
+
+			return false;
+		}
+
+		if (output->start != *output->dynamic_buffer) {
+			free(*output->dynamic_buffer);
+			memcpy(p, output->start, used);
+		}
+
+		*output->dynamic_buffer = p;
+		*output->dynamic_buffer_size = new_capacity;
+	} else
+	if (output->start != *output->dynamic_buffer) {
+		memcpy(*output->dynamic_buffer, output->start, used);
+	}
+
+	output->start = *output->dynamic_buffer;
+	output->bound = output->start + *output->dynamic_buffer_size;
+	output->putp = output->start + used;
+
+	return true;
+}
+
+static inline bool __ndm_core_output_reserve(
+		struct ndm_core_output_t *output,
+		const size_t size)
+{
+	return
+		((size_t) (output->bound - output->putp)) >= size ||
+		__ndm_core_output_grow(output, size);
+}
+
+static inline bool __ndm_core_request_store_ctrl(
+		struct ndm_core_output_t *output,
+		const ndm_core_ctrl_t ctrl,
+		const enum ndm_xml_node_type_t node_type)
+{
+	if (!__ndm_core_output_reserve(output, sizeof(ndm_core_ctrl_t))) {
+		return false;
+	}
+
+	*((ndm_core_ctrl_t *) output->putp) = (ndm_core_ctrl_t)
+		((ctrl << 6) | ((ndm_core_ctrl_t) node_type));
+	output->putp += sizeof(ndm_core_ctrl_t);
+
+	return true;
+}
+
+static inline bool __ndm_core_request_store_str(
+		struct ndm_core_output_t *output,
+		const char *const str,
+		const size_t str_size)
+{
+	const ndm_core_size_t size = (ndm_core_size_t) htonl((uint32_t) str_size);
+
+	if (!__ndm_core_output_reserve(output, sizeof(size) + str_size)) {
+		return false;
+	}
+
+	/* a size field is not aligned in a binary stream */
+	memcpy(output->putp, &size, sizeof(size));
+	output->putp += sizeof(size);
+	memcpy(output->putp, str, str_size);
+	output->putp += str_size;
+
+	return true;
+}
+
+static inline bool __ndm_core_request_store_base(
+		struct ndm_core_output_t *output,
+		const ndm_core_ctrl_t ctrl,
+		const enum ndm_xml_node_type_t node_type,
+		const char *const name,
+		const size_t name_size,
+		const char *const value,
+		const size_t value_size)
+{
+	return
+		__ndm_core_request_store_ctrl(output, ctrl, node_type) &&
+		__ndm_core_request_store_str(output, name, name_size) &&
+		__ndm_core_request_store_str(output, value, value_size);
+}
+
+static bool __ndm_core_request_store_node(
+		const struct ndm_xml_node_t *node,
+		const ndm_core_ctrl_t node_ctrl,
+		struct ndm_core_output_t *output,
+		const size_t level)
+{
+	bool done = __ndm_core_request_store_base(
+		output, node_ctrl, ndm_xml_node_type(node),
+		ndm_xml_node_name(node), ndm_xml_node_name_size(node),
+		ndm_xml_node_value(node), ndm_xml_node_value_size(node));
+	struct ndm_xml_attr_t *attr = ndm_xml_node_first_attr(node, NULL);
+	struct ndm_xml_node_t *child = ndm_xml_node_first_child(node, NULL);
+	struct ndm_xml_node_t *first_child = child;
+
+	while (done && attr != NULL) {
+		done = __ndm_core_request_store_base(
+			output, NDM_CORE_CTRL_ATTR_, 0,
+			ndm_xml_attr_name(attr), ndm_xml_attr_name_size(attr),
+			ndm_xml_attr_value(attr), ndm_xml_attr_value_size(attr));
+		attr = ndm_xml_attr_next(attr, NULL);
+	}
+
+	while (done && child != NULL) {
+		done = __ndm_core_request_store_node(child,
+			(ndm_core_ctrl_t) ((child == first_child) ?
+			NDM_CORE_CTRL_NODE_ : NDM_CORE_CTRL_SIBL_),
+			output, level + 1);
+		child = ndm_xml_node_next_sibling(child, NULL);
+	}
+
+	if (done && (first_child != NULL || level == 0)) {
+		done = __ndm_core_request_store_ctrl(output, NDM_CORE_CTRL_END_, 0);
+	}
+
+	return done;
+}
+
+static bool __ndm_core_request_store(
+		const struct ndm_xml_node_t *root,
+		struct ndm_core_output_t *output)
+{
+	if (root == NULL) {
+		/* empty request */
+		errno = EBADMSG;
+
+		return false;
+	}
+
+	return __ndm_core_request_store_node(
+		root, NDM_CORE_CTRL_NODE_, output, 0);
+}
+
+static struct ndm_core_response_t *__ndm_core_response_alloc()
+{
+	struct ndm_core_response_t *response = malloc(sizeof(*response));
+
+	if (response == NULL) {
+		errno = ENOMEM;
+	} else {
+		response->root = NULL;
+		response->frame = NULL;
+		response->id = NDM_CORE_RESPONSE_ID_INITIALIZER_;
+		response->references = 1;
+		ndm_xml_document_init(&response->doc,
+			response->buffer, sizeof(response->buffer),
+			NDM_CORE_RESPONSE_DYNAMIC_BLOCK_SIZE_);
+	}
+
+	return response;
+}
+
+/**
+ * A compact copy owns its strings, a zero-copy frame
+ * of an original response is not referenced.
+ **/
+
+static struct ndm_core_response_t *__ndm_core_response_compact(
+		const struct ndm_core_response_t *response)
+{
+	struct ndm_core_response_t *compact = __ndm_core_response_alloc();
+
+	if (compact == NULL) {
+		return NULL;
+	}
+
+	if (!ndm_xml_document_compact(&compact->doc, &response->doc) ||
+		(compact->root = ndm_xml_node_first_child(
+			ndm_xml_document_root(&compact->doc), "response")) == NULL)
+	{
+		ndm_core_response_free(&compact);
+
+		return NULL;
+	}
+
+	compact->id = response->id;
+
+	return compact;
+}
+
+static bool __ndm_core_response_read(
+		struct ndm_core_response_t *response,
+		struct ndm_core_input_t *input)
+{
+	struct ndm_xml_node_t *root = NULL;
+
+	return
+		(root = ndm_xml_document_alloc_root(&response->doc)) != NULL &&
+		__ndm_core_read_xml_children(input, root) &&
+		(response->root = ndm_xml_node_first_child(
+			root, "response")) != NULL;
+}
+
+static bool __ndm_core_response_receive(
+		struct ndm_core_t *core,
+		struct ndm_core_response_t *response,
+		const struct timespec *intblock,
+		const struct timespec *deadline)
+{
+	struct ndm_core_input_t input;
+	struct ndm_core_buffer_t frame_buffer;
+
+	__ndm_core_input_init(&input, &core->buffer,
+		core->fd, intblock, deadline);
+
+	if (core->zero_copy) {
+		if (!__ndm_core_read_frame(&input, &response->frame)) {
+			return false;
+		}
+
+		/* strings of a response refer to the frame */
+		__ndm_core_input_init_in_place(&input,
+			&frame_buffer, response->frame);
+	}
+
+	return __ndm_core_response_read(response, &input);
+}
+
+/**
+ * Request metrics are collected only if statistics or a request hook
+ * are enabled, a regular request path makes no extra clock calls.
+ **/
+
+static inline uint64_t __ndm_core_stats_lap(
+		struct timespec *mark)
+{
+	struct timespec now;
+	struct timespec elapsed;
+
+	ndm_time_get_monotonic(&now);
+	elapsed = now;
+	ndm_time_sub(&elapsed, mark);
+	*mark = now;
+
+	return (uint64_t) ndm_time_to_nsec(&elapsed);
+}
+
+static size_t __ndm_core_stats_node_count(
+		const struct ndm_xml_node_t *root)
+{
+	const struct ndm_xml_node_t *n = ndm_xml_node_first_child(root, NULL);
+	size_t count = 0;
+
+	while (n != NULL) {
+		const struct ndm_xml_node_t *next = ndm_xml_node_first_child(n, NULL);
+
+		++count;
+
+		while (next == NULL && n != root) {
+			next = ndm_xml_node_next_sibling(n, NULL);
+
+			if (next == NULL) {
+				n = ndm_xml_node_parent(n);
+			}
+		}
+
+		n = next;
+	}
+
+	return count;
+}
+
+/**
+ * A measured response is received as a whole frame to separate
+ * a socket time from a decoding time.
+ **/
+
+static bool __ndm_core_response_receive_measured(
+		struct ndm_core_t *core,
+		struct ndm_core_response_t *response,
+		const struct timespec *intblock,
+		const struct timespec *deadline,
+		struct timespec *mark,
+		struct ndm_core_request_stats_t *stats)
+{
+	struct ndm_core_input_t input;
+	struct ndm_core_buffer_t frame_buffer;
+	struct ndm_core_frame_t *frame = NULL;
+	bool done = false;
+
+	if (__ndm_core_buffer_is_empty(&core->buffer)) {
+		const int delay = (int) ndm_time_left_monotonic_msec(deadline);
+		struct pollfd pfd =
+		{
+			.fd = core->fd,
+			.events = POLLIN,
+			.revents = 0
+		};
+
+		/* poll errors are detected by a following receive */
+		if (delay > 0 && ndm_poll(&pfd, 1, delay) < 0) {
+			return false;
+		}
+	}
+
+	stats->first_byte_nsec = __ndm_core_stats_lap(mark);
+
+	__ndm_core_input_init(&input, &core->buffer,
+		core->fd, intblock, deadline);
+
+	if (!__ndm_core_read_frame(&input, &frame)) {
+		return false;
+	}
+
+	stats->receive_nsec = __ndm_core_stats_lap(mark);
+	stats->bytes_received = frame->size;
+
+	__ndm_core_input_init_in_place(&input, &frame_buffer, frame);
+
+	if (core->zero_copy) {
+		response->frame = __ndm_core_frame_retain(frame);
+	} else {
+		/* strings are copied from a complete frame */
+		input.in_place = false;
+	}
+
+	done = __ndm_core_response_read(response, &input);
+	__ndm_core_frame_release(&frame);
+
+	stats->decode_nsec = __ndm_core_stats_lap(mark);
+
+	if (done) {
+		stats->node_count = __ndm_core_stats_node_count(response->root);
+	}
+
+	return done;
+}
+
+static void __ndm_core_stats_update(
+		struct ndm_core_t *core,
+		const struct ndm_core_request_stats_t *request_stats)
+{
+	if (core->stats_enabled) {
+		struct ndm_core_stats_t *stats = &core->stats;
+
+		stats->requests++;
+		stats->cache_hits += request_stats->cache_hit ? 1 : 0;
+		stats->failures += request_stats->failed ? 1 : 0;
+		stats->serialize_nsec += request_stats->serialize_nsec;
+		stats->send_nsec += request_stats->send_nsec;
+		stats->first_byte_nsec += request_stats->first_byte_nsec;
+		stats->receive_nsec += request_stats->receive_nsec;
+		stats->decode_nsec += request_stats->decode_nsec;
+		stats->bytes_sent += request_stats->bytes_sent;
+		stats->bytes_received += request_stats->bytes_received;
+		stats->node_count += request_stats->node_count;
+	}
+
+	if (core->request_hook != NULL) {
+		core->request_hook(core->request_hook_data, request_stats);
+	}
+}
+
+static struct ndm_core_response_t *__ndm_core_do_request(
+		struct ndm_core_t *core,
+		const enum ndm_core_cache_mode_t cache_mode,
+		const bool copy_cached_response,
+		struct ndm_xml_node_t *request,
+		bool *response_copied)
+{
+	struct timespec intblock;
+	struct timespec deadline;
+	uint8_t request_static_buffer[NDM_CORE_REQUEST_BINARY_STATIC_SIZE_];
+	struct ndm_core_output_t output;
+	struct ndm_core_response_t *response = NULL;
+	const bool measured =
+		core->stats_enabled || core->request_hook != NULL;
+	struct ndm_core_request_stats_t stats;
+	struct timespec mark;
+	struct ndm_core_cache_flight_t *flight = NULL;
+	bool coalesced = false;
+
+	if (measured) {
+		memset(&stats, 0, sizeof(stats));
+		ndm_time_get_monotonic(&mark);
+	}
+
+	__ndm_core_output_init(&output,
+		request_static_buffer, sizeof(request_static_buffer),
+		&core->request_buffer, &core->request_buffer_size);
+	ndm_time_get_monotonic_plus_msec(&intblock, NDM_CORE_INTBLOCK_TIMEOUT_);
+	ndm_time_get_monotonic_plus_msec(&deadline, core->timeout);
+
+	if (!ndm_dlist_is_empty(&core->pipeline.sent)) {
+		/* responses to pipelined requests are expected first */
+		errno = EBUSY;
+	} else
+	if (__ndm_core_request_store(request, &output)) {
+		uint8_t *buffer = output.start;
+		const size_t request_size = __ndm_core_output_size(&output);
+
+		/* a request sequence is ready */
+
+		if (measured) {
+			stats.serialize_nsec = __ndm_core_stats_lap(&mark);
+		}
+
+		if (cache_mode == NDM_CORE_MODE_CACHE) {
+			__ndm_core_cache_lock(core->cache);
+			__ndm_core_cache_get(core->cache, buffer,
+				request_size, copy_cached_response,
+				response_copied, &response);
+
+			if (response == NULL && core->cache->shared) {
+				coalesced = __ndm_core_cache_flight_join(core->cache,
+					buffer, request_size, &deadline, &response, &flight);
+
+				if (response != NULL && response_copied != NULL) {
+					*response_copied = true;
+				}
+			}
+
+			__ndm_core_cache_unlock(core->cache);
+
+			if (measured) {
+				/* a coalesced response is counted by the cache only */
+				stats.cache_hit = (response != NULL && !coalesced);
+			}
+		}
+
+		if (response == NULL && !coalesced) {
+			/* cache miss or noncached mode */
+			struct ndm_core_buffer_t core_buffer;
+
+			__ndm_core_buffer_init(&core_buffer, buffer, request_size);
+			core_buffer.putp = core_buffer.bound;
+
+			if (__ndm_core_buffer_send_all(
+					&core_buffer, core->fd, &intblock, &deadline))
+			{
+				/* the request sequence was sent */
+				if (measured) {
+					stats.send_nsec = __ndm_core_stats_lap(&mark);
+					stats.bytes_sent = request_size;
+				}
+
+				if ((response = __ndm_core_response_alloc()) != NULL) {
+					if (!(measured ?
+							__ndm_core_response_receive_measured(core,
+								response, &intblock, &deadline,
+								&mark, &stats) :
+							__ndm_core_response_receive(core,
+								response, &intblock, &deadline)))
+					{
+						ndm_core_response_free(&response);
+					} else {
+						response->id = ++core->response_id;
+
+						if (cache_mode == NDM_CORE_MODE_CACHE &&
+							flight == NULL &&
+							!ndm_core_response_is_continued(response))
+						{
+							__ndm_core_cache_store(core->cache,
+								buffer, request_size, response);
+						}
+
+						/* this allocated response copy should be freed */
+						if (response_copied != NULL) {
+							*response_copied = true;
+						}
+					}
+				}
+			}
+		}
+
+		if (flight != NULL) {
+			__ndm_core_cache_flight_finish(core->cache, flight, response,
+				response != NULL &&
+				!ndm_core_response_is_continued(response));
+		}
+
+		if (response != NULL) {
+			__ndm_core_message_update(&core->last_message, response);
+		}
+	}
+
+	if (response == NULL) {
+		__ndm_core_message_init(&core->last_message);
+	}
+
+	if (measured) {
+		const int error = errno;
+
+		stats.failed = (response == NULL);
+		__ndm_core_stats_update(core, &stats);
+		errno = error;
+	}
+
+	return response;
+}
+
+static struct ndm_xml_node_t *__ndm_core_request_document_init(
+		struct ndm_xml_document_t *doc,
+		uint8_t *buffer,
+		const size_t buffer_size,
+		const char *const agent)
+{
+	struct ndm_xml_node_t *root = NULL;
+	struct ndm_xml_node_t *request_node = NULL;
+
+	ndm_xml_document_init(doc, buffer, buffer_size,
+		NDM_CORE_REQUEST_DYNAMIC_BLOCK_SIZE_);
+
+	if ((root = ndm_xml_document_alloc_root(doc)) == NULL ||
+		(request_node = ndm_xml_node_append_child_str(
+			root, "request", NULL)) == NULL ||
+		ndm_xml_node_append_attr_str(request_node, "agent", agent) == NULL)
+	{
+		ndm_xml_document_clear(doc);
+		request_node = NULL;
+	}
+
+	return request_node;
+}
+
+bool ndm_core_authenticate(
+		struct ndm_core_t *core,
+		const char *const user,
+		const char *const password,
+		const char *const tag,
+		bool *authenticated)
+{
+	bool done = false;
+	uint8_t request_buffer[NDM_CORE_REQUEST_STATIC_SIZE_];
+	struct ndm_xml_document_t request;
+	struct ndm_xml_node_t *hello_node = NULL;
+	struct ndm_xml_node_t *request_node =
+		__ndm_core_request_document_init(&request,
+			request_buffer, sizeof(request_buffer),
+			core->agent);
+
+	*authenticated = false;
+
+	if (request_node != NULL &&
+		(hello_node = ndm_xml_node_append_child_str(
+			request_node, "hello", password)) != NULL &&
+		ndm_xml_node_append_attr_str(hello_node, "name", user) != NULL &&
+		ndm_xml_node_append_attr_str(hello_node, "tag", tag) != NULL)
+	{
+		struct ndm_core_response_t *response = __ndm_core_do_request(
+			core, NDM_CORE_MODE_NO_CACHE, true, request_node, NULL);
+
+		if (response != NULL) {
+			const struct ndm_xml_node_t *response_node =
+				ndm_core_response_root(response);
+
+			*authenticated =
+				(ndm_xml_node_first_child(response_node, "prompt") != NULL);
+
+			ndm_core_response_free(&response);
+			done = true;
+		}
+	}
+
+	ndm_xml_document_clear(&request);
+
+	return done;
+}
+
+bool ndm_core_find_command(
+		struct ndm_core_t *core,
+		const char *const command,
+		bool* found)
+{
+	bool done = false;
+	uint8_t request_buffer[NDM_CORE_REQUEST_STATIC_SIZE_];
+	struct ndm_xml_document_t request;
+	struct ndm_xml_node_t *probe_node = NULL;
+	struct ndm_xml_node_t *request_node =
+		__ndm_core_request_document_init(&request,
+			request_buffer, sizeof(request_buffer),
+			core->agent);
+
+	*found = false;
+
+	if (request_node != NULL &&
+		(probe_node = ndm_xml_node_append_child_str(
+			request_node, "probe", NULL)) != NULL &&
+		ndm_xml_node_append_attr_str(probe_node, "name", command) != NULL)
+	{
+		struct ndm_core_response_t *response = __ndm_core_do_request(
+			core, NDM_CORE_MODE_NO_CACHE, true, request_node, NULL);
+
+		if (response != NULL) {
+			const struct ndm_xml_node_t *response_node =
+				ndm_core_response_root(response);
+			const struct ndm_xml_node_t *probe_resp_node =
+				ndm_xml_node_first_child(response_node, "probe");
+			struct ndm_xml_attr_t *found_attr = NULL;
+
+			if ( probe_resp_node == NULL ||
+				(found_attr = ndm_xml_node_first_attr(
+					probe_resp_node, "found")) == NULL)
+			{
+				errno = EBADMSG;
+			} else {
+				const char *const found_val = ndm_xml_attr_value(found_attr);
+
+				if (strcasecmp(found_val, "yes") == 0) {
+					done = true;
+					*found = true;
+				} else
+				if (strcasecmp(found_val, "no") == 0) {
+					done = true;
+				} else {
+					errno = EBADMSG;
+				}
+			}
+
+			ndm_core_response_free(&response);
+		}
+	}
+
+	ndm_xml_document_clear(&request);
+
+	return done;
+}
+
+/**
+ * Build a request document, it should be cleared by a caller
+ * regardless of a result.
+ **/
+
+static struct ndm_xml_node_t *__ndm_core_request_build(
+		struct ndm_core_t *core,
+		struct ndm_xml_document_t *request,
+		uint8_t *request_buffer,
+		const size_t request_buffer_size,
+		const enum ndm_core_request_type_t request_type,
+		const char *const command_args[],
+		const char *const command_format,
+		va_list ap)
+{
+	struct ndm_xml_node_t *request_node =
+		__ndm_core_request_document_init(request,
+			request_buffer, request_buffer_size,
+			core->agent);
+	struct ndm_xml_node_t *built_node = NULL;
+
+	if (request_node != NULL) {
+		char command_buffer[NDM_CORE_REQUEST_STATIC_COMMAND_BUFFER_SIZE_];
+		char *command = command_buffer;
+		va_list aq;
+
+		va_copy(aq, ap);
+		ndm_vabsprintf(
+			command_buffer, sizeof(command_buffer),
+			&command, command_format, aq);
+		va_end(aq);
+
+		if (command != NULL) {
+			if (request_type != NDM_CORE_REQUEST_CONFIG  &&
+				request_type != NDM_CORE_REQUEST_EXECUTE &&
+				request_type != NDM_CORE_REQUEST_PARSE)
+			{
+				errno = EINVAL;
+			} else {
 				bool has_args = false;
 				struct ndm_xml_node_t *command_node = NULL;
 
-				command_node = ndm_xml_node_append_child_str(
-					request_node,
-					(request_type == NDM_CORE_REQUEST_CONFIG)  ? "config"  :
-					(request_type == NDM_CORE_REQUEST_EXECUTE) ? "command" :
-																 "parse",
-					(request_type == NDM_CORE_REQUEST_PARSE)   ? command   :
-																 NULL);
+				command_node = ndm_xml_node_append_child_str(
+					request_node,
+					(request_type == NDM_CORE_REQUEST_CONFIG)  ? "config"  :
+					(request_type == NDM_CORE_REQUEST_EXECUTE) ? "command" :
+																 "parse",
+					(request_type == NDM_CORE_REQUEST_PARSE)   ? command   :
+																 NULL);
+
+				if (command_node == NULL) {
+					errno = ENOMEM;
+				} else
+				if ((request_type == NDM_CORE_REQUEST_CONFIG ||
+					 request_type == NDM_CORE_REQUEST_EXECUTE) &&
+					 ndm_xml_node_append_attr_str(command_node,
+						NDM_CORE_REQUEST_ATTR_NAME_, command) == NULL)
+				{
+					errno = ENOMEM;
+					command_node = NULL;
+				} else
+				if (command_args != NULL) {
+					size_t i = 0;
+
+					while (
+						command_node != NULL &&
+						command_args[i] != NULL &&
+						command_args[i + 1] != NULL)
+					{
+						const char *const name = command_args[i];
+						const char *const value = command_args[i + 1];
+
+						if (*name == NDM_CORE_REQUEST_ATTR_PREFIX_) {
+							if (strcmp(
+									name +
+									sizeof(NDM_CORE_REQUEST_ATTR_PREFIX_),
+									NDM_CORE_REQUEST_ATTR_NAME_) == 0)
+							{
+								/* reserved attribute */
+								errno = EINVAL;
+								command_node = NULL;
+							} else
+							if (ndm_xml_node_append_attr_str(
+									command_node, name, value) == NULL)
+							{
+								errno = ENOMEM;
+								command_node = NULL;
+							}
+						} else
+						if (ndm_xml_node_append_child_str(
+								command_node, name, value) == NULL)
+						{
+							errno = ENOMEM;
+							command_node = NULL;
+						} else {
+							has_args = true;
+						}
+
+						i += 2;
+					}
+
+					if (command_node != NULL &&
+						command_args[i] != NULL)
+					{
+						if (command_args[i + 1] == NULL) {
+							errno = EINVAL;
+						} else {
+							/* ENOMEM or EINVAL */
+						}
+
+						command_node = NULL;
+					}
+				}
+
+				if (command_node != NULL) {
+					if (request_type == NDM_CORE_REQUEST_PARSE &&
+						has_args)
+					{
+						/* no arguments allowed for "parse" request */
+						errno = EINVAL;
+						command_node = NULL;
+					} else {
+						built_node = request_node;
+					}
+				}
+			}
+
+			if (command != command_buffer) {
+				free(command);
+			}
+		}
+	}
+
+	return built_node;
+}
+
+static struct ndm_core_response_t *__ndm_core_request(
+		struct ndm_core_t *core,
+		const enum ndm_core_request_type_t request_type,
+		const enum ndm_core_cache_mode_t cache_mode,
+		const bool copy_cached_response,
+		bool *response_copied,
+		const char *const command_args[],
+		const char *const command_format,
+		va_list ap)
+{
+	uint8_t request_buffer[NDM_CORE_REQUEST_STATIC_SIZE_];
+	struct ndm_xml_document_t request;
+	struct ndm_xml_node_t *request_node =
+		__ndm_core_request_build(core, &request,
+			request_buffer, sizeof(request_buffer),
+			request_type, command_args, command_format, ap);
+	struct ndm_core_response_t *response = NULL;
+
+	if (request_node != NULL) {
+		response = __ndm_core_do_request(core,
+			cache_mode, copy_cached_response,
+			request_node, response_copied);
+	}
+
+	ndm_xml_document_clear(&request);
+
+	return response;
+}
+
+static struct ndm_core_response_t *__ndm_core_request_cf(
+		struct ndm_core_t *core,
+		const enum ndm_core_request_type_t request_type,
+		const enum ndm_core_cache_mode_t cache_mode,
+		const bool copy_cached_response,
+		bool *response_copied,
+		const char *const command_args[],
+		const char *const command_format,
+		...)
+{
+	va_list ap;
+	struct ndm_core_response_t *response = NULL;
+
+	va_start(ap, command_format);
+	response = __ndm_core_request(
+		core, request_type, cache_mode, copy_cached_response,
+		response_copied, command_args, command_format, ap);
+	va_end(ap);
+
+	return response;
+}
+
+struct ndm_core_response_t *ndm_core_request(
+		struct ndm_core_t *core,
+		const enum ndm_core_request_type_t request_type,
+		const enum ndm_core_cache_mode_t cache_mode,
+		const char *const command_args[],
+		const char *const command_format,
+		...)
+{
+	va_list ap;
+	struct ndm_core_response_t *response = NULL;
+
+	va_start(ap, command_format);
+	response = __ndm_core_request(
+		core, request_type, cache_mode, true,
+		NULL, command_args, command_format, ap);
+	va_end(ap);
+
+	return response;
+}
+
+/**
+ * Streaming request functions.
+ **/
+
+static bool __ndm_core_stream_reserve(
+		struct ndm_core_t *core,
+		const size_t size)
+{
+	if (size > core->request_buffer_size) {
+		size_t new_size = (core->request_buffer_size == 0) ?
+			NDM_CORE_REQUEST_DYNAMIC_BLOCK_SIZE_ : core->request_buffer_size;
+		uint8_t *buffer = NULL;
+
+		while (new_size < size) {
+			new_size *= 2;
+		}
+
+		if ((buffer = realloc(core->request_buffer, new_size)) == NULL) {
+			errno = ENOMEM;
+
+			return false;
+		}
+
+		core->request_buffer = buffer;
+		core->request_buffer_size = new_size;
+	}
+
+	return true;
+}
+
+/**
+ * Read a record name and value into a request buffer of a connection,
+ * it is not used after a request was sent.
+ **/
+
+static bool __ndm_core_stream_read_strings(
+		struct ndm_core_t *core,
+		struct ndm_core_input_t *input,
+		const char **name,
+		const char **value)
+{
+	size_t offset = 0;
+	size_t value_offset = 0;
+
+	for (size_t i = 0; i < 2; i++) {
+		ndm_core_size_t size = 0;
+
+		if (!__ndm_core_input_get(input, &size, sizeof(size))) {
+			return false;
+		}
+
+		size = ntohl(size);
+
+		if (!__ndm_core_stream_reserve(core, offset + size + 1) ||
+			!__ndm_core_input_get(input,
+				core->request_buffer + offset, size))
+		{
+			return false;
+		}
+
+		core->request_buffer[offset + size] = '\0';
+		value_offset = offset;
+		offset += size + 1;
+	}
+
+	*name = (const char *) core->request_buffer;
+	*value = (const char *) core->request_buffer + value_offset;
+
+	return true;
+}
+
+static bool __ndm_core_read_stream(
+		struct ndm_core_t *core,
+		struct ndm_core_input_t *input,
+		const struct ndm_core_response_handler_t *handler,
+		void *user_data)
+{
+	struct ndm_core_frame_scanner_t scanner;
+	bool element = false;
+	bool error = false;
+	bool stopped = false;
+
+	__ndm_core_frame_scanner_init(&scanner);
+
+	do {
+		const size_t depth = scanner.depth;
+		const char *name = "";
+		const char *value = "";
+		bool has_strings = false;
+		uint8_t data = 0;
+
+		if (!__ndm_core_input_get(input, &data, sizeof(data)) ||
+			!__ndm_core_frame_scanner_next(
+				&scanner, data, &has_strings, &stopped) ||
+			(has_strings &&
+			 !__ndm_core_stream_read_strings(core, input, &name, &value)))
+		{
+			error = true;
+		} else {
+			const ndm_core_ctrl_t ctrl = (ndm_core_ctrl_t) ((data >> 6) & 0x03);
+			const enum ndm_xml_node_type_t type =
+				(enum ndm_xml_node_type_t) (data & 0x3f);
+
+			if (ctrl == NDM_CORE_CTRL_ATTR_) {
+				if (element && handler->attr != NULL) {
+					handler->attr(user_data, depth, name, value);
+				}
+			} else
+			if (ctrl == NDM_CORE_CTRL_END_ ||
+				type != NDM_XML_NODE_TYPE_DOCUMENT)
+			{
+				/* a document record has no events */
+				if (ctrl != NDM_CORE_CTRL_NODE_ && element &&
+					handler->node_end != NULL)
+				{
+					/* a current node ends at a sibling or a level end */
+					handler->node_end(user_data, depth);
+				}
+
+				element = false;
+
+				if (ctrl == NDM_CORE_CTRL_END_) {
+					/* a parent of an ended node is an element
+					 * unless it is a document node */
+					element = (scanner.depth > 0);
+				} else
+				if (type == NDM_XML_NODE_TYPE_ELEMENT) {
+					element = true;
+
+					if (handler->node_start != NULL) {
+						handler->node_start(user_data,
+							scanner.depth, name, value);
+					}
+				} else
+				if ((type == NDM_XML_NODE_TYPE_DATA ||
+					 type == NDM_XML_NODE_TYPE_CDATA) &&
+					handler->text != NULL)
+				{
+					handler->text(user_data, scanner.depth, value);
+				}
+			}
+		}
+	} while (!error && !stopped);
+
+	return !error;
+}
+
+bool ndm_core_request_stream(
+		struct ndm_core_t *core,
+		const enum ndm_core_request_type_t request_type,
+		const struct ndm_core_response_handler_t *handler,
+		void *user_data,
+		const char *const command_args[],
+		const char *const command_format,
+		...)
+{
+	va_list ap;
+	uint8_t request_buffer[NDM_CORE_REQUEST_STATIC_SIZE_];
+	uint8_t request_static_buffer[NDM_CORE_REQUEST_BINARY_STATIC_SIZE_];
+	struct ndm_xml_document_t request;
+	struct ndm_xml_node_t *request_node = NULL;
+	struct ndm_core_output_t output;
+	struct timespec intblock;
+	struct timespec deadline;
+	bool done = false;
+
+	va_start(ap, command_format);
+	request_node = __ndm_core_request_build(core, &request,
+		request_buffer, sizeof(request_buffer),
+		request_type, command_args, command_format, ap);
+	va_end(ap);
+
+	__ndm_core_output_init(&output,
+		request_static_buffer, sizeof(request_static_buffer),
+		&core->request_buffer, &core->request_buffer_size);
+	ndm_time_get_monotonic_plus_msec(&intblock, NDM_CORE_INTBLOCK_TIMEOUT_);
+	ndm_time_get_monotonic_plus_msec(&deadline, core->timeout);
+
+	if (request_node == NULL) {
+		/* failed to build a request */
+	} else
+	if (!ndm_dlist_is_empty(&core->pipeline.sent)) {
+		/* responses to pipelined requests are expected first */
+		errno = EBUSY;
+	} else
+	if (__ndm_core_request_store(request_node, &output)) {
+		struct ndm_core_buffer_t core_buffer;
+		struct ndm_core_input_t input;
+
+		__ndm_core_buffer_init(&core_buffer,
+			output.start, __ndm_core_output_size(&output));
+		core_buffer.putp = core_buffer.bound;
+		__ndm_core_input_init(&input, &core->buffer,
+			core->fd, &intblock, &deadline);
+
+		done =
+			__ndm_core_buffer_send_all(
+				&core_buffer, core->fd, &intblock, &deadline) &&
+			__ndm_core_read_stream(core, &input, handler, user_data);
+	}
+
+	ndm_xml_document_clear(&request);
+	__ndm_core_message_init(&core->last_message);
+
+	return done;
+}
+
+static bool __ndm_core_pipeline_reserve(
+		struct ndm_core_pipeline_t *pipeline,
+		const size_t size)
+{
+	const size_t need = pipeline->size + size;
+
+	if (need > pipeline->capacity) {
+		size_t capacity = (pipeline->capacity == 0) ?
+			NDM_CORE_CONNECTION_BUFFER_SIZE_ : pipeline->capacity;
+		uint8_t *data = NULL;
+
+		while (capacity < need) {
+			capacity *= 2;
+		}
+
+		if ((data = realloc(pipeline->data, capacity)) == NULL) {
+			errno = ENOMEM;
+
+			return false;
+		}
+
+		pipeline->data = data;
+		pipeline->capacity = capacity;
+	}
+
+	return true;
+}
+
+/**
+ * Receive all available response data without blocking.
+ * Data of completed responses are dropped once per call.
+ **/
+
+static bool __ndm_core_pipeline_recv(
+		struct ndm_core_t *core)
+{
+	struct ndm_core_pipeline_t *pipeline = &core->pipeline;
+	struct ndm_core_buffer_t *buffer = &core->buffer;
+
+	if (pipeline->consumed > 0) {
+		memmove(pipeline->data, pipeline->data + pipeline->consumed,
+			pipeline->size - pipeline->consumed);
+		pipeline->size -= pipeline->consumed;
+		pipeline->scanned -= pipeline->consumed;
+		pipeline->consumed = 0;
+	}
+
+	if (!__ndm_core_buffer_is_empty(buffer)) {
+		/* take data left in a connection buffer */
+		const size_t size = (size_t) (buffer->putp - buffer->getp);
+
+		if (!__ndm_core_pipeline_reserve(pipeline, size)) {
+			return false;
+		}
+
+		memcpy(pipeline->data + pipeline->size, buffer->getp, size);
+		pipeline->size += size;
+		buffer->getp = buffer->start;
+		buffer->putp = buffer->start;
+	}
+
+	for (;;) {
+		size_t room = 0;
+		ssize_t s = 0;
+
+		if (!__ndm_core_pipeline_reserve(
+				pipeline, NDM_CORE_CONNECTION_BUFFER_SIZE_))
+		{
+			return false;
+		}
+
+		room = pipeline->capacity - pipeline->size;
+		s = recv(core->fd, pipeline->data + pipeline->size, room,
+			MSG_DONTWAIT);
+
+		if (s < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+
+		if (s == 0) {
+			errno = ECONNRESET;
+
+			return false;
+		}
+
+		pipeline->size += (size_t) s;
+
+		if ((size_t) s < room) {
+			/* a socket queue is drained */
+			return true;
+		}
+	}
+}
+
+/**
+ * Decode a first unconsumed frame of @a length bytes as a response
+ * to the oldest sent request. Per-request errors are kept
+ * in a pending entry to be reported by @c ndm_core_request_complete().
+ **/
+
+static void __ndm_core_pipeline_complete_first(
+		struct ndm_core_t *core,
+		const size_t length)
+{
+	struct ndm_core_pipeline_t *pipeline = &core->pipeline;
+	struct ndm_core_pending_t *pending =
+		ndm_dlist_entry(pipeline->sent.next,
+			struct ndm_core_pending_t, list);
+	struct ndm_core_response_t *response = __ndm_core_response_alloc();
+	struct ndm_core_frame_t *frame = NULL;
+	int error = 0;
+
+	if (response == NULL) {
+		error = ENOMEM;
+	} else
+	if ((frame = __ndm_core_frame_alloc(length)) == NULL) {
+		error = ENOMEM;
+	} else {
+		struct ndm_core_input_t input;
+		struct ndm_core_buffer_t frame_buffer;
+
+		memcpy(frame->data, pipeline->data + pipeline->consumed, length);
+		frame->size = length;
+		response->frame = frame;
+
+		/* strings of a response refer to the frame */
+		__ndm_core_input_init_in_place(&input, &frame_buffer, frame);
+
+		if (!__ndm_core_response_read(response, &input)) {
+			/* a whole frame is received, so it is either malformed
+			 * or a response document is out of memory */
+			error =
+				(ndm_xml_document_root(&response->doc) != NULL &&
+				 ndm_xml_document_is_valid(&response->doc)) ?
+				EBADMSG : ENOMEM;
+		}
+	}
+
+	if (error != 0) {
+		ndm_core_response_free(&response);
+	}
+
+	pipeline->consumed += length;
+	__ndm_core_frame_scanner_init(&pipeline->scanner);
+
+	if (response == NULL) {
+		pending->error = error;
+	} else {
+		response->id = pending->id;
+
+		if (pending->request_size > 0 &&
+			!ndm_core_response_is_continued(response))
+		{
+			__ndm_core_cache_store(core->cache,
+				pending->request, pending->request_size, response);
+		}
+
+		pending->response = response;
+	}
+
+	ndm_dlist_remove(&pending->list);
+	ndm_dlist_insert_before(&pipeline->completed, &pending->list);
+}
+
+/**
+ * Scan received data record by record, a scanning position is kept
+ * between calls, so each byte is examined only once.
+ **/
+
+static bool __ndm_core_pipeline_scan(
+		struct ndm_core_t *core)
+{
+	struct ndm_core_pipeline_t *pipeline = &core->pipeline;
+
+	while (!ndm_dlist_is_empty(&pipeline->sent) &&
+		pipeline->scanned < pipeline->size)
+	{
+		size_t missing = 0;
+		bool stopped = false;
+
+		if (!__ndm_core_frame_scan(&pipeline->scanner,
+				pipeline->data, pipeline->size,
+				&pipeline->scanned, &missing, &stopped))
+		{
+			return false;
+		}
+
+		if (!stopped) {
+			/* wait for the rest of a response */
+			break;
+		}
+
+		__ndm_core_pipeline_complete_first(core,
+			pipeline->scanned - pipeline->consumed);
+	}
+
+	return true;
+}
+
+static bool __ndm_core_pipeline_wait(
+		struct ndm_core_t *core,
+		const struct timespec *deadline)
+{
+	const int delay = (int) ndm_time_left_monotonic_msec(deadline);
+	struct pollfd pfd =
+	{
+		.fd = core->fd,
+		.events = POLLIN,
+		.revents = 0
+	};
+	int n = 0;
+
+	if (delay <= 0) {
+		errno = ETIMEDOUT;
+
+		return false;
+	}
+
+	if ((n = ndm_poll(&pfd, 1, delay)) < 0) {
+		return false;
+	}
+
+	if (n == 0) {
+		errno = ETIMEDOUT;
+
+		return false;
+	}
+
+	if (pfd.revents & POLLNVAL) {
+		errno = EINVAL;
+
+		return false;
+	}
+
+	return true;
+}
+
+static struct ndm_core_pending_t *__ndm_core_pipeline_find(
+		struct ndm_dlist_entry_t *list,
+		const ndm_core_response_id_t id)
+{
+	struct ndm_core_pending_t *pending;
+
+	ndm_dlist_foreach_entry(pending,
+		struct ndm_core_pending_t, list, list)
+	{
+		if (pending->id == id) {
+			return pending;
+		}
+	}
+
+	return NULL;
+}
+
+static bool __ndm_core_pipeline_submit(
+		struct ndm_core_t *core,
+		const enum ndm_core_cache_mode_t cache_mode,
+		struct ndm_xml_node_t *request,
+		ndm_core_response_id_t *id)
+{
+	struct timespec intblock;
+	struct timespec deadline;
+	uint8_t request_static_buffer[NDM_CORE_REQUEST_BINARY_STATIC_SIZE_];
+	struct ndm_core_output_t output;
+	bool done = false;
+
+	__ndm_core_output_init(&output,
+		request_static_buffer, sizeof(request_static_buffer),
+		&core->request_buffer, &core->request_buffer_size);
+	ndm_time_get_monotonic_plus_msec(&intblock, NDM_CORE_INTBLOCK_TIMEOUT_);
+	ndm_time_get_monotonic_plus_msec(&deadline, core->timeout);
+
+	if (__ndm_core_request_store(request, &output)) {
+		uint8_t *buffer = output.start;
+		const size_t request_size = __ndm_core_output_size(&output);
+
+		/* a request is kept as a cache key until its response */
+		const size_t key_size =
+			(cache_mode == NDM_CORE_MODE_CACHE) ? request_size : 0;
+		struct ndm_core_pending_t *pending =
+			malloc(sizeof(*pending) + key_size);
+
+		if (pending == NULL) {
+			errno = ENOMEM;
+		} else {
+			ndm_dlist_init(&pending->list);
+			pending->response = NULL;
+			pending->error = 0;
+			pending->request_size = key_size;
+			memcpy(pending->request, buffer, key_size);
+
+			if (cache_mode == NDM_CORE_MODE_CACHE) {
+				__ndm_core_cache_lock(core->cache);
+				__ndm_core_cache_get(core->cache, buffer,
+					request_size, true, NULL, &pending->response);
+				__ndm_core_cache_unlock(core->cache);
+			}
+
+			if (pending->response != NULL) {
+				/* a cache hit is completed immediately */
+				ndm_dlist_insert_before(
+					&core->pipeline.completed, &pending->list);
+				done = true;
+			} else {
+				struct ndm_core_buffer_t core_buffer;
+
+				__ndm_core_buffer_init(&core_buffer, buffer, request_size);
+				core_buffer.putp = core_buffer.bound;
+
+				if (__ndm_core_buffer_send_all(
+						&core_buffer, core->fd, &intblock, &deadline))
+				{
+					ndm_dlist_insert_before(
+						&core->pipeline.sent, &pending->list);
+					done = true;
+				} else {
+					free(pending);
+				}
+			}
+
+			if (done) {
+				*id = pending->id = ++core->response_id;
+			}
+		}
+	}
+
+	return done;
+}
+
+bool ndm_core_request_submit(
+		struct ndm_core_t *core,
+		const enum ndm_core_request_type_t request_type,
+		const enum ndm_core_cache_mode_t cache_mode,
+		ndm_core_response_id_t *id,
+		const char *const command_args[],
+		const char *const command_format,
+		...)
+{
+	va_list ap;
+	uint8_t request_buffer[NDM_CORE_REQUEST_STATIC_SIZE_];
+	struct ndm_xml_document_t request;
+	struct ndm_xml_node_t *request_node = NULL;
+	bool done = false;
+
+	va_start(ap, command_format);
+	request_node = __ndm_core_request_build(core, &request,
+		request_buffer, sizeof(request_buffer),
+		request_type, command_args, command_format, ap);
+	va_end(ap);
+
+	if (request_node != NULL) {
+		done = __ndm_core_pipeline_submit(core, cache_mode, request_node, id);
+	}
+
+	ndm_xml_document_clear(&request);
+
+	return done;
+}
+
+bool ndm_core_request_poll(
+		struct ndm_core_t *core,
+		size_t *completed)
+{
+	const bool done =
+		ndm_dlist_is_empty(&core->pipeline.sent) || (
+		__ndm_core_pipeline_recv(core) &&
+		__ndm_core_pipeline_scan(core));
+
+	*completed = ndm_dlist_size(&core->pipeline.completed);
+
+	return done;
+}
+
+struct ndm_core_response_t *ndm_core_request_complete(
+		struct ndm_core_t *core,
+		const ndm_core_response_id_t id)
+{
+	struct ndm_core_pipeline_t *pipeline = &core->pipeline;
+	struct ndm_core_pending_t *pending = NULL;
+	struct ndm_core_response_t *response = NULL;
+	struct timespec deadline;
+
+	ndm_time_get_monotonic_plus_msec(&deadline, core->timeout);
+
+	while ((pending = __ndm_core_pipeline_find(
+			&pipeline->completed, id)) == NULL)
+	{
+		if (__ndm_core_pipeline_find(&pipeline->sent, id) == NULL) {
+			errno = ENOENT;
+
+			break;
+		}
+
+		if (!__ndm_core_pipeline_wait(core, &deadline) ||
+			!__ndm_core_pipeline_recv(core) ||
+			!__ndm_core_pipeline_scan(core))
+		{
+			break;
+		}
+	}
+
+	if (pending != NULL) {
+		if ((response = pending->response) == NULL) {
+			errno = pending->error;
+		}
+
+		pending->response = NULL;
+		__ndm_core_pending_free(pending);
+	}
+
+	if (response == NULL) {
+		__ndm_core_message_init(&core->last_message);
+	} else {
+		__ndm_core_message_update(&core->last_message, response);
+	}
+
+	return response;
+}
+
+static struct ndm_core_response_t *__ndm_core_get_one_tag(
+		struct ndm_core_t *core,
+		const enum ndm_core_cache_mode_t cache_mode,
+		const char *const tag,
+		const char *const value)
+{
+	struct ndm_core_response_t *response = NULL;
+	uint8_t request_buffer[NDM_CORE_REQUEST_STATIC_SIZE_];
+	struct ndm_xml_document_t request;
+	struct ndm_xml_node_t *request_node =
+		__ndm_core_request_document_init(&request,
+			request_buffer, sizeof(request_buffer),
+			core->agent);
+
+	if (request_node != NULL &&
+		ndm_xml_node_append_child_str(request_node, tag, value) != NULL)
+	{
+		response = __ndm_core_do_request(core,
+			cache_mode, true, request_node, NULL);
+	}
+
+	ndm_xml_document_clear(&request);
+
+	return response;
+}
+
+struct ndm_core_response_t *ndm_core_get_help(
+		struct ndm_core_t *core,
+		const enum ndm_core_cache_mode_t cache_mode,
+		const char *const command)
+{
+	return __ndm_core_get_one_tag(core,
+		cache_mode, "help", command);
+}
+
+struct ndm_core_response_t *ndm_core_continue(
+		struct ndm_core_t *core)
+{
+	return __ndm_core_get_one_tag(core,
+		NDM_CORE_MODE_NO_CACHE, "continue", "");
+}
+
+struct ndm_core_response_t *ndm_core_break(
+		struct ndm_core_t *core)
+{
+	return __ndm_core_get_one_tag(core,
+		NDM_CORE_MODE_NO_CACHE, "break", "");
+}
+
+bool ndm_core_last_message_received(
+		struct ndm_core_t *core)
+{
+	return core->last_message.received;
+}
+
+enum ndm_core_response_type_t ndm_core_last_message_type(
+		struct ndm_core_t *core)
+{
+	return core->last_message.type;
+}
+
+const char *ndm_core_last_message_string(
+		struct ndm_core_t *core)
+{
+	return core->last_message.string;
+}
+
+const char *ndm_core_last_message_ident(
+		struct ndm_core_t *core)
+{
+	return core->last_message.ident;
+}
+
+const char *ndm_core_last_message_source(
+		struct ndm_core_t *core)
+{
+	return core->last_message.source;
+}
+
+ndm_code_t ndm_core_last_message_code(
+		struct ndm_core_t *core)
+{
+	return core->last_message.code;
+}
+
+void ndm_core_response_free(
+		struct ndm_core_response_t **response)
+{
+	if (response != NULL && *response != NULL) {
+		if (__atomic_sub_fetch(
+				&(*response)->references, 1, __ATOMIC_ACQ_REL) == 0)
+		{
+			ndm_xml_document_clear(&(*response)->doc);
+			__ndm_core_frame_release(&(*response)->frame);
+			free(*response);
+		}
+
+		*response = NULL;
+	}
+}
+
+bool ndm_core_response_is_ok(
+		const struct ndm_core_response_t *response)
+{
+	const enum ndm_core_response_type_t type =
+		ndm_core_response_type(response);
+
+	return type == NDM_CORE_INFO || type == NDM_CORE_WARNING;
+}
+
+enum ndm_core_response_type_t ndm_core_response_type(
+		const struct ndm_core_response_t *response)
+{
+	enum ndm_core_response_type_t message_type = NDM_CORE_INFO;
+
+	if (__ndm_core_response_message_node(response, &message_type) == NULL) {
+		message_type = NDM_CORE_INFO;
+	}
+
+	return message_type;
+}
+
+bool ndm_core_response_is_continued(
+		const struct ndm_core_response_t *response)
+{
+	return ndm_xml_node_first_child(response->root, "continued") != NULL;
+}
+
+const struct ndm_xml_node_t *ndm_core_response_root(
+		const struct ndm_core_response_t *response)
+{
+	return response->root;
+}
+
+static inline size_t __ndm_core_response_size(
+		const struct ndm_core_response_t *response)
+{
+	return (response == NULL) ?
+		0 : sizeof(*response) + ndm_xml_document_size(&response->doc) +
+			(response->frame == NULL ? 0 : response->frame->size);
+}
+
+static inline void __ndm_core_response_find_end(char **p)
+{
+	char *q = *p;
+
+	while (*q != '/' && *q != NDM_CORE_REQUEST_ATTR_PREFIX_ && *q != '\0') {
+		++q;
+	}
+
+	*p = q;
+}
+
+static enum ndm_core_response_error_t __ndm_core_response_first_node(
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t **value,
+		char *value_path)
+{
+	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_OK;
+	char *p = value_path;
+
+	*value = node;
+
+	do {
+		const char *node_name = p;
+
+		__ndm_core_response_find_end(&p);
+
+		if (*p == NDM_CORE_REQUEST_ATTR_PREFIX_) {
+			/* no attribute reference allowed here */
+			e = NDM_CORE_RESPONSE_ERROR_SYNTAX;
+		} else {
+			if (*p == '/') {
+				*p = '\0';
+				++p;
+			}
+
+			if (*node_name != '\0' &&
+				(*value = ndm_xml_node_first_child(
+					*value, node_name)) == NULL)
+			{
+				/* there is no such a child */
+				e = NDM_CORE_RESPONSE_ERROR_NOT_FOUND;
+			}
+		}
+	} while (*p != '\0' && e == NDM_CORE_RESPONSE_ERROR_OK);
+
+	return e;
+}
+
+enum ndm_core_response_error_t ndm_core_response_first_node(
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t **value,
+		const char *const value_path_format,
+		...)
+{
+	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_SYSTEM;
+	char path_buffer[NDM_CORE_RESPONSE_STATIC_PATH_BUFFER_SIZE_];
+	char *value_path = path_buffer;
+	va_list ap;
+
+	va_start(ap, value_path_format);
+	ndm_vabsprintf(
+		path_buffer, sizeof(path_buffer),
+		&value_path, value_path_format, ap);
+	va_end(ap);
+
+	if (value_path != NULL) {
+		e = __ndm_core_response_first_node(node, value, value_path);
+
+		if (value_path != path_buffer) {
+			free(value_path);
+		}
+	}
+
+	return e;
+}
+
+static enum ndm_core_response_error_t __ndm_core_response_first_str(
+		const struct ndm_xml_node_t *node,
+		const char **value,
+		const char *const path_format,
+		va_list ap)
+{
+	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_SYSTEM;
+	char path_buffer[NDM_CORE_RESPONSE_STATIC_PATH_BUFFER_SIZE_];
+	char *path = path_buffer;
+	int path_size = -1;
+	va_list aq;
+
+	va_copy(aq, ap);
+	path_size = ndm_vabsprintf(
+		path_buffer, sizeof(path_buffer),
+		&path, path_format, aq);
+	va_end(aq);
+
+	if (path != NULL) {
+		const struct ndm_xml_node_t *n = node;
+		char *p = path + path_size - 1;
+		char *attr_name = NULL;
+
+		while (
+			path < p &&
+			*p != NDM_CORE_REQUEST_ATTR_PREFIX_ &&
+			*p != '/')
+		{
+			--p;
+		}
+
+		if (path <= p && *p == NDM_CORE_REQUEST_ATTR_PREFIX_) {
+			*p = '\0';
+			attr_name = p + 1;
+		}
+
+		e = __ndm_core_response_first_node(node, &n, path);
+
+		if (e == NDM_CORE_RESPONSE_ERROR_OK) {
+			if (attr_name == NULL) {
+				*value = ndm_xml_node_value(n);
+			} else {
+				struct ndm_xml_attr_t *a =
+					ndm_xml_node_first_attr(n, attr_name);
+
+				if (a == NULL) {
+					e = NDM_CORE_RESPONSE_ERROR_NOT_FOUND;
+				} else {
+					*value = ndm_xml_attr_value(a);
+				}
+			}
+		}
+
+		if (path != path_buffer) {
+			free(path);
+		}
+	}
+
+	return e;
+}
+
+enum ndm_core_response_error_t ndm_core_response_first_str(
+		const struct ndm_xml_node_t *node,
+		const char **value,
+		const char *const path_format,
+		...)
+{
+	va_list ap;
+	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_OK;
+
+	va_start(ap, path_format);
+	e = __ndm_core_response_first_str(node, value, path_format, ap);
+	va_end(ap);
+
+	return e;
+}
+
+#define NDM_CORE_RESPONSE_FIRST_INTEGER_(tabbr, type)						\
+static enum ndm_core_response_error_t __ndm_core_response_first_##tabbr(	\
+		const struct ndm_xml_node_t *node,									\
+		type *value,														\
+		const char *const path_format,										\
+		va_list ap)															\
+{																			\
+	const char *str_value = NULL;											\
+	enum ndm_core_response_error_t e =										\
+		__ndm_core_response_first_str(node, &str_value, path_format, ap);	\
+																			\
+	if (e == NDM_CORE_RESPONSE_ERROR_OK &&									\
+		!ndm_int_parse_##tabbr(str_value, value))							\
+	{																		\
+		e = NDM_CORE_RESPONSE_ERROR_FORMAT;									\
+	}																		\
+																			\
+	return e;																\
+}																			\
+																			\
+enum ndm_core_response_error_t ndm_core_response_first_##tabbr(				\
+		const struct ndm_xml_node_t *node,									\
+		type *value,														\
+		const char *const path_format,										\
+		...)																\
+{																			\
+	va_list ap;																\
+	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_OK;			\
+																			\
+	va_start(ap, path_format);												\
+	e = __ndm_core_response_first_##tabbr(node, value, path_format, ap);	\
+	va_end(ap);																\
+																			\
+	return e;																\
+}																			\
+																			\
+static enum ndm_core_response_error_t __ndm_core_response_first_u##tabbr(	\
+		const struct ndm_xml_node_t *node,									\
+		unsigned type *value,												\
+		const char *const path_format,										\
+		va_list ap)															\
+{																			\
+	const char *str_value = NULL;											\
+	enum ndm_core_response_error_t e =										\
+		__ndm_core_response_first_str(node, &str_value, path_format, ap);	\
+																			\
+	if (e == NDM_CORE_RESPONSE_ERROR_OK &&									\
+		!ndm_int_parse_u##tabbr(str_value, value))							\
+	{																		\
+		e = NDM_CORE_RESPONSE_ERROR_FORMAT;									\
+	}																		\
+																			\
+	return e;																\
+}																			\
+																			\
+enum ndm_core_response_error_t ndm_core_response_first_u##tabbr(			\
+		const struct ndm_xml_node_t *node,									\
+		unsigned type *value,												\
+		const char *const path_format,										\
+		...)																\
+{																			\
+	va_list ap;																\
+	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_OK;			\
+																			\
+	va_start(ap, path_format);												\
+	e = __ndm_core_response_first_u##tabbr(node, value, path_format, ap);	\
+	va_end(ap);																\
+																			\
+	return e;																\
+}
+
+NDM_CORE_RESPONSE_FIRST_INTEGER_(char, char)
+NDM_CORE_RESPONSE_FIRST_INTEGER_(short, short)
+NDM_CORE_RESPONSE_FIRST_INTEGER_(int, int)
+NDM_CORE_RESPONSE_FIRST_INTEGER_(long, long)
+NDM_CORE_RESPONSE_FIRST_INTEGER_(llong, long long)
+
+static enum ndm_core_response_error_t __ndm_core_response_parse_bool(
+		enum ndm_core_response_error_t e,
+		const char *const str_value,
+		const bool parse_value,
+		bool *value)
+{
+	if (!parse_value) {
+		/* try to find only */
+		if (e == NDM_CORE_RESPONSE_ERROR_OK) {
+			/* a tag found */
+			*value = true;
+		} else
+		if (e == NDM_CORE_RESPONSE_ERROR_NOT_FOUND) {
+			/* no tag found */
+			*value = false;
+			e = NDM_CORE_RESPONSE_ERROR_OK;
+		}
+	} else
+	if (e == NDM_CORE_RESPONSE_ERROR_OK) {
+		long l;
 
-				if (command_node == NULL) {
-					errno = ENOMEM;
-				} else
-				if ((request_type == NDM_CORE_REQUEST_CONFIG ||
-					 request_type == NDM_CORE_REQUEST_EXECUTE) &&
-					 ndm_xml_node_append_attr_str(command_node,
-						NDM_CORE_REQUEST_ATTR_NAME_, command) == NULL)
-				{
-					errno = ENOMEM;
-					command_node = NULL;
-				} else
-				if (command_args != NULL) {
-					size_t i = 0;
+		if (ndm_int_parse_long(str_value, &l)) {
+			*value = (l == 0) ? false : true;
+		} else
+		if (strcasecmp(str_value, "yes") == 0 ||
+			strcasecmp(str_value, "true") == 0 ||
+			strcasecmp(str_value, "up") == 0 ||
+			strcasecmp(str_value, "on") == 0)
+		{
+			*value = true;
+		} else
+		if (strcasecmp(str_value, "no") == 0 ||
+			strcasecmp(str_value, "false") == 0 ||
+			strcasecmp(str_value, "down") == 0 ||
+			strcasecmp(str_value, "off") == 0)
+		{
+			*value = false;
+		} else {
+			e = NDM_CORE_RESPONSE_ERROR_FORMAT;
+		}
+	}
 
-					while (
-						command_node != NULL &&
-						command_args[i] != NULL &&
-						command_args[i + 1] != NULL)
-					{
-						const char *const name = command_args[i];
-						const char *const value = command_args[i + 1];
+	return e;
+}
 
-						if (*name == NDM_CORE_REQUEST_ATTR_PREFIX_) {
-							if (strcmp(
-									name +
-									sizeof(NDM_CORE_REQUEST_ATTR_PREFIX_),
-									NDM_CORE_REQUEST_ATTR_NAME_) == 0)
-							{
-								/* reserved attribute */
-								errno = EINVAL;
-								command_node = NULL;
-							} else
-							if (ndm_xml_node_append_attr_str(
-									command_node, name, value) == NULL)
-							{
-								errno = ENOMEM;
-								command_node = NULL;
-							}
-						} else
-						if (ndm_xml_node_append_child_str(
-								command_node, name, value) == NULL)
-						{
-							errno = ENOMEM;
-							command_node = NULL;
-						} else {
-							has_args = true;
-						}
+static enum ndm_core_response_error_t __ndm_core_response_first_bool(
+		const struct ndm_xml_node_t *node,
+		const bool parse_value,
+		bool *value,
+		const char *const path_format,
+		va_list ap)
+{
+	const char *str_value = NULL;
+	const enum ndm_core_response_error_t e =
+		__ndm_core_response_first_str(node, &str_value, path_format, ap);
 
-						i += 2;
-					}
+	return __ndm_core_response_parse_bool(e, str_value, parse_value, value);
+}
 
-					if (command_node != NULL &&
-						command_args[i] != NULL)
-					{
-						if (command_args[i + 1] == NULL) {
-							errno = EINVAL;
-						} else {
-							/* ENOMEM or EINVAL */
-						}
+enum ndm_core_response_error_t ndm_core_response_first_bool(
+		const struct ndm_xml_node_t *node,
+		const bool parse_value,
+		bool *value,
+		const char *const path_format,
+		...)
+{
+	va_list ap;
+	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_OK;
 
-						command_node = NULL;
-					}
-				}
+	va_start(ap, path_format);
+	e = __ndm_core_response_first_bool(node,
+		parse_value, value, path_format, ap);
+	va_end(ap);
 
-				if (command_node != NULL) {
-					if (request_type == NDM_CORE_REQUEST_PARSE &&
-						has_args)
-					{
-						/* no arguments allowed for "parse" request */
-						errno = EINVAL;
-						command_node = NULL;
-					} else {
-						response = __ndm_core_do_request(core,
-							cache_mode, copy_cached_response,
-							request_node, response_copied);
-					}
-				}
+	return e;
+}
+
+/**
+ * Compiled path functions.
+ **/
+
+struct ndm_core_path_t *ndm_core_path_compile(
+		const char *const path_format,
+		...)
+{
+	struct ndm_core_path_t *path = NULL;
+	char path_buffer[NDM_CORE_RESPONSE_STATIC_PATH_BUFFER_SIZE_];
+	char *value_path = path_buffer;
+	char *attr_name = NULL;
+	char *p = NULL;
+	size_t segment_count = 0;
+	int path_size = -1;
+	va_list ap;
+
+	va_start(ap, path_format);
+	path_size = ndm_vabsprintf(
+		path_buffer, sizeof(path_buffer),
+		&value_path, path_format, ap);
+	va_end(ap);
+
+	if (value_path == NULL) {
+		return NULL;
+	}
+
+	/* an attribute reference is allowed after the last node only */
+	p = value_path + path_size;
+
+	while (value_path < p && *(p - 1) != '/' &&
+		   *(p - 1) != NDM_CORE_REQUEST_ATTR_PREFIX_)
+	{
+		--p;
+	}
+
+	if (value_path < p && *(p - 1) == NDM_CORE_REQUEST_ATTR_PREFIX_) {
+		*(p - 1) = '\0';
+		attr_name = p;
+	}
+
+	if (strchr(value_path, NDM_CORE_REQUEST_ATTR_PREFIX_) != NULL) {
+		errno = EINVAL;
+	} else {
+		const size_t strings_size = (size_t) path_size + 1;
+		char *strings = NULL;
+
+		for (p = value_path; *p != '\0'; p++) {
+			if (*p != '/' && (p == value_path || *(p - 1) == '/')) {
+				++segment_count;
 			}
+		}
 
-			if (command != command_buffer) {
-				free(command);
+		if ((path = malloc(
+				sizeof(*path) +
+				segment_count*sizeof(path->segments[0]) +
+				strings_size)) == NULL)
+		{
+			errno = ENOMEM;
+		} else {
+			strings = (char *) &path->segments[segment_count];
+			memcpy(strings, value_path, strings_size);
+
+			path->attr_name = (attr_name == NULL) ?
+				NULL : strings + (attr_name - value_path);
+			path->segment_count = 0;
+
+			for (p = strings; *p != '\0'; p++) {
+				if (*p == '/') {
+					*p = '\0';
+				} else
+				if (p == strings || *(p - 1) == '\0') {
+					path->segments[path->segment_count++] = p;
+				}
 			}
 		}
 	}
 
-	ndm_xml_document_clear(&request);
+	if (value_path != path_buffer) {
+		free(value_path);
+	}
 
-	return response;
+	return path;
 }
 
-static struct ndm_core_response_t *__ndm_core_request_cf(
-		struct ndm_core_t *core,
-		const enum ndm_core_request_type_t request_type,
-		const enum ndm_core_cache_mode_t cache_mode,
-		const bool copy_cached_response,
-		bool *response_copied,
-		const char *const command_args[],
-		const char *const command_format,
-		...)
+void ndm_core_path_free(
+		struct ndm_core_path_t **path)
 {
-	va_list ap;
-	struct ndm_core_response_t *response = NULL;
+	if (path != NULL) {
+		free(*path);
+		*path = NULL;
+	}
+}
 
-	va_start(ap, command_format);
-	response = __ndm_core_request(
-		core, request_type, cache_mode, copy_cached_response,
-		response_copied, command_args, command_format, ap);
-	va_end(ap);
+static enum ndm_core_response_error_t __ndm_core_path_first_node(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t **value)
+{
+	size_t i;
 
-	return response;
+	*value = node;
+
+	for (i = 0; i < path->segment_count; i++) {
+		if ((*value = ndm_xml_node_first_child(
+				*value, path->segments[i])) == NULL)
+		{
+			/* there is no such a child */
+			return NDM_CORE_RESPONSE_ERROR_NOT_FOUND;
+		}
+	}
+
+	return NDM_CORE_RESPONSE_ERROR_OK;
+}
+
+enum ndm_core_response_error_t ndm_core_path_first_node(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t **value)
+{
+	if (path->attr_name != NULL) {
+		/* no attribute reference allowed here */
+		return NDM_CORE_RESPONSE_ERROR_SYNTAX;
+	}
+
+	return __ndm_core_path_first_node(path, node, value);
+}
+
+enum ndm_core_response_error_t ndm_core_path_first_str(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const char **value)
+{
+	const struct ndm_xml_node_t *n = NULL;
+	enum ndm_core_response_error_t e =
+		__ndm_core_path_first_node(path, node, &n);
+
+	if (e == NDM_CORE_RESPONSE_ERROR_OK) {
+		if (path->attr_name == NULL) {
+			*value = ndm_xml_node_value(n);
+		} else {
+			struct ndm_xml_attr_t *a =
+				ndm_xml_node_first_attr(n, path->attr_name);
+
+			if (a == NULL) {
+				e = NDM_CORE_RESPONSE_ERROR_NOT_FOUND;
+			} else {
+				*value = ndm_xml_attr_value(a);
+			}
+		}
+	}
+
+	return e;
+}
+
+#define NDM_CORE_PATH_FIRST_INTEGER_(tabbr, type)							\
+enum ndm_core_response_error_t ndm_core_path_first_##tabbr(					\
+		const struct ndm_core_path_t *path,									\
+		const struct ndm_xml_node_t *node,									\
+		type *value)														\
+{																			\
+	const char *str_value = NULL;											\
+	enum ndm_core_response_error_t e =										\
+		ndm_core_path_first_str(path, node, &str_value);					\
+																			\
+	if (e == NDM_CORE_RESPONSE_ERROR_OK &&									\
+		!ndm_int_parse_##tabbr(str_value, value))							\
+	{																		\
+		e = NDM_CORE_RESPONSE_ERROR_FORMAT;									\
+	}																		\
+																			\
+	return e;																\
+}																			\
+																			\
+enum ndm_core_response_error_t ndm_core_path_first_u##tabbr(				\
+		const struct ndm_core_path_t *path,									\
+		const struct ndm_xml_node_t *node,									\
+		unsigned type *value)												\
+{																			\
+	const char *str_value = NULL;											\
+	enum ndm_core_response_error_t e =										\
+		ndm_core_path_first_str(path, node, &str_value);					\
+																			\
+	if (e == NDM_CORE_RESPONSE_ERROR_OK &&									\
+		!ndm_int_parse_u##tabbr(str_value, value))							\
+	{																		\
+		e = NDM_CORE_RESPONSE_ERROR_FORMAT;									\
+	}																		\
+																			\
+	return e;																\
 }
 
-struct ndm_core_response_t *ndm_core_request(
-		struct ndm_core_t *core,
-		const enum ndm_core_request_type_t request_type,
-		const enum ndm_core_cache_mode_t cache_mode,
-		const char *const command_args[],
-		const char *const command_format,
-		...)
-{
-	va_list ap;
-	struct ndm_core_response_t *response = NULL;
+NDM_CORE_PATH_FIRST_INTEGER_(char, char)
+NDM_CORE_PATH_FIRST_INTEGER_(short, short)
+NDM_CORE_PATH_FIRST_INTEGER_(int, int)
+NDM_CORE_PATH_FIRST_INTEGER_(long, long)
+NDM_CORE_PATH_FIRST_INTEGER_(llong, long long)
 
-	va_start(ap, command_format);
-	response = __ndm_core_request(
-		core, request_type, cache_mode, true,
-		NULL, command_args, command_format, ap);
-	va_end(ap);
+enum ndm_core_response_error_t ndm_core_path_first_bool(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const bool parse_value,
+		bool *value)
+{
+	const char *str_value = NULL;
+	const enum ndm_core_response_error_t e =
+		ndm_core_path_first_str(path, node, &str_value);
 
-	return response;
+	return __ndm_core_response_parse_bool(e, str_value, parse_value, value);
 }
 
-static struct ndm_core_response_t *__ndm_core_get_one_tag(
-		struct ndm_core_t *core,
-		const enum ndm_core_cache_mode_t cache_mode,
-		const char *const tag,
-		const char *const value)
+/**
+ * A path cursor resumes a depth-first search from a previous match
+ * climbing up by parent links, so no traversal stack is kept.
+ **/
+
+static const struct ndm_xml_node_t *__ndm_core_path_descend(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const size_t level)
 {
-	struct ndm_core_response_t *response = NULL;
-	uint8_t request_buffer[NDM_CORE_REQUEST_STATIC_SIZE_];
-	struct ndm_xml_document_t request;
-	struct ndm_xml_node_t *request_node =
-		__ndm_core_request_document_init(&request,
-			request_buffer, sizeof(request_buffer),
-			core->agent);
+	const char *const name = path->segments[level];
+	const struct ndm_xml_node_t *n = ndm_xml_node_first_child(node, name);
 
-	if (request_node != NULL &&
-		ndm_xml_node_append_child_str(request_node, tag, value) != NULL)
-	{
-		response = __ndm_core_do_request(core,
-			cache_mode, true, request_node, NULL);
+	if (level + 1 == path->segment_count) {
+		return n;
 	}
 
-	ndm_xml_document_clear(&request);
+	while (n != NULL) {
+		const struct ndm_xml_node_t *m =
+			__ndm_core_path_descend(path, n, level + 1);
 
-	return response;
-}
+		if (m != NULL) {
+			return m;
+		}
 
-struct ndm_core_response_t *ndm_core_get_help(
-		struct ndm_core_t *core,
-		const enum ndm_core_cache_mode_t cache_mode,
-		const char *const command)
-{
-	return __ndm_core_get_one_tag(core,
-		cache_mode, "help", command);
-}
+		n = ndm_xml_node_next_sibling(n, name);
+	}
 
-struct ndm_core_response_t *ndm_core_continue(
-		struct ndm_core_t *core)
-{
-	return __ndm_core_get_one_tag(core,
-		NDM_CORE_MODE_NO_CACHE, "continue", "");
+	return NULL;
 }
 
-struct ndm_core_response_t *ndm_core_break(
-		struct ndm_core_t *core)
+static const struct ndm_xml_node_t *__ndm_core_path_next(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t *previous)
 {
-	return __ndm_core_get_one_tag(core,
-		NDM_CORE_MODE_NO_CACHE, "break", "");
-}
+	size_t level = path->segment_count;
 
-bool ndm_core_last_message_received(
-		struct ndm_core_t *core)
-{
-	return core->last_message.received;
-}
+	if (previous == NULL) {
+		return (level == 0) ?
+			node : __ndm_core_path_descend(path, node, 0);
+	}
 
-enum ndm_core_response_type_t ndm_core_last_message_type(
-		struct ndm_core_t *core)
-{
-	return core->last_message.type;
-}
+	while (level > 0) {
+		const char *const name = path->segments[level - 1];
+		const struct ndm_xml_node_t *n =
+			ndm_xml_node_next_sibling(previous, name);
 
-const char *ndm_core_last_message_string(
-		struct ndm_core_t *core)
-{
-	return core->last_message.string;
-}
+		while (n != NULL) {
+			const struct ndm_xml_node_t *m = (level == path->segment_count) ?
+				n : __ndm_core_path_descend(path, n, level);
 
-const char *ndm_core_last_message_ident(
-		struct ndm_core_t *core)
-{
-	return core->last_message.ident;
-}
+			if (m != NULL) {
+				return m;
+			}
 
-const char *ndm_core_last_message_source(
-		struct ndm_core_t *core)
-{
-	return core->last_message.source;
-}
+			n = ndm_xml_node_next_sibling(n, name);
+		}
 
-ndm_code_t ndm_core_last_message_code(
-		struct ndm_core_t *core)
-{
-	return core->last_message.code;
+		previous = ndm_xml_node_parent(previous);
+		--level;
+	}
+
+	return NULL;
 }
 
-void ndm_core_response_free(
-		struct ndm_core_response_t **response)
+enum ndm_core_response_error_t ndm_core_path_next_node(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t **value)
 {
-	if (response != NULL && *response != NULL) {
-		ndm_xml_document_clear(&(*response)->doc);
-		free(*response);
-		*response = NULL;
+	if (path->attr_name != NULL) {
+		/* no attribute reference allowed here */
+		return NDM_CORE_RESPONSE_ERROR_SYNTAX;
 	}
-}
 
-bool ndm_core_response_is_ok(
-		const struct ndm_core_response_t *response)
-{
-	const enum ndm_core_response_type_t type =
-		ndm_core_response_type(response);
+	if ((*value = __ndm_core_path_next(path, node, *value)) == NULL) {
+		return NDM_CORE_RESPONSE_ERROR_NOT_FOUND;
+	}
 
-	return type == NDM_CORE_INFO || type == NDM_CORE_WARNING;
+	return NDM_CORE_RESPONSE_ERROR_OK;
 }
 
-enum ndm_core_response_type_t ndm_core_response_type(
-		const struct ndm_core_response_t *response)
+enum ndm_core_response_error_t ndm_core_path_next_str(
+		const struct ndm_core_path_t *path,
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t **cursor,
+		const char **value)
 {
-	enum ndm_core_response_type_t message_type = NDM_CORE_INFO;
+	while ((*cursor = __ndm_core_path_next(path, node, *cursor)) != NULL) {
+		if (path->attr_name == NULL) {
+			*value = ndm_xml_node_value(*cursor);
 
-	if (__ndm_core_response_message_node(response, &message_type) == NULL) {
-		message_type = NDM_CORE_INFO;
+			return NDM_CORE_RESPONSE_ERROR_OK;
+		} else {
+			struct ndm_xml_attr_t *a =
+				ndm_xml_node_first_attr(*cursor, path->attr_name);
+
+			if (a != NULL) {
+				*value = ndm_xml_attr_value(a);
+
+				return NDM_CORE_RESPONSE_ERROR_OK;
+			}
+		}
 	}
 
-	return message_type;
+	return NDM_CORE_RESPONSE_ERROR_NOT_FOUND;
 }
 
-bool ndm_core_response_is_continued(
-		const struct ndm_core_response_t *response)
-{
-	return ndm_xml_node_first_child(response->root, "continued") != NULL;
-}
+/**
+ * Schema functions.
+ **/
 
-const struct ndm_xml_node_t *ndm_core_response_root(
-		const struct ndm_core_response_t *response)
+static size_t __ndm_core_schema_add_node(
+		struct ndm_core_schema_t *schema,
+		const size_t parent,
+		const char *const name)
 {
-	return response->root;
+	struct ndm_core_schema_node_t *p = &schema->nodes[parent];
+	size_t i = p->first_child;
+	size_t last = NDM_CORE_SCHEMA_NO_NODE_;
+
+	while (i != NDM_CORE_SCHEMA_NO_NODE_) {
+		if (strcmp(schema->nodes[i].name, name) == 0) {
+			return i;
+		}
+
+		last = i;
+		i = schema->nodes[i].next_sibling;
+	}
+
+	i = schema->node_count++;
+	schema->nodes[i].name = name;
+	schema->nodes[i].first_child = NDM_CORE_SCHEMA_NO_NODE_;
+	schema->nodes[i].next_sibling = NDM_CORE_SCHEMA_NO_NODE_;
+	schema->nodes[i].child_count = 0;
+
+	/* keep a schema order of children */
+	if (last == NDM_CORE_SCHEMA_NO_NODE_) {
+		p->first_child = i;
+	} else {
+		schema->nodes[last].next_sibling = i;
+	}
+
+	p->child_count++;
+
+	return i;
 }
 
-static struct ndm_core_response_t *__ndm_core_response_copy(
-		const struct ndm_core_response_t *response)
+struct ndm_core_schema_t *ndm_core_schema_compile(
+		const struct ndm_core_field_t *fields,
+		const size_t field_count)
 {
-	struct ndm_core_response_t *copy = malloc(sizeof(*response));
+	struct ndm_core_schema_t *schema =
+		malloc(sizeof(*schema) + field_count*sizeof(schema->fields[0]));
+	size_t node_count = 1;
+	size_t i;
 
-	if (copy != NULL) {
-		bool error = false;
+	if (schema == NULL) {
+		errno = ENOMEM;
 
-		copy->id = response->id;
+		return NULL;
+	}
 
-		ndm_xml_document_init(&copy->doc,
-			copy->buffer, sizeof(copy->buffer),
-			NDM_CORE_RESPONSE_DYNAMIC_BLOCK_SIZE_);
+	schema->nodes = NULL;
+	schema->node_count = 0;
+	schema->field_count = 0;
 
-		if (!ndm_xml_document_copy(&copy->doc, &response->doc)) {
-			error = true;
-			errno = ENOMEM;
-		} else
-		if ((copy->root = ndm_xml_node_first_child(
-				ndm_xml_document_root(&copy->doc), "response")) == NULL)
-		{
-			error = true;
+	for (i = 0; i < field_count; i++) {
+		struct ndm_core_schema_field_t *f = &schema->fields[i];
+
+		if ((f->path = ndm_core_path_compile("%s", fields[i].path)) == NULL) {
+			ndm_core_schema_free(&schema);
+
+			return NULL;
+		}
+
+		f->type = fields[i].type;
+		f->offset = fields[i].offset;
+		f->node = 0;
+		schema->field_count++;
+		node_count += f->path->segment_count;
+
+		if (f->type == NDM_CORE_FIELD_NODE && f->path->attr_name != NULL) {
+			/* no attribute reference allowed for a node field */
+			ndm_core_schema_free(&schema);
 			errno = EINVAL;
+
+			return NULL;
 		}
+	}
+
+	if ((schema->nodes = malloc(node_count*sizeof(*schema->nodes))) == NULL) {
+		ndm_core_schema_free(&schema);
+		errno = ENOMEM;
+
+		return NULL;
+	}
 
-		if (error) {
-			ndm_xml_document_clear(&copy->doc);
-			free(copy);
-			copy = NULL;
+	schema->nodes[0].name = "";
+	schema->nodes[0].first_child = NDM_CORE_SCHEMA_NO_NODE_;
+	schema->nodes[0].next_sibling = NDM_CORE_SCHEMA_NO_NODE_;
+	schema->nodes[0].child_count = 0;
+	schema->node_count = 1;
+
+	for (i = 0; i < schema->field_count; i++) {
+		struct ndm_core_schema_field_t *f = &schema->fields[i];
+		size_t j;
+
+		for (j = 0; j < f->path->segment_count; j++) {
+			f->node = __ndm_core_schema_add_node(
+				schema, f->node, f->path->segments[j]);
 		}
 	}
 
-	return copy;
+	return schema;
 }
 
-static inline size_t __ndm_core_response_size(
-		const struct ndm_core_response_t *response)
+void ndm_core_schema_free(
+		struct ndm_core_schema_t **schema)
 {
-	return (response == NULL) ?
-		0 : sizeof(*response) + ndm_xml_document_size(&response->doc);
-}
+	if (schema != NULL && *schema != NULL) {
+		size_t i;
 
-static inline void __ndm_core_response_find_end(char **p)
-{
-	char *q = *p;
+		for (i = 0; i < (*schema)->field_count; i++) {
+			ndm_core_path_free(&(*schema)->fields[i].path);
+		}
 
-	while (*q != '/' && *q != NDM_CORE_REQUEST_ATTR_PREFIX_ && *q != '\0') {
-		++q;
+		free((*schema)->nodes);
+		free(*schema);
+		*schema = NULL;
 	}
-
-	*p = q;
 }
 
-static enum ndm_core_response_error_t __ndm_core_response_first_node(
+static enum ndm_core_response_error_t __ndm_core_schema_field_set(
+		const struct ndm_core_schema_field_t *field,
 		const struct ndm_xml_node_t *node,
-		const struct ndm_xml_node_t **value,
-		char *value_path)
+		uint8_t *dest)
 {
 	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_OK;
-	char *p = value_path;
+	uint8_t *value = dest + field->offset;
+	const char *str_value = NULL;
 
-	*value = node;
+	if (node == NULL) {
+		e = NDM_CORE_RESPONSE_ERROR_NOT_FOUND;
+	} else
+	if (field->path->attr_name == NULL) {
+		str_value = ndm_xml_node_value(node);
+	} else {
+		struct ndm_xml_attr_t *a =
+			ndm_xml_node_first_attr(node, field->path->attr_name);
 
-	do {
-		const char *node_name = p;
+		if (a == NULL) {
+			e = NDM_CORE_RESPONSE_ERROR_NOT_FOUND;
+		} else {
+			str_value = ndm_xml_attr_value(a);
+		}
+	}
 
-		__ndm_core_response_find_end(&p);
+	switch (field->type) {
+		case NDM_CORE_FIELD_NODE:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK) {
+				*((const struct ndm_xml_node_t **) value) = node;
+			}
 
-		if (*p == NDM_CORE_REQUEST_ATTR_PREFIX_) {
-			/* no attribute reference allowed here */
-			e = NDM_CORE_RESPONSE_ERROR_SYNTAX;
-		} else {
-			if (*p == '/') {
-				*p = '\0';
-				++p;
+			break;
+
+		case NDM_CORE_FIELD_STR:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK) {
+				*((const char **) value) = str_value;
+			}
+
+			break;
+
+		case NDM_CORE_FIELD_CHAR:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK &&
+				!ndm_int_parse_char(str_value, (char *) value))
+			{
+				e = NDM_CORE_RESPONSE_ERROR_FORMAT;
+			}
+
+			break;
+
+		case NDM_CORE_FIELD_UCHAR:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK &&
+				!ndm_int_parse_uchar(str_value, (unsigned char *) value))
+			{
+				e = NDM_CORE_RESPONSE_ERROR_FORMAT;
+			}
+
+			break;
+
+		case NDM_CORE_FIELD_SHORT:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK &&
+				!ndm_int_parse_short(str_value, (short *) value))
+			{
+				e = NDM_CORE_RESPONSE_ERROR_FORMAT;
+			}
+
+			break;
+
+		case NDM_CORE_FIELD_USHORT:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK &&
+				!ndm_int_parse_ushort(str_value, (unsigned short *) value))
+			{
+				e = NDM_CORE_RESPONSE_ERROR_FORMAT;
+			}
+
+			break;
+
+		case NDM_CORE_FIELD_INT:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK &&
+				!ndm_int_parse_int(str_value, (int *) value))
+			{
+				e = NDM_CORE_RESPONSE_ERROR_FORMAT;
+			}
+
+			break;
+
+		case NDM_CORE_FIELD_UINT:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK &&
+				!ndm_int_parse_uint(str_value, (unsigned int *) value))
+			{
+				e = NDM_CORE_RESPONSE_ERROR_FORMAT;
+			}
+
+			break;
+
+		case NDM_CORE_FIELD_LONG:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK &&
+				!ndm_int_parse_long(str_value, (long *) value))
+			{
+				e = NDM_CORE_RESPONSE_ERROR_FORMAT;
+			}
+
+			break;
+
+		case NDM_CORE_FIELD_ULONG:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK &&
+				!ndm_int_parse_ulong(str_value, (unsigned long *) value))
+			{
+				e = NDM_CORE_RESPONSE_ERROR_FORMAT;
 			}
 
-			if (*node_name != '\0' &&
-				(*value = ndm_xml_node_first_child(
-					*value, node_name)) == NULL)
+			break;
+
+		case NDM_CORE_FIELD_LLONG:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK &&
+				!ndm_int_parse_llong(str_value, (long long *) value))
 			{
-				/* there is no such a child */
-				e = NDM_CORE_RESPONSE_ERROR_NOT_FOUND;
+				e = NDM_CORE_RESPONSE_ERROR_FORMAT;
 			}
-		}
-	} while (*p != '\0' && e == NDM_CORE_RESPONSE_ERROR_OK);
 
-	return e;
-}
+			break;
 
-enum ndm_core_response_error_t ndm_core_response_first_node(
-		const struct ndm_xml_node_t *node,
-		const struct ndm_xml_node_t **value,
-		const char *const value_path_format,
-		...)
-{
-	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_SYSTEM;
-	char path_buffer[NDM_CORE_RESPONSE_STATIC_PATH_BUFFER_SIZE_];
-	char *value_path = path_buffer;
-	va_list ap;
+		case NDM_CORE_FIELD_ULLONG:
+			if (e == NDM_CORE_RESPONSE_ERROR_OK &&
+				!ndm_int_parse_ullong(str_value, (unsigned long long *) value))
+			{
+				e = NDM_CORE_RESPONSE_ERROR_FORMAT;
+			}
 
-	va_start(ap, value_path_format);
-	ndm_vabsprintf(
-		path_buffer, sizeof(path_buffer),
-		&value_path, value_path_format, ap);
-	va_end(ap);
+			break;
 
-	if (value_path != NULL) {
-		e = __ndm_core_response_first_node(node, value, value_path);
+		case NDM_CORE_FIELD_BOOL:
+			e = __ndm_core_response_parse_bool(
+				e, str_value, true, (bool *) value);
 
-		if (value_path != path_buffer) {
-			free(value_path);
-		}
+			break;
+
+		case NDM_CORE_FIELD_PRESENT:
+			e = __ndm_core_response_parse_bool(
+				e, str_value, false, (bool *) value);
+
+			break;
 	}
 
 	return e;
 }
 
-static enum ndm_core_response_error_t __ndm_core_response_first_str(
+/**
+ * Match every schema node to the first child with the same name,
+ * children of each matched node are enumerated only once.
+ **/
+
+static void __ndm_core_schema_walk(
+		const struct ndm_core_schema_t *schema,
+		const size_t index,
 		const struct ndm_xml_node_t *node,
-		const char **value,
-		const char *const path_format,
-		va_list ap)
+		const struct ndm_xml_node_t **matches)
 {
-	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_SYSTEM;
-	char path_buffer[NDM_CORE_RESPONSE_STATIC_PATH_BUFFER_SIZE_];
-	char *path = path_buffer;
-	int path_size = -1;
-	va_list aq;
-
-	va_copy(aq, ap);
-	path_size = ndm_vabsprintf(
-		path_buffer, sizeof(path_buffer),
-		&path, path_format, aq);
-	va_end(aq);
+	const struct ndm_core_schema_node_t *s = &schema->nodes[index];
+	const struct ndm_xml_node_t *child = NULL;
+	size_t unmatched = s->child_count;
 
-	if (path != NULL) {
-		const struct ndm_xml_node_t *n = node;
-		char *p = path + path_size - 1;
-		char *attr_name = NULL;
+	matches[index] = node;
 
-		while (
-			path < p &&
-			*p != NDM_CORE_REQUEST_ATTR_PREFIX_ &&
-			*p != '/')
-		{
-			--p;
-		}
+	if (unmatched == 0) {
+		return;
+	}
 
-		if (path <= p && *p == NDM_CORE_REQUEST_ATTR_PREFIX_) {
-			*p = '\0';
-			attr_name = p + 1;
-		}
+	child = ndm_xml_node_first_child(node, NULL);
 
-		e = __ndm_core_response_first_node(node, &n, path);
+	while (child != NULL && unmatched > 0) {
+		const char *const name = ndm_xml_node_name(child);
+		size_t i = s->first_child;
 
-		if (e == NDM_CORE_RESPONSE_ERROR_OK) {
-			if (attr_name == NULL) {
-				*value = ndm_xml_node_value(n);
-			} else {
-				struct ndm_xml_attr_t *a =
-					ndm_xml_node_first_attr(n, attr_name);
+		while (i != NDM_CORE_SCHEMA_NO_NODE_) {
+			if (matches[i] == NULL &&
+				strcmp(schema->nodes[i].name, name) == 0)
+			{
+				__ndm_core_schema_walk(schema, i, child, matches);
+				--unmatched;
 
-				if (a == NULL) {
-					e = NDM_CORE_RESPONSE_ERROR_NOT_FOUND;
-				} else {
-					*value = ndm_xml_attr_value(a);
-				}
+				break;
 			}
-		}
 
-		if (path != path_buffer) {
-			free(path);
+			i = schema->nodes[i].next_sibling;
 		}
-	}
 
-	return e;
+		child = ndm_xml_node_next_sibling(child, NULL);
+	}
 }
 
-enum ndm_core_response_error_t ndm_core_response_first_str(
+enum ndm_core_response_error_t ndm_core_schema_extract(
+		const struct ndm_core_schema_t *schema,
 		const struct ndm_xml_node_t *node,
-		const char **value,
-		const char *const path_format,
-		...)
+		void *dest,
+		enum ndm_core_response_error_t *errors)
 {
-	va_list ap;
 	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_OK;
+	const struct ndm_xml_node_t *static_matches[
+		NDM_CORE_SCHEMA_STATIC_MATCH_BUFFER_SIZE_/sizeof(void *)];
+	const struct ndm_xml_node_t **matches = static_matches;
+	size_t i;
 
-	va_start(ap, path_format);
-	e = __ndm_core_response_first_str(node, value, path_format, ap);
-	va_end(ap);
+	if (schema->node_count > NDM_ARRAY_SIZE(static_matches) &&
+		(matches = malloc(schema->node_count*sizeof(*matches))) == NULL)
+	{
+		errno = ENOMEM;
 
-	return e;
-}
+		return NDM_CORE_RESPONSE_ERROR_SYSTEM;
+	}
 
-#define NDM_CORE_RESPONSE_FIRST_INTEGER_(tabbr, type)						\
-static enum ndm_core_response_error_t __ndm_core_response_first_##tabbr(	\
-		const struct ndm_xml_node_t *node,									\
-		type *value,														\
-		const char *const path_format,										\
-		va_list ap)															\
-{																			\
-	const char *str_value = NULL;											\
-	enum ndm_core_response_error_t e =										\
-		__ndm_core_response_first_str(node, &str_value, path_format, ap);	\
-																			\
-	if (e == NDM_CORE_RESPONSE_ERROR_OK &&									\
-		!ndm_int_parse_##tabbr(str_value, value))							\
-	{																		\
-		e = NDM_CORE_RESPONSE_ERROR_FORMAT;									\
-	}																		\
-																			\
-	return e;																\
-}																			\
-																			\
-enum ndm_core_response_error_t ndm_core_response_first_##tabbr(				\
-		const struct ndm_xml_node_t *node,									\
-		type *value,														\
-		const char *const path_format,										\
-		...)																\
-{																			\
-	va_list ap;																\
-	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_OK;			\
-																			\
-	va_start(ap, path_format);												\
-	e = __ndm_core_response_first_##tabbr(node, value, path_format, ap);	\
-	va_end(ap);																\
-																			\
-	return e;																\
-}																			\
-																			\
-static enum ndm_core_response_error_t __ndm_core_response_first_u##tabbr(	\
-		const struct ndm_xml_node_t *node,									\
-		unsigned type *value,												\
-		const char *const path_format,										\
-		va_list ap)															\
-{																			\
-	const char *str_value = NULL;											\
-	enum ndm_core_response_error_t e =										\
-		__ndm_core_response_first_str(node, &str_value, path_format, ap);	\
-																			\
-	if (e == NDM_CORE_RESPONSE_ERROR_OK &&									\
-		!ndm_int_parse_u##tabbr(str_value, value))							\
-	{																		\
-		e = NDM_CORE_RESPONSE_ERROR_FORMAT;									\
-	}																		\
-																			\
-	return e;																\
-}																			\
-																			\
-enum ndm_core_response_error_t ndm_core_response_first_u##tabbr(			\
-		const struct ndm_xml_node_t *node,									\
-		unsigned type *value,												\
-		const char *const path_format,										\
-		...)																\
-{																			\
-	va_list ap;																\
-	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_OK;			\
-																			\
-	va_start(ap, path_format);												\
-	e = __ndm_core_response_first_u##tabbr(node, value, path_format, ap);	\
-	va_end(ap);																\
-																			\
-	return e;																\
-}
+	for (i = 0; i < schema->node_count; i++) {
+		matches[i] = NULL;
+	}
 
-NDM_CORE_RESPONSE_FIRST_INTEGER_(char, char)
-NDM_CORE_RESPONSE_FIRST_INTEGER_(short, short)
-NDM_CORE_RESPONSE_FIRST_INTEGER_(int, int)
-NDM_CORE_RESPONSE_FIRST_INTEGER_(long, long)
-NDM_CORE_RESPONSE_FIRST_INTEGER_(llong, long long)
+	__ndm_core_schema_walk(schema, 0, node, matches);
 
-static enum ndm_core_response_error_t __ndm_core_response_first_bool(
-		const struct ndm_xml_node_t *node,
-		const bool parse_value,
-		bool *value,
-		const char *const path_format,
-		va_list ap)
-{
-	const char *str_value = NULL;
-	enum ndm_core_response_error_t e =
-		__ndm_core_response_first_str(node, &str_value, path_format, ap);
+	for (i = 0; i < schema->field_count; i++) {
+		const struct ndm_core_schema_field_t *f = &schema->fields[i];
+		const enum ndm_core_response_error_t field_e =
+			__ndm_core_schema_field_set(f, matches[f->node], dest);
 
-	if (!parse_value) {
-		/* try to find only */
-		if (e == NDM_CORE_RESPONSE_ERROR_OK) {
-			/* a tag found */
-			*value = true;
-		} else
-		if (e == NDM_CORE_RESPONSE_ERROR_NOT_FOUND) {
-			/* no tag found */
-			*value = false;
-			e = NDM_CORE_RESPONSE_ERROR_OK;
+		if (errors != NULL) {
+			errors[i] = field_e;
 		}
-	} else
-	if (e == NDM_CORE_RESPONSE_ERROR_OK) {
-		long l;
 
-		if (ndm_int_parse_long(str_value, &l)) {
-			*value = (l == 0) ? false : true;
-		} else
-		if (strcasecmp(str_value, "yes") == 0 ||
-			strcasecmp(str_value, "true") == 0 ||
-			strcasecmp(str_value, "up") == 0 ||
-			strcasecmp(str_value, "on") == 0)
-		{
-			*value = true;
-		} else
-		if (strcasecmp(str_value, "no") == 0 ||
-			strcasecmp(str_value, "false") == 0 ||
-			strcasecmp(str_value, "down") == 0 ||
-			strcasecmp(str_value, "off") == 0)
-		{
-			*value = false;
-		} else {
-			e = NDM_CORE_RESPONSE_ERROR_FORMAT;
+		if (e == NDM_CORE_RESPONSE_ERROR_OK) {
+			e = field_e;
 		}
 	}
 
-	return e;
-}
-
-enum ndm_core_response_error_t ndm_core_response_first_bool(
-		const struct ndm_xml_node_t *node,
-		const bool parse_value,
-		bool *value,
-		const char *const path_format,
-		...)
-{
-	va_list ap;
-	enum ndm_core_response_error_t e = NDM_CORE_RESPONSE_ERROR_OK;
-
-	va_start(ap, path_format);
-	e = __ndm_core_response_first_bool(node,
-		parse_value, value, path_format, ap);
-	va_end(ap);
+	if (matches != static_matches) {
+		free(matches);
+	}
 
 	return e;
 }
@@ -2896,37 +6986,29 @@ static inline bool __ndm_core_feedback_send(
 	if (!ndm_xml_document_is_valid(&doc)) {
 		errno = ENOMEM;
 	} else {
-		const size_t size = __ndm_core_request_store(root, NULL, 0);
 		uint8_t static_buffer[NDM_CORE_REQUEST_BINARY_STATIC_SIZE_];
-		uint8_t *p = static_buffer;
+		uint8_t *dynamic_buffer = NULL;
+		size_t dynamic_buffer_size = 0;
+		struct ndm_core_output_t output;
 
-		if (size == 0) {
-			/* empty feedback */
-			errno = EBADMSG;
-		} else
-		if ((size > sizeof(static_buffer)) &&
-			(p = malloc(size)) == NULL)
-		{
-			errno = ENOMEM;
-		} else
-		if (__ndm_core_request_store(root, p, size) != size) {
-			/* internal error occurred */
-			errno = EILSEQ;
-		} else {
+		__ndm_core_output_init(&output,
+			static_buffer, sizeof(static_buffer),
+			&dynamic_buffer, &dynamic_buffer_size);
+
+		if (__ndm_core_request_store(root, &output)) {
 			struct ndm_core_buffer_t core_buffer;
 
-			__ndm_core_buffer_init(&core_buffer, p, size);
+			__ndm_core_buffer_init(&core_buffer,
+				output.start, __ndm_core_output_size(&output));
 			core_buffer.putp = core_buffer.bound;
 
 			done = __ndm_core_buffer_send_all(
 				&core_buffer, fd, intblock, deadline);
 		}
 
-		if (p != static_buffer) {
-			error = errno;
-			free(p);
-			errno = error;
-		}
+		error = errno;
+		free(dynamic_buffer);
+		errno = error;
 	}
 
 	error = errno;
@@ -2955,11 +7037,12 @@ static inline bool __ndm_core_feedback_recv(
 	} else {
 		uint8_t buf[NDM_CORE_FEEDBACK_BUFFER_SIZE_];
 		struct ndm_core_buffer_t core_buffer;
+		struct ndm_core_input_t input;
 
 		__ndm_core_buffer_init(&core_buffer, buf, sizeof(buf));
+		__ndm_core_input_init(&input, &core_buffer, fd, intblock, deadline);
 
-		if (__ndm_core_read_xml_children(
-				fd, &core_buffer, intblock, deadline, root)) {
+		if (__ndm_core_read_xml_children(&input, root)) {
 			const struct ndm_xml_node_t *feedback =
 				ndm_xml_node_first_child(
 					root, NDM_CORE_FEEDBACK_NODE_FEEDBACK_);
@@ -22,19 +22,31 @@
  */
 
 #include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
 #include <ndm/int.h>
 #include <ndm/xml.h>
 
+/**
+ * The first byte of a node is its type, a compact node type has
+ * the @c NDM_XML_NODE_COMPACT_ bit set.
+ **/
+
+#define NDM_XML_NODE_COMPACT_							0x80
+#define NDM_XML_NODE_TYPE_MASK_							0x7f
+
 struct ndm_xml_node_t
 {
+	uint8_t type;
+	ndm_xml_atom_t atom;
 	const char *name;
 	size_t name_size;
 	const char *value;
 	size_t value_size;
-	enum ndm_xml_node_type_t type;
 	struct ndm_xml_document_t *document;
 	struct ndm_xml_node_t *parent;
 	struct ndm_xml_node_t *first_child;
@@ -43,10 +55,14 @@ struct ndm_xml_node_t
 	struct ndm_xml_attr_t *last_attr;
 	struct ndm_xml_node_t *next_sibling;
 	struct ndm_xml_node_t *prev_sibling;
+	size_t child_count;
+	struct ndm_xml_child_index_t *child_index;
 };
 
 struct ndm_xml_attr_t
 {
+	bool compact;
+	ndm_xml_atom_t atom;
 	const char *name;
 	size_t name_size;
 	const char *value;
@@ -57,11 +73,184 @@ struct ndm_xml_attr_t
 	struct ndm_xml_attr_t *prev;
 };
 
+#define NDM_XML_COMPACT_HAS_PREV_						0x01
+#define NDM_XML_COMPACT_HAS_NEXT_						0x02
+
+/**
+ * A read-only node of a compact document. Children of a node
+ * are placed one after another, so siblings are walked
+ * sequentially; names are atoms of a document name table,
+ * values are offsets of size-prefixed strings.
+ **/
+
+struct ndm_xml_compact_node_t
+{
+	uint8_t type;
+	uint8_t flags;							//!< sibling presence
+	uint16_t attr_count;
+	uint32_t index;
+	uint32_t parent;
+	uint32_t first_child;					//!< zero if none
+	uint32_t child_count;
+	uint32_t first_attr;
+	uint32_t name;
+	uint32_t value;
+};
+
+struct ndm_xml_compact_attr_t
+{
+	bool compact;
+	uint16_t index;							//!< in a node attribute list
+	uint32_t node_offset;					//!< from a node to an attribute
+	uint32_t name;
+	uint32_t value;
+};
+
+struct ndm_xml_compact_t
+{
+	struct ndm_xml_document_t *document;
+	const struct ndm_xml_compact_attr_t *attrs;
+	const uint32_t *names;					//!< string offsets by atoms
+	const uint32_t *slots;					//!< name hash set of atoms
+	const char *strings;
+	uint32_t name_count;
+	uint32_t slot_count;
+	uint32_t node_count;
+	uint32_t attr_count;
+	struct ndm_xml_compact_node_t nodes[];
+};
+
+/**
+ * An opt-in index of a node with many children: children
+ * by position and an open addressing hash set of first children
+ * by name. Both arrays are allocated in a document pool and reused
+ * while a child count fits in @c capacity.
+ **/
+
+#define NDM_XML_CHILD_INDEX_MIN_CAPACITY_				32
+
+struct ndm_xml_child_index_t
+{
+	struct ndm_xml_node_t **children;
+	struct ndm_xml_node_t **slots;			//!< twice larger than children
+	size_t capacity;
+	bool is_valid;
+};
+
+struct ndm_xml_atom_entry_t
+{
+	uint32_t hash;
+	ndm_xml_atom_t atom;
+	size_t size;
+	char name[];
+};
+
+/**
+ * An open addressing hash set of node and attribute names
+ * allocated in a document pool, @c names are indexed by atoms.
+ **/
+
+struct ndm_xml_atoms_t
+{
+	struct ndm_xml_atom_entry_t **entries;
+	size_t capacity;
+	struct ndm_xml_atom_entry_t **names;
+	size_t count;	//!< including the reserved @c NDM_XML_ATOM_NONE
+};
+
 static inline bool __ndm_xml_name_is_empty(const char *const name)
 {
 	return name == NULL || name[0] == '\0';
 }
 
+/**
+ * Interned names are compared by atoms, other ones by strings.
+ **/
+
+static inline bool __ndm_xml_name_matches(
+		const char *const name,
+		const ndm_xml_atom_t atom,
+		const char *const key_name,
+		const ndm_xml_atom_t key_atom)
+{
+	if (atom != NDM_XML_ATOM_NONE) {
+		return atom == key_atom;
+	}
+
+	return key_name != NULL && strcmp(name, key_name) == 0;
+}
+
+/**
+ * Compact document helpers.
+ **/
+
+static inline bool __ndm_xml_node_is_compact(
+		const struct ndm_xml_node_t *node)
+{
+	return (node->type & NDM_XML_NODE_COMPACT_) != 0;
+}
+
+static inline const struct ndm_xml_compact_node_t *__ndm_xml_compact_node(
+		const struct ndm_xml_node_t *node)
+{
+	return (const struct ndm_xml_compact_node_t *) (const void *) node;
+}
+
+static inline struct ndm_xml_node_t *__ndm_xml_compact_node_ptr(
+		const struct ndm_xml_compact_node_t *c)
+{
+	return (struct ndm_xml_node_t *) (uintptr_t) c;
+}
+
+static inline const struct ndm_xml_compact_t *__ndm_xml_compact_of(
+		const struct ndm_xml_compact_node_t *c)
+{
+	return (const struct ndm_xml_compact_t *) (const void *)
+		((const char *) (c - c->index) -
+			offsetof(struct ndm_xml_compact_t, nodes));
+}
+
+static inline const struct ndm_xml_compact_attr_t *__ndm_xml_compact_attr(
+		const struct ndm_xml_attr_t *attr)
+{
+	return (const struct ndm_xml_compact_attr_t *) (const void *) attr;
+}
+
+static inline struct ndm_xml_attr_t *__ndm_xml_compact_attr_ptr(
+		const struct ndm_xml_compact_attr_t *a)
+{
+	return (struct ndm_xml_attr_t *) (uintptr_t) a;
+}
+
+static inline const struct ndm_xml_compact_node_t *
+__ndm_xml_compact_attr_node(
+		const struct ndm_xml_compact_attr_t *a)
+{
+	return (const struct ndm_xml_compact_node_t *) (const void *)
+		((const char *) a - a->node_offset);
+}
+
+static inline const char *__ndm_xml_compact_str(
+		const struct ndm_xml_compact_t *compact,
+		const uint32_t offset)
+{
+	return compact->strings + offset + sizeof(uint32_t);
+}
+
+static inline size_t __ndm_xml_compact_str_size(
+		const struct ndm_xml_compact_t *compact,
+		const uint32_t offset)
+{
+	return *(const uint32_t *) (const void *) (compact->strings + offset);
+}
+
+static inline const char *__ndm_xml_compact_name(
+		const struct ndm_xml_compact_t *compact,
+		const uint32_t atom)
+{
+	return __ndm_xml_compact_str(compact, compact->names[atom]);
+}
+
 /**
  * XML parser functions.
  */
@@ -70,17 +259,22 @@ typedef bool (*predicate_t)(const char c);
 
 static inline bool __ndm_xml_parser_whitespace_pred(const char ch)
 {
-	return strchr(" \n\r\t", ch) != NULL && ch != '\0';
+	return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
 }
 
 static inline bool __ndm_xml_parser_node_name_pred(const char ch)
 {
-	return strchr(" \n\r\t/>?", ch) == NULL && ch != '\0';
+	return
+		!__ndm_xml_parser_whitespace_pred(ch) &&
+		ch != '/' && ch != '>' && ch != '?' && ch != '\0';
 }
 
 static inline bool __ndm_xml_parser_attr_name_pred(const char ch)
 {
-	return strchr(" \n\r\t/<>=?!", ch) == NULL && ch != '\0';
+	return
+		!__ndm_xml_parser_whitespace_pred(ch) &&
+		ch != '/' && ch != '<' && ch != '>' && ch != '=' &&
+		ch != '?' && ch != '!' && ch != '\0';
 }
 
 static inline bool __ndm_xml_parser_text_pred(const char ch)
@@ -95,7 +289,9 @@ static inline bool __ndm_xml_parser_text_pure_no_ws_pred(const char ch)
 
 static inline bool __ndm_xml_parser_text_pure_with_ws_pred(const char ch)
 {
-	return strchr(" \n\r\t<&", ch) == NULL && ch != '\0';
+	return
+		!__ndm_xml_parser_whitespace_pred(ch) &&
+		ch != '<' && ch != '&' && ch != '\0';
 }
 
 static inline bool __ndm_xml_parser_attr_value_quote_pred(const char ch)
@@ -120,6 +316,271 @@ __ndm_xml_parser_attr_value_pure_dquote_pred(const char ch)
 	return !((ch == '\"') || (ch == '\0') || (ch == '&'));
 }
 
+/**
+ * Vectorized skip kernels for the most frequent predicates.
+ * A text is always zero terminated, so blocks are loaded
+ * from aligned addresses that never cross a page boundary;
+ * bytes before a start position are masked out. A last block
+ * may be read past a terminator, so kernels are not instrumented
+ * by an address sanitizer.
+ **/
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NDM_XML_PARSER_SIMD_BLOCK_SIZE_				32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NDM_XML_PARSER_SIMD_BLOCK_SIZE_				16
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NDM_XML_PARSER_SIMD_BLOCK_SIZE_				16
+#endif
+
+#ifdef NDM_XML_PARSER_SIMD_BLOCK_SIZE_
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define NDM_XML_PARSER_SIMD_NO_ASAN_ __attribute__((no_sanitize_address))
+#endif
+#elif defined(__SANITIZE_ADDRESS__)
+#define NDM_XML_PARSER_SIMD_NO_ASAN_ __attribute__((no_sanitize_address))
+#endif
+
+#ifndef NDM_XML_PARSER_SIMD_NO_ASAN_
+#define NDM_XML_PARSER_SIMD_NO_ASAN_
+#endif
+
+#if defined(__AVX2__)
+
+typedef __m256i ndm_xml_parser_block_t;
+
+static inline NDM_XML_PARSER_SIMD_NO_ASAN_ ndm_xml_parser_block_t
+__ndm_xml_parser_block_load(
+		const char *p)
+{
+	return _mm256_load_si256((const __m256i *) p);
+}
+
+static inline ndm_xml_parser_block_t __ndm_xml_parser_block_eq(
+		const ndm_xml_parser_block_t block,
+		const char ch)
+{
+	return _mm256_cmpeq_epi8(block, _mm256_set1_epi8(ch));
+}
+
+static inline ndm_xml_parser_block_t __ndm_xml_parser_block_or(
+		const ndm_xml_parser_block_t a,
+		const ndm_xml_parser_block_t b)
+{
+	return _mm256_or_si256(a, b);
+}
+
+/* one bit per byte */
+static inline uint64_t __ndm_xml_parser_block_mask(
+		const ndm_xml_parser_block_t block)
+{
+	return (uint32_t) _mm256_movemask_epi8(block);
+}
+
+#define NDM_XML_PARSER_SIMD_MASK_BITS_				1
+
+#elif defined(__SSE2__)
+
+typedef __m128i ndm_xml_parser_block_t;
+
+static inline NDM_XML_PARSER_SIMD_NO_ASAN_ ndm_xml_parser_block_t
+__ndm_xml_parser_block_load(
+		const char *p)
+{
+	return _mm_load_si128((const __m128i *) p);
+}
+
+static inline ndm_xml_parser_block_t __ndm_xml_parser_block_eq(
+		const ndm_xml_parser_block_t block,
+		const char ch)
+{
+	return _mm_cmpeq_epi8(block, _mm_set1_epi8(ch));
+}
+
+static inline ndm_xml_parser_block_t __ndm_xml_parser_block_or(
+		const ndm_xml_parser_block_t a,
+		const ndm_xml_parser_block_t b)
+{
+	return _mm_or_si128(a, b);
+}
+
+/* one bit per byte */
+static inline uint64_t __ndm_xml_parser_block_mask(
+		const ndm_xml_parser_block_t block)
+{
+	return (uint16_t) _mm_movemask_epi8(block);
+}
+
+#define NDM_XML_PARSER_SIMD_MASK_BITS_				1
+
+#else	/* __ARM_NEON */
+
+typedef uint8x16_t ndm_xml_parser_block_t;
+
+static inline NDM_XML_PARSER_SIMD_NO_ASAN_ ndm_xml_parser_block_t
+__ndm_xml_parser_block_load(
+		const char *p)
+{
+	return vld1q_u8((const uint8_t *) p);
+}
+
+static inline ndm_xml_parser_block_t __ndm_xml_parser_block_eq(
+		const ndm_xml_parser_block_t block,
+		const char ch)
+{
+	return vceqq_u8(block, vdupq_n_u8((uint8_t) ch));
+}
+
+static inline ndm_xml_parser_block_t __ndm_xml_parser_block_or(
+		const ndm_xml_parser_block_t a,
+		const ndm_xml_parser_block_t b)
+{
+	return vorrq_u8(a, b);
+}
+
+/* four bits per byte */
+static inline uint64_t __ndm_xml_parser_block_mask(
+		const ndm_xml_parser_block_t block)
+{
+	return vget_lane_u64(vreinterpret_u64_u8(
+		vshrn_n_u16(vreinterpretq_u16_u8(block), 4)), 0);
+}
+
+#define NDM_XML_PARSER_SIMD_MASK_BITS_				4
+
+#endif
+
+/**
+ * Returns a pointer to a first byte equal to @a a, @a b, @a c, @a d
+ * or to a whitespace character if @a whitespace is set, or
+ * to a first byte not equal to any of them if @a skip_set is set.
+ **/
+
+static inline NDM_XML_PARSER_SIMD_NO_ASAN_ const char *
+__ndm_xml_parser_simd_scan(
+		const char *text,
+		const char a,
+		const char b,
+		const char c,
+		const char d,
+		const bool whitespace,
+		const bool skip_set)
+{
+	const size_t offset = (size_t)
+		((uintptr_t) text % NDM_XML_PARSER_SIMD_BLOCK_SIZE_);
+	const char *p = text - offset;
+	uint64_t mask = 0;
+	bool first = true;
+
+	do {
+		const ndm_xml_parser_block_t block =
+			__ndm_xml_parser_block_load(p);
+		ndm_xml_parser_block_t found =
+			__ndm_xml_parser_block_or(
+				__ndm_xml_parser_block_or(
+					__ndm_xml_parser_block_eq(block, a),
+					__ndm_xml_parser_block_eq(block, b)),
+				__ndm_xml_parser_block_or(
+					__ndm_xml_parser_block_eq(block, c),
+					__ndm_xml_parser_block_eq(block, d)));
+
+		if (whitespace) {
+			found = __ndm_xml_parser_block_or(found,
+				__ndm_xml_parser_block_or(
+					__ndm_xml_parser_block_or(
+						__ndm_xml_parser_block_eq(block, ' '),
+						__ndm_xml_parser_block_eq(block, '\n')),
+					__ndm_xml_parser_block_or(
+						__ndm_xml_parser_block_eq(block, '\r'),
+						__ndm_xml_parser_block_eq(block, '\t'))));
+		}
+
+		mask = __ndm_xml_parser_block_mask(found);
+
+		if (skip_set) {
+			mask = ~mask;
+
+			if (NDM_XML_PARSER_SIMD_BLOCK_SIZE_ *
+					NDM_XML_PARSER_SIMD_MASK_BITS_ < 64)
+			{
+				mask &= (UINT64_C(1) << (NDM_XML_PARSER_SIMD_BLOCK_SIZE_ *
+					NDM_XML_PARSER_SIMD_MASK_BITS_ % 64)) - 1;
+			}
+		}
+
+		if (first) {
+			mask &= ~UINT64_C(0) << (offset * NDM_XML_PARSER_SIMD_MASK_BITS_);
+			first = false;
+		}
+
+		if (mask == 0) {
+			p += NDM_XML_PARSER_SIMD_BLOCK_SIZE_;
+		}
+	} while (mask == 0);
+
+	return p + ((size_t) __builtin_ctzll(mask)) /
+		NDM_XML_PARSER_SIMD_MASK_BITS_;
+}
+
+static inline bool __ndm_xml_parser_simd_skip(
+		char **ptext,
+		predicate_t stop_pred)
+{
+	const char *text = *ptext;
+
+	if (!stop_pred(*text)) {
+		/* most of whitespace and text runs are empty */
+		return true;
+	}
+
+	if (stop_pred == __ndm_xml_parser_whitespace_pred) {
+		/* a terminating zero is not in a set */
+		text = __ndm_xml_parser_simd_scan(
+			text, ' ', '\n', '\r', '\t', false, true);
+	} else
+	if (stop_pred == __ndm_xml_parser_text_pred) {
+		text = __ndm_xml_parser_simd_scan(
+			text, '\0', '<', '<', '<', false, false);
+	} else
+	if (stop_pred == __ndm_xml_parser_text_pure_no_ws_pred) {
+		text = __ndm_xml_parser_simd_scan(
+			text, '\0', '<', '&', '&', false, false);
+	} else
+	if (stop_pred == __ndm_xml_parser_text_pure_with_ws_pred) {
+		text = __ndm_xml_parser_simd_scan(
+			text, '\0', '<', '&', '&', true, false);
+	} else
+	if (stop_pred == __ndm_xml_parser_attr_value_pure_quote_pred) {
+		text = __ndm_xml_parser_simd_scan(
+			text, '\0', '\'', '&', '&', false, false);
+	} else
+	if (stop_pred == __ndm_xml_parser_attr_value_pure_dquote_pred) {
+		text = __ndm_xml_parser_simd_scan(
+			text, '\0', '"', '&', '&', false, false);
+	} else
+	if (stop_pred == __ndm_xml_parser_attr_value_quote_pred) {
+		text = __ndm_xml_parser_simd_scan(
+			text, '\0', '\'', '\'', '\'', false, false);
+	} else
+	if (stop_pred == __ndm_xml_parser_attr_value_dquote_pred) {
+		text = __ndm_xml_parser_simd_scan(
+			text, '\0', '"', '"', '"', false, false);
+	} else {
+		return false;
+	}
+
+	*ptext = (char *) text;
+
+	return true;
+}
+
+#endif	/* NDM_XML_PARSER_SIMD_BLOCK_SIZE_ */
+
 static enum ndm_xml_document_parse_error_t
 __ndm_xml_parser_insert_coded_character(
 		char **ptext,
@@ -190,6 +651,12 @@ static void __ndm_xml_parser_skip(char **ptext, predicate_t stop_pred)
 {
 	char *t = *ptext;
 
+#ifdef NDM_XML_PARSER_SIMD_BLOCK_SIZE_
+	if (__ndm_xml_parser_simd_skip(ptext, stop_pred)) {
+		return;
+	}
+#endif
+
 	while (stop_pred(*t)) {
 		++t;
 	}
@@ -983,12 +1450,18 @@ __ndm_xml_parser_parse_node_contents(
 		struct ndm_xml_node_t *node,
 		const enum ndm_xml_document_parse_flags_t flags);
 
+/**
+ * Parse an element name and attributes up to '>' or '/>',
+ * @a closed is set for an empty element.
+ **/
+
 static enum ndm_xml_document_parse_error_t
-__ndm_xml_parser_parse_element(
+__ndm_xml_parser_parse_element_start(
 		struct ndm_xml_document_t *doc,
 		char **ptext,
 		const enum ndm_xml_document_parse_flags_t flags,
-		struct ndm_xml_node_t **element)
+		struct ndm_xml_node_t **element,
+		bool *closed)
 {
 	enum ndm_xml_document_parse_error_t code =
 		NDM_XML_DOCUMENT_PARSE_ERROR_OK;
@@ -1020,8 +1493,6 @@ __ndm_xml_parser_parse_element(
 
 	__ndm_xml_parser_skip(&text, __ndm_xml_parser_whitespace_pred);
 
-	ndm_xml_node_set_name(*element, name);
-
 	/**
 	 * Parse attributes, if any.
 	 **/
@@ -1041,25 +1512,11 @@ __ndm_xml_parser_parse_element(
 
 	if (*text == '>') {
 		++text;
-
-		*end = '\0';
-		ndm_xml_node_set_name(*element, name);
-
-		code = __ndm_xml_parser_parse_node_contents(
-			doc, &text, *element, flags);
-
-		if (code != NDM_XML_DOCUMENT_PARSE_ERROR_OK) {
-			*ptext = text;
-
-			return code;
-		}
+		*closed = false;
 	} else
 	if (*text == '/') {
 		++text;
 
-		*end = '\0';
-		ndm_xml_node_set_name(*element, name);
-
 		if (*text != '>') {
 			*ptext = text;
 
@@ -1067,6 +1524,7 @@ __ndm_xml_parser_parse_element(
 		}
 
 		++text;
+		*closed = true;
 	} else {
 		*ptext = text;
 
@@ -1074,11 +1532,32 @@ __ndm_xml_parser_parse_element(
 	}
 
 	*end = '\0';
+	ndm_xml_node_set_name(*element, name);
 	*ptext = text;
 
 	return code;
 }
 
+static enum ndm_xml_document_parse_error_t
+__ndm_xml_parser_parse_element(
+		struct ndm_xml_document_t *doc,
+		char **ptext,
+		const enum ndm_xml_document_parse_flags_t flags,
+		struct ndm_xml_node_t **element)
+{
+	bool closed = false;
+	enum ndm_xml_document_parse_error_t code =
+		__ndm_xml_parser_parse_element_start(
+			doc, ptext, flags, element, &closed);
+
+	if (code == NDM_XML_DOCUMENT_PARSE_ERROR_OK && !closed) {
+		code = __ndm_xml_parser_parse_node_contents(
+			doc, ptext, *element, flags);
+	}
+
+	return code;
+}
+
 static enum ndm_xml_document_parse_error_t
 __ndm_xml_parser_parse_node(
 		struct ndm_xml_document_t *doc,
@@ -1283,6 +1762,7 @@ __ndm_xml_parser_parse_and_append_data(
 	char *text = *ptext;
 	char *value = NULL;
 	char *end = NULL;
+	struct ndm_xml_node_t *data = NULL;
 	enum ndm_xml_document_parse_error_t code =
 		NDM_XML_DOCUMENT_PARSE_ERROR_OK;
 
@@ -1351,9 +1831,8 @@ __ndm_xml_parser_parse_and_append_data(
 	 **/
 
 	if (!(flags & NDM_XML_DOCUMENT_PARSE_FLAGS_NO_DATA_NODES)) {
-		struct ndm_xml_node_t *data =
-			ndm_xml_document_alloc_node(
-				doc, NDM_XML_NODE_TYPE_DATA, NULL, NULL);
+		data = ndm_xml_document_alloc_node(
+			doc, NDM_XML_NODE_TYPE_DATA, NULL, NULL);
 
 		if (data == NULL) {
 			*ptext = text;
@@ -1375,12 +1854,16 @@ __ndm_xml_parser_parse_and_append_data(
 
 	*ptext = text;
 
+	if (data != NULL) {
+		ndm_xml_node_set_value(data, value);
+	}
+
 	/**
 	 * Add data to parent node if no data exists yet.
 	 **/
 
 	if (!(flags & NDM_XML_DOCUMENT_PARSE_FLAGS_NO_ELEMENT_VALUES) &&
-		__ndm_xml_name_is_empty(ndm_xml_node_name(node)))
+		__ndm_xml_name_is_empty(ndm_xml_node_value(node)))
 	{
 		ndm_xml_node_set_value(node, value);
 	}
@@ -1388,6 +1871,69 @@ __ndm_xml_parser_parse_and_append_data(
 	return code;
 }
 
+static enum ndm_xml_document_parse_error_t
+__ndm_xml_parser_parse_closing_tag(
+		struct ndm_xml_node_t *node,
+		char **ptext,
+		const enum ndm_xml_document_parse_flags_t flags)
+{
+	char *text = *ptext;
+
+	if (flags & NDM_XML_DOCUMENT_PARSE_FLAGS_CHECK_CLOSING_TAGS) {
+		/**
+		 * Skip and validate closing tag name.
+		 **/
+
+		char *closing_name = text;
+
+		__ndm_xml_parser_skip(&text,
+			__ndm_xml_parser_node_name_pred);
+
+		if (strncmp(
+				ndm_xml_node_name(node), closing_name,
+				(size_t) (text - closing_name)) != 0)
+		{
+			*ptext = text;
+
+			return NDM_XML_DOCUMENT_PARSE_ERROR_CLOSING_TAG;
+		}
+	} else {
+		/**
+		 * No validation, just skip name.
+		 **/
+
+		__ndm_xml_parser_skip(&text,
+			__ndm_xml_parser_node_name_pred);
+	}
+
+	/**
+	 * Skip remaining whitespace after node name.
+	 **/
+
+	__ndm_xml_parser_skip(&text,
+		__ndm_xml_parser_whitespace_pred);
+
+	if (*text != '>') {
+		*ptext = text;
+
+		return NDM_XML_DOCUMENT_PARSE_ERROR_RBRACKET_EXPECTED;
+	}
+
+	/**
+	 * Skip '>'
+	 **/
+
+	++text;
+
+	/**
+	 * Node closed, finished parsing contents.
+	 **/
+
+	*ptext = text;
+
+	return NDM_XML_DOCUMENT_PARSE_ERROR_OK;
+}
+
 static enum ndm_xml_document_parse_error_t
 __ndm_xml_parser_parse_node_contents(
 		struct ndm_xml_document_t *doc,
@@ -1444,65 +1990,17 @@ after_data_node:
 
 				text += 2;
 
-				if (flags & NDM_XML_DOCUMENT_PARSE_FLAGS_CHECK_CLOSING_TAGS) {
-					/**
-					 * Skip and validate closing tag name.
-					 **/
+				code = __ndm_xml_parser_parse_closing_tag(
+					node, &text, flags);
+				*ptext = text;
 
-					char *closing_name = text;
+				return code;
+			} else {
+				/**
+				 * Child node, skip '<'.
+				 **/
 
-					__ndm_xml_parser_skip(&text,
-						__ndm_xml_parser_node_name_pred);
-
-					if (strncmp(
-							ndm_xml_node_name(node), closing_name,
-							(size_t) (text - closing_name)) != 0)
-					{
-						*ptext = text;
-
-						return NDM_XML_DOCUMENT_PARSE_ERROR_CLOSING_TAG;
-					}
-				} else {
-					/**
-					 * No validation, just skip name.
-					 **/
-
-					__ndm_xml_parser_skip(&text,
-						__ndm_xml_parser_node_name_pred);
-				}
-
-				/**
-				 * Skip remaining whitespace after node name.
-				 **/
-
-				__ndm_xml_parser_skip(&text,
-					__ndm_xml_parser_whitespace_pred);
-
-				if (*text != '>') {
-					*ptext = text;
-
-					return NDM_XML_DOCUMENT_PARSE_ERROR_RBRACKET_EXPECTED;
-				}
-
-				/**
-				 * Skip '>'
-				 **/
-
-				++text;
-
-				/**
-				 * Node closed, finished parsing contents.
-				 **/
-
-				*ptext = text;
-
-				return code;
-			} else {
-				/**
-				 * Child node, skip '<'.
-				 **/
-
-				struct ndm_xml_node_t *child;
+				struct ndm_xml_node_t *child;
 
 				++text;
 
@@ -1631,463 +2129,2922 @@ static enum ndm_xml_document_parse_error_t __ndm_xml_parser_do(
 }
 
 /**
- * XML document functions.
+ * An incremental parser splits an input stream into text runs
+ * and complete markup units, only an incomplete unit is buffered.
+ * Every unit is parsed by in situ functions above: retained units
+ * are copied into a document pool, so a resulting tree is the same
+ * as one of a whole document parsed at once.
  **/
 
-void ndm_xml_document_init(
-		struct ndm_xml_document_t *doc,
-		void *static_buffer,
-		const size_t static_buffer_size,
-		const size_t dynamic_buffer_size)
+#define NDM_XML_PARSER_INITIAL_BUFFER_SIZE_				256
+
+enum ndm_xml_parser_kind_t
 {
-	doc->__root = NULL;
-	ndm_pool_init(&doc->__pool, static_buffer,
-		static_buffer_size, dynamic_buffer_size);
-}
+	NDM_XML_PARSER_KIND_UNKNOWN_,
+	NDM_XML_PARSER_KIND_ELEMENT_,
+	NDM_XML_PARSER_KIND_CLOSING_,
+	NDM_XML_PARSER_KIND_PI_,
+	NDM_XML_PARSER_KIND_COMMENT_,
+	NDM_XML_PARSER_KIND_CDATA_,
+	NDM_XML_PARSER_KIND_DOCTYPE_,
+	NDM_XML_PARSER_KIND_OTHER_
+};
 
-static struct ndm_xml_node_t *__ndm_xml_document_copy_node(
-		const struct ndm_xml_node_t *node,
-		struct ndm_xml_document_t *dest)
+static bool __ndm_xml_parser_reserve(
+		struct ndm_xml_document_parser_t *parser,
+		const size_t size)
 {
-	struct ndm_xml_node_t *new_node =
-		ndm_xml_document_alloc_node(dest, ndm_xml_node_type(node),
-			ndm_xml_document_alloc_str(dest, ndm_xml_node_name(node)),
-			ndm_xml_document_alloc_str(dest, ndm_xml_node_value(node)));
+	if (parser->__capacity - parser->__size < size) {
+		size_t capacity = (parser->__capacity == 0) ?
+			NDM_XML_PARSER_INITIAL_BUFFER_SIZE_ : parser->__capacity;
+		char *buffer = NULL;
 
-	if (new_node != NULL) {
-		struct ndm_xml_attr_t *attr = ndm_xml_node_first_attr(node, NULL);
-		struct ndm_xml_node_t *child = ndm_xml_node_first_child(node, NULL);
+		while (capacity - parser->__size < size) {
+			capacity *= 2;
+		}
 
-		while (
-			attr != NULL &&
-			ndm_xml_node_append_attr_str(
-				new_node,
-				ndm_xml_attr_name(attr),
-				ndm_xml_attr_value(attr)) != NULL)
-		{
-			attr = ndm_xml_attr_next(attr, NULL);
+		if ((buffer = realloc(parser->__buffer, capacity)) == NULL) {
+			return false;
 		}
 
-		while (child != NULL && ndm_xml_document_is_valid(dest)) {
-			struct ndm_xml_node_t *new_child =
-				__ndm_xml_document_copy_node(child, dest);
+		parser->__buffer = buffer;
+		parser->__capacity = capacity;
+	}
 
-			if (new_child != NULL) {
-				ndm_xml_node_append_child(new_node, new_child);
-				child = ndm_xml_node_next_sibling(child, NULL);
-			}
-		}
+	return true;
+}
+
+static bool __ndm_xml_parser_append(
+		struct ndm_xml_document_parser_t *parser,
+		const char *data,
+		const size_t size)
+{
+	if (!__ndm_xml_parser_reserve(parser, size + 1)) {
+		return false;
 	}
 
-	return ndm_xml_document_is_valid(dest) ? new_node : NULL;
+	memcpy(parser->__buffer + parser->__size, data, size);
+	parser->__size += size;
+
+	/* a buffered unit is always terminated for in situ functions */
+	parser->__buffer[parser->__size] = '\0';
+
+	return true;
 }
 
-bool ndm_xml_document_copy(
-		struct ndm_xml_document_t *dest,
-		const struct ndm_xml_document_t *source)
+static void __ndm_xml_parser_unit_reset(
+		struct ndm_xml_document_parser_t *parser,
+		const bool markup)
 {
-	bool copied = true;
+	parser->__size = 0;
+	parser->__markup = markup;
+	parser->__kind = NDM_XML_PARSER_KIND_UNKNOWN_;
+	parser->__match = 0;
+	parser->__quote = '\0';
+	parser->__after_eq = false;
+	parser->__depth = 0;
+}
 
-	ndm_xml_document_clear(dest);
+/**
+ * Returns 1 if a buffered unit starts with @a prefix,
+ * 0 if it does not, -1 if more data is needed to decide.
+ **/
 
-	if (!ndm_xml_document_is_empty(source)) {
-		dest->__root = __ndm_xml_document_copy_node(source->__root, dest);
+static int __ndm_xml_parser_unit_prefix(
+		const struct ndm_xml_document_parser_t *parser,
+		const char *const prefix)
+{
+	const size_t prefix_size = strlen(prefix);
+	const size_t size = (parser->__size < prefix_size) ?
+		parser->__size : prefix_size;
 
-		if (!ndm_xml_document_is_valid(dest)) {
-			ndm_xml_document_clear(dest);
-			copied = false;
-		}
+	if (memcmp(parser->__buffer, prefix, size) != 0) {
+		return 0;
 	}
 
-	return copied;
+	return (size < prefix_size) ? -1 : 1;
 }
 
-static bool __ndm_xml_node_is_equal(
-		const struct ndm_xml_node_t *node,
-		const struct ndm_xml_node_t *other)
+/**
+ * Classify a buffered markup unit by its prefix, returns an offset
+ * of a first byte to be scanned for a unit end or 0 if more data
+ * is needed.
+ **/
+
+static size_t __ndm_xml_parser_unit_classify(
+		struct ndm_xml_document_parser_t *parser)
 {
-	bool equal =
-		ndm_xml_node_type(node) == ndm_xml_node_type(other) &&
-		ndm_xml_node_name_size(node) == ndm_xml_node_name_size(other) &&
-		ndm_xml_node_value_size(node) == ndm_xml_node_value_size(other) &&
-		strcmp(ndm_xml_node_name(node), ndm_xml_node_name(other)) == 0 &&
-		strcmp(ndm_xml_node_value(node), ndm_xml_node_value(other)) == 0;
+	int match = 0;
 
-	if (equal) {
-		struct ndm_xml_attr_t *attr =
-			ndm_xml_node_first_attr(node, NULL);
-		struct ndm_xml_attr_t *other_attr =
-			ndm_xml_node_first_attr(other, NULL);
+	if (parser->__size < 2) {
+		return 0;
+	}
 
-		while (attr != NULL && other_attr != NULL && equal) {
-			equal =
-				ndm_xml_attr_name_size(attr) ==
-					ndm_xml_attr_name_size(other_attr) &&
-				ndm_xml_attr_value_size(attr) ==
-					ndm_xml_attr_value_size(other_attr) &&
-				(strcmp(
-					ndm_xml_attr_name(attr),
-					ndm_xml_attr_name(other_attr)) == 0) &&
-				(strcmp(
-					ndm_xml_attr_value(attr),
-					ndm_xml_attr_value(other_attr)) == 0);
-			attr = ndm_xml_attr_next(attr, NULL);
-			other_attr = ndm_xml_attr_next(other_attr, NULL);
+	if (parser->__buffer[1] == '/') {
+		parser->__kind = NDM_XML_PARSER_KIND_CLOSING_;
+
+		return 2;
+	}
+
+	if (parser->__buffer[1] == '?') {
+		parser->__kind = NDM_XML_PARSER_KIND_PI_;
+
+		return 2;
+	}
+
+	if (parser->__buffer[1] != '!') {
+		parser->__kind = NDM_XML_PARSER_KIND_ELEMENT_;
+
+		return 1;
+	}
+
+	if ((match = __ndm_xml_parser_unit_prefix(parser, "<!--")) != 0) {
+		if (match < 0) {
+			return 0;
 		}
 
-		equal = equal && attr == NULL && other_attr == NULL;
+		parser->__kind = NDM_XML_PARSER_KIND_COMMENT_;
 
-		if (equal) {
-			struct ndm_xml_node_t *child =
-				ndm_xml_node_first_child(node, NULL);
-			struct ndm_xml_node_t *other_child =
-				ndm_xml_node_first_child(other, NULL);
+		return 4;
+	}
 
-			while (child != NULL && other_child != NULL && equal) {
-				equal = __ndm_xml_node_is_equal(child, other_child);
-				child = ndm_xml_node_next_sibling(child, NULL);
-				other_child = ndm_xml_node_next_sibling(other_child, NULL);
-			}
+	if ((match = __ndm_xml_parser_unit_prefix(parser, "<![CDATA[")) != 0) {
+		if (match < 0) {
+			return 0;
+		}
 
-			equal = equal && child == NULL && other_child == NULL;
+		parser->__kind = NDM_XML_PARSER_KIND_CDATA_;
+
+		return 9;
+	}
+
+	if ((match = __ndm_xml_parser_unit_prefix(parser, "<!DOCTYPE")) != 0) {
+		if (match < 0 || parser->__size < 10) {
+			return 0;
+		}
+
+		if (__ndm_xml_parser_whitespace_pred(parser->__buffer[9])) {
+			parser->__kind = NDM_XML_PARSER_KIND_DOCTYPE_;
+
+			return 10;
 		}
 	}
 
-	return equal;
+	parser->__kind = NDM_XML_PARSER_KIND_OTHER_;
+
+	return 2;
 }
 
-bool ndm_xml_document_is_equal(
-		const struct ndm_xml_document_t *doc,
-		const struct ndm_xml_document_t *other)
+static bool __ndm_xml_parser_match_end(
+		struct ndm_xml_document_parser_t *parser,
+		const char *const end,
+		const size_t end_size,
+		const char ch)
 {
-	bool equal = false;
+	if (ch == '>' && parser->__match == end_size - 1) {
+		return true;
+	}
 
-	if (ndm_xml_document_is_valid(doc) &&
-		ndm_xml_document_is_valid(other))
-	{
-		if (ndm_xml_document_is_empty(doc) &&
-			ndm_xml_document_is_empty(other))
-		{
-			equal = true;
-		} else
-		if (!ndm_xml_document_is_empty(doc) &&
-			!ndm_xml_document_is_empty(other))
-		{
-			equal = __ndm_xml_node_is_equal(doc->__root, other->__root);
-		} else {
-			/* not equal */
+	if (ch == end[0]) {
+		if (parser->__match < end_size - 1) {
+			++parser->__match;
 		}
+	} else {
+		parser->__match = 0;
 	}
 
-	return equal;
+	return false;
 }
 
-enum ndm_xml_document_parse_error_t ndm_xml_document_parse(
-		struct ndm_xml_document_t *doc,
-		char *text,
-		const enum ndm_xml_document_parse_flags_t flags)
+/**
+ * Returns @c true if @a ch ends a classified markup unit.
+ **/
+
+static bool __ndm_xml_parser_unit_scan(
+		struct ndm_xml_document_parser_t *parser,
+		const char ch)
 {
-	enum ndm_xml_document_parse_error_t code =
-		__ndm_xml_parser_do(doc, text, flags);
+	switch ((enum ndm_xml_parser_kind_t) parser->__kind) {
+		case NDM_XML_PARSER_KIND_ELEMENT_:
+			/* attribute values may contain '>' */
+			if (parser->__quote != '\0') {
+				if (ch == parser->__quote) {
+					parser->__quote = '\0';
+				}
 
-	if (code != NDM_XML_DOCUMENT_PARSE_ERROR_OK ||
-		!ndm_xml_document_is_valid(doc))
-	{
-		ndm_xml_document_clear(doc);
+				return false;
+			}
 
-		if (!ndm_xml_document_is_valid(doc)) {
-			code = NDM_XML_DOCUMENT_PARSE_ERROR_OOM;
-		}
+			if (ch == '>') {
+				return true;
+			}
+
+			if (ch == '=') {
+				parser->__after_eq = true;
+			} else
+			if ((ch == '\'' || ch == '"') && parser->__after_eq) {
+				parser->__quote = ch;
+				parser->__after_eq = false;
+			} else
+			if (!__ndm_xml_parser_whitespace_pred(ch)) {
+				parser->__after_eq = false;
+			}
+
+			return false;
+
+		case NDM_XML_PARSER_KIND_PI_:
+			return __ndm_xml_parser_match_end(parser, "?>", 2, ch);
+
+		case NDM_XML_PARSER_KIND_COMMENT_:
+			return __ndm_xml_parser_match_end(parser, "-->", 3, ch);
+
+		case NDM_XML_PARSER_KIND_CDATA_:
+			return __ndm_xml_parser_match_end(parser, "]]>", 3, ch);
+
+		case NDM_XML_PARSER_KIND_DOCTYPE_:
+			if (ch == '[') {
+				++parser->__depth;
+			} else
+			if (ch == ']') {
+				if (parser->__depth > 0) {
+					--parser->__depth;
+				}
+			} else
+			if (ch == '>' && parser->__depth == 0) {
+				return true;
+			}
+
+			return false;
+
+		case NDM_XML_PARSER_KIND_CLOSING_:
+		case NDM_XML_PARSER_KIND_OTHER_:
+			return ch == '>';
+
+		case NDM_XML_PARSER_KIND_UNKNOWN_:
+			break;
 	}
 
-	return code;
+	return false;
 }
 
-void *ndm_xml_document_alloc(
-		struct ndm_xml_document_t *doc,
-		const size_t size)
-{
-	return ndm_pool_malloc(&doc->__pool, size);
-}
+/**
+ * Copy a buffered unit from @a offset into a document pool
+ * to keep strings of parsed nodes.
+ **/
 
-struct ndm_xml_node_t *ndm_xml_document_alloc_root(
-		struct ndm_xml_document_t *doc)
+static char *__ndm_xml_parser_unit_copy(
+		struct ndm_xml_document_parser_t *parser,
+		const size_t offset)
 {
-	ndm_xml_document_clear(doc);
+	const size_t size = parser->__size - offset;
+	char *copy = ndm_xml_document_alloc(parser->__doc, size + 1);
 
-	if ((doc->__root = ndm_xml_document_alloc_node(
-			doc, NDM_XML_NODE_TYPE_DOCUMENT, NULL, NULL)) == NULL)
-	{
-		ndm_xml_document_clear(doc);
+	if (copy != NULL) {
+		memcpy(copy, parser->__buffer + offset, size);
+		copy[size] = '\0';
 	}
 
-	return ndm_xml_document_root(doc);
+	return copy;
 }
 
-struct ndm_xml_node_t *ndm_xml_document_alloc_node(
-		struct ndm_xml_document_t *doc,
-		const enum ndm_xml_node_type_t type,
-		const char *const name,
-		const char *const value)
+static enum ndm_xml_document_parse_error_t __ndm_xml_parser_text(
+		struct ndm_xml_document_parser_t *parser)
 {
-	struct ndm_xml_node_t *node = (struct ndm_xml_node_t *)
-		ndm_pool_malloc(&doc->__pool, sizeof(*node));
+	char *text = parser->__buffer;
+	char next = '\0';
 
-	if (node != NULL) {
-		ndm_xml_node_set_name(node, name);
-		ndm_xml_node_set_value(node, value);
-		node->type = type;
-		node->document = doc;
-		node->parent = NULL;
-		node->first_child = NULL;
-		node->last_child = NULL;
-		node->first_attr = NULL;
-		node->last_attr = NULL;
-		node->next_sibling = NULL;
-		node->prev_sibling = NULL;
+	if (!parser->__started) {
+		parser->__started = true;
+
+		if (!(parser->__flags & NDM_XML_DOCUMENT_PARSE_FLAGS_NO_UTF8) &&
+			parser->__size >= 3 &&
+			((unsigned char) (text[0]) == 0xef) &&
+			((unsigned char) (text[1]) == 0xbb) &&
+			((unsigned char) (text[2]) == 0xbf))
+		{
+			text += 3;      /* Skip UTF-8 BOM */
+		}
+	}
+
+	__ndm_xml_parser_skip(&text, __ndm_xml_parser_whitespace_pred);
+
+	if (*text == '\0') {
+		/* whitespace between nodes */
+		return NDM_XML_DOCUMENT_PARSE_ERROR_OK;
+	}
+
+	if (parser->__node == ndm_xml_document_root(parser->__doc)) {
+		return NDM_XML_DOCUMENT_PARSE_ERROR_LBRACKET_EXPECTED;
+	} else {
+		char *contents_start = __ndm_xml_parser_unit_copy(parser, 0);
+
+		if (contents_start == NULL) {
+			return NDM_XML_DOCUMENT_PARSE_ERROR_OOM;
+		}
+
+		text = contents_start + (text - parser->__buffer);
+
+		return __ndm_xml_parser_parse_and_append_data(
+			parser->__doc, parser->__node, &text, contents_start,
+			parser->__flags, &next);
+	}
+}
+
+static enum ndm_xml_document_parse_error_t __ndm_xml_parser_markup(
+		struct ndm_xml_document_parser_t *parser)
+{
+	enum ndm_xml_document_parse_error_t code =
+		NDM_XML_DOCUMENT_PARSE_ERROR_OK;
+	struct ndm_xml_node_t *root = ndm_xml_document_root(parser->__doc);
+	struct ndm_xml_node_t *node = NULL;
+	char *text = NULL;
+
+	parser->__started = true;
+
+	if (parser->__kind == NDM_XML_PARSER_KIND_CLOSING_) {
+		if (parser->__node == root) {
+			/* no element to be closed */
+			return NDM_XML_DOCUMENT_PARSE_ERROR_NODE_NAME_EXPECTED;
+		}
+
+		text = parser->__buffer + 2;	/* Skip '</' */
+		code = __ndm_xml_parser_parse_closing_tag(
+			parser->__node, &text, parser->__flags);
+
+		if (code == NDM_XML_DOCUMENT_PARSE_ERROR_OK) {
+			parser->__node = ndm_xml_node_parent(parser->__node);
+		}
+
+		return code;
+	}
+
+	if ((text = __ndm_xml_parser_unit_copy(parser, 1)) == NULL) {
+		return NDM_XML_DOCUMENT_PARSE_ERROR_OOM;
+	}
+
+	if (parser->__kind == NDM_XML_PARSER_KIND_ELEMENT_) {
+		bool closed = false;
+
+		code = __ndm_xml_parser_parse_element_start(
+			parser->__doc, &text, parser->__flags, &node, &closed);
+
+		if (code == NDM_XML_DOCUMENT_PARSE_ERROR_OK) {
+			ndm_xml_node_append_child(parser->__node, node);
+
+			if (!closed) {
+				parser->__node = node;
+			}
+		}
+	} else {
+		code = __ndm_xml_parser_parse_node(
+			parser->__doc, &text, parser->__flags, &node);
+
+		/**
+		 * A node can be parsed but not recognized.
+		 **/
+
+		if (code == NDM_XML_DOCUMENT_PARSE_ERROR_OK && node != NULL) {
+			ndm_xml_node_append_child(parser->__node, node);
+		}
+	}
+
+	return code;
+}
+
+static enum ndm_xml_document_parse_error_t __ndm_xml_parser_feed(
+		struct ndm_xml_document_parser_t *parser,
+		const char *data,
+		size_t size)
+{
+	enum ndm_xml_document_parse_error_t code =
+		NDM_XML_DOCUMENT_PARSE_ERROR_OK;
+
+	while (size > 0 && code == NDM_XML_DOCUMENT_PARSE_ERROR_OK) {
+		if (!parser->__markup) {
+			/**
+			 * A text run up to a next '<'.
+			 **/
+
+			const char *lt = memchr(data, '<', size);
+			const size_t text_size =
+				(lt == NULL) ? size : (size_t) (lt - data);
+
+			if (!__ndm_xml_parser_append(parser, data, text_size)) {
+				return NDM_XML_DOCUMENT_PARSE_ERROR_OOM;
+			}
+
+			data += text_size;
+			size -= text_size;
+
+			if (lt != NULL) {
+				code = __ndm_xml_parser_text(parser);
+				__ndm_xml_parser_unit_reset(parser, true);
+			}
+		} else
+		if (parser->__kind == NDM_XML_PARSER_KIND_UNKNOWN_) {
+			/**
+			 * A markup prefix is collected byte by byte,
+			 * classified bytes are scanned for a unit end.
+			 **/
+
+			size_t offset = 0;
+
+			if (!__ndm_xml_parser_append(parser, data, 1)) {
+				return NDM_XML_DOCUMENT_PARSE_ERROR_OOM;
+			}
+
+			++data;
+			--size;
+
+			if ((offset = __ndm_xml_parser_unit_classify(parser)) > 0) {
+				while (offset < parser->__size) {
+					if (__ndm_xml_parser_unit_scan(
+							parser, parser->__buffer[offset++]))
+					{
+						code = __ndm_xml_parser_markup(parser);
+						__ndm_xml_parser_unit_reset(parser, false);
+						break;
+					}
+				}
+			}
+		} else {
+			/**
+			 * Scan for a unit end.
+			 **/
+
+			size_t unit_size = 0;
+			bool complete = false;
+
+			while (unit_size < size && !complete) {
+				complete = __ndm_xml_parser_unit_scan(
+					parser, data[unit_size++]);
+			}
+
+			if (!__ndm_xml_parser_append(parser, data, unit_size)) {
+				return NDM_XML_DOCUMENT_PARSE_ERROR_OOM;
+			}
+
+			data += unit_size;
+			size -= unit_size;
+
+			if (complete) {
+				code = __ndm_xml_parser_markup(parser);
+				__ndm_xml_parser_unit_reset(parser, false);
+			}
+		}
+	}
+
+	return code;
+}
+
+static enum ndm_xml_document_parse_error_t __ndm_xml_parser_finish(
+		struct ndm_xml_document_parser_t *parser)
+{
+	enum ndm_xml_document_parse_error_t code =
+		NDM_XML_DOCUMENT_PARSE_ERROR_OK;
+
+	if (!__ndm_xml_parser_reserve(parser, 1)) {
+		return NDM_XML_DOCUMENT_PARSE_ERROR_OOM;
+	}
+
+	parser->__buffer[parser->__size] = '\0';
+
+	if (parser->__markup) {
+		/**
+		 * An incomplete markup unit is parsed to get
+		 * the same error as of a whole document.
+		 **/
+
+		if (parser->__kind == NDM_XML_PARSER_KIND_UNKNOWN_) {
+			parser->__kind = (parser->__size < 2) ?
+				NDM_XML_PARSER_KIND_ELEMENT_ :
+				NDM_XML_PARSER_KIND_OTHER_;
+		}
+
+		code = __ndm_xml_parser_markup(parser);
+
+		return (code == NDM_XML_DOCUMENT_PARSE_ERROR_OK) ?
+			NDM_XML_DOCUMENT_PARSE_ERROR_UNEXPECTED_STREAM_END : code;
+	}
+
+	code = __ndm_xml_parser_text(parser);
+
+	if (code == NDM_XML_DOCUMENT_PARSE_ERROR_OK &&
+		parser->__node != ndm_xml_document_root(parser->__doc))
+	{
+		/* an element is not closed */
+		code = NDM_XML_DOCUMENT_PARSE_ERROR_UNEXPECTED_STREAM_END;
+	}
+
+	return code;
+}
+
+/**
+ * XML document functions.
+ **/
+
+#define NDM_XML_ATOMS_INITIAL_CAPACITY_					64
+
+static inline uint32_t __ndm_xml_atoms_hash(
+		const char *const name,
+		const size_t size)
+{
+	/* FNV-1a is cheaper than CRC32 for short names */
+	uint32_t hash = 2166136261U;
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		hash = (hash ^ (uint8_t) name[i])*16777619U;
+	}
+
+	return hash;
+}
+
+static struct ndm_xml_atom_entry_t **__ndm_xml_atoms_slot(
+		struct ndm_xml_atom_entry_t **entries,
+		const size_t capacity,
+		const uint32_t hash,
+		const char *const name,
+		const size_t size)
+{
+	/* a capacity is always a power of two and a set is never full */
+	size_t i = hash & (capacity - 1);
+
+	while (entries[i] != NULL) {
+		const struct ndm_xml_atom_entry_t *e = entries[i];
+
+		if (e->hash == hash &&
+			e->size == size &&
+			memcmp(e->name, name, size) == 0)
+		{
+			break;
+		}
+
+		i = (i + 1) & (capacity - 1);
+	}
+
+	return &entries[i];
+}
+
+static bool __ndm_xml_atoms_reserve(
+		struct ndm_xml_document_t *doc,
+		struct ndm_xml_atoms_t *atoms)
+{
+	const size_t capacity = (atoms->capacity == 0) ?
+		NDM_XML_ATOMS_INITIAL_CAPACITY_ :
+		atoms->capacity*2;
+	struct ndm_xml_atom_entry_t **entries;
+	struct ndm_xml_atom_entry_t **names;
+	size_t i;
+
+	if ((atoms->count + 1)*2 <= atoms->capacity) {
+		return true;
+	}
+
+	/**
+	 * Previous arrays are left in a pool until a document is cleared.
+	 **/
+
+	if ((entries = ndm_pool_calloc(
+			&doc->__pool, capacity, sizeof(*entries))) == NULL ||
+		(names = ndm_pool_malloc(
+			&doc->__pool, (capacity/2)*sizeof(*names))) == NULL)
+	{
+		return false;
+	}
+
+	for (i = 0; i < atoms->capacity; i++) {
+		struct ndm_xml_atom_entry_t *e = atoms->entries[i];
+
+		if (e != NULL) {
+			*__ndm_xml_atoms_slot(entries, capacity,
+				e->hash, e->name, e->size) = e;
+		}
+	}
+
+	names[NDM_XML_ATOM_NONE] = NULL;
+
+	for (i = NDM_XML_ATOM_NONE + 1; i < atoms->count; i++) {
+		names[i] = atoms->names[i];
+	}
+
+	atoms->entries = entries;
+	atoms->capacity = capacity;
+	atoms->names = names;
+
+	return true;
+}
+
+static ndm_xml_atom_t __ndm_xml_document_intern(
+		struct ndm_xml_document_t *doc,
+		const char *const name,
+		const size_t size)
+{
+	struct ndm_xml_atoms_t *atoms = doc->__atoms;
+	struct ndm_xml_atom_entry_t **slot;
+	uint32_t hash;
+
+	if (!doc->__intern_names) {
+		return NDM_XML_ATOM_NONE;
+	}
+
+	if (atoms == NULL) {
+		if ((atoms = ndm_pool_malloc(
+				&doc->__pool, sizeof(*atoms))) == NULL)
+		{
+			return NDM_XML_ATOM_NONE;
+		}
+
+		atoms->entries = NULL;
+		atoms->capacity = 0;
+		atoms->names = NULL;
+		atoms->count = NDM_XML_ATOM_NONE + 1;
+		doc->__atoms = atoms;
+	}
+
+	if (!__ndm_xml_atoms_reserve(doc, atoms)) {
+		return NDM_XML_ATOM_NONE;
+	}
+
+	hash = __ndm_xml_atoms_hash(name, size);
+	slot = __ndm_xml_atoms_slot(
+		atoms->entries, atoms->capacity, hash, name, size);
+
+	if (*slot == NULL) {
+		struct ndm_xml_atom_entry_t *e =
+			ndm_pool_malloc(&doc->__pool, sizeof(*e) + size + 1);
+
+		if (e == NULL) {
+			return NDM_XML_ATOM_NONE;
+		}
+
+		e->hash = hash;
+		e->atom = (ndm_xml_atom_t) atoms->count;
+		e->size = size;
+		memcpy(e->name, name, size);
+		e->name[size] = '\0';
+
+		atoms->names[atoms->count++] = e;
+		*slot = e;
+	}
+
+	return (*slot)->atom;
+}
+
+static const char *__ndm_xml_document_atom_name(
+		const struct ndm_xml_document_t *doc,
+		const ndm_xml_atom_t atom)
+{
+	const struct ndm_xml_atoms_t *atoms = doc->__atoms;
+
+	if (atoms == NULL ||
+		atom == NDM_XML_ATOM_NONE ||
+		atom >= atoms->count)
+	{
+		return NULL;
+	}
+
+	return atoms->names[atom]->name;
+}
+
+static void __ndm_xml_document_intern_node(
+		struct ndm_xml_document_t *doc,
+		struct ndm_xml_node_t *node)
+{
+	struct ndm_xml_attr_t *attr = node->first_attr;
+	struct ndm_xml_node_t *child = node->first_child;
+
+	node->atom = __ndm_xml_document_intern(
+		doc, node->name, node->name_size);
+
+	while (attr != NULL) {
+		attr->atom = __ndm_xml_document_intern(
+			doc, attr->name, attr->name_size);
+		attr = attr->next;
+	}
+
+	while (child != NULL) {
+		__ndm_xml_document_intern_node(doc, child);
+		child = child->next_sibling;
+	}
+}
+
+void ndm_xml_document_init(
+		struct ndm_xml_document_t *doc,
+		void *static_buffer,
+		const size_t static_buffer_size,
+		const size_t dynamic_buffer_size)
+{
+	doc->__root = NULL;
+	ndm_pool_init(&doc->__pool, static_buffer,
+		static_buffer_size, dynamic_buffer_size);
+	doc->__atoms = NULL;
+	doc->__intern_names = false;
+}
+
+bool ndm_xml_document_intern_names(
+		struct ndm_xml_document_t *doc)
+{
+	doc->__intern_names = true;
+
+	/* names of a compact document are always interned */
+	if (doc->__root != NULL && !ndm_xml_document_is_compact(doc)) {
+		__ndm_xml_document_intern_node(doc, doc->__root);
+	}
+
+	return ndm_xml_document_is_valid(doc);
+}
+
+/**
+ * Compact document functions.
+ **/
+
+#define NDM_XML_COMPACT_MAX_SIZE_						UINT32_MAX
+
+struct ndm_xml_compact_name_t
+{
+	const char *name;
+	size_t size;
+	uint32_t hash;
+	uint32_t offset;
+};
+
+static ndm_xml_atom_t __ndm_xml_compact_atom(
+		const struct ndm_xml_compact_t *compact,
+		const char *const name)
+{
+	const size_t size = strlen(name);
+	const uint32_t hash = __ndm_xml_atoms_hash(name, size);
+	size_t i = hash & (compact->slot_count - 1);
+
+	while (compact->slots[i] != NDM_XML_ATOM_NONE) {
+		const uint32_t atom = compact->slots[i];
+		const uint32_t offset = compact->names[atom];
+
+		if (__ndm_xml_compact_str_size(compact, offset) == size &&
+			memcmp(__ndm_xml_compact_str(compact, offset), name, size) == 0)
+		{
+			return atom;
+		}
+
+		i = (i + 1) & (compact->slot_count - 1);
+	}
+
+	return NDM_XML_ATOM_NONE;
+}
+
+static size_t __ndm_xml_compact_str_record_size(
+		const size_t size)
+{
+	/* a size prefix, characters and a null-terminator */
+	return (sizeof(uint32_t) + size + 1 + sizeof(uint32_t) - 1) &
+		~(sizeof(uint32_t) - 1);
+}
+
+static uint32_t __ndm_xml_compact_put_str(
+		char *strings,
+		size_t *offset,
+		const char *const s,
+		const size_t size)
+{
+	const uint32_t start = (uint32_t) *offset;
+	const uint32_t size32 = (uint32_t) size;
+
+	memcpy(strings + start, &size32, sizeof(size32));
+	memcpy(strings + start + sizeof(size32), s, size);
+	strings[start + sizeof(size32) + size] = '\0';
+	*offset += __ndm_xml_compact_str_record_size(size);
+
+	return start;
+}
+
+static size_t __ndm_xml_compact_slot_count(
+		const size_t count)
+{
+	/* a power of two with a load factor of at most one half */
+	size_t slot_count = 2;
+
+	while (slot_count < count*2) {
+		slot_count *= 2;
+	}
+
+	return slot_count;
+}
+
+static uint32_t *__ndm_xml_compact_slot(
+		uint32_t *slots,
+		const size_t slot_count,
+		const struct ndm_xml_compact_name_t *names,
+		const uint32_t hash,
+		const char *const name,
+		const size_t size)
+{
+	size_t i = hash & (slot_count - 1);
+
+	while (slots[i] != NDM_XML_ATOM_NONE) {
+		const struct ndm_xml_compact_name_t *n = &names[slots[i]];
+
+		if (n->hash == hash &&
+			n->size == size &&
+			memcmp(n->name, name, size) == 0)
+		{
+			break;
+		}
+
+		i = (i + 1) & (slot_count - 1);
+	}
+
+	return &slots[i];
+}
+
+static uint32_t __ndm_xml_compact_intern(
+		struct ndm_xml_compact_name_t *names,
+		size_t *name_count,
+		uint32_t *slots,
+		const size_t slot_count,
+		const char *const name,
+		const size_t size)
+{
+	const uint32_t hash = __ndm_xml_atoms_hash(name, size);
+	uint32_t *slot = __ndm_xml_compact_slot(
+		slots, slot_count, names, hash, name, size);
+
+	if (*slot == NDM_XML_ATOM_NONE) {
+		struct ndm_xml_compact_name_t *n = &names[*name_count];
+
+		n->name = name;
+		n->size = size;
+		n->hash = hash;
+		n->offset = 0;
+		*slot = (uint32_t) (*name_count)++;
+	}
+
+	return *slot;
+}
+
+static bool __ndm_xml_compact_push(
+		const struct ndm_xml_node_t ***queue,
+		size_t *node_count,
+		size_t *capacity,
+		const struct ndm_xml_node_t *node)
+{
+	if (*node_count == *capacity) {
+		const size_t new_capacity = (*capacity == 0) ? 64 : *capacity*2;
+		const struct ndm_xml_node_t **q =
+			realloc(*queue, new_capacity*sizeof(*q));
+
+		if (q == NULL) {
+			errno = ENOMEM;
+
+			return false;
+		}
+
+		*queue = q;
+		*capacity = new_capacity;
+	}
+
+	(*queue)[(*node_count)++] = node;
+
+	return true;
+}
+
+static bool __ndm_xml_compact_enqueue(
+		const struct ndm_xml_node_t *root,
+		const struct ndm_xml_node_t ***queue,
+		size_t *node_count,
+		size_t *attr_count)
+{
+	size_t capacity = 0;
+	size_t i;
+
+	*queue = NULL;
+	*node_count = 0;
+	*attr_count = 0;
+
+	/* a breadth-first order places all children of a node together */
+	if (!__ndm_xml_compact_push(queue, node_count, &capacity, root)) {
+		return false;
+	}
+
+	for (i = 0; i < *node_count; i++) {
+		const struct ndm_xml_node_t *node = (*queue)[i];
+		const struct ndm_xml_node_t *child =
+			ndm_xml_node_first_child(node, NULL);
+		const struct ndm_xml_attr_t *attr =
+			ndm_xml_node_first_attr(node, NULL);
+		size_t node_attr_count = 0;
+
+		while (attr != NULL) {
+			++node_attr_count;
+			attr = ndm_xml_attr_next(attr, NULL);
+		}
+
+		if (node_attr_count > UINT16_MAX) {
+			errno = EOVERFLOW;
+
+			return false;
+		}
+
+		*attr_count += node_attr_count;
+
+		while (child != NULL) {
+			if (!__ndm_xml_compact_push(queue, node_count, &capacity, child)) {
+				return false;
+			}
+
+			child = ndm_xml_node_next_sibling(child, NULL);
+		}
+	}
+
+	return true;
+}
+
+bool ndm_xml_document_compact(
+		struct ndm_xml_document_t *dest,
+		const struct ndm_xml_document_t *source)
+{
+	const struct ndm_xml_node_t **queue = NULL;
+	struct ndm_xml_compact_name_t *names = NULL;
+	uint32_t *slots = NULL;
+	struct ndm_xml_compact_t *compact = NULL;
+	struct ndm_xml_compact_node_t *nodes;
+	struct ndm_xml_compact_attr_t *attrs;
+	uint32_t *compact_names;
+	uint32_t *compact_slots;
+	char *strings;
+	size_t node_count = 0;
+	size_t attr_count = 0;
+	size_t name_count = NDM_XML_ATOM_NONE + 1;
+	size_t slot_count = 0;
+	size_t compact_slot_count = 0;
+	size_t strings_size = 0;
+	size_t size = 0;
+	size_t offset = 0;
+	size_t next_child = 1;
+	size_t next_attr = 0;
+	size_t i;
+	bool done = false;
+
+	ndm_xml_document_clear(dest);
+
+	if (ndm_xml_document_is_empty(source)) {
+		return true;
+	}
+
+	if (!__ndm_xml_compact_enqueue(
+			source->__root, &queue, &node_count, &attr_count))
+	{
+		goto out;
+	}
+
+	/**
+	 * Intern names to size a string area and a name table.
+	 **/
+
+	slot_count = __ndm_xml_compact_slot_count(node_count + attr_count + 1);
+
+	if ((names = malloc(
+			(node_count + attr_count + 1)*sizeof(*names))) == NULL ||
+		(slots = calloc(slot_count, sizeof(*slots))) == NULL)
+	{
+		errno = ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < node_count; i++) {
+		const struct ndm_xml_node_t *node = queue[i];
+		const struct ndm_xml_attr_t *attr =
+			ndm_xml_node_first_attr(node, NULL);
+
+		__ndm_xml_compact_intern(names, &name_count, slots, slot_count,
+			ndm_xml_node_name(node), ndm_xml_node_name_size(node));
+		strings_size += __ndm_xml_compact_str_record_size(
+			ndm_xml_node_value_size(node));
+
+		while (attr != NULL) {
+			__ndm_xml_compact_intern(names, &name_count, slots, slot_count,
+				ndm_xml_attr_name(attr), ndm_xml_attr_name_size(attr));
+			strings_size += __ndm_xml_compact_str_record_size(
+				ndm_xml_attr_value_size(attr));
+			attr = ndm_xml_attr_next(attr, NULL);
+		}
+	}
+
+	for (i = NDM_XML_ATOM_NONE + 1; i < name_count; i++) {
+		strings_size += __ndm_xml_compact_str_record_size(names[i].size);
+	}
+
+	compact_slot_count = __ndm_xml_compact_slot_count(name_count);
+	size =
+		sizeof(*compact) +
+		node_count*sizeof(*nodes) +
+		attr_count*sizeof(*attrs) +
+		name_count*sizeof(*compact_names) +
+		compact_slot_count*sizeof(*compact_slots) +
+		strings_size;
+
+	if (size > NDM_XML_COMPACT_MAX_SIZE_) {
+		errno = EOVERFLOW;
+		goto out;
+	}
+
+	if ((compact = ndm_xml_document_alloc(dest, size)) == NULL) {
+		errno = ENOMEM;
+		goto out;
+	}
+
+	nodes = compact->nodes;
+	attrs = (struct ndm_xml_compact_attr_t *) (void *) (nodes + node_count);
+	compact_names = (uint32_t *) (void *) (attrs + attr_count);
+	compact_slots = compact_names + name_count;
+	strings = (char *) (compact_slots + compact_slot_count);
+
+	compact->document = dest;
+	compact->attrs = attrs;
+	compact->names = compact_names;
+	compact->slots = compact_slots;
+	compact->strings = strings;
+	compact->name_count = (uint32_t) name_count;
+	compact->slot_count = (uint32_t) compact_slot_count;
+	compact->node_count = (uint32_t) node_count;
+	compact->attr_count = (uint32_t) attr_count;
+
+	memset(compact_slots, 0, compact_slot_count*sizeof(*compact_slots));
+	compact_names[NDM_XML_ATOM_NONE] = 0;
+
+	for (i = NDM_XML_ATOM_NONE + 1; i < name_count; i++) {
+		struct ndm_xml_compact_name_t *n = &names[i];
+		size_t j = n->hash & (compact_slot_count - 1);
+
+		n->offset = __ndm_xml_compact_put_str(
+			strings, &offset, n->name, n->size);
+		compact_names[i] = n->offset;
+
+		while (compact_slots[j] != NDM_XML_ATOM_NONE) {
+			j = (j + 1) & (compact_slot_count - 1);
+		}
+
+		compact_slots[j] = (uint32_t) i;
+	}
+
+	nodes[0].parent = 0;
+	nodes[0].flags = 0;
+
+	for (i = 0; i < node_count; i++) {
+		const struct ndm_xml_node_t *node = queue[i];
+		const struct ndm_xml_node_t *child =
+			ndm_xml_node_first_child(node, NULL);
+		const struct ndm_xml_attr_t *attr =
+			ndm_xml_node_first_attr(node, NULL);
+		struct ndm_xml_compact_node_t *c = &nodes[i];
+		size_t child_count = 0;
+		uint16_t attr_index = 0;
+
+		/* a parent and sibling flags are set by a parent node */
+		c->type = (uint8_t)
+			(ndm_xml_node_type(node) | NDM_XML_NODE_COMPACT_);
+		c->index = (uint32_t) i;
+		c->name = __ndm_xml_compact_intern(
+			names, &name_count, slots, slot_count,
+			ndm_xml_node_name(node), ndm_xml_node_name_size(node));
+		c->value = __ndm_xml_compact_put_str(strings, &offset,
+			ndm_xml_node_value(node), ndm_xml_node_value_size(node));
+		c->first_attr = (uint32_t) next_attr;
+
+		while (attr != NULL) {
+			struct ndm_xml_compact_attr_t *a = &attrs[next_attr++];
+
+			a->compact = true;
+			a->index = attr_index++;
+			a->node_offset = (uint32_t) ((char *) a - (char *) c);
+			a->name = __ndm_xml_compact_intern(
+				names, &name_count, slots, slot_count,
+				ndm_xml_attr_name(attr), ndm_xml_attr_name_size(attr));
+			a->value = __ndm_xml_compact_put_str(strings, &offset,
+				ndm_xml_attr_value(attr), ndm_xml_attr_value_size(attr));
+			attr = ndm_xml_attr_next(attr, NULL);
+		}
+
+		c->attr_count = attr_index;
+		c->first_child = (child == NULL) ? 0 : (uint32_t) next_child;
+
+		while (child != NULL) {
+			struct ndm_xml_compact_node_t *n = &nodes[next_child++];
+
+			n->parent = (uint32_t) i;
+			n->flags = (child_count == 0) ? 0 : NDM_XML_COMPACT_HAS_PREV_;
+			child = ndm_xml_node_next_sibling(child, NULL);
+
+			if (child != NULL) {
+				n->flags |= NDM_XML_COMPACT_HAS_NEXT_;
+			}
+
+			++child_count;
+		}
+
+		c->child_count = (uint32_t) child_count;
+	}
+
+	dest->__root = __ndm_xml_compact_node_ptr(&nodes[0]);
+	done = true;
+
+out:
+	free(queue);
+	free(names);
+	free(slots);
+
+	if (!done) {
+		ndm_xml_document_clear(dest);
+	}
+
+	return done;
+}
+
+bool ndm_xml_document_is_compact(
+		const struct ndm_xml_document_t *doc)
+{
+	return doc->__root != NULL && __ndm_xml_node_is_compact(doc->__root);
+}
+
+ndm_xml_atom_t ndm_xml_document_atom(
+		const struct ndm_xml_document_t *doc,
+		const char *const name)
+{
+	const struct ndm_xml_atoms_t *atoms = doc->__atoms;
+	const struct ndm_xml_atom_entry_t *e;
+	size_t size;
+
+	if (name == NULL) {
+		return NDM_XML_ATOM_NONE;
+	}
+
+	if (ndm_xml_document_is_compact(doc)) {
+		return __ndm_xml_compact_atom(
+			__ndm_xml_compact_of(__ndm_xml_compact_node(doc->__root)),
+			name);
+	}
+
+	if (atoms == NULL || atoms->capacity == 0) {
+		return NDM_XML_ATOM_NONE;
+	}
+
+	size = strlen(name);
+	e = *__ndm_xml_atoms_slot(atoms->entries, atoms->capacity,
+		__ndm_xml_atoms_hash(name, size), name, size);
+
+	return (e == NULL) ? NDM_XML_ATOM_NONE : e->atom;
+}
+
+static struct ndm_xml_node_t *__ndm_xml_document_copy_node(
+		const struct ndm_xml_node_t *node,
+		struct ndm_xml_document_t *dest)
+{
+	struct ndm_xml_node_t *new_node =
+		ndm_xml_document_alloc_node(dest, ndm_xml_node_type(node),
+			ndm_xml_document_alloc_str(dest, ndm_xml_node_name(node)),
+			ndm_xml_document_alloc_str(dest, ndm_xml_node_value(node)));
+
+	if (new_node != NULL) {
+		struct ndm_xml_attr_t *attr = ndm_xml_node_first_attr(node, NULL);
+		struct ndm_xml_node_t *child = ndm_xml_node_first_child(node, NULL);
+
+		while (
+			attr != NULL &&
+			ndm_xml_node_append_attr_str(
+				new_node,
+				ndm_xml_attr_name(attr),
+				ndm_xml_attr_value(attr)) != NULL)
+		{
+			attr = ndm_xml_attr_next(attr, NULL);
+		}
+
+		while (child != NULL && ndm_xml_document_is_valid(dest)) {
+			struct ndm_xml_node_t *new_child =
+				__ndm_xml_document_copy_node(child, dest);
+
+			if (new_child != NULL) {
+				ndm_xml_node_append_child(new_node, new_child);
+				child = ndm_xml_node_next_sibling(child, NULL);
+			}
+		}
+	}
+
+	return ndm_xml_document_is_valid(dest) ? new_node : NULL;
+}
+
+bool ndm_xml_document_copy(
+		struct ndm_xml_document_t *dest,
+		const struct ndm_xml_document_t *source)
+{
+	bool copied = true;
+
+	ndm_xml_document_clear(dest);
+
+	if (!ndm_xml_document_is_empty(source)) {
+		dest->__root = __ndm_xml_document_copy_node(source->__root, dest);
+
+		if (!ndm_xml_document_is_valid(dest)) {
+			ndm_xml_document_clear(dest);
+			copied = false;
+		}
+	}
+
+	return copied;
+}
+
+static bool __ndm_xml_node_is_equal(
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t *other)
+{
+	bool equal =
+		ndm_xml_node_type(node) == ndm_xml_node_type(other) &&
+		ndm_xml_node_name_size(node) == ndm_xml_node_name_size(other) &&
+		ndm_xml_node_value_size(node) == ndm_xml_node_value_size(other) &&
+		strcmp(ndm_xml_node_name(node), ndm_xml_node_name(other)) == 0 &&
+		strcmp(ndm_xml_node_value(node), ndm_xml_node_value(other)) == 0;
+
+	if (equal) {
+		struct ndm_xml_attr_t *attr =
+			ndm_xml_node_first_attr(node, NULL);
+		struct ndm_xml_attr_t *other_attr =
+			ndm_xml_node_first_attr(other, NULL);
+
+		while (attr != NULL && other_attr != NULL && equal) {
+			equal =
+				ndm_xml_attr_name_size(attr) ==
+					ndm_xml_attr_name_size(other_attr) &&
+				ndm_xml_attr_value_size(attr) ==
+					ndm_xml_attr_value_size(other_attr) &&
+				(strcmp(
+					ndm_xml_attr_name(attr),
+					ndm_xml_attr_name(other_attr)) == 0) &&
+				(strcmp(
+					ndm_xml_attr_value(attr),
+					ndm_xml_attr_value(other_attr)) == 0);
+			attr = ndm_xml_attr_next(attr, NULL);
+			other_attr = ndm_xml_attr_next(other_attr, NULL);
+		}
+
+		equal = equal && attr == NULL && other_attr == NULL;
+
+		if (equal) {
+			struct ndm_xml_node_t *child =
+				ndm_xml_node_first_child(node, NULL);
+			struct ndm_xml_node_t *other_child =
+				ndm_xml_node_first_child(other, NULL);
+
+			while (child != NULL && other_child != NULL && equal) {
+				equal = __ndm_xml_node_is_equal(child, other_child);
+				child = ndm_xml_node_next_sibling(child, NULL);
+				other_child = ndm_xml_node_next_sibling(other_child, NULL);
+			}
+
+			equal = equal && child == NULL && other_child == NULL;
+		}
+	}
+
+	return equal;
+}
+
+bool ndm_xml_document_is_equal(
+		const struct ndm_xml_document_t *doc,
+		const struct ndm_xml_document_t *other)
+{
+	bool equal = false;
+
+	if (ndm_xml_document_is_valid(doc) &&
+		ndm_xml_document_is_valid(other))
+	{
+		if (ndm_xml_document_is_empty(doc) &&
+			ndm_xml_document_is_empty(other))
+		{
+			equal = true;
+		} else
+		if (!ndm_xml_document_is_empty(doc) &&
+			!ndm_xml_document_is_empty(other))
+		{
+			equal = __ndm_xml_node_is_equal(doc->__root, other->__root);
+		} else {
+			/* not equal */
+		}
+	}
+
+	return equal;
+}
+
+enum ndm_xml_document_parse_error_t ndm_xml_document_parse(
+		struct ndm_xml_document_t *doc,
+		char *text,
+		const enum ndm_xml_document_parse_flags_t flags)
+{
+	enum ndm_xml_document_parse_error_t code =
+		__ndm_xml_parser_do(doc, text, flags);
+
+	if (code != NDM_XML_DOCUMENT_PARSE_ERROR_OK ||
+		!ndm_xml_document_is_valid(doc))
+	{
+		ndm_xml_document_clear(doc);
+
+		if (!ndm_xml_document_is_valid(doc)) {
+			code = NDM_XML_DOCUMENT_PARSE_ERROR_OOM;
+		}
+	}
+
+	return code;
+}
+
+/**
+ * Incremental XML document parser functions.
+ **/
+
+void ndm_xml_document_parser_init(
+		struct ndm_xml_document_parser_t *parser,
+		struct ndm_xml_document_t *doc,
+		const enum ndm_xml_document_parse_flags_t flags)
+{
+	parser->__doc = doc;
+	parser->__node = ndm_xml_document_alloc_root(doc);
+	parser->__flags = flags;
+	parser->__error = (parser->__node == NULL) ?
+		NDM_XML_DOCUMENT_PARSE_ERROR_OOM :
+		NDM_XML_DOCUMENT_PARSE_ERROR_OK;
+	parser->__buffer = NULL;
+	parser->__size = 0;
+	parser->__capacity = 0;
+	parser->__started = false;
+	__ndm_xml_parser_unit_reset(parser, false);
+}
+
+static enum ndm_xml_document_parse_error_t __ndm_xml_parser_result(
+		struct ndm_xml_document_parser_t *parser,
+		enum ndm_xml_document_parse_error_t code)
+{
+	if (code != NDM_XML_DOCUMENT_PARSE_ERROR_OK ||
+		!ndm_xml_document_is_valid(parser->__doc))
+	{
+		ndm_xml_document_clear(parser->__doc);
+
+		if (!ndm_xml_document_is_valid(parser->__doc)) {
+			code = NDM_XML_DOCUMENT_PARSE_ERROR_OOM;
+		}
+
+		parser->__error = code;
+	}
+
+	return code;
+}
+
+enum ndm_xml_document_parse_error_t ndm_xml_document_parser_feed(
+		struct ndm_xml_document_parser_t *parser,
+		const char *data,
+		const size_t size)
+{
+	if (parser->__error != NDM_XML_DOCUMENT_PARSE_ERROR_OK) {
+		return parser->__error;
+	}
+
+	return __ndm_xml_parser_result(parser,
+		__ndm_xml_parser_feed(parser, data, size));
+}
+
+enum ndm_xml_document_parse_error_t ndm_xml_document_parser_finish(
+		struct ndm_xml_document_parser_t *parser)
+{
+	enum ndm_xml_document_parse_error_t code = parser->__error;
+
+	if (code == NDM_XML_DOCUMENT_PARSE_ERROR_OK) {
+		code = __ndm_xml_parser_result(parser,
+			__ndm_xml_parser_finish(parser));
+	}
+
+	ndm_xml_document_parser_clear(parser);
+
+	return code;
+}
+
+void ndm_xml_document_parser_clear(
+		struct ndm_xml_document_parser_t *parser)
+{
+	free(parser->__buffer);
+	parser->__buffer = NULL;
+	parser->__size = 0;
+	parser->__capacity = 0;
+}
+
+void *ndm_xml_document_alloc(
+		struct ndm_xml_document_t *doc,
+		const size_t size)
+{
+	return ndm_pool_malloc(&doc->__pool, size);
+}
+
+struct ndm_xml_node_t *ndm_xml_document_alloc_root(
+		struct ndm_xml_document_t *doc)
+{
+	ndm_xml_document_clear(doc);
+
+	if ((doc->__root = ndm_xml_document_alloc_node(
+			doc, NDM_XML_NODE_TYPE_DOCUMENT, NULL, NULL)) == NULL)
+	{
+		ndm_xml_document_clear(doc);
+	}
+
+	return ndm_xml_document_root(doc);
+}
+
+struct ndm_xml_node_t *ndm_xml_document_alloc_node(
+		struct ndm_xml_document_t *doc,
+		const enum ndm_xml_node_type_t type,
+		const char *const name,
+		const char *const value)
+{
+	struct ndm_xml_node_t *node = (struct ndm_xml_node_t *)
+		ndm_pool_malloc(&doc->__pool, sizeof(*node));
+
+	if (node != NULL) {
+		node->type = (uint8_t) type;
+		node->document = doc;
+		node->parent = NULL;
+		node->first_child = NULL;
+		node->last_child = NULL;
+		node->first_attr = NULL;
+		node->last_attr = NULL;
+		node->next_sibling = NULL;
+		node->prev_sibling = NULL;
+		node->child_count = 0;
+		node->child_index = NULL;
+		ndm_xml_node_set_name(node, name);
+		ndm_xml_node_set_value(node, value);
 	}
 
 	return node;
 }
 
-struct ndm_xml_attr_t *ndm_xml_document_alloc_attr(
-		struct ndm_xml_document_t *doc,
+struct ndm_xml_attr_t *ndm_xml_document_alloc_attr(
+		struct ndm_xml_document_t *doc,
+		const char *const name,
+		const char *const value)
+{
+	struct ndm_xml_attr_t *attr = (struct ndm_xml_attr_t *)
+		ndm_pool_malloc(&doc->__pool, sizeof(*attr));
+
+	if (attr != NULL) {
+		attr->compact = false;
+		attr->document = doc;
+		ndm_xml_attr_set_name(attr, name);
+		ndm_xml_attr_set_value(attr, value);
+		attr->node = NULL;
+		attr->next = NULL;
+		attr->prev = NULL;
+	}
+
+	return attr;
+}
+
+char *ndm_xml_document_alloc_str(
+		struct ndm_xml_document_t *doc,
+		const char *const s)
+{
+	return ndm_pool_strdup(&doc->__pool, s);
+}
+
+char *ndm_xml_document_alloc_strn(
+		struct ndm_xml_document_t *doc,
+		const char *const s,
+		const size_t size)
+{
+	return ndm_pool_strndup(&doc->__pool, s, size);
+}
+
+void ndm_xml_document_clear(
+		struct ndm_xml_document_t *doc)
+{
+	ndm_pool_clear(&doc->__pool);
+	doc->__root = NULL;
+	doc->__atoms = NULL;
+}
+
+bool ndm_xml_document_is_valid(
+		const struct ndm_xml_document_t *doc)
+{
+	return ndm_pool_is_valid(&doc->__pool);
+}
+
+bool ndm_xml_document_is_empty(
+		const struct ndm_xml_document_t *doc)
+{
+	return doc->__root == NULL;
+}
+
+size_t ndm_xml_document_size(
+		const struct ndm_xml_document_t *doc)
+{
+	return ndm_pool_total_dynamic_size(&doc->__pool);
+}
+
+size_t ndm_xml_document_allocated_size(
+		const struct ndm_xml_document_t *doc)
+{
+	return ndm_pool_allocated(&doc->__pool);
+}
+
+struct ndm_xml_node_t *ndm_xml_document_root(
+		const struct ndm_xml_document_t *doc)
+{
+	return doc->__root;
+}
+
+/**
+ * XML printer functions.
+ */
+
+#define NDM_XML_PRINT_INDENT_STEP_						2	/* two spaces */
+#define NDM_XML_PRINT_BUFSIZE_							4096
+
+#define NDM_XML_PRINT_ESCAPE_TEXT_						0x01
+#define NDM_XML_PRINT_ESCAPE_ATTR_						0x02
+
+struct ndm_xml_print_context_t_;
+
+typedef bool (*ndm_xml_print_sink_t_)(
+		struct ndm_xml_print_context_t_ *ctx,
+		const char *data,
+		const size_t size);
+
+struct ndm_xml_print_context_t_
+{
+	enum ndm_xml_print_flags_t flags;
+	size_t indent;							//!< current indent
+	ndm_xml_print_sink_t_ sink;				//!< output of full chunks
+	char *xml;								//!< heap or caller buffer
+	size_t xml_size;						//!< without null-terminator
+	size_t xml_capacity;					//!< heap or caller buffer size
+	int fd;									//!< output descriptor
+	char buffer[NDM_XML_PRINT_BUFSIZE_];	//!< static print buffer
+	char *pp;								//!< @c buffer put position
+	bool ok;								//!< XML printing state
+};
+
+static bool __ndm_xml_print_sink_heap(
+		struct ndm_xml_print_context_t_ *ctx,
+		const char *data,
+		const size_t size)
+{
+	if (ctx->xml_capacity - ctx->xml_size < size + 1) {
+		/**
+		 * Grow geometrically to keep a long output linear,
+		 * the result is trimmed once printing is done.
+		 **/
+
+		size_t capacity =
+			ctx->xml_capacity == 0 ? NDM_XML_PRINT_BUFSIZE_ : ctx->xml_capacity;
+		char *xml = NULL;
+
+		while (capacity - ctx->xml_size < size + 1) {
+			if (capacity > SIZE_MAX / 2) {
+				return false;
+			}
+
+			capacity *= 2;
+		}
+
+		if ((xml = realloc(ctx->xml, capacity)) == NULL) {
+			return false;
+		}
+
+		ctx->xml = xml;
+		ctx->xml_capacity = capacity;
+	}
+
+	memcpy(ctx->xml + ctx->xml_size, data, size);
+	ctx->xml_size += size;
+	ctx->xml[ctx->xml_size] = '\0';
+
+	return true;
+}
+
+static bool __ndm_xml_print_sink_buffer(
+		struct ndm_xml_print_context_t_ *ctx,
+		const char *data,
+		const size_t size)
+{
+	/**
+	 * Continue counting the output size on overflow
+	 * to report a required buffer size.
+	 **/
+
+	if (ctx->xml_size < ctx->xml_capacity) {
+		const size_t avail = ctx->xml_capacity - ctx->xml_size;
+
+		memcpy(ctx->xml + ctx->xml_size, data,
+			size < avail ? size : avail);
+	}
+
+	ctx->xml_size += size;
+
+	return true;
+}
+
+static bool __ndm_xml_print_sink_fd(
+		struct ndm_xml_print_context_t_ *ctx,
+		const char *data,
+		const size_t size)
+{
+	size_t written = 0;
+
+	while (written < size) {
+		const ssize_t n = write(ctx->fd, data + written, size - written);
+
+		if (n < 0) {
+			if (errno != EINTR) {
+				return false;
+			}
+		} else {
+			written += (size_t) n;
+		}
+	}
+
+	ctx->xml_size += size;
+
+	return true;
+}
+
+static void __ndm_xml_print_init(
+		struct ndm_xml_print_context_t_ *ctx,
+		const enum ndm_xml_print_flags_t flags,
+		ndm_xml_print_sink_t_ sink)
+{
+	ctx->flags = flags;
+	ctx->indent = 0;
+	ctx->sink = sink;
+	ctx->xml = NULL;
+	ctx->xml_size = 0;
+	ctx->xml_capacity = 0;
+	ctx->fd = -1;
+	ctx->pp = ctx->buffer;
+	ctx->ok = true;
+}
+
+static void __ndm_xml_print_flush(
+		struct ndm_xml_print_context_t_ *ctx)
+{
+	const size_t buffered = (size_t) (ctx->pp - ctx->buffer);
+
+	if (ctx->ok && buffered > 0 && !ctx->sink(ctx, ctx->buffer, buffered)) {
+		ctx->ok = false;
+	}
+
+	/**
+	 * Always reset a pointer.
+	 **/
+
+	ctx->pp = ctx->buffer;
+}
+
+static void __ndm_xml_print_data(
+		struct ndm_xml_print_context_t_ *ctx,
+		const char *const data,
+		const size_t size)
+{
+	const size_t avail =
+		(size_t) (ctx->buffer + sizeof(ctx->buffer) - ctx->pp);
+
+	if (size <= avail) {
+		memcpy(ctx->pp, data, size);
+		ctx->pp += size;
+	} else {
+		__ndm_xml_print_flush(ctx);
+
+		if (size < sizeof(ctx->buffer)) {
+			memcpy(ctx->pp, data, size);
+			ctx->pp += size;
+		} else
+		if (ctx->ok && !ctx->sink(ctx, data, size)) {
+			/**
+			 * Long data is passed to a sink without copying.
+			 **/
+
+			ctx->ok = false;
+		}
+	}
+}
+
+#define NDM_XML_PRINT_CSTR_(ctx, cstr)				\
+	__ndm_xml_print_data(ctx, cstr, sizeof(cstr) - 1)
+
+static inline void __ndm_xml_print_char(
+		struct ndm_xml_print_context_t_ *ctx,
+		const char c)
+{
+	if (ctx->pp == ctx->buffer + sizeof(ctx->buffer)) {
+		__ndm_xml_print_flush(ctx);
+	}
+
+	*ctx->pp++ = c;
+}
+
+static void __ndm_xml_print_indent(
+		struct ndm_xml_print_context_t_ *ctx)
+{
+	if (!(ctx->flags & NDM_XML_PRINT_FLAGS_COMPACT)) {
+		size_t indent = ctx->indent;
+
+		if (ctx->flags & NDM_XML_PRINT_FLAGS_CRLF) {
+			NDM_XML_PRINT_CSTR_(ctx, "\r\n");
+		} else {
+			__ndm_xml_print_char(ctx, '\n');
+		}
+
+		while (indent > 0) {
+			__ndm_xml_print_char(ctx, ' ');
+			--indent;
+		}
+	}
+}
+
+static void __ndm_xml_print_escaped(
+		struct ndm_xml_print_context_t_ *ctx,
+		const char *const value,
+		const size_t size,
+		const uint8_t escape)
+{
+	static const uint8_t ESCAPE_[256] =
+	{
+		['&'] = NDM_XML_PRINT_ESCAPE_TEXT_ | NDM_XML_PRINT_ESCAPE_ATTR_,
+		['<'] = NDM_XML_PRINT_ESCAPE_TEXT_ | NDM_XML_PRINT_ESCAPE_ATTR_,
+		['>'] = NDM_XML_PRINT_ESCAPE_TEXT_ | NDM_XML_PRINT_ESCAPE_ATTR_,
+		['"'] = NDM_XML_PRINT_ESCAPE_ATTR_
+	};
+
+	const char *s = value;
+	const char *end = value + size;
+
+	while (s < end) {
+		const char *run = s;
+
+		/**
+		 * Characters without entities are copied in runs.
+		 **/
+
+		while (s < end && !(ESCAPE_[(unsigned char) *s] & escape)) {
+			++s;
+		}
+
+		__ndm_xml_print_data(ctx, run, (size_t) (s - run));
+
+		if (s < end) {
+			switch (*s++) {
+				case '&':
+					NDM_XML_PRINT_CSTR_(ctx, "&amp;");
+					break;
+
+				case '<':
+					NDM_XML_PRINT_CSTR_(ctx, "&lt;");
+					break;
+
+				case '>':
+					NDM_XML_PRINT_CSTR_(ctx, "&gt;");
+					break;
+
+				default:
+					NDM_XML_PRINT_CSTR_(ctx, "&quot;");
+					break;
+			}
+		}
+	}
+}
+
+static void __ndm_xml_print_attrs(
+		struct ndm_xml_print_context_t_ *ctx,
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_attr_t *attr = ndm_xml_node_first_attr(node, NULL);
+
+	while (attr != NULL) {
+		__ndm_xml_print_char(ctx, ' ');
+		__ndm_xml_print_data(ctx, ndm_xml_attr_name(attr),
+			ndm_xml_attr_name_size(attr));
+		NDM_XML_PRINT_CSTR_(ctx, "=\"");
+		__ndm_xml_print_escaped(ctx, ndm_xml_attr_value(attr),
+			ndm_xml_attr_value_size(attr),
+			NDM_XML_PRINT_ESCAPE_ATTR_);
+		__ndm_xml_print_char(ctx, '"');
+
+		attr = ndm_xml_attr_next(attr, NULL);
+	}
+}
+
+static void __ndm_xml_print_node(
+		struct ndm_xml_print_context_t_ *ctx,
+		const struct ndm_xml_node_t *node);
+
+static void __ndm_xml_print_children(
+		struct ndm_xml_print_context_t_ *ctx,
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_node_t *child = ndm_xml_node_first_child(node, NULL);
+
+	while (child != NULL && ctx->ok) {
+		__ndm_xml_print_indent(ctx);
+		__ndm_xml_print_node(ctx, child);
+
+		child = ndm_xml_node_next_sibling(child, NULL);
+	}
+}
+
+static bool __ndm_xml_print_has_data_child(
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_node_t *child = ndm_xml_node_first_child(node, NULL);
+
+	while (child != NULL) {
+		if (ndm_xml_node_type(child) == NDM_XML_NODE_TYPE_DATA) {
+			return true;
+		}
+
+		child = ndm_xml_node_next_sibling(child, NULL);
+	}
+
+	return false;
+}
+
+static void __ndm_xml_print_element(
+		struct ndm_xml_print_context_t_ *ctx,
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_node_t *child = ndm_xml_node_first_child(node, NULL);
+
+	__ndm_xml_print_char(ctx, '<');
+	__ndm_xml_print_data(ctx, ndm_xml_node_name(node),
+		ndm_xml_node_name_size(node));
+	__ndm_xml_print_attrs(ctx, node);
+
+	if (child == NULL && ndm_xml_node_value_size(node) == 0) {
+		NDM_XML_PRINT_CSTR_(ctx, "/>");
+
+		return;
+	}
+
+	__ndm_xml_print_char(ctx, '>');
+
+	if (child == NULL) {
+		/**
+		 * An element without data nodes.
+		 **/
+
+		__ndm_xml_print_escaped(ctx, ndm_xml_node_value(node),
+			ndm_xml_node_value_size(node),
+			NDM_XML_PRINT_ESCAPE_TEXT_);
+	} else
+	if (ndm_xml_node_next_sibling(child, NULL) == NULL &&
+		ndm_xml_node_type(child) == NDM_XML_NODE_TYPE_DATA)
+	{
+		/**
+		 * A single data node is printed inline.
+		 **/
+
+		__ndm_xml_print_node(ctx, child);
+	} else {
+		if (ndm_xml_node_value_size(node) > 0 &&
+			!__ndm_xml_print_has_data_child(node))
+		{
+			/**
+			 * An own element value is printed as leading text,
+			 * otherwise it is a copy of a first data node.
+			 **/
+
+			__ndm_xml_print_escaped(ctx, ndm_xml_node_value(node),
+				ndm_xml_node_value_size(node),
+				NDM_XML_PRINT_ESCAPE_TEXT_);
+		}
+
+		ctx->indent += NDM_XML_PRINT_INDENT_STEP_;
+		__ndm_xml_print_children(ctx, node);
+		ctx->indent -= NDM_XML_PRINT_INDENT_STEP_;
+		__ndm_xml_print_indent(ctx);
+	}
+
+	NDM_XML_PRINT_CSTR_(ctx, "</");
+	__ndm_xml_print_data(ctx, ndm_xml_node_name(node),
+		ndm_xml_node_name_size(node));
+	__ndm_xml_print_char(ctx, '>');
+}
+
+static void __ndm_xml_print_node(
+		struct ndm_xml_print_context_t_ *ctx,
+		const struct ndm_xml_node_t *node)
+{
+	switch (ndm_xml_node_type(node)) {
+		case NDM_XML_NODE_TYPE_DOCUMENT:
+		{
+			const struct ndm_xml_node_t *child = ndm_xml_node_first_child(node, NULL);
+
+			while (child != NULL && ctx->ok) {
+				__ndm_xml_print_node(ctx, child);
+
+				child = ndm_xml_node_next_sibling(child, NULL);
+
+				if (child != NULL) {
+					__ndm_xml_print_indent(ctx);
+				}
+			}
+
+			break;
+		}
+
+		case NDM_XML_NODE_TYPE_ELEMENT:
+			__ndm_xml_print_element(ctx, node);
+			break;
+
+		case NDM_XML_NODE_TYPE_DATA:
+			__ndm_xml_print_escaped(ctx, ndm_xml_node_value(node),
+				ndm_xml_node_value_size(node),
+				NDM_XML_PRINT_ESCAPE_TEXT_);
+			break;
+
+		case NDM_XML_NODE_TYPE_CDATA:
+			NDM_XML_PRINT_CSTR_(ctx, "<![CDATA[");
+			__ndm_xml_print_data(ctx, ndm_xml_node_value(node),
+				ndm_xml_node_value_size(node));
+			NDM_XML_PRINT_CSTR_(ctx, "]]>");
+			break;
+
+		case NDM_XML_NODE_TYPE_COMMENT:
+			NDM_XML_PRINT_CSTR_(ctx, "<!--");
+			__ndm_xml_print_data(ctx, ndm_xml_node_value(node),
+				ndm_xml_node_value_size(node));
+			NDM_XML_PRINT_CSTR_(ctx, "-->");
+			break;
+
+		case NDM_XML_NODE_TYPE_DECLARATION:
+			NDM_XML_PRINT_CSTR_(ctx, "<?xml");
+			__ndm_xml_print_attrs(ctx, node);
+			NDM_XML_PRINT_CSTR_(ctx, "?>");
+			break;
+
+		case NDM_XML_NODE_TYPE_DOCTYPE:
+			NDM_XML_PRINT_CSTR_(ctx, "<!DOCTYPE ");
+			__ndm_xml_print_data(ctx, ndm_xml_node_value(node),
+				ndm_xml_node_value_size(node));
+			__ndm_xml_print_char(ctx, '>');
+			break;
+
+		case NDM_XML_NODE_TYPE_PI:
+			NDM_XML_PRINT_CSTR_(ctx, "<?");
+			__ndm_xml_print_data(ctx, ndm_xml_node_name(node),
+				ndm_xml_node_name_size(node));
+
+			if (ndm_xml_node_value_size(node) > 0) {
+				__ndm_xml_print_char(ctx, ' ');
+				__ndm_xml_print_data(ctx, ndm_xml_node_value(node),
+					ndm_xml_node_value_size(node));
+			}
+
+			NDM_XML_PRINT_CSTR_(ctx, "?>");
+			break;
+	}
+}
+
+char *ndm_xml_node_print(
+		const struct ndm_xml_node_t *node,
+		const enum ndm_xml_print_flags_t flags,
+		size_t *xml_size)
+{
+	struct ndm_xml_print_context_t_ ctx;
+
+	__ndm_xml_print_init(&ctx, flags, __ndm_xml_print_sink_heap);
+	__ndm_xml_print_node(&ctx, node);
+	__ndm_xml_print_flush(&ctx);
+
+	if (ctx.ok && ctx.xml == NULL) {
+		/**
+		 * An empty output.
+		 **/
+
+		if ((ctx.xml = malloc(1)) == NULL) {
+			ctx.ok = false;
+		} else {
+			ctx.xml[0] = '\0';
+		}
+	} else
+	if (ctx.ok && ctx.xml_size + 1 < ctx.xml_capacity) {
+		char *xml = realloc(ctx.xml, ctx.xml_size + 1);
+
+		/**
+		 * A failed trim keeps a larger block valid.
+		 **/
+
+		if (xml != NULL) {
+			ctx.xml = xml;
+		}
+	}
+
+	if (xml_size != NULL) {
+		*xml_size = ctx.ok ? ctx.xml_size : 0;
+	}
+
+	if (ctx.ok) {
+		return ctx.xml;
+	}
+
+	free(ctx.xml);
+	errno = ENOMEM;
+
+	return NULL;
+}
+
+bool ndm_xml_node_print_buffer(
+		const struct ndm_xml_node_t *node,
+		const enum ndm_xml_print_flags_t flags,
+		char *buffer,
+		const size_t buffer_size,
+		size_t *xml_size)
+{
+	struct ndm_xml_print_context_t_ ctx;
+
+	__ndm_xml_print_init(&ctx, flags, __ndm_xml_print_sink_buffer);
+	ctx.xml = buffer;
+	ctx.xml_capacity = buffer_size;
+	__ndm_xml_print_node(&ctx, node);
+	__ndm_xml_print_flush(&ctx);
+
+	if (xml_size != NULL) {
+		*xml_size = ctx.xml_size;
+	}
+
+	if (ctx.xml_size >= buffer_size) {
+		if (buffer_size > 0) {
+			buffer[buffer_size - 1] = '\0';
+		}
+
+		errno = ENOBUFS;
+
+		return false;
+	}
+
+	buffer[ctx.xml_size] = '\0';
+
+	return true;
+}
+
+bool ndm_xml_node_print_fd(
+		const struct ndm_xml_node_t *node,
+		const enum ndm_xml_print_flags_t flags,
+		const int fd)
+{
+	struct ndm_xml_print_context_t_ ctx;
+
+	__ndm_xml_print_init(&ctx, flags, __ndm_xml_print_sink_fd);
+	ctx.fd = fd;
+	__ndm_xml_print_node(&ctx, node);
+	__ndm_xml_print_flush(&ctx);
+
+	return ctx.ok;
+}
+
+char *ndm_xml_document_print(
+		const struct ndm_xml_document_t *doc,
+		const enum ndm_xml_print_flags_t flags,
+		size_t *xml_size)
+{
+	if (doc->__root == NULL) {
+		char *xml = malloc(1);
+
+		if (xml != NULL) {
+			xml[0] = '\0';
+		}
+
+		if (xml_size != NULL) {
+			*xml_size = 0;
+		}
+
+		return xml;
+	}
+
+	return ndm_xml_node_print(doc->__root, flags, xml_size);
+}
+
+bool ndm_xml_document_print_buffer(
+		const struct ndm_xml_document_t *doc,
+		const enum ndm_xml_print_flags_t flags,
+		char *buffer,
+		const size_t buffer_size,
+		size_t *xml_size)
+{
+	if (doc->__root == NULL) {
+		if (xml_size != NULL) {
+			*xml_size = 0;
+		}
+
+		if (buffer_size == 0) {
+			errno = ENOBUFS;
+
+			return false;
+		}
+
+		buffer[0] = '\0';
+
+		return true;
+	}
+
+	return ndm_xml_node_print_buffer(
+		doc->__root, flags, buffer, buffer_size, xml_size);
+}
+
+bool ndm_xml_document_print_fd(
+		const struct ndm_xml_document_t *doc,
+		const enum ndm_xml_print_flags_t flags,
+		const int fd)
+{
+	return
+		doc->__root == NULL ||
+		ndm_xml_node_print_fd(doc->__root, flags, fd);
+}
+
+/**
+ * XML node functions.
+ */
+
+static bool __ndm_xml_node_build_child_index(
+		struct ndm_xml_node_t *node);
+
+/**
+ * Called by mutators after a child count is updated. A stale index
+ * is refreshed by the next lookup, it is grown here if children
+ * do not fit it anymore since lookups never allocate.
+ **/
+
+static void __ndm_xml_node_invalidate_index(
+		struct ndm_xml_node_t *node)
+{
+	struct ndm_xml_child_index_t *index = node->child_index;
+
+	if (index == NULL) {
+		return;
+	}
+
+	index->is_valid = false;
+
+	if (node->child_count > index->capacity) {
+		/* a failed allocation invalidates a document */
+		(void) __ndm_xml_node_build_child_index(node);
+	}
+}
+
+static struct ndm_xml_node_t **__ndm_xml_child_index_slot(
+		const struct ndm_xml_child_index_t *index,
 		const char *const name,
+		const size_t size)
+{
+	const size_t mask = 2*index->capacity - 1;
+	size_t i = __ndm_xml_atoms_hash(name, size) & mask;
+
+	while (index->slots[i] != NULL &&
+		!(index->slots[i]->name_size == size &&
+		  memcmp(index->slots[i]->name, name, size) == 0))
+	{
+		i = (i + 1) & mask;
+	}
+
+	return &index->slots[i];
+}
+
+static void __ndm_xml_child_index_add(
+		struct ndm_xml_child_index_t *index,
+		const size_t position,
+		struct ndm_xml_node_t *child)
+{
+	struct ndm_xml_node_t **slot = __ndm_xml_child_index_slot(
+		index, child->name, child->name_size);
+
+	index->children[position] = child;
+
+	if (*slot == NULL) {
+		*slot = child;
+	}
+}
+
+/**
+ * (Re)builds an index of a node, fails only on no memory.
+ * It never allocates if all children fit an existing index.
+ **/
+
+static bool __ndm_xml_node_build_child_index(
+		struct ndm_xml_node_t *node)
+{
+	struct ndm_xml_child_index_t *index = node->child_index;
+	struct ndm_xml_node_t *child = node->first_child;
+	size_t position = 0;
+
+	if (index == NULL) {
+		if ((index = ndm_xml_document_alloc(
+				node->document, sizeof(*index))) == NULL)
+		{
+			return false;
+		}
+
+		index->children = NULL;
+		index->slots = NULL;
+		index->capacity = 0;
+		index->is_valid = false;
+		node->child_index = index;
+	}
+
+	if (index->capacity < node->child_count) {
+		size_t capacity = NDM_XML_CHILD_INDEX_MIN_CAPACITY_;
+		struct ndm_xml_node_t **children;
+		struct ndm_xml_node_t **slots;
+
+		while (capacity < node->child_count) {
+			capacity *= 2;
+		}
+
+		if ((children = ndm_xml_document_alloc(
+				node->document, capacity*sizeof(*children))) == NULL ||
+			(slots = ndm_xml_document_alloc(
+				node->document, 2*capacity*sizeof(*slots))) == NULL)
+		{
+			return false;
+		}
+
+		index->children = children;
+		index->slots = slots;
+		index->capacity = capacity;
+	}
+
+	memset(index->slots, 0, 2*index->capacity*sizeof(*index->slots));
+
+	while (child != NULL) {
+		__ndm_xml_child_index_add(index, position++, child);
+		child = child->next_sibling;
+	}
+
+	index->is_valid = true;
+
+	return true;
+}
+
+/**
+ * Returns a valid index of a node or @c NULL to scan children linearly.
+ * A stale index is rebuilt in place, mutators keep it large enough.
+ **/
+
+static inline const struct ndm_xml_child_index_t *__ndm_xml_node_child_index(
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_child_index_t *index = node->child_index;
+
+	if (index == NULL) {
+		return NULL;
+	}
+
+	if (!index->is_valid && node->child_count <= index->capacity) {
+		(void) __ndm_xml_node_build_child_index(
+			(struct ndm_xml_node_t *) node);
+	}
+
+	return index->is_valid ? index : NULL;
+}
+
+enum ndm_xml_node_type_t ndm_xml_node_type(
+		const struct ndm_xml_node_t *node)
+{
+	return (enum ndm_xml_node_type_t) (node->type & NDM_XML_NODE_TYPE_MASK_);
+}
+
+const char *ndm_xml_node_name(
+		const struct ndm_xml_node_t *node)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		const struct ndm_xml_compact_node_t *c = __ndm_xml_compact_node(node);
+
+		return __ndm_xml_compact_name(__ndm_xml_compact_of(c), c->name);
+	}
+
+	return node->name;
+}
+
+size_t ndm_xml_node_name_size(
+		const struct ndm_xml_node_t *node)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		const struct ndm_xml_compact_node_t *c = __ndm_xml_compact_node(node);
+		const struct ndm_xml_compact_t *compact = __ndm_xml_compact_of(c);
+
+		return __ndm_xml_compact_str_size(compact, compact->names[c->name]);
+	}
+
+	return node->name_size;
+}
+
+ndm_xml_atom_t ndm_xml_node_atom(
+		const struct ndm_xml_node_t *node)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_node(node)->name;
+	}
+
+	return node->atom;
+}
+
+const char *ndm_xml_node_value(
+		const struct ndm_xml_node_t *node)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		const struct ndm_xml_compact_node_t *c = __ndm_xml_compact_node(node);
+
+		return __ndm_xml_compact_str(__ndm_xml_compact_of(c), c->value);
+	}
+
+	return node->value;
+}
+
+size_t ndm_xml_node_value_size(
+		const struct ndm_xml_node_t *node)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		const struct ndm_xml_compact_node_t *c = __ndm_xml_compact_node(node);
+
+		return __ndm_xml_compact_str_size(__ndm_xml_compact_of(c), c->value);
+	}
+
+	return node->value_size;
+}
+
+struct ndm_xml_node_t *ndm_xml_node_parent(
+		const struct ndm_xml_node_t *node)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		const struct ndm_xml_compact_node_t *c = __ndm_xml_compact_node(node);
+
+		return (c->index == 0) ? NULL : __ndm_xml_compact_node_ptr(
+			&__ndm_xml_compact_of(c)->nodes[c->parent]);
+	}
+
+	return node->parent;
+}
+
+void ndm_xml_node_set_name(
+		struct ndm_xml_node_t *node,
+		const char *const name)
+{
+	/* a compact document is read-only */
+	assert (!__ndm_xml_node_is_compact(node));
+
+	node->name = (name == NULL) ? "" : name;
+	node->name_size = strlen(node->name);
+	node->atom = __ndm_xml_document_intern(
+		node->document, node->name, node->name_size);
+
+	if (node->parent != NULL) {
+		/* a parent index is keyed by child names */
+		__ndm_xml_node_invalidate_index(node->parent);
+	}
+}
+
+void ndm_xml_node_set_value(
+		struct ndm_xml_node_t *node,
 		const char *const value)
 {
-	struct ndm_xml_attr_t *attr = (struct ndm_xml_attr_t *)
-		ndm_pool_malloc(&doc->__pool, sizeof(*attr));
+	assert (!__ndm_xml_node_is_compact(node));
+
+	node->value = (value == NULL) ? "" : value;
+	node->value_size = strlen(node->value);
+}
+
+struct ndm_xml_document_t *ndm_xml_node_document(
+		const struct ndm_xml_node_t *node)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_of(__ndm_xml_compact_node(node))->document;
+	}
+
+	return node->document;
+}
+
+/**
+ * Compact siblings are adjacent, so they are walked by an index
+ * until a node without a next (or previous) sibling is reached.
+ * An empty name matches any node.
+ **/
+
+static struct ndm_xml_node_t *__ndm_xml_compact_find_node(
+		const struct ndm_xml_compact_node_t *c,
+		const bool forward,
+		const bool any,
+		const ndm_xml_atom_t atom)
+{
+	const uint8_t more = forward ?
+		NDM_XML_COMPACT_HAS_NEXT_ :
+		NDM_XML_COMPACT_HAS_PREV_;
+
+	while (c != NULL && !any && c->name != atom) {
+		c = ((c->flags & more) == 0) ? NULL : (forward ? c + 1 : c - 1);
+	}
+
+	return __ndm_xml_compact_node_ptr(c);
+}
+
+static struct ndm_xml_node_t *__ndm_xml_compact_find_node_name(
+		const struct ndm_xml_compact_node_t *c,
+		const bool forward,
+		const char *const name)
+{
+	const bool any = __ndm_xml_name_is_empty(name);
+	const struct ndm_xml_compact_t *compact;
+	ndm_xml_atom_t atom = NDM_XML_ATOM_NONE;
+
+	if (c == NULL || any) {
+		return __ndm_xml_compact_node_ptr(c);
+	}
+
+	compact = __ndm_xml_compact_of(c);
+
+	/* a name is hashed only when the nearest node does not match */
+	if (strcmp(__ndm_xml_compact_name(compact, c->name), name) == 0) {
+		return __ndm_xml_compact_node_ptr(c);
+	}
+
+	if ((atom = __ndm_xml_compact_atom(compact, name)) == NDM_XML_ATOM_NONE) {
+		/* a name is not used in a document */
+		return NULL;
+	}
+
+	return __ndm_xml_compact_find_node(c, forward, false, atom);
+}
+
+static const struct ndm_xml_compact_node_t *__ndm_xml_compact_child(
+		const struct ndm_xml_node_t *node,
+		const bool first)
+{
+	const struct ndm_xml_compact_node_t *c = __ndm_xml_compact_node(node);
+
+	if (c->first_child == 0) {
+		return NULL;
+	}
+
+	return &__ndm_xml_compact_of(c)->nodes[
+		first ? c->first_child : c->first_child + c->child_count - 1];
+}
+
+static const struct ndm_xml_compact_node_t *__ndm_xml_compact_sibling(
+		const struct ndm_xml_node_t *node,
+		const bool next)
+{
+	const struct ndm_xml_compact_node_t *c = __ndm_xml_compact_node(node);
 
-	if (attr != NULL) {
-		ndm_xml_attr_set_name(attr, name);
-		ndm_xml_attr_set_value(attr, value);
-		attr->document = doc;
-		attr->node = NULL;
-		attr->next = NULL;
-		attr->prev = NULL;
+	if (next) {
+		return ((c->flags & NDM_XML_COMPACT_HAS_NEXT_) == 0) ? NULL : c + 1;
 	}
 
-	return attr;
+	return ((c->flags & NDM_XML_COMPACT_HAS_PREV_) == 0) ? NULL : c - 1;
 }
 
-char *ndm_xml_document_alloc_str(
-		struct ndm_xml_document_t *doc,
-		const char *const s)
+static struct ndm_xml_attr_t *__ndm_xml_compact_find_attr(
+		const struct ndm_xml_compact_attr_t *a,
+		const bool forward,
+		const bool any,
+		const ndm_xml_atom_t atom)
 {
-	return ndm_pool_strdup(&doc->__pool, s);
+	while (a != NULL && !any && a->name != atom) {
+		const struct ndm_xml_compact_node_t *c =
+			__ndm_xml_compact_attr_node(a);
+
+		if (forward) {
+			a = (a->index + 1 < c->attr_count) ? a + 1 : NULL;
+		} else {
+			a = (a->index > 0) ? a - 1 : NULL;
+		}
+	}
+
+	return __ndm_xml_compact_attr_ptr(a);
 }
 
-char *ndm_xml_document_alloc_strn(
-		struct ndm_xml_document_t *doc,
-		const char *const s,
-		const size_t size)
+static struct ndm_xml_attr_t *__ndm_xml_compact_find_attr_name(
+		const struct ndm_xml_compact_attr_t *a,
+		const bool forward,
+		const char *const name)
 {
-	return ndm_pool_strndup(&doc->__pool, s, size);
+	const bool any = __ndm_xml_name_is_empty(name);
+	const struct ndm_xml_compact_t *compact;
+	ndm_xml_atom_t atom = NDM_XML_ATOM_NONE;
+
+	if (a == NULL || any) {
+		return __ndm_xml_compact_attr_ptr(a);
+	}
+
+	compact = __ndm_xml_compact_of(__ndm_xml_compact_attr_node(a));
+
+	/* a name is hashed only when the nearest attr does not match */
+	if (strcmp(__ndm_xml_compact_name(compact, a->name), name) == 0) {
+		return __ndm_xml_compact_attr_ptr(a);
+	}
+
+	if ((atom = __ndm_xml_compact_atom(compact, name)) == NDM_XML_ATOM_NONE) {
+		return NULL;
+	}
+
+	return __ndm_xml_compact_find_attr(a, forward, false, atom);
 }
 
-void ndm_xml_document_clear(
-		struct ndm_xml_document_t *doc)
+static const struct ndm_xml_compact_attr_t *__ndm_xml_compact_node_attr(
+		const struct ndm_xml_node_t *node,
+		const bool first)
 {
-	ndm_pool_clear(&doc->__pool);
-	doc->__root = NULL;
+	const struct ndm_xml_compact_node_t *c = __ndm_xml_compact_node(node);
+
+	if (c->attr_count == 0) {
+		return NULL;
+	}
+
+	return &__ndm_xml_compact_of(c)->attrs[
+		first ? c->first_attr : c->first_attr + c->attr_count - 1u];
 }
 
-bool ndm_xml_document_is_valid(
-		const struct ndm_xml_document_t *doc)
+static const struct ndm_xml_compact_attr_t *__ndm_xml_compact_attr_sibling(
+		const struct ndm_xml_attr_t *attr,
+		const bool next)
 {
-	return ndm_pool_is_valid(&doc->__pool);
+	const struct ndm_xml_compact_attr_t *a = __ndm_xml_compact_attr(attr);
+
+	if (next) {
+		return (a->index + 1 < __ndm_xml_compact_attr_node(a)->attr_count) ?
+			a + 1 : NULL;
+	}
+
+	return (a->index > 0) ? a - 1 : NULL;
 }
 
-bool ndm_xml_document_is_empty(
-		const struct ndm_xml_document_t *doc)
+static struct ndm_xml_node_t *__ndm_xml_node_find_next(
+		struct ndm_xml_node_t *n,
+		const char *const name,
+		const ndm_xml_atom_t atom)
 {
-	return doc->__root == NULL;
+	while (n != NULL &&
+		!__ndm_xml_name_matches(n->name, n->atom, name, atom))
+	{
+		n = n->next_sibling;
+	}
+
+	return n;
 }
 
-size_t ndm_xml_document_size(
-		const struct ndm_xml_document_t *doc)
+static struct ndm_xml_node_t *__ndm_xml_node_find_prev(
+		struct ndm_xml_node_t *n,
+		const char *const name,
+		const ndm_xml_atom_t atom)
 {
-	return ndm_pool_total_dynamic_size(&doc->__pool);
+	while (n != NULL &&
+		!__ndm_xml_name_matches(n->name, n->atom, name, atom))
+	{
+		n = n->prev_sibling;
+	}
+
+	return n;
 }
 
-size_t ndm_xml_document_allocated_size(
-		const struct ndm_xml_document_t *doc)
+static struct ndm_xml_attr_t *__ndm_xml_attr_find_next(
+		struct ndm_xml_attr_t *a,
+		const char *const name,
+		const ndm_xml_atom_t atom)
 {
-	return ndm_pool_allocated(&doc->__pool);
+	while (a != NULL &&
+		!__ndm_xml_name_matches(a->name, a->atom, name, atom))
+	{
+		a = a->next;
+	}
+
+	return a;
 }
 
-struct ndm_xml_node_t *ndm_xml_document_root(
-		const struct ndm_xml_document_t *doc)
+static struct ndm_xml_attr_t *__ndm_xml_attr_find_prev(
+		struct ndm_xml_attr_t *a,
+		const char *const name,
+		const ndm_xml_atom_t atom)
 {
-	return doc->__root;
-}
+	while (a != NULL &&
+		!__ndm_xml_name_matches(a->name, a->atom, name, atom))
+	{
+		a = a->prev;
+	}
 
-/**
- * XML node functions.
- */
+	return a;
+}
 
-enum ndm_xml_node_type_t ndm_xml_node_type(
-		const struct ndm_xml_node_t *node)
+static struct ndm_xml_node_t *__ndm_xml_node_find_next_name(
+		struct ndm_xml_node_t *n,
+		const char *const name)
 {
-	return node->type;
+	/* a name is hashed only when the nearest node does not match */
+	if (__ndm_xml_name_is_empty(name) ||
+		n == NULL ||
+		strcmp(n->name, name) == 0)
+	{
+		return n;
+	}
+
+	return __ndm_xml_node_find_next(n->next_sibling,
+		name, ndm_xml_document_atom(n->document, name));
 }
 
-const char *ndm_xml_node_name(
-		const struct ndm_xml_node_t *node)
+static struct ndm_xml_node_t *__ndm_xml_node_find_prev_name(
+		struct ndm_xml_node_t *n,
+		const char *const name)
 {
-	return node->name;
+	/* a name is hashed only when the nearest node does not match */
+	if (__ndm_xml_name_is_empty(name) ||
+		n == NULL ||
+		strcmp(n->name, name) == 0)
+	{
+		return n;
+	}
+
+	return __ndm_xml_node_find_prev(n->prev_sibling,
+		name, ndm_xml_document_atom(n->document, name));
 }
 
-size_t ndm_xml_node_name_size(
-		const struct ndm_xml_node_t *node)
+static struct ndm_xml_attr_t *__ndm_xml_attr_find_next_name(
+		struct ndm_xml_attr_t *a,
+		const char *const name)
 {
-	return node->name_size;
+	/* a name is hashed only when the nearest attr does not match */
+	if (__ndm_xml_name_is_empty(name) ||
+		a == NULL ||
+		strcmp(a->name, name) == 0)
+	{
+		return a;
+	}
+
+	return __ndm_xml_attr_find_next(a->next,
+		name, ndm_xml_document_atom(a->document, name));
 }
 
-const char *ndm_xml_node_value(
-		const struct ndm_xml_node_t *node)
+static struct ndm_xml_attr_t *__ndm_xml_attr_find_prev_name(
+		struct ndm_xml_attr_t *a,
+		const char *const name)
 {
-	return node->value;
+	/* a name is hashed only when the nearest attr does not match */
+	if (__ndm_xml_name_is_empty(name) ||
+		a == NULL ||
+		strcmp(a->name, name) == 0)
+	{
+		return a;
+	}
+
+	return __ndm_xml_attr_find_prev(a->prev,
+		name, ndm_xml_document_atom(a->document, name));
 }
 
-size_t ndm_xml_node_value_size(
-		const struct ndm_xml_node_t *node)
+struct ndm_xml_node_t *ndm_xml_node_first_child(
+		const struct ndm_xml_node_t *node,
+		const char *const name)
 {
-	return node->value_size;
+	const struct ndm_xml_child_index_t *index;
+
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_node_name(
+			__ndm_xml_compact_child(node, true), true, name);
+	}
+
+	if (!__ndm_xml_name_is_empty(name) &&
+		node->first_child != NULL &&
+		strcmp(node->first_child->name, name) != 0 &&
+		(index = __ndm_xml_node_child_index(node)) != NULL)
+	{
+		/* a wide node is looked up by a name hash */
+		return *__ndm_xml_child_index_slot(index, name, strlen(name));
+	}
+
+	return __ndm_xml_node_find_next_name(node->first_child, name);
 }
 
-struct ndm_xml_node_t *ndm_xml_node_parent(
-		const struct ndm_xml_node_t *node)
+struct ndm_xml_node_t *ndm_xml_node_first_child_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom)
 {
-	return node->parent;
+	const struct ndm_xml_child_index_t *index;
+	const char *name;
+
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_node(
+			__ndm_xml_compact_child(node, true), true, false, atom);
+	}
+
+	name = __ndm_xml_document_atom_name(node->document, atom);
+
+	if (name != NULL &&
+		node->first_child != NULL &&
+		node->first_child->atom != atom &&
+		(index = __ndm_xml_node_child_index(node)) != NULL)
+	{
+		return *__ndm_xml_child_index_slot(index, name, strlen(name));
+	}
+
+	return __ndm_xml_node_find_next(node->first_child, name, atom);
 }
 
-void ndm_xml_node_set_name(
-		struct ndm_xml_node_t *node,
+struct ndm_xml_node_t *ndm_xml_node_last_child(
+		const struct ndm_xml_node_t *node,
 		const char *const name)
 {
-	node->name = (name == NULL) ? "" : name;
-	node->name_size = strlen(node->name);
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_node_name(
+			__ndm_xml_compact_child(node, false), false, name);
+	}
+
+	return __ndm_xml_node_find_prev_name(node->last_child, name);
 }
 
-void ndm_xml_node_set_value(
-		struct ndm_xml_node_t *node,
-		const char *const value)
+struct ndm_xml_node_t *ndm_xml_node_last_child_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom)
 {
-	node->value = (value == NULL) ? "" : value;
-	node->value_size = strlen(node->value);
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_node(
+			__ndm_xml_compact_child(node, false), false, false, atom);
+	}
+
+	return __ndm_xml_node_find_prev(node->last_child,
+		__ndm_xml_document_atom_name(node->document, atom), atom);
 }
 
-struct ndm_xml_document_t *ndm_xml_node_document(
+size_t ndm_xml_node_child_count(
 		const struct ndm_xml_node_t *node)
 {
-	return node->document;
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_node(node)->child_count;
+	}
+
+	return node->child_count;
 }
 
-struct ndm_xml_node_t *ndm_xml_node_first_child(
+struct ndm_xml_node_t *ndm_xml_node_nth_child(
 		const struct ndm_xml_node_t *node,
-		const char *const name)
+		const size_t n)
 {
-	struct ndm_xml_node_t *n = node->first_child;
+	const struct ndm_xml_child_index_t *index;
+	struct ndm_xml_node_t *child;
+	size_t i = 0;
 
-	if (!__ndm_xml_name_is_empty(name)) {
-		while (n != NULL && strcmp(n->name, name) != 0) {
-			n = n->next_sibling;
-		}
+	if (n >= ndm_xml_node_child_count(node)) {
+		return NULL;
 	}
 
-	return n;
+	if (__ndm_xml_node_is_compact(node)) {
+		const struct ndm_xml_compact_node_t *c = __ndm_xml_compact_node(node);
+
+		return __ndm_xml_compact_node_ptr(
+			&__ndm_xml_compact_of(c)->nodes[c->first_child + n]);
+	}
+
+	if ((index = __ndm_xml_node_child_index(node)) != NULL) {
+		return index->children[n];
+	}
+
+	child = node->first_child;
+
+	while (i++ < n) {
+		child = child->next_sibling;
+	}
+
+	return child;
 }
 
-struct ndm_xml_node_t *ndm_xml_node_last_child(
-		const struct ndm_xml_node_t *node,
-		const char *const name)
+bool ndm_xml_node_index_children(
+		struct ndm_xml_node_t *node)
 {
-	struct ndm_xml_node_t *n = node->last_child;
-
-	if (node->first_child != NULL &&
-		!__ndm_xml_name_is_empty(name))
+	if (__ndm_xml_node_is_compact(node) ||
+		__ndm_xml_node_child_index(node) != NULL)
 	{
-		while (n != NULL && strcmp(n->name, name) != 0) {
-			n = n->prev_sibling;
-		}
+		return true;
 	}
 
-	return n;
+	if (!__ndm_xml_node_build_child_index(node)) {
+		errno = ENOMEM;
+
+		return false;
+	}
+
+	return true;
 }
 
 struct ndm_xml_node_t *ndm_xml_node_next_sibling(
 		const struct ndm_xml_node_t *node,
 		const char *const name)
 {
-	struct ndm_xml_node_t* s = node->next_sibling;
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_node_name(
+			__ndm_xml_compact_sibling(node, true), true, name);
+	}
 
 	/* cannot query for siblings if a node has no parent */
 	assert (node->parent != NULL);
 
-	if (!__ndm_xml_name_is_empty(name)) {
-		while (s != NULL && strcmp(s->name, name) != 0) {
-			s = s->next_sibling;
-		}
+	return __ndm_xml_node_find_next_name(node->next_sibling, name);
+}
+
+struct ndm_xml_node_t *ndm_xml_node_next_sibling_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_node(
+			__ndm_xml_compact_sibling(node, true), true, false, atom);
 	}
 
-	return s;
+	/* cannot query for siblings if a node has no parent */
+	assert (node->parent != NULL);
+
+	return __ndm_xml_node_find_next(node->next_sibling,
+		__ndm_xml_document_atom_name(node->document, atom), atom);
 }
 
 struct ndm_xml_node_t *ndm_xml_node_prev_sibling(
 		const struct ndm_xml_node_t *node,
 		const char *const name)
 {
-	struct ndm_xml_node_t* s = node->prev_sibling;
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_node_name(
+			__ndm_xml_compact_sibling(node, false), false, name);
+	}
 
 	/* cannot query for siblings if a node has no parent */
 	assert (node->parent != NULL);
 
-	if (!__ndm_xml_name_is_empty(name)) {
-		while (s != NULL && strcmp(s->name, name) != 0) {
-			s = s->prev_sibling;
-		}
+	return __ndm_xml_node_find_prev_name(node->prev_sibling, name);
+}
+
+struct ndm_xml_node_t *ndm_xml_node_prev_sibling_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_node(
+			__ndm_xml_compact_sibling(node, false), false, false, atom);
 	}
 
-	return s;
+	/* cannot query for siblings if a node has no parent */
+	assert (node->parent != NULL);
+
+	return __ndm_xml_node_find_prev(node->prev_sibling,
+		__ndm_xml_document_atom_name(node->document, atom), atom);
 }
 
 struct ndm_xml_attr_t *ndm_xml_node_first_attr(
 		const struct ndm_xml_node_t *node,
 		const char *const name)
 {
-	struct ndm_xml_attr_t* a = node->first_attr;
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_attr_name(
+			__ndm_xml_compact_node_attr(node, true), true, name);
+	}
 
-	if (!__ndm_xml_name_is_empty(name)) {
-		while (a != NULL && strcmp(a->name, name) != 0) {
-			a = a->next;
-		}
+	return __ndm_xml_attr_find_next_name(node->first_attr, name);
+}
+
+struct ndm_xml_attr_t *ndm_xml_node_first_attr_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_attr(
+			__ndm_xml_compact_node_attr(node, true), true, false, atom);
 	}
 
-	return a;
+	return __ndm_xml_attr_find_next(node->first_attr,
+		__ndm_xml_document_atom_name(node->document, atom), atom);
 }
 
 struct ndm_xml_attr_t *ndm_xml_node_last_attr(
 		const struct ndm_xml_node_t *node,
 		const char *const name)
 {
-	struct ndm_xml_attr_t *a = node->last_attr;
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_attr_name(
+			__ndm_xml_compact_node_attr(node, false), false, name);
+	}
 
-	if (node->first_attr != NULL &&
-		!__ndm_xml_name_is_empty(name))
-	{
-		while (a != NULL && strcmp(a->name, name) != 0) {
-			a = a->prev;
-		}
+	return __ndm_xml_attr_find_prev_name(node->last_attr, name);
+}
+
+struct ndm_xml_attr_t *ndm_xml_node_last_attr_atom(
+		const struct ndm_xml_node_t *node,
+		const ndm_xml_atom_t atom)
+{
+	if (__ndm_xml_node_is_compact(node)) {
+		return __ndm_xml_compact_find_attr(
+			__ndm_xml_compact_node_attr(node, false), false, false, atom);
 	}
 
-	return a;
+	return __ndm_xml_attr_find_prev(node->last_attr,
+		__ndm_xml_document_atom_name(node->document, atom), atom);
 }
 
 void ndm_xml_node_prepend_child(
 		struct ndm_xml_node_t *node,
 		struct ndm_xml_node_t *child)
 {
+	assert (!__ndm_xml_node_is_compact(node));
 	assert(
 		child != NULL &&
 		child->parent == NULL &&
@@ -2105,12 +5062,15 @@ void ndm_xml_node_prepend_child(
 	node->first_child = child;
 	child->parent = node;
 	child->prev_sibling = NULL;
+	++node->child_count;
+	__ndm_xml_node_invalidate_index(node);
 }
 
 void ndm_xml_node_append_child(
 		struct ndm_xml_node_t *node,
 		struct ndm_xml_node_t *child)
 {
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (
 		child != NULL &&
 		child->parent == NULL &&
@@ -2128,6 +5088,19 @@ void ndm_xml_node_append_child(
 	node->last_child = child;
 	child->parent = node;
 	child->next_sibling = NULL;
+
+	if (node->child_index != NULL &&
+		node->child_index->is_valid &&
+		node->child_count < node->child_index->capacity)
+	{
+		/* an appended child does not move other ones */
+		__ndm_xml_child_index_add(
+			node->child_index, node->child_count, child);
+		++node->child_count;
+	} else {
+		++node->child_count;
+		__ndm_xml_node_invalidate_index(node);
+	}
 }
 
 struct ndm_xml_node_t *ndm_xml_node_append_child_str(
@@ -2223,6 +5196,7 @@ void ndm_xml_node_insert_child(
 		struct ndm_xml_node_t *where,
 		struct ndm_xml_node_t *child)
 {
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (node->document == child->document);
 	assert (where == NULL || where->document == node->document);
 	assert (where == NULL || where->parent == node);
@@ -2242,6 +5216,8 @@ void ndm_xml_node_insert_child(
 		where->prev_sibling->next_sibling = child;
 		where->prev_sibling = child;
 		child->parent = node;
+		++node->child_count;
+		__ndm_xml_node_invalidate_index(node);
 	}
 }
 
@@ -2250,6 +5226,7 @@ void ndm_xml_node_remove_first_child(
 {
 	struct ndm_xml_node_t *child = node->first_child;
 
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (node->first_child != NULL);
 
 	node->first_child = child->next_sibling;
@@ -2261,6 +5238,8 @@ void ndm_xml_node_remove_first_child(
 	}
 
 	child->parent = NULL;
+	--node->child_count;
+	__ndm_xml_node_invalidate_index(node);
 }
 
 void ndm_xml_node_remove_last_child(
@@ -2268,6 +5247,7 @@ void ndm_xml_node_remove_last_child(
 {
 	struct ndm_xml_node_t *child = node->last_child;
 
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (node->first_child != NULL);
 
 	if (child->prev_sibling != NULL) {
@@ -2278,12 +5258,15 @@ void ndm_xml_node_remove_last_child(
 	}
 
 	child->parent = NULL;
+	--node->child_count;
+	__ndm_xml_node_invalidate_index(node);
 }
 
 void ndm_xml_node_remove_child(
 		struct ndm_xml_node_t *node,
 		struct ndm_xml_node_t *child)
 {
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (child != NULL && child->parent == node);
 	assert (node->first_child != NULL);
 
@@ -2296,6 +5279,8 @@ void ndm_xml_node_remove_child(
 		child->prev_sibling->next_sibling = child->next_sibling;
 		child->next_sibling->prev_sibling = child->prev_sibling;
 		child->parent = NULL;
+		--node->child_count;
+		__ndm_xml_node_invalidate_index(node);
 	}
 }
 
@@ -2306,11 +5291,13 @@ void ndm_xml_node_remove_all_children(
 	struct ndm_xml_node_t *n =
 		(start_child == NULL) ? node->first_child : start_child;
 
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (start_child == NULL || start_child->parent == node);
 
 	while (n != NULL) {
 		n->parent = NULL;
 		n = n->next_sibling;
+		--node->child_count;
 	}
 
 	if (start_child == NULL || start_child == node->first_child) {
@@ -2318,13 +5305,18 @@ void ndm_xml_node_remove_all_children(
 		node->last_child = NULL;
 	} else {
 		node->last_child = start_child->prev_sibling;
+		node->last_child->next_sibling = NULL;
+		start_child->prev_sibling = NULL;
 	}
+
+	__ndm_xml_node_invalidate_index(node);
 }
 
 void ndm_xml_node_prepend_attr(
 		struct ndm_xml_node_t *node,
 		struct ndm_xml_attr_t *attr)
 {
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (attr != NULL && attr->node == NULL);
 	assert (node->document == attr->document);
 
@@ -2345,6 +5337,7 @@ void ndm_xml_node_append_attr(
 		struct ndm_xml_node_t *node,
 		struct ndm_xml_attr_t *attr)
 {
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (attr != NULL && attr->node == NULL);
 	assert (node->document == attr->document);
 
@@ -2366,6 +5359,7 @@ void ndm_xml_node_insert_attr(
 		struct ndm_xml_attr_t *where,
 		struct ndm_xml_attr_t *attr)
 {
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (where == NULL || where->node == node);
 	assert (where == NULL || node->document == where->document);
 	assert (attr != NULL && attr->node == NULL);
@@ -2390,6 +5384,7 @@ void ndm_xml_node_remove_first_attr(
 {
 	struct ndm_xml_attr_t *attr = node->first_attr;
 
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (attr != NULL);
 
 	if (attr->next != NULL) {
@@ -2407,6 +5402,7 @@ void ndm_xml_node_remove_last_attr(
 {
 	struct ndm_xml_attr_t *attr = node->last_attr;
 
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (node->first_attr != NULL);
 
 	if (attr->prev != NULL) {
@@ -2423,6 +5419,7 @@ void ndm_xml_node_remove_attr(
 		struct ndm_xml_node_t *node,
 		struct ndm_xml_attr_t *where)
 {
+	assert (!__ndm_xml_node_is_compact(node));
 	assert (node->first_attr != NULL && where->node == node);
 
 	if (where == node->first_attr) {
@@ -2442,6 +5439,8 @@ void ndm_xml_node_remove_all_attr(
 {
 	struct ndm_xml_attr_t *a = node->first_attr;
 
+	assert (!__ndm_xml_node_is_compact(node));
+
 	while (a != NULL) {
 		a->node = NULL;
 		a = a->next;
@@ -2457,24 +5456,63 @@ void ndm_xml_node_remove_all_attr(
 const char *ndm_xml_attr_name(
 		const struct ndm_xml_attr_t *attr)
 {
+	if (attr->compact) {
+		const struct ndm_xml_compact_attr_t *a = __ndm_xml_compact_attr(attr);
+
+		return __ndm_xml_compact_name(
+			__ndm_xml_compact_of(__ndm_xml_compact_attr_node(a)), a->name);
+	}
+
 	return attr->name;
 }
 
 size_t ndm_xml_attr_name_size(
 		const struct ndm_xml_attr_t *attr)
 {
+	if (attr->compact) {
+		const struct ndm_xml_compact_attr_t *a = __ndm_xml_compact_attr(attr);
+		const struct ndm_xml_compact_t *compact =
+			__ndm_xml_compact_of(__ndm_xml_compact_attr_node(a));
+
+		return __ndm_xml_compact_str_size(compact, compact->names[a->name]);
+	}
+
 	return attr->name_size;
 }
 
+ndm_xml_atom_t ndm_xml_attr_atom(
+		const struct ndm_xml_attr_t *attr)
+{
+	if (attr->compact) {
+		return __ndm_xml_compact_attr(attr)->name;
+	}
+
+	return attr->atom;
+}
+
 const char *ndm_xml_attr_value(
 		const struct ndm_xml_attr_t *attr)
 {
+	if (attr->compact) {
+		const struct ndm_xml_compact_attr_t *a = __ndm_xml_compact_attr(attr);
+
+		return __ndm_xml_compact_str(
+			__ndm_xml_compact_of(__ndm_xml_compact_attr_node(a)), a->value);
+	}
+
 	return attr->value;
 }
 
 size_t ndm_xml_attr_value_size(
 		const struct ndm_xml_attr_t *attr)
 {
+	if (attr->compact) {
+		const struct ndm_xml_compact_attr_t *a = __ndm_xml_compact_attr(attr);
+
+		return __ndm_xml_compact_str_size(
+			__ndm_xml_compact_of(__ndm_xml_compact_attr_node(a)), a->value);
+	}
+
 	return attr->value_size;
 }
 
@@ -2482,14 +5520,21 @@ void ndm_xml_attr_set_name(
 		struct ndm_xml_attr_t *attr,
 		const char *const name)
 {
+	/* a compact document is read-only */
+	assert (!attr->compact);
+
 	attr->name = (name == NULL) ? "" : name;
 	attr->name_size = strlen(attr->name);
+	attr->atom = __ndm_xml_document_intern(
+		attr->document, attr->name, attr->name_size);
 }
 
 void ndm_xml_attr_set_value(
 		struct ndm_xml_attr_t *attr,
 		const char *const value)
 {
+	assert (!attr->compact);
+
 	attr->value = (value == NULL) ? "" : value;
 	attr->value_size = strlen(attr->value);
 }
@@ -2497,12 +5542,22 @@ void ndm_xml_attr_set_value(
 struct ndm_xml_node_t *ndm_xml_attr_node(
 		const struct ndm_xml_attr_t *attr)
 {
+	if (attr->compact) {
+		return __ndm_xml_compact_node_ptr(
+			__ndm_xml_compact_attr_node(__ndm_xml_compact_attr(attr)));
+	}
+
 	return attr->node;
 }
 
 struct ndm_xml_document_t *ndm_xml_attr_document(
 		const struct ndm_xml_attr_t *attr)
 {
+	if (attr->compact) {
+		return __ndm_xml_compact_of(__ndm_xml_compact_attr_node(
+			__ndm_xml_compact_attr(attr)))->document;
+	}
+
 	return attr->document;
 }
 
@@ -2510,29 +5565,53 @@ struct ndm_xml_attr_t *ndm_xml_attr_next(
 		const struct ndm_xml_attr_t *attr,
 		const char *const name)
 {
-	struct ndm_xml_attr_t *a = (attr->node == NULL) ? NULL : attr->next;
+	if (attr->compact) {
+		return __ndm_xml_compact_find_attr_name(
+			__ndm_xml_compact_attr_sibling(attr, true), true, name);
+	}
 
-	if (!__ndm_xml_name_is_empty(name)) {
-		while (a != NULL && strcmp(a->name, name) != 0) {
-			a = a->next;
-		}
+	return __ndm_xml_attr_find_next_name(
+		(attr->node == NULL) ? NULL : attr->next, name);
+}
+
+struct ndm_xml_attr_t *ndm_xml_attr_next_atom(
+		const struct ndm_xml_attr_t *attr,
+		const ndm_xml_atom_t atom)
+{
+	if (attr->compact) {
+		return __ndm_xml_compact_find_attr(
+			__ndm_xml_compact_attr_sibling(attr, true), true, false, atom);
 	}
 
-	return a;
+	return __ndm_xml_attr_find_next(
+		(attr->node == NULL) ? NULL : attr->next,
+		__ndm_xml_document_atom_name(attr->document, atom), atom);
 }
 
 struct ndm_xml_attr_t *ndm_xml_attr_prev(
 		const struct ndm_xml_attr_t *attr,
 		const char *const name)
 {
-	struct ndm_xml_attr_t *a = (attr->node == NULL) ? NULL : attr->prev;
+	if (attr->compact) {
+		return __ndm_xml_compact_find_attr_name(
+			__ndm_xml_compact_attr_sibling(attr, false), false, name);
+	}
 
-	if (!__ndm_xml_name_is_empty(name)) {
-		while (a != NULL && strcmp(a->name, name) != 0) {
-			a = a->prev;
-		}
+	return __ndm_xml_attr_find_prev_name(
+		(attr->node == NULL) ? NULL : attr->prev, name);
+}
+
+struct ndm_xml_attr_t *ndm_xml_attr_prev_atom(
+		const struct ndm_xml_attr_t *attr,
+		const ndm_xml_atom_t atom)
+{
+	if (attr->compact) {
+		return __ndm_xml_compact_find_attr(
+			__ndm_xml_compact_attr_sibling(attr, false), false, false, atom);
 	}
 
-	return a;
+	return __ndm_xml_attr_find_prev(
+		(attr->node == NULL) ? NULL : attr->prev,
+		__ndm_xml_document_atom_name(attr->document, atom), atom);
 }
 
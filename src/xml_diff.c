@@ -0,0 +1,712 @@
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ndm/xml.h>
+#include <ndm/xml_diff.h>
+
+/**
+ * Both trees are hashed bottom-up in a single pre-order pass before
+ * a diff. Every node gets a subtree hash, a hash of its type, name and
+ * attributes ("head") and a subtree node count, so the hashes of
+ * children are found by skipping subtrees without any lookups.
+ * Matched nodes with equal subtree hashes are skipped at once.
+ *
+ * Children of a changed node are matched in passes: identical
+ * subtrees, nodes with the same head, nodes with the same name and
+ * first attribute (a key of a list item as in "interface name=...")
+ * and at last nodes of the same name if one of them has no attributes.
+ * Nodes of the same name and type are matched in their document order.
+ * Sibling order changes are not reported. Unmatched children are
+ * reported as removed or added subtrees.
+ **/
+
+#define NDM_XML_DIFF_HASH_OFFSET_				14695981039346656037ULL
+#define NDM_XML_DIFF_HASH_PRIME_				1099511628211ULL
+#define NDM_XML_DIFF_INITIAL_CAPACITY_			64
+#define NDM_XML_DIFF_STATIC_ITEMS_				32
+
+enum ndm_xml_diff_key_t
+{
+	NDM_XML_DIFF_KEY_HASH,
+	NDM_XML_DIFF_KEY_HEAD,
+	NDM_XML_DIFF_KEY_FIRST_ATTR,
+	NDM_XML_DIFF_KEY_NAME
+};
+
+struct ndm_xml_diff_hash_t
+{
+	uint64_t hash;							//!< a subtree hash
+	uint64_t head;							//!< a type, name and attributes
+	size_t size;							//!< a subtree node count
+};
+
+struct ndm_xml_diff_tree_t
+{
+	struct ndm_xml_diff_hash_t *hashes;		//!< in pre-order
+	size_t size;
+	size_t capacity;
+};
+
+struct ndm_xml_diff_item_t
+{
+	const struct ndm_xml_node_t *node;
+	const struct ndm_xml_diff_hash_t *hash;
+	struct ndm_xml_diff_item_t *pair;
+	uint64_t key;
+};
+
+struct ndm_xml_diff_state_t
+{
+	struct ndm_xml_diff_tree_t old_tree;
+	struct ndm_xml_diff_tree_t new_tree;
+	ndm_xml_diff_cb_t cb;
+	void *user_data;
+	int error;
+};
+
+static inline uint64_t __ndm_xml_diff_mix(
+		uint64_t hash,
+		const uint64_t value)
+{
+	hash = (hash ^ value)*NDM_XML_DIFF_HASH_PRIME_;
+
+	return hash ^ (hash >> 32);
+}
+
+static inline uint64_t __ndm_xml_diff_hash_str(
+		uint64_t hash,
+		const char *const s,
+		const size_t size)
+{
+	size_t i = 0;
+
+	/* a size prefix keeps "ab"+"c" and "a"+"bc" apart */
+	hash = __ndm_xml_diff_mix(hash, size);
+
+	/* hashes are never stored, so a native byte order is fine */
+	for (i = 0; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		uint64_t word;
+
+		memcpy(&word, s + i, sizeof(word));
+		hash = __ndm_xml_diff_mix(hash, word);
+	}
+
+	for (; i < size; i++) {
+		hash = __ndm_xml_diff_mix(hash, (uint8_t) s[i]);
+	}
+
+	return hash;
+}
+
+static inline uint64_t __ndm_xml_diff_finish(
+		uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+static inline uint64_t __ndm_xml_diff_hash_name(
+		const struct ndm_xml_node_t *node,
+		const bool with_first_attr)
+{
+	const struct ndm_xml_attr_t *attr = ndm_xml_node_first_attr(node, NULL);
+	uint64_t hash = __ndm_xml_diff_hash_str(
+		__ndm_xml_diff_mix(
+			NDM_XML_DIFF_HASH_OFFSET_, (uint64_t) ndm_xml_node_type(node)),
+		ndm_xml_node_name(node), ndm_xml_node_name_size(node));
+
+	if (with_first_attr && attr != NULL) {
+		hash = __ndm_xml_diff_hash_str(
+			__ndm_xml_diff_hash_str(hash,
+				ndm_xml_attr_name(attr), ndm_xml_attr_name_size(attr)),
+			ndm_xml_attr_value(attr), ndm_xml_attr_value_size(attr));
+	}
+
+	return __ndm_xml_diff_finish(hash);
+}
+
+static bool __ndm_xml_diff_hash_node(
+		struct ndm_xml_diff_tree_t *tree,
+		const struct ndm_xml_node_t *node)
+{
+	const size_t index = tree->size;
+	const struct ndm_xml_attr_t *attr = NULL;
+	const struct ndm_xml_node_t *child = NULL;
+	uint64_t head = 0;
+	uint64_t hash = 0;
+
+	if (tree->size == tree->capacity) {
+		const size_t capacity = (tree->capacity == 0) ?
+			NDM_XML_DIFF_INITIAL_CAPACITY_ : tree->capacity*2;
+		struct ndm_xml_diff_hash_t *hashes =
+			realloc(tree->hashes, capacity*sizeof(*hashes));
+
+		if (hashes == NULL) {
+			return false;
+		}
+
+		tree->hashes = hashes;
+		tree->capacity = capacity;
+	}
+
+	tree->size++;
+
+	head = __ndm_xml_diff_hash_str(
+		__ndm_xml_diff_mix(
+			NDM_XML_DIFF_HASH_OFFSET_, (uint64_t) ndm_xml_node_type(node)),
+		ndm_xml_node_name(node), ndm_xml_node_name_size(node));
+
+	for (attr = ndm_xml_node_first_attr(node, NULL);
+		 attr != NULL;
+		 attr = ndm_xml_attr_next(attr, NULL))
+	{
+		head = __ndm_xml_diff_hash_str(
+			__ndm_xml_diff_hash_str(head,
+				ndm_xml_attr_name(attr), ndm_xml_attr_name_size(attr)),
+			ndm_xml_attr_value(attr), ndm_xml_attr_value_size(attr));
+	}
+
+	hash = __ndm_xml_diff_hash_str(head,
+		ndm_xml_node_value(node), ndm_xml_node_value_size(node));
+
+	for (child = ndm_xml_node_first_child(node, NULL);
+		 child != NULL;
+		 child = ndm_xml_node_next_sibling(child, NULL))
+	{
+		const size_t child_index = tree->size;
+
+		if (!__ndm_xml_diff_hash_node(tree, child)) {
+			return false;
+		}
+
+		hash = __ndm_xml_diff_mix(hash, tree->hashes[child_index].hash);
+	}
+
+	tree->hashes[index].hash = __ndm_xml_diff_finish(hash);
+	tree->hashes[index].head = __ndm_xml_diff_finish(head);
+	tree->hashes[index].size = tree->size - index;
+
+	return true;
+}
+
+static bool __ndm_xml_diff_emit(
+		struct ndm_xml_diff_state_t *state,
+		const enum ndm_xml_diff_type_t type,
+		const struct ndm_xml_node_t *old_node,
+		const struct ndm_xml_node_t *new_node,
+		const struct ndm_xml_attr_t *old_attr,
+		const struct ndm_xml_attr_t *new_attr)
+{
+	struct ndm_xml_diff_t diff;
+
+	diff.type = type;
+	diff.old_node = old_node;
+	diff.new_node = new_node;
+	diff.old_attr = old_attr;
+	diff.new_attr = new_attr;
+
+	if (!state->cb(state->user_data, &diff)) {
+		state->error = ECANCELED;
+
+		return false;
+	}
+
+	return true;
+}
+
+static inline bool __ndm_xml_diff_is_same_name(
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t *other)
+{
+	return
+		ndm_xml_node_type(node) == ndm_xml_node_type(other) &&
+		ndm_xml_node_name_size(node) == ndm_xml_node_name_size(other) &&
+		strcmp(ndm_xml_node_name(node), ndm_xml_node_name(other)) == 0;
+}
+
+/**
+ * A parser copies a value of a first data child into an element,
+ * such a value is compared and reported with data nodes only.
+ **/
+
+static bool __ndm_xml_diff_has_own_value(
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_node_t *child = NULL;
+
+	if (ndm_xml_node_type(node) != NDM_XML_NODE_TYPE_ELEMENT) {
+		return true;
+	}
+
+	for (child = ndm_xml_node_first_child(node, NULL);
+		 child != NULL;
+		 child = ndm_xml_node_next_sibling(child, NULL))
+	{
+		if (ndm_xml_node_type(child) == NDM_XML_NODE_TYPE_DATA) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* an attribute of the same name and occurrence number in other node */
+static const struct ndm_xml_attr_t *__ndm_xml_diff_attr_peer(
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_attr_t *attr,
+		const struct ndm_xml_node_t *other)
+{
+	const char *name = ndm_xml_attr_name(attr);
+	const struct ndm_xml_attr_t *a = ndm_xml_node_first_attr(node, name);
+	const struct ndm_xml_attr_t *peer = ndm_xml_node_first_attr(other, name);
+
+	while (a != attr && a != NULL && peer != NULL) {
+		a = ndm_xml_attr_next(a, name);
+		peer = ndm_xml_attr_next(peer, name);
+	}
+
+	return peer;
+}
+
+static bool __ndm_xml_diff_attrs(
+		struct ndm_xml_diff_state_t *state,
+		const struct ndm_xml_node_t *old_node,
+		const struct ndm_xml_node_t *new_node)
+{
+	const struct ndm_xml_attr_t *attr = NULL;
+
+	for (attr = ndm_xml_node_first_attr(old_node, NULL);
+		 attr != NULL;
+		 attr = ndm_xml_attr_next(attr, NULL))
+	{
+		const struct ndm_xml_attr_t *peer =
+			__ndm_xml_diff_attr_peer(old_node, attr, new_node);
+
+		if (peer == NULL) {
+			if (!__ndm_xml_diff_emit(state,
+					NDM_XML_DIFF_TYPE_ATTR_REMOVED,
+					old_node, new_node, attr, NULL))
+			{
+				return false;
+			}
+		} else
+		if (ndm_xml_attr_value_size(attr) !=
+				ndm_xml_attr_value_size(peer) ||
+			strcmp(ndm_xml_attr_value(attr), ndm_xml_attr_value(peer)) != 0)
+		{
+			if (!__ndm_xml_diff_emit(state,
+					NDM_XML_DIFF_TYPE_ATTR_CHANGED,
+					old_node, new_node, attr, peer))
+			{
+				return false;
+			}
+		}
+	}
+
+	for (attr = ndm_xml_node_first_attr(new_node, NULL);
+		 attr != NULL;
+		 attr = ndm_xml_attr_next(attr, NULL))
+	{
+		if (__ndm_xml_diff_attr_peer(new_node, attr, old_node) == NULL &&
+			!__ndm_xml_diff_emit(state,
+				NDM_XML_DIFF_TYPE_ATTR_ADDED,
+				old_node, new_node, NULL, attr))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int __ndm_xml_diff_item_compare(
+		const void *l,
+		const void *r)
+{
+	const struct ndm_xml_diff_item_t *lhs =
+		*(const struct ndm_xml_diff_item_t *const *) l;
+	const struct ndm_xml_diff_item_t *rhs =
+		*(const struct ndm_xml_diff_item_t *const *) r;
+
+	if (lhs->key != rhs->key) {
+		return (lhs->key < rhs->key) ? -1 : 1;
+	}
+
+	/* items of the same key keep their document order */
+	return (lhs < rhs) ? -1 : (lhs > rhs) ? 1 : 0;
+}
+
+static size_t __ndm_xml_diff_sort_unmatched(
+		struct ndm_xml_diff_item_t *items,
+		const size_t count,
+		struct ndm_xml_diff_item_t **sorted,
+		const enum ndm_xml_diff_key_t key)
+{
+	size_t sorted_count = 0;
+	size_t i = 0;
+
+	for (i = 0; i < count; i++) {
+		struct ndm_xml_diff_item_t *item = &items[i];
+
+		if (item->pair != NULL) {
+			continue;
+		}
+
+		switch (key) {
+			case NDM_XML_DIFF_KEY_HASH:
+				item->key = item->hash->hash;
+				break;
+
+			case NDM_XML_DIFF_KEY_HEAD:
+				item->key = item->hash->head;
+				break;
+
+			case NDM_XML_DIFF_KEY_FIRST_ATTR:
+				item->key = __ndm_xml_diff_hash_name(item->node, true);
+				break;
+
+			case NDM_XML_DIFF_KEY_NAME:
+				item->key = __ndm_xml_diff_hash_name(item->node, false);
+				break;
+		}
+
+		sorted[sorted_count++] = item;
+	}
+
+	qsort(sorted, sorted_count, sizeof(*sorted),
+		__ndm_xml_diff_item_compare);
+
+	return sorted_count;
+}
+
+/* pairs unmatched items of equal keys in their document order */
+static void __ndm_xml_diff_match(
+		struct ndm_xml_diff_item_t *old_items,
+		const size_t old_count,
+		struct ndm_xml_diff_item_t *new_items,
+		const size_t new_count,
+		struct ndm_xml_diff_item_t **sorted,
+		const enum ndm_xml_diff_key_t key)
+{
+	struct ndm_xml_diff_item_t **old_sorted = sorted;
+	struct ndm_xml_diff_item_t **new_sorted = NULL;
+	size_t old_sorted_count = 0;
+	size_t new_sorted_count = 0;
+	size_t i = 0;
+	size_t j = 0;
+
+	old_sorted_count = __ndm_xml_diff_sort_unmatched(
+		old_items, old_count, old_sorted, key);
+
+	if (old_sorted_count == 0) {
+		return;
+	}
+
+	new_sorted = old_sorted + old_sorted_count;
+	new_sorted_count = __ndm_xml_diff_sort_unmatched(
+		new_items, new_count, new_sorted, key);
+
+	while (i < old_sorted_count && j < new_sorted_count) {
+		struct ndm_xml_diff_item_t *o = old_sorted[i];
+		struct ndm_xml_diff_item_t *n = new_sorted[j];
+
+		if (o->key < n->key) {
+			i++;
+		} else
+		if (o->key > n->key) {
+			j++;
+		} else
+		if (key != NDM_XML_DIFF_KEY_HASH &&
+			!__ndm_xml_diff_is_same_name(o->node, n->node))
+		{
+			/* a hash collision of different names */
+			i++;
+			j++;
+		} else
+		if (key == NDM_XML_DIFF_KEY_NAME &&
+			ndm_xml_node_first_attr(o->node, NULL) != NULL &&
+			ndm_xml_node_first_attr(n->node, NULL) != NULL)
+		{
+			/* nodes with different keys are different list items,
+			 * the new one may still match an old node with no keys */
+			i++;
+		} else {
+			o->pair = n;
+			n->pair = o;
+			i++;
+			j++;
+		}
+	}
+}
+
+static bool __ndm_xml_diff_nodes(
+		struct ndm_xml_diff_state_t *state,
+		const struct ndm_xml_node_t *old_node,
+		const struct ndm_xml_diff_hash_t *old_hash,
+		const struct ndm_xml_node_t *new_node,
+		const struct ndm_xml_diff_hash_t *new_hash);
+
+static size_t __ndm_xml_diff_fill_items(
+		struct ndm_xml_diff_item_t *items,
+		const struct ndm_xml_node_t *parent,
+		const struct ndm_xml_diff_hash_t *parent_hash)
+{
+	const struct ndm_xml_diff_hash_t *hash = parent_hash + 1;
+	const struct ndm_xml_node_t *child = NULL;
+	size_t count = 0;
+
+	for (child = ndm_xml_node_first_child(parent, NULL);
+		 child != NULL;
+		 child = ndm_xml_node_next_sibling(child, NULL))
+	{
+		items[count].node = child;
+		items[count].hash = hash;
+		items[count].pair = NULL;
+		items[count].key = 0;
+		hash += hash->size;
+		count++;
+	}
+
+	return count;
+}
+
+static bool __ndm_xml_diff_children(
+		struct ndm_xml_diff_state_t *state,
+		const struct ndm_xml_node_t *old_node,
+		const struct ndm_xml_diff_hash_t *old_hash,
+		const struct ndm_xml_node_t *new_node,
+		const struct ndm_xml_diff_hash_t *new_hash)
+{
+	struct ndm_xml_diff_item_t static_items[NDM_XML_DIFF_STATIC_ITEMS_];
+	struct ndm_xml_diff_item_t *static_sorted[NDM_XML_DIFF_STATIC_ITEMS_];
+	struct ndm_xml_diff_item_t *items = static_items;
+	struct ndm_xml_diff_item_t **sorted = static_sorted;
+	struct ndm_xml_diff_item_t *old_items = NULL;
+	struct ndm_xml_diff_item_t *new_items = NULL;
+	const size_t old_count =
+		(old_node == NULL) ? 0 : ndm_xml_node_child_count(old_node);
+	const size_t new_count =
+		(new_node == NULL) ? 0 : ndm_xml_node_child_count(new_node);
+	const size_t count = old_count + new_count;
+	size_t old_end = old_count;
+	size_t new_end = new_count;
+	size_t start = 0;
+	size_t i = 0;
+	bool done = true;
+
+	if (count > NDM_XML_DIFF_STATIC_ITEMS_) {
+		items = malloc(count*(sizeof(*items) + sizeof(*sorted)));
+
+		if (items == NULL) {
+			state->error = ENOMEM;
+
+			return false;
+		}
+
+		sorted = (struct ndm_xml_diff_item_t **) (items + count);
+	}
+
+	old_items = items;
+	new_items = items + old_count;
+
+	if (old_node != NULL) {
+		__ndm_xml_diff_fill_items(old_items, old_node, old_hash);
+	}
+
+	if (new_node != NULL) {
+		__ndm_xml_diff_fill_items(new_items, new_node, new_hash);
+	}
+
+	/* an unchanged prefix and suffix need no sorting */
+	while (start < old_end && start < new_end &&
+		   old_items[start].hash->hash == new_items[start].hash->hash)
+	{
+		old_items[start].pair = &new_items[start];
+		new_items[start].pair = &old_items[start];
+		start++;
+	}
+
+	while (start < old_end && start < new_end &&
+		   old_items[old_end - 1].hash->hash ==
+			new_items[new_end - 1].hash->hash)
+	{
+		old_end--;
+		new_end--;
+		old_items[old_end].pair = &new_items[new_end];
+		new_items[new_end].pair = &old_items[old_end];
+	}
+
+	if (start < old_end && start < new_end) {
+		__ndm_xml_diff_match(
+			old_items + start, old_end - start,
+			new_items + start, new_end - start,
+			sorted, NDM_XML_DIFF_KEY_HASH);
+		__ndm_xml_diff_match(
+			old_items + start, old_end - start,
+			new_items + start, new_end - start,
+			sorted, NDM_XML_DIFF_KEY_HEAD);
+		__ndm_xml_diff_match(
+			old_items + start, old_end - start,
+			new_items + start, new_end - start,
+			sorted, NDM_XML_DIFF_KEY_FIRST_ATTR);
+		__ndm_xml_diff_match(
+			old_items + start, old_end - start,
+			new_items + start, new_end - start,
+			sorted, NDM_XML_DIFF_KEY_NAME);
+	}
+
+	for (i = start; i < old_end && done; i++) {
+		if (old_items[i].pair == NULL) {
+			done = __ndm_xml_diff_emit(state,
+				NDM_XML_DIFF_TYPE_NODE_REMOVED,
+				old_items[i].node, NULL, NULL, NULL);
+		}
+	}
+
+	for (i = start; i < new_end && done; i++) {
+		const struct ndm_xml_diff_item_t *item = &new_items[i];
+
+		if (item->pair == NULL) {
+			done = __ndm_xml_diff_emit(state,
+				NDM_XML_DIFF_TYPE_NODE_ADDED,
+				NULL, item->node, NULL, NULL);
+		} else {
+			done = __ndm_xml_diff_nodes(state,
+				item->pair->node, item->pair->hash,
+				item->node, item->hash);
+		}
+	}
+
+	if (items != static_items) {
+		free(items);
+	}
+
+	return done;
+}
+
+static bool __ndm_xml_diff_nodes(
+		struct ndm_xml_diff_state_t *state,
+		const struct ndm_xml_node_t *old_node,
+		const struct ndm_xml_diff_hash_t *old_hash,
+		const struct ndm_xml_node_t *new_node,
+		const struct ndm_xml_diff_hash_t *new_hash)
+{
+	if (old_hash->hash == new_hash->hash) {
+		return true;
+	}
+
+	if (!__ndm_xml_diff_is_same_name(old_node, new_node)) {
+		return
+			__ndm_xml_diff_emit(state,
+				NDM_XML_DIFF_TYPE_NODE_REMOVED,
+				old_node, NULL, NULL, NULL) &&
+			__ndm_xml_diff_emit(state,
+				NDM_XML_DIFF_TYPE_NODE_ADDED,
+				NULL, new_node, NULL, NULL);
+	}
+
+	if (__ndm_xml_diff_has_own_value(old_node) &&
+		__ndm_xml_diff_has_own_value(new_node) &&
+		(ndm_xml_node_value_size(old_node) !=
+			ndm_xml_node_value_size(new_node) ||
+		 strcmp(ndm_xml_node_value(old_node),
+			ndm_xml_node_value(new_node)) != 0) &&
+		!__ndm_xml_diff_emit(state,
+			NDM_XML_DIFF_TYPE_NODE_CHANGED,
+			old_node, new_node, NULL, NULL))
+	{
+		return false;
+	}
+
+	if (old_hash->head != new_hash->head &&
+		!__ndm_xml_diff_attrs(state, old_node, new_node))
+	{
+		return false;
+	}
+
+	return
+		(old_hash->size == 1 && new_hash->size == 1) ||
+		__ndm_xml_diff_children(state,
+			old_node, old_hash, new_node, new_hash);
+}
+
+static bool __ndm_xml_diff(
+		const struct ndm_xml_node_t *old_node,
+		const struct ndm_xml_node_t *new_node,
+		ndm_xml_diff_cb_t cb,
+		void *user_data)
+{
+	struct ndm_xml_diff_state_t state;
+	bool done = true;
+
+	memset(&state, 0, sizeof(state));
+	state.cb = cb;
+	state.user_data = user_data;
+	state.error = ENOMEM;
+
+	if ((old_node != NULL &&
+		 !__ndm_xml_diff_hash_node(&state.old_tree, old_node)) ||
+		(new_node != NULL &&
+		 !__ndm_xml_diff_hash_node(&state.new_tree, new_node)))
+	{
+		done = false;
+	} else
+	if (old_node != NULL && new_node != NULL) {
+		done = __ndm_xml_diff_nodes(&state,
+			old_node, state.old_tree.hashes,
+			new_node, state.new_tree.hashes);
+	} else {
+		/* an empty document has no children */
+		done = __ndm_xml_diff_children(&state,
+			old_node, state.old_tree.hashes,
+			new_node, state.new_tree.hashes);
+	}
+
+	free(state.old_tree.hashes);
+	free(state.new_tree.hashes);
+
+	if (!done) {
+		errno = state.error;
+	}
+
+	return done;
+}
+
+bool ndm_xml_document_diff(
+		const struct ndm_xml_document_t *old_doc,
+		const struct ndm_xml_document_t *new_doc,
+		ndm_xml_diff_cb_t cb,
+		void *user_data)
+{
+	if (!ndm_xml_document_is_valid(old_doc) ||
+		!ndm_xml_document_is_valid(new_doc))
+	{
+		errno = EINVAL;
+
+		return false;
+	}
+
+	return __ndm_xml_diff(
+		ndm_xml_document_root(old_doc),
+		ndm_xml_document_root(new_doc), cb, user_data);
+}
+
+bool ndm_xml_node_diff(
+		const struct ndm_xml_node_t *old_node,
+		const struct ndm_xml_node_t *new_node,
+		ndm_xml_diff_cb_t cb,
+		void *user_data)
+{
+	if (old_node == NULL || new_node == NULL) {
+		errno = EINVAL;
+
+		return false;
+	}
+
+	return __ndm_xml_diff(old_node, new_node, cb, user_data);
+}
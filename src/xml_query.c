@@ -0,0 +1,1187 @@
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <ndm/int.h>
+#include <ndm/xml.h>
+#include <ndm/xml_query.h>
+
+/**
+ * A compiled query is a sequence of location steps, each with
+ * an axis, a name test and an optional list of predicates.
+ * A path "//name" is evaluated as a descendant step instead of
+ * a "descendant-or-self::node()/child::name" pair, both select
+ * the same nodes.
+ **/
+
+#define NDM_XML_QUERY_MAX_PREDICATES_				32
+
+enum ndm_xml_query_axis_t
+{
+	NDM_XML_QUERY_AXIS_CHILD,
+	NDM_XML_QUERY_AXIS_DESCENDANT,
+	NDM_XML_QUERY_AXIS_DESCENDANT_OR_SELF,
+	NDM_XML_QUERY_AXIS_SELF,
+	NDM_XML_QUERY_AXIS_PARENT,
+	NDM_XML_QUERY_AXIS_ATTR
+};
+
+enum ndm_xml_query_op_t
+{
+	NDM_XML_QUERY_OP_POSITION,
+	NDM_XML_QUERY_OP_EXISTS,
+	NDM_XML_QUERY_OP_EQ,
+	NDM_XML_QUERY_OP_NE,
+	NDM_XML_QUERY_OP_LT,
+	NDM_XML_QUERY_OP_LE,
+	NDM_XML_QUERY_OP_GT,
+	NDM_XML_QUERY_OP_GE
+};
+
+enum ndm_xml_query_operand_t
+{
+	NDM_XML_QUERY_OPERAND_ATTR,
+	NDM_XML_QUERY_OPERAND_CHILD,
+	NDM_XML_QUERY_OPERAND_SELF
+};
+
+struct ndm_xml_query_predicate_t
+{
+	enum ndm_xml_query_op_t op;
+	enum ndm_xml_query_operand_t operand;
+	const char *name;
+	const char *value;
+	long long number;
+	bool is_numeric;
+	size_t position;
+};
+
+struct ndm_xml_query_step_t
+{
+	enum ndm_xml_query_axis_t axis;
+	const char *name;						//!< @c NULL for any name
+	size_t predicate_first;
+	size_t predicate_count;
+	size_t position;						//!< zero if no position
+	bool is_nested;							//!< follows a descendant step
+};
+
+struct ndm_xml_query_t
+{
+	const char *expr;
+	bool is_absolute;
+	size_t step_count;
+	size_t node_step_count;
+	struct ndm_xml_query_step_t steps[NDM_XML_QUERY_MAX_STEPS];
+	struct ndm_xml_query_predicate_t
+		predicates[NDM_XML_QUERY_MAX_PREDICATES_];
+	size_t predicate_count;
+	char *strings_end;
+	char strings[];
+};
+
+/**
+ * Query compilation functions.
+ **/
+
+struct ndm_xml_query_parser_t_
+{
+	struct ndm_xml_query_t *query;
+	const char *p;
+	int error;
+};
+
+static inline bool __ndm_xml_query_is_name_start(const char c)
+{
+	return
+		(c >= 'a' && c <= 'z') ||
+		(c >= 'A' && c <= 'Z') ||
+		c == '_' ||
+		c == ':';
+}
+
+static inline bool __ndm_xml_query_is_name_char(const char c)
+{
+	return
+		__ndm_xml_query_is_name_start(c) ||
+		(c >= '0' && c <= '9') ||
+		c == '-' ||
+		c == '.';
+}
+
+static void __ndm_xml_query_skip_spaces(
+		struct ndm_xml_query_parser_t_ *parser)
+{
+	while (*parser->p == ' ' || *parser->p == '\t') {
+		++parser->p;
+	}
+}
+
+static const char *__ndm_xml_query_copy(
+		struct ndm_xml_query_parser_t_ *parser,
+		const char *const s,
+		const size_t size)
+{
+	char *copy = parser->query->strings_end;
+
+	memcpy(copy, s, size);
+	copy[size] = '\0';
+	parser->query->strings_end += size + 1;
+
+	return copy;
+}
+
+static const char *__ndm_xml_query_parse_name(
+		struct ndm_xml_query_parser_t_ *parser)
+{
+	const char *start = parser->p;
+
+	if (!__ndm_xml_query_is_name_start(*parser->p)) {
+		return NULL;
+	}
+
+	while (__ndm_xml_query_is_name_char(*parser->p)) {
+		++parser->p;
+	}
+
+	return __ndm_xml_query_copy(
+		parser, start, (size_t) (parser->p - start));
+}
+
+static bool __ndm_xml_query_parse_literal(
+		struct ndm_xml_query_parser_t_ *parser,
+		struct ndm_xml_query_predicate_t *predicate)
+{
+	const char *start = parser->p;
+
+	if (*parser->p == '\'' || *parser->p == '"') {
+		const char quote = *parser->p++;
+
+		start = parser->p;
+
+		while (*parser->p != quote) {
+			if (*parser->p == '\0') {
+				return false;
+			}
+
+			++parser->p;
+		}
+
+		predicate->value = __ndm_xml_query_copy(
+			parser, start, (size_t) (parser->p - start));
+		++parser->p;
+
+		return true;
+	}
+
+	if (*parser->p == '-') {
+		++parser->p;
+	}
+
+	while (*parser->p >= '0' && *parser->p <= '9') {
+		++parser->p;
+	}
+
+	predicate->value = __ndm_xml_query_copy(
+		parser, start, (size_t) (parser->p - start));
+	predicate->is_numeric = true;
+
+	return ndm_int_parse_llong(predicate->value, &predicate->number);
+}
+
+static bool __ndm_xml_query_parse_op(
+		struct ndm_xml_query_parser_t_ *parser,
+		struct ndm_xml_query_predicate_t *predicate)
+{
+	const char c = *parser->p;
+	const bool eq = (c != '\0' && parser->p[1] == '=');
+
+	if (c == '=') {
+		predicate->op = NDM_XML_QUERY_OP_EQ;
+	} else
+	if (c == '!' && eq) {
+		predicate->op = NDM_XML_QUERY_OP_NE;
+	} else
+	if (c == '<') {
+		predicate->op = eq ? NDM_XML_QUERY_OP_LE : NDM_XML_QUERY_OP_LT;
+	} else
+	if (c == '>') {
+		predicate->op = eq ? NDM_XML_QUERY_OP_GE : NDM_XML_QUERY_OP_GT;
+	} else {
+		predicate->op = NDM_XML_QUERY_OP_EXISTS;
+
+		return true;
+	}
+
+	parser->p += (c != '=' && eq) ? 2 : 1;
+	__ndm_xml_query_skip_spaces(parser);
+
+	if (!__ndm_xml_query_parse_literal(parser, predicate)) {
+		return false;
+	}
+
+	/* an order is defined for numbers only */
+	return
+		predicate->is_numeric ||
+		predicate->op == NDM_XML_QUERY_OP_EQ ||
+		predicate->op == NDM_XML_QUERY_OP_NE;
+}
+
+static bool __ndm_xml_query_parse_predicate(
+		struct ndm_xml_query_parser_t_ *parser,
+		struct ndm_xml_query_step_t *step)
+{
+	struct ndm_xml_query_t *query = parser->query;
+	struct ndm_xml_query_predicate_t *predicate;
+
+	if (query->predicate_count == NDM_XML_QUERY_MAX_PREDICATES_) {
+		parser->error = E2BIG;
+
+		return false;
+	}
+
+	predicate = &query->predicates[query->predicate_count++];
+	memset(predicate, 0, sizeof(*predicate));
+	++step->predicate_count;
+
+	++parser->p;
+	__ndm_xml_query_skip_spaces(parser);
+
+	if (*parser->p >= '0' && *parser->p <= '9') {
+		const char *start = parser->p;
+		unsigned long position = 0;
+
+		while (*parser->p >= '0' && *parser->p <= '9') {
+			++parser->p;
+		}
+
+		/* a single position is supported for child and descendant steps */
+		if (!ndm_int_parse_ulong(__ndm_xml_query_copy(
+				parser, start, (size_t) (parser->p - start)), &position) ||
+			position == 0 ||
+			step->position != 0 ||
+			(step->axis != NDM_XML_QUERY_AXIS_CHILD &&
+			 step->axis != NDM_XML_QUERY_AXIS_DESCENDANT))
+		{
+			return false;
+		}
+
+		predicate->op = NDM_XML_QUERY_OP_POSITION;
+		predicate->position = position;
+		step->position = position;
+	} else {
+		if (*parser->p == '@') {
+			++parser->p;
+			predicate->operand = NDM_XML_QUERY_OPERAND_ATTR;
+		} else
+		if (*parser->p == '.') {
+			++parser->p;
+			predicate->operand = NDM_XML_QUERY_OPERAND_SELF;
+		} else {
+			predicate->operand = NDM_XML_QUERY_OPERAND_CHILD;
+		}
+
+		if (predicate->operand != NDM_XML_QUERY_OPERAND_SELF &&
+			(predicate->name = __ndm_xml_query_parse_name(parser)) == NULL)
+		{
+			return false;
+		}
+
+		__ndm_xml_query_skip_spaces(parser);
+
+		if (!__ndm_xml_query_parse_op(parser, predicate)) {
+			return false;
+		}
+	}
+
+	__ndm_xml_query_skip_spaces(parser);
+
+	if (*parser->p != ']') {
+		return false;
+	}
+
+	++parser->p;
+
+	return true;
+}
+
+static inline bool __ndm_xml_query_axis_is_descendant(
+		const enum ndm_xml_query_axis_t axis)
+{
+	return
+		axis == NDM_XML_QUERY_AXIS_DESCENDANT ||
+		axis == NDM_XML_QUERY_AXIS_DESCENDANT_OR_SELF;
+}
+
+static struct ndm_xml_query_step_t *__ndm_xml_query_add_step(
+		struct ndm_xml_query_parser_t_ *parser,
+		const enum ndm_xml_query_axis_t axis)
+{
+	struct ndm_xml_query_t *query = parser->query;
+	struct ndm_xml_query_step_t *step;
+
+	if (query->step_count == NDM_XML_QUERY_MAX_STEPS) {
+		parser->error = E2BIG;
+
+		return NULL;
+	}
+
+	step = &query->steps[query->step_count++];
+	step->axis = axis;
+	step->name = NULL;
+	step->predicate_first = query->predicate_count;
+	step->predicate_count = 0;
+	step->position = 0;
+	step->is_nested = false;
+
+	if (__ndm_xml_query_axis_is_descendant(axis)) {
+		for (size_t i = 0; i + 1 < query->step_count; i++) {
+			step->is_nested = step->is_nested ||
+				__ndm_xml_query_axis_is_descendant(query->steps[i].axis);
+		}
+	}
+
+	return step;
+}
+
+static bool __ndm_xml_query_parse_step(
+		struct ndm_xml_query_parser_t_ *parser,
+		const bool descendant)
+{
+	struct ndm_xml_query_step_t *step;
+
+	if (parser->p[0] == '.' && parser->p[1] == '.') {
+		parser->p += 2;
+
+		return
+			!descendant &&
+			__ndm_xml_query_add_step(
+				parser, NDM_XML_QUERY_AXIS_PARENT) != NULL;
+	}
+
+	if (parser->p[0] == '.') {
+		++parser->p;
+
+		return
+			!descendant &&
+			__ndm_xml_query_add_step(
+				parser, NDM_XML_QUERY_AXIS_SELF) != NULL;
+	}
+
+	if (parser->p[0] == '@') {
+		++parser->p;
+
+		/* "//@name" selects attributes of a context and its descendants */
+		if ((descendant && __ndm_xml_query_add_step(parser,
+				NDM_XML_QUERY_AXIS_DESCENDANT_OR_SELF) == NULL) ||
+			(step = __ndm_xml_query_add_step(
+				parser, NDM_XML_QUERY_AXIS_ATTR)) == NULL)
+		{
+			return false;
+		}
+	} else
+	if ((step = __ndm_xml_query_add_step(parser, descendant ?
+			NDM_XML_QUERY_AXIS_DESCENDANT :
+			NDM_XML_QUERY_AXIS_CHILD)) == NULL)
+	{
+		return false;
+	}
+
+	if (*parser->p == '*') {
+		++parser->p;
+	} else
+	if ((step->name = __ndm_xml_query_parse_name(parser)) == NULL) {
+		return false;
+	}
+
+	while (*parser->p == '[') {
+		if (step->axis == NDM_XML_QUERY_AXIS_ATTR ||
+			!__ndm_xml_query_parse_predicate(parser, step))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool __ndm_xml_query_parse(
+		struct ndm_xml_query_parser_t_ *parser)
+{
+	struct ndm_xml_query_t *query = parser->query;
+	bool descendant = false;
+
+	if (*parser->p == '/') {
+		query->is_absolute = true;
+		++parser->p;
+
+		if (*parser->p == '\0') {
+			/* "/" selects a document root */
+			return true;
+		}
+
+		if (*parser->p == '/') {
+			descendant = true;
+			++parser->p;
+		}
+	}
+
+	for (;;) {
+		if (!__ndm_xml_query_parse_step(parser, descendant)) {
+			return false;
+		}
+
+		if (*parser->p == '\0') {
+			break;
+		}
+
+		/* an attribute step is the last one */
+		if (*parser->p != '/' ||
+			query->steps[query->step_count - 1].axis ==
+				NDM_XML_QUERY_AXIS_ATTR)
+		{
+			return false;
+		}
+
+		++parser->p;
+		descendant = (*parser->p == '/');
+
+		if (descendant) {
+			++parser->p;
+		}
+	}
+
+	return true;
+}
+
+struct ndm_xml_query_t *ndm_xml_query_alloc(
+		const char *const expr)
+{
+	const size_t size = strlen(expr);
+	struct ndm_xml_query_parser_t_ parser;
+	struct ndm_xml_query_t *query;
+
+	/* every copied name and literal is shorter than its source,
+	 * but gets a null-terminator */
+	if ((query = malloc(sizeof(*query) + 3*size + 2)) == NULL) {
+		errno = ENOMEM;
+
+		return NULL;
+	}
+
+	query->is_absolute = false;
+	query->step_count = 0;
+	query->predicate_count = 0;
+	query->strings_end = query->strings;
+	query->expr = query->strings_end;
+	memcpy(query->strings_end, expr, size + 1);
+	query->strings_end += size + 1;
+
+	parser.query = query;
+	parser.p = expr;
+	parser.error = EINVAL;
+
+	if (!__ndm_xml_query_parse(&parser)) {
+		free(query);
+		errno = parser.error;
+
+		return NULL;
+	}
+
+	query->node_step_count = query->step_count;
+
+	if (query->step_count > 0 &&
+		query->steps[query->step_count - 1].axis == NDM_XML_QUERY_AXIS_ATTR)
+	{
+		--query->node_step_count;
+	}
+
+	return query;
+}
+
+void ndm_xml_query_free(
+		struct ndm_xml_query_t **query)
+{
+	if (query != NULL) {
+		free(*query);
+		*query = NULL;
+	}
+}
+
+const char *ndm_xml_query_expr(
+		const struct ndm_xml_query_t *query)
+{
+	return query->expr;
+}
+
+bool ndm_xml_query_selects_attr(
+		const struct ndm_xml_query_t *query)
+{
+	return query->node_step_count < query->step_count;
+}
+
+/**
+ * Query evaluation functions.
+ **/
+
+/**
+ * Short decimal values are parsed inline, other ones are passed
+ * to a generic parser with range checks.
+ **/
+
+static bool __ndm_xml_query_parse_number(
+		const char *const value,
+		long long *number)
+{
+	const char *p = (*value == '-') ? value + 1 : value;
+	long long n = 0;
+	size_t digits = 0;
+
+	while (*p >= '0' && *p <= '9' && digits < 18) {
+		n = n*10 + (*p++ - '0');
+		++digits;
+	}
+
+	if (*p != '\0' || digits == 0) {
+		return (digits == 18) && ndm_int_parse_llong(value, number);
+	}
+
+	*number = (*value == '-') ? -n : n;
+
+	return true;
+}
+
+static bool __ndm_xml_query_compare(
+		const struct ndm_xml_query_predicate_t *predicate,
+		const char *const value)
+{
+	long long number = 0;
+
+	if (predicate->is_numeric &&
+		!__ndm_xml_query_parse_number(value, &number))
+	{
+		/* a non-numeric value is not comparable with a number */
+		return false;
+	}
+
+	switch (predicate->op) {
+		case NDM_XML_QUERY_OP_EQ:
+			return predicate->is_numeric ?
+				number == predicate->number :
+				strcmp(value, predicate->value) == 0;
+
+		case NDM_XML_QUERY_OP_NE:
+			return predicate->is_numeric ?
+				number != predicate->number :
+				strcmp(value, predicate->value) != 0;
+
+		case NDM_XML_QUERY_OP_LT:
+			return number < predicate->number;
+
+		case NDM_XML_QUERY_OP_LE:
+			return number <= predicate->number;
+
+		case NDM_XML_QUERY_OP_GT:
+			return number > predicate->number;
+
+		case NDM_XML_QUERY_OP_GE:
+			return number >= predicate->number;
+
+		case NDM_XML_QUERY_OP_POSITION:
+		case NDM_XML_QUERY_OP_EXISTS:
+			break;
+	}
+
+	return true;
+}
+
+static bool __ndm_xml_query_value_matches(
+		const struct ndm_xml_query_predicate_t *predicate,
+		const struct ndm_xml_node_t *node)
+{
+	switch (predicate->operand) {
+		case NDM_XML_QUERY_OPERAND_ATTR:
+		{
+			const struct ndm_xml_attr_t *attr =
+				ndm_xml_node_first_attr(node, predicate->name);
+
+			return
+				attr != NULL &&
+				__ndm_xml_query_compare(predicate, ndm_xml_attr_value(attr));
+		}
+
+		case NDM_XML_QUERY_OPERAND_CHILD:
+		{
+			/* any child with a matching value */
+			const struct ndm_xml_node_t *child =
+				ndm_xml_node_first_child(node, predicate->name);
+
+			while (child != NULL) {
+				if (ndm_xml_node_type(child) == NDM_XML_NODE_TYPE_ELEMENT &&
+					__ndm_xml_query_compare(
+						predicate, ndm_xml_node_value(child)))
+				{
+					return true;
+				}
+
+				child = ndm_xml_node_next_sibling(child, predicate->name);
+			}
+
+			return false;
+		}
+
+		case NDM_XML_QUERY_OPERAND_SELF:
+			return __ndm_xml_query_compare(
+				predicate, ndm_xml_node_value(node));
+	}
+
+	return false;
+}
+
+static inline bool __ndm_xml_query_name_matches(
+		const struct ndm_xml_query_step_t *step,
+		const struct ndm_xml_node_t *node)
+{
+	return
+		ndm_xml_node_type(node) == NDM_XML_NODE_TYPE_ELEMENT &&
+		(step->name == NULL ||
+		 strcmp(ndm_xml_node_name(node), step->name) == 0);
+}
+
+static bool __ndm_xml_query_values_match(
+		const struct ndm_xml_query_t *query,
+		const struct ndm_xml_query_step_t *step,
+		const size_t predicate_count,
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_query_predicate_t *predicate =
+		&query->predicates[step->predicate_first];
+
+	for (size_t i = 0; i < predicate_count; i++, predicate++) {
+		if (predicate->op != NDM_XML_QUERY_OP_POSITION &&
+			!__ndm_xml_query_value_matches(predicate, node))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * A position of a descendant step node is counted among preceding
+ * siblings that pass a name test and predicates before a position
+ * one, since descendants of siblings are walked in between.
+ **/
+
+static size_t __ndm_xml_query_sibling_position(
+		const struct ndm_xml_query_t *query,
+		const struct ndm_xml_query_step_t *step,
+		const size_t predicate_count,
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_node_t *sibling = node;
+	size_t position = 1;
+
+	if (ndm_xml_node_parent(node) == NULL) {
+		return position;
+	}
+
+	while ((sibling = ndm_xml_node_prev_sibling(sibling, step->name)) != NULL) {
+		if (__ndm_xml_query_name_matches(step, sibling) &&
+			__ndm_xml_query_values_match(
+				query, step, predicate_count, sibling))
+		{
+			++position;
+		}
+	}
+
+	return position;
+}
+
+/**
+ * Checks all predicates of a step without an iterator state.
+ **/
+
+static bool __ndm_xml_query_predicates_match(
+		const struct ndm_xml_query_t *query,
+		const struct ndm_xml_query_step_t *step,
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_query_predicate_t *predicate =
+		&query->predicates[step->predicate_first];
+
+	for (size_t i = 0; i < step->predicate_count; i++, predicate++) {
+		if (predicate->op == NDM_XML_QUERY_OP_POSITION) {
+			if (__ndm_xml_query_sibling_position(query, step, i, node) !=
+					predicate->position)
+			{
+				return false;
+			}
+		} else
+		if (!__ndm_xml_query_value_matches(predicate, node)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool __ndm_xml_query_node_matches(
+		struct ndm_xml_query_iter_t *iter,
+		const size_t index,
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_query_t *query = iter->__query;
+	const struct ndm_xml_query_step_t *step = &query->steps[index];
+	const struct ndm_xml_query_predicate_t *predicate =
+		&query->predicates[step->predicate_first];
+
+	if (step->axis != NDM_XML_QUERY_AXIS_CHILD) {
+		return __ndm_xml_query_predicates_match(query, step, node);
+	}
+
+	/* child positions are counted while siblings are scanned */
+	for (size_t i = 0; i < step->predicate_count; i++, predicate++) {
+		if (predicate->op == NDM_XML_QUERY_OP_POSITION) {
+			if (++iter->__positions[index] != predicate->position) {
+				return false;
+			}
+		} else
+		if (!__ndm_xml_query_value_matches(predicate, node)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Checks whether the first @a count node steps may bind @a node
+ * as the last one, a start node is bound by no steps at all.
+ **/
+
+static bool __ndm_xml_query_binds(
+		const struct ndm_xml_query_iter_t *iter,
+		const size_t count,
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_query_t *query = iter->__query;
+	const struct ndm_xml_query_step_t *step;
+	const struct ndm_xml_node_t *context = node;
+
+	if (count == 0) {
+		return node == iter->__start;
+	}
+
+	step = &query->steps[count - 1];
+
+	switch (step->axis) {
+		case NDM_XML_QUERY_AXIS_CHILD:
+		case NDM_XML_QUERY_AXIS_DESCENDANT:
+			if (!__ndm_xml_query_name_matches(step, node) ||
+				!__ndm_xml_query_predicates_match(query, step, node))
+			{
+				return false;
+			}
+
+			context = ndm_xml_node_parent(node);
+
+			if (step->axis == NDM_XML_QUERY_AXIS_CHILD) {
+				return
+					context != NULL &&
+					__ndm_xml_query_binds(iter, count - 1, context);
+			}
+
+			break;
+
+		case NDM_XML_QUERY_AXIS_DESCENDANT_OR_SELF:
+			/* only a context itself may be of any type */
+			if (ndm_xml_node_type(node) != NDM_XML_NODE_TYPE_ELEMENT) {
+				return __ndm_xml_query_binds(iter, count - 1, node);
+			}
+
+			break;
+
+		case NDM_XML_QUERY_AXIS_SELF:
+			return
+				__ndm_xml_query_predicates_match(query, step, node) &&
+				__ndm_xml_query_binds(iter, count - 1, node);
+
+		case NDM_XML_QUERY_AXIS_PARENT:
+		{
+			const struct ndm_xml_node_t *child =
+				ndm_xml_node_first_child(node, NULL);
+
+			if (!__ndm_xml_query_predicates_match(query, step, node)) {
+				return false;
+			}
+
+			while (child != NULL) {
+				if (__ndm_xml_query_binds(iter, count - 1, child)) {
+					return true;
+				}
+
+				child = ndm_xml_node_next_sibling(child, NULL);
+			}
+
+			return false;
+		}
+
+		case NDM_XML_QUERY_AXIS_ATTR:
+			return false;
+	}
+
+	while (context != NULL) {
+		if (__ndm_xml_query_binds(iter, count - 1, context)) {
+			return true;
+		}
+
+		context = ndm_xml_node_parent(context);
+	}
+
+	return false;
+}
+
+/**
+ * A descendant step selects the same nodes under a context and under
+ * any of its ancestors, so nodes are selected under an outermost
+ * context only: a context is skipped if any of its ancestors may be
+ * bound by a previous step too.
+ **/
+
+static bool __ndm_xml_query_context_is_nested(
+		const struct ndm_xml_query_iter_t *iter,
+		const size_t index,
+		const struct ndm_xml_node_t *context)
+{
+	const struct ndm_xml_node_t *ancestor = ndm_xml_node_parent(context);
+
+	if (!iter->__query->steps[index].is_nested) {
+		return false;
+	}
+
+	while (ancestor != NULL) {
+		if (__ndm_xml_query_binds(iter, index, ancestor)) {
+			return true;
+		}
+
+		ancestor = ndm_xml_node_parent(ancestor);
+	}
+
+	return false;
+}
+
+/**
+ * A pre-order successor of @a node within a @a root subtree.
+ **/
+
+static struct ndm_xml_node_t *__ndm_xml_query_skip(
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t *root)
+{
+	while (node != root) {
+		struct ndm_xml_node_t *next = ndm_xml_node_next_sibling(node, NULL);
+
+		if (next != NULL) {
+			return next;
+		}
+
+		node = ndm_xml_node_parent(node);
+	}
+
+	return NULL;
+}
+
+static struct ndm_xml_node_t *__ndm_xml_query_successor(
+		const struct ndm_xml_node_t *node,
+		const struct ndm_xml_node_t *root)
+{
+	struct ndm_xml_node_t *child = ndm_xml_node_first_child(node, NULL);
+
+	return (child != NULL) ? child : __ndm_xml_query_skip(node, root);
+}
+
+static struct ndm_xml_node_t *__ndm_xml_query_scan_children(
+		struct ndm_xml_query_iter_t *iter,
+		const size_t index,
+		struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_query_step_t *step = &iter->__query->steps[index];
+
+	while (node != NULL) {
+		if (step->position != 0 &&
+			iter->__positions[index] >= step->position)
+		{
+			/* no more siblings may have a requested position */
+			return NULL;
+		}
+
+		/* siblings are already filtered by a name */
+		if (ndm_xml_node_type(node) == NDM_XML_NODE_TYPE_ELEMENT &&
+			__ndm_xml_query_node_matches(iter, index, node))
+		{
+			return node;
+		}
+
+		node = ndm_xml_node_next_sibling(node, step->name);
+	}
+
+	return NULL;
+}
+
+static struct ndm_xml_node_t *__ndm_xml_query_scan_descendants(
+		struct ndm_xml_query_iter_t *iter,
+		const size_t index,
+		const struct ndm_xml_node_t *context,
+		struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_query_step_t *step = &iter->__query->steps[index];
+
+	while (node != NULL &&
+		!(__ndm_xml_query_name_matches(step, node) &&
+		  __ndm_xml_query_node_matches(iter, index, node)))
+	{
+		node = __ndm_xml_query_successor(node, context);
+	}
+
+	return node;
+}
+
+static struct ndm_xml_node_t *__ndm_xml_query_step_first(
+		struct ndm_xml_query_iter_t *iter,
+		const size_t index,
+		const struct ndm_xml_node_t *context)
+{
+	const struct ndm_xml_query_step_t *step = &iter->__query->steps[index];
+	struct ndm_xml_node_t *node = NULL;
+
+	iter->__positions[index] = 0;
+
+	switch (step->axis) {
+		case NDM_XML_QUERY_AXIS_CHILD:
+			return __ndm_xml_query_scan_children(iter, index,
+				ndm_xml_node_first_child(context, step->name));
+
+		case NDM_XML_QUERY_AXIS_DESCENDANT:
+			return __ndm_xml_query_context_is_nested(iter, index, context) ?
+				NULL :
+				__ndm_xml_query_scan_descendants(iter, index, context,
+					__ndm_xml_query_successor(context, context));
+
+		case NDM_XML_QUERY_AXIS_DESCENDANT_OR_SELF:
+			/* a context itself is selected regardless of its type */
+			return __ndm_xml_query_context_is_nested(iter, index, context) ?
+				NULL : (struct ndm_xml_node_t *) (uintptr_t) context;
+
+		case NDM_XML_QUERY_AXIS_SELF:
+			node = (struct ndm_xml_node_t *) (uintptr_t) context;
+			break;
+
+		case NDM_XML_QUERY_AXIS_PARENT:
+			node = ndm_xml_node_parent(context);
+			break;
+
+		case NDM_XML_QUERY_AXIS_ATTR:
+			break;
+	}
+
+	return
+		(node != NULL && __ndm_xml_query_node_matches(iter, index, node)) ?
+		node : NULL;
+}
+
+static struct ndm_xml_node_t *__ndm_xml_query_step_next(
+		struct ndm_xml_query_iter_t *iter,
+		const size_t index,
+		const struct ndm_xml_node_t *context,
+		const struct ndm_xml_node_t *node)
+{
+	const struct ndm_xml_query_t *query = iter->__query;
+	const struct ndm_xml_query_step_t *step = &query->steps[index];
+
+	switch (step->axis) {
+		case NDM_XML_QUERY_AXIS_CHILD:
+			return __ndm_xml_query_scan_children(iter, index,
+				ndm_xml_node_next_sibling(node, step->name));
+
+		case NDM_XML_QUERY_AXIS_DESCENDANT:
+			/**
+			 * When a next step is a descendant one too, nodes
+			 * below a current one would repeat its results.
+			 **/
+
+			return __ndm_xml_query_scan_descendants(iter, index, context,
+				(index + 1 < query->node_step_count &&
+				 __ndm_xml_query_axis_is_descendant(
+					query->steps[index + 1].axis)) ?
+				__ndm_xml_query_skip(node, context) :
+				__ndm_xml_query_successor(node, context));
+
+		case NDM_XML_QUERY_AXIS_DESCENDANT_OR_SELF:
+		{
+			struct ndm_xml_node_t *next =
+				__ndm_xml_query_successor(node, context);
+
+			while (next != NULL &&
+				ndm_xml_node_type(next) != NDM_XML_NODE_TYPE_ELEMENT)
+			{
+				next = __ndm_xml_query_successor(next, context);
+			}
+
+			return next;
+		}
+
+		case NDM_XML_QUERY_AXIS_SELF:
+		case NDM_XML_QUERY_AXIS_PARENT:
+		case NDM_XML_QUERY_AXIS_ATTR:
+			break;
+	}
+
+	return NULL;
+}
+
+static inline const struct ndm_xml_node_t *__ndm_xml_query_context(
+		const struct ndm_xml_query_iter_t *iter,
+		const size_t index)
+{
+	return (index == 0) ? iter->__start : iter->__nodes[index - 1];
+}
+
+/**
+ * Binds all node steps to a next combination of nodes
+ * with a depth-first backtracking, no memory is allocated.
+ **/
+
+static bool __ndm_xml_query_next_nodes(
+		struct ndm_xml_query_iter_t *iter)
+{
+	const size_t count = iter->__query->node_step_count;
+	struct ndm_xml_node_t *node;
+	size_t i;
+
+	if (iter->__finished) {
+		return false;
+	}
+
+	if (!iter->__started) {
+		iter->__started = true;
+
+		if (count == 0) {
+			return true;
+		}
+
+		i = 0;
+		node = __ndm_xml_query_step_first(iter, i, iter->__start);
+	} else {
+		if (count == 0) {
+			iter->__finished = true;
+
+			return false;
+		}
+
+		i = count - 1;
+		node = __ndm_xml_query_step_next(
+			iter, i, __ndm_xml_query_context(iter, i), iter->__nodes[i]);
+	}
+
+	for (;;) {
+		if (node == NULL) {
+			if (i == 0) {
+				iter->__finished = true;
+
+				return false;
+			}
+
+			--i;
+			node = __ndm_xml_query_step_next(
+				iter, i, __ndm_xml_query_context(iter, i), iter->__nodes[i]);
+		} else {
+			iter->__nodes[i] = node;
+
+			if (++i == count) {
+				return true;
+			}
+
+			node = __ndm_xml_query_step_first(iter, i, node);
+		}
+	}
+}
+
+static inline const char *__ndm_xml_query_attr_name(
+		const struct ndm_xml_query_t *query)
+{
+	return query->steps[query->node_step_count].name;
+}
+
+void ndm_xml_query_iter_init(
+		struct ndm_xml_query_iter_t *iter,
+		const struct ndm_xml_query_t *query,
+		const struct ndm_xml_node_t *context)
+{
+	assert (context != NULL);
+
+	iter->__query = query;
+	iter->__start = query->is_absolute ?
+		ndm_xml_document_root(ndm_xml_node_document(context)) :
+		(struct ndm_xml_node_t *) (uintptr_t) context;
+	iter->__attr = NULL;
+	iter->__started = false;
+	iter->__finished = (iter->__start == NULL);
+}
+
+bool ndm_xml_query_iter_next(
+		struct ndm_xml_query_iter_t *iter)
+{
+	const struct ndm_xml_query_t *query = iter->__query;
+
+	if (!ndm_xml_query_selects_attr(query)) {
+		return __ndm_xml_query_next_nodes(iter);
+	}
+
+	if (iter->__attr != NULL &&
+		(iter->__attr = ndm_xml_attr_next(
+			iter->__attr, __ndm_xml_query_attr_name(query))) != NULL)
+	{
+		return true;
+	}
+
+	while (__ndm_xml_query_next_nodes(iter)) {
+		if ((iter->__attr = ndm_xml_node_first_attr(
+				ndm_xml_query_iter_node(iter),
+				__ndm_xml_query_attr_name(query))) != NULL)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+struct ndm_xml_node_t *ndm_xml_query_iter_node(
+		const struct ndm_xml_query_iter_t *iter)
+{
+	const size_t count = iter->__query->node_step_count;
+
+	return (count == 0) ? iter->__start : iter->__nodes[count - 1];
+}
+
+struct ndm_xml_attr_t *ndm_xml_query_iter_attr(
+		const struct ndm_xml_query_iter_t *iter)
+{
+	return iter->__attr;
+}
+
+struct ndm_xml_node_t *ndm_xml_query_first(
+		const struct ndm_xml_query_t *query,
+		const struct ndm_xml_node_t *context)
+{
+	struct ndm_xml_query_iter_t iter;
+
+	ndm_xml_query_iter_init(&iter, query, context);
+
+	return ndm_xml_query_iter_next(&iter) ?
+		ndm_xml_query_iter_node(&iter) : NULL;
+}
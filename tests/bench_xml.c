@@ -0,0 +1,546 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ndm/xml.h>
+#include <ndm/xml_query.h>
+#include <ndm/xml_diff.h>
+#include <ndm/time.h>
+#include <ndm/macro.h>
+
+#define BENCH_MIN_MSEC				500
+#define BENCH_DYNAMIC_BUFFER_SIZE	65536
+#define BENCH_STREAM_CHUNK_SIZE		4096
+
+struct bench_text_t
+{
+	char *data;
+	size_t size;
+	size_t capacity;
+};
+
+static void bench_text_append(
+		struct bench_text_t *text,
+		const char *const s)
+{
+	const size_t size = strlen(s);
+
+	if (text->capacity - text->size <= size) {
+		while (text->capacity - text->size <= size) {
+			text->capacity = (text->capacity == 0) ? 4096 : text->capacity*2;
+		}
+
+		if ((text->data = realloc(text->data, text->capacity)) == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	memcpy(text->data + text->size, s, size + 1);
+	text->size += size;
+}
+
+static bool bench_text_load(
+		struct bench_text_t *text,
+		const char *const path)
+{
+	char buffer[4096];
+	FILE *fp = fopen(path, "r");
+	size_t size = 0;
+
+	if (fp == NULL) {
+		return false;
+	}
+
+	while ((size = fread(buffer, 1, sizeof(buffer) - 1, fp)) > 0) {
+		buffer[size] = '\0';
+		bench_text_append(text, buffer);
+	}
+
+	fclose(fp);
+
+	return text->size > 0;
+}
+
+/* a configuration-like document: many small elements with attributes */
+static void bench_text_config(
+		struct bench_text_t *text,
+		const size_t count)
+{
+	char buffer[512];
+
+	bench_text_append(text, "<?xml version=\"1.0\"?>\n<config>\n");
+
+	for (size_t i = 0; i < count; i++) {
+		snprintf(buffer, sizeof(buffer),
+			"\t<interface name=\"GigabitEthernet0/%zu\" index=\"%zu\">\n"
+			"\t\t<description>Port %zu &amp; uplink</description>\n"
+			"\t\t<mtu>1500</mtu>\n"
+			"\t\t<ip address=\"10.%zu.%zu.1\" mask=\"255.255.255.0\"/>\n"
+			"\t\t<up/>\n"
+			"\t</interface>\n",
+			i, i, i, (i >> 8) & 0xff, i & 0xff);
+		bench_text_append(text, buffer);
+	}
+
+	bench_text_append(text, "</config>\n");
+}
+
+/* a text-heavy document: long element values and attribute values */
+static void bench_text_log(
+		struct bench_text_t *text,
+		const size_t count)
+{
+	char buffer[1024];
+
+	bench_text_append(text, "<log>\n");
+
+	for (size_t i = 0; i < count; i++) {
+		snprintf(buffer, sizeof(buffer),
+			"<message source=\"Network::Interface::Ethernet::Port\" "
+			"time=\"2024-01-01T00:00:%02zu\" ident=\"ndm\">"
+			"Interface GigabitEthernet0/%zu changed its link state: the "
+			"carrier signal is detected after a negotiation of a speed "
+			"and a duplex mode with a link partner, new state is up"
+			"</message>\n",
+			i % 60, i);
+		bench_text_append(text, buffer);
+	}
+
+	bench_text_append(text, "</log>\n");
+}
+
+static void bench_run(
+		const char *const name,
+		const struct bench_text_t *text,
+		const bool stream)
+{
+	char *copy = malloc(text->size + 1);
+	struct ndm_xml_document_t doc;
+	struct timespec start;
+	struct timespec now;
+	int64_t msec = 0;
+	size_t count = 0;
+
+	if (copy == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	ndm_xml_document_init(&doc, NULL, 0, BENCH_DYNAMIC_BUFFER_SIZE);
+	ndm_time_get_monotonic(&start);
+
+	do {
+		enum ndm_xml_document_parse_error_t e;
+
+		if (stream) {
+			struct ndm_xml_document_parser_t parser;
+			size_t offset = 0;
+
+			ndm_xml_document_parser_init(&parser, &doc,
+				NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT);
+
+			do {
+				const size_t size =
+					(text->size - offset < BENCH_STREAM_CHUNK_SIZE) ?
+					text->size - offset : BENCH_STREAM_CHUNK_SIZE;
+
+				e = ndm_xml_document_parser_feed(&parser,
+					text->data + offset, size);
+				offset += size;
+			} while (e == NDM_XML_DOCUMENT_PARSE_ERROR_OK &&
+				offset < text->size);
+
+			if (e == NDM_XML_DOCUMENT_PARSE_ERROR_OK) {
+				e = ndm_xml_document_parser_finish(&parser);
+			} else {
+				ndm_xml_document_parser_clear(&parser);
+			}
+		} else {
+			/* a document is parsed in situ */
+			memcpy(copy, text->data, text->size + 1);
+			e = ndm_xml_document_parse(&doc, copy,
+				NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT);
+		}
+
+		if (e != NDM_XML_DOCUMENT_PARSE_ERROR_OK) {
+			fprintf(stderr, "%s: parse error %i\n", name, (int) e);
+			exit(EXIT_FAILURE);
+		}
+
+		ndm_xml_document_clear(&doc);
+		++count;
+
+		ndm_time_get_monotonic(&now);
+		ndm_time_sub(&now, &start);
+		msec = ndm_time_to_msec(&now);
+	} while (msec < BENCH_MIN_MSEC);
+
+	printf("%-24s %-8s %10zu bytes %8zu runs %10.1f MB/s\n",
+		name, stream ? "stream" : "in situ", text->size, count,
+		(double) (text->size * count) / 1048576.0 /
+		((double) msec / 1000.0));
+
+	free(copy);
+}
+
+static size_t bench_lookup_pass(
+		const struct ndm_xml_node_t *config,
+		const bool atoms)
+{
+	const struct ndm_xml_document_t *doc = ndm_xml_node_document(config);
+	const ndm_xml_atom_t interface = ndm_xml_document_atom(doc, "interface");
+	const ndm_xml_atom_t mtu = ndm_xml_document_atom(doc, "mtu");
+	const struct ndm_xml_node_t *n = atoms ?
+		ndm_xml_node_first_child_atom(config, interface) :
+		ndm_xml_node_first_child(config, "interface");
+	size_t count = 0;
+
+	while (n != NULL) {
+		if ((atoms ?
+				ndm_xml_node_first_child_atom(n, mtu) :
+				ndm_xml_node_first_child(n, "mtu")) != NULL)
+		{
+			++count;
+		}
+
+		n = atoms ?
+			ndm_xml_node_next_sibling_atom(n, interface) :
+			ndm_xml_node_next_sibling(n, "interface");
+	}
+
+	return count;
+}
+
+static void bench_lookup(
+		const char *const name,
+		const struct bench_text_t *text,
+		const bool intern,
+		const bool atoms,
+		const bool compact)
+{
+	char *copy = malloc(text->size + 1);
+	struct ndm_xml_document_t doc;
+	struct ndm_xml_document_t compact_doc;
+	const struct ndm_xml_node_t *config;
+	struct timespec start;
+	struct timespec now;
+	int64_t msec = 0;
+	size_t count = 0;
+	size_t found = 0;
+
+	if (copy == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	memcpy(copy, text->data, text->size + 1);
+	ndm_xml_document_init(&doc, NULL, 0, BENCH_DYNAMIC_BUFFER_SIZE);
+	ndm_xml_document_init(&compact_doc, NULL, 0, BENCH_DYNAMIC_BUFFER_SIZE);
+
+	if ((intern && !ndm_xml_document_intern_names(&doc)) ||
+		ndm_xml_document_parse(&doc, copy,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) !=
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK ||
+		(compact && !ndm_xml_document_compact(&compact_doc, &doc)) ||
+		(config = ndm_xml_node_first_child(
+			ndm_xml_document_root(compact ? &compact_doc : &doc),
+			"config")) == NULL)
+	{
+		fprintf(stderr, "%s: failed to parse\n", name);
+		exit(EXIT_FAILURE);
+	}
+
+	ndm_time_get_monotonic(&start);
+
+	do {
+		found += bench_lookup_pass(config, atoms);
+		++count;
+
+		ndm_time_get_monotonic(&now);
+		ndm_time_sub(&now, &start);
+		msec = ndm_time_to_msec(&now);
+	} while (msec < BENCH_MIN_MSEC);
+
+	printf("%-24s %-8s %10zu found %8zu runs %10.1f ns/node %10zu bytes\n",
+		name, compact ?
+			(atoms ? "c/atoms" : "c/string") :
+			(atoms ? "atoms" : (intern ? "interned" : "strings")),
+		found/count, count,
+		(double) msec*1e6 / (double) found,
+		ndm_xml_document_size(compact ? &compact_doc : &doc));
+
+	ndm_xml_document_clear(&compact_doc);
+	ndm_xml_document_clear(&doc);
+	free(copy);
+}
+
+static size_t bench_query_pass(
+		const struct ndm_xml_node_t *config,
+		const struct ndm_xml_query_t *query)
+{
+	struct ndm_xml_query_iter_t iter;
+	size_t count = 0;
+
+	ndm_xml_query_iter_init(&iter, query, config);
+
+	while (ndm_xml_query_iter_next(&iter)) {
+		++count;
+	}
+
+	return count;
+}
+
+static void bench_query(
+		const char *const name,
+		const struct bench_text_t *text,
+		const char *const expr)
+{
+	char *copy = malloc(text->size + 1);
+	struct ndm_xml_document_t doc;
+	struct ndm_xml_query_t *query = NULL;
+	const struct ndm_xml_node_t *config;
+	struct timespec start;
+	struct timespec now;
+	int64_t msec = 0;
+	size_t count = 0;
+	size_t found = 0;
+
+	if (copy == NULL || (query = ndm_xml_query_alloc(expr)) == NULL) {
+		fprintf(stderr, "%s: failed to compile a query\n", name);
+		exit(EXIT_FAILURE);
+	}
+
+	memcpy(copy, text->data, text->size + 1);
+	ndm_xml_document_init(&doc, NULL, 0, BENCH_DYNAMIC_BUFFER_SIZE);
+
+	if (ndm_xml_document_parse(&doc, copy,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) !=
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK ||
+		(config = ndm_xml_node_first_child(
+			ndm_xml_document_root(&doc), "config")) == NULL)
+	{
+		fprintf(stderr, "%s: failed to parse\n", name);
+		exit(EXIT_FAILURE);
+	}
+
+	ndm_time_get_monotonic(&start);
+
+	do {
+		found += bench_query_pass(config, query);
+		++count;
+
+		ndm_time_get_monotonic(&now);
+		ndm_time_sub(&now, &start);
+		msec = ndm_time_to_msec(&now);
+	} while (msec < BENCH_MIN_MSEC);
+
+	printf("%-24s %-8s %10zu found %8zu runs %10.1f us/pass  %s\n",
+		name, "query", found/count, count,
+		(double) msec*1e3 / (double) count, expr);
+
+	ndm_xml_query_free(&query);
+	ndm_xml_document_clear(&doc);
+	free(copy);
+}
+
+static bool bench_diff_cb(
+		void *user_data,
+		const struct ndm_xml_diff_t *diff)
+{
+	size_t *found = user_data;
+
+	(void) diff;
+	++(*found);
+
+	return true;
+}
+
+/* two snapshots of a configuration with one changed value */
+static void bench_diff(
+		const char *const name,
+		const struct bench_text_t *text,
+		const bool diff)
+{
+	char *old_copy = malloc(text->size + 1);
+	char *new_copy = malloc(text->size + 1);
+	char *mtu = NULL;
+	struct ndm_xml_document_t old_doc;
+	struct ndm_xml_document_t new_doc;
+	struct timespec start;
+	struct timespec now;
+	int64_t msec = 0;
+	size_t count = 0;
+	size_t found = 0;
+
+	if (old_copy == NULL || new_copy == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	memcpy(old_copy, text->data, text->size + 1);
+	memcpy(new_copy, text->data, text->size + 1);
+
+	if ((mtu = strstr(new_copy + text->size/2, "<mtu>1500")) != NULL) {
+		memcpy(mtu, "<mtu>9000", 9);
+	}
+
+	ndm_xml_document_init(&old_doc, NULL, 0, BENCH_DYNAMIC_BUFFER_SIZE);
+	ndm_xml_document_init(&new_doc, NULL, 0, BENCH_DYNAMIC_BUFFER_SIZE);
+
+	if (ndm_xml_document_parse(&old_doc, old_copy,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) !=
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK ||
+		ndm_xml_document_parse(&new_doc, new_copy,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) !=
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK)
+	{
+		fprintf(stderr, "%s: failed to parse\n", name);
+		exit(EXIT_FAILURE);
+	}
+
+	ndm_time_get_monotonic(&start);
+
+	do {
+		if (diff) {
+			if (!ndm_xml_document_diff(
+					&old_doc, &new_doc, bench_diff_cb, &found))
+			{
+				fprintf(stderr, "%s: failed to diff\n", name);
+				exit(EXIT_FAILURE);
+			}
+		} else
+		if (!ndm_xml_document_is_equal(&old_doc, &new_doc)) {
+			++found;
+		}
+
+		++count;
+
+		ndm_time_get_monotonic(&now);
+		ndm_time_sub(&now, &start);
+		msec = ndm_time_to_msec(&now);
+	} while (msec < BENCH_MIN_MSEC);
+
+	printf("%-24s %-8s %10zu found %8zu runs %10.1f us/pass\n",
+		name, diff ? "diff" : "is_equal", found/count, count,
+		(double) msec*1e3 / (double) count);
+
+	ndm_xml_document_clear(&new_doc);
+	ndm_xml_document_clear(&old_doc);
+	free(new_copy);
+	free(old_copy);
+}
+
+/* a wide response: one element per route, looked up by names and positions */
+static void bench_wide(
+		const size_t count)
+{
+	struct ndm_xml_document_t doc;
+	struct ndm_xml_node_t *response;
+	struct timespec start;
+	struct timespec now;
+	int64_t msec = 0;
+	size_t lookups = 0;
+	size_t found = 0;
+	char name[32];
+
+	ndm_xml_document_init(&doc, NULL, 0, BENCH_DYNAMIC_BUFFER_SIZE);
+
+	if (ndm_xml_document_alloc_root(&doc) == NULL ||
+		(response = ndm_xml_node_append_child_str(
+			ndm_xml_document_root(&doc), "response", NULL)) == NULL)
+	{
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		snprintf(name, sizeof(name), "route%zu", i);
+
+		if (ndm_xml_node_append_child_str(response, name, NULL) == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	ndm_time_get_monotonic(&start);
+
+	do {
+		for (size_t i = 0; i < 1000; i++) {
+			const size_t n = (lookups*7919 + i*104729) % count;
+
+			snprintf(name, sizeof(name), "route%zu", n);
+
+			if (ndm_xml_node_first_child(response, name) ==
+					ndm_xml_node_nth_child(response, n))
+			{
+				++found;
+			}
+		}
+
+		lookups += 1000;
+
+		ndm_time_get_monotonic(&now);
+		ndm_time_sub(&now, &start);
+		msec = ndm_time_to_msec(&now);
+	} while (msec < BENCH_MIN_MSEC);
+
+	printf("%-24s %-8s %10zu found %8zu runs %10.1f ns/lookup\n",
+		"generated response", "wide", found, lookups,
+		(double) msec*1e6 / (double) lookups);
+
+	ndm_xml_document_clear(&doc);
+}
+
+int main()
+{
+	struct bench_text_t texts[3];
+	const char *const names[NDM_ARRAY_SIZE(texts)] =
+	{
+		"test.xml",
+		"generated config",
+		"generated log"
+	};
+
+	if (!ndm_time_init()) {
+		fprintf(stderr, "failed to initialize time\n");
+
+		return EXIT_FAILURE;
+	}
+
+	memset(texts, 0, sizeof(texts));
+
+	if (!bench_text_load(&texts[0], "test.xml") &&
+		!bench_text_load(&texts[0], "tests/test.xml"))
+	{
+		fprintf(stderr, "failed to load test.xml\n");
+
+		return EXIT_FAILURE;
+	}
+
+	bench_text_config(&texts[1], 20000);
+	bench_text_log(&texts[2], 20000);
+
+	for (size_t i = 0; i < NDM_ARRAY_SIZE(texts); i++) {
+		bench_run(names[i], &texts[i], false);
+		bench_run(names[i], &texts[i], true);
+	}
+
+	bench_lookup(names[1], &texts[1], false, false, false);
+	bench_lookup(names[1], &texts[1], true, false, false);
+	bench_lookup(names[1], &texts[1], true, true, false);
+	bench_lookup(names[1], &texts[1], false, false, true);
+	bench_lookup(names[1], &texts[1], false, true, true);
+	bench_query(names[1], &texts[1], "interface[mtu=1500]/ip/@address");
+	bench_query(names[1], &texts[1], "//interface[mtu=1500]/ip/@address");
+	bench_query(names[1], &texts[1],
+		"interface[@name='GigabitEthernet0/19999']");
+	bench_diff(names[1], &texts[1], false);
+	bench_diff(names[1], &texts[1], true);
+	bench_wide(20000);
+
+	for (size_t i = 0; i < NDM_ARRAY_SIZE(texts); i++) {
+		free(texts[i].data);
+	}
+
+	return EXIT_SUCCESS;
+}
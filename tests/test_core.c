@@ -1,8 +1,12 @@
+#include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <ndm/xml.h>
+#include <ndm/xml_diff.h>
 #include <ndm/core.h>
 #include <ndm/poll.h>
 #include <ndm/time.h>
@@ -11,6 +15,123 @@
 
 #define CACHE_TTL_MS			1000
 
+struct test_stream_t
+{
+	size_t starts;
+	size_t ends;
+	size_t open;
+	bool balanced;
+};
+
+static void test_stream_node_start(
+		void *user_data,
+		const size_t depth,
+		const char *const name,
+		const char *const value)
+{
+	struct test_stream_t *stream = user_data;
+
+	stream->starts++;
+	stream->open++;
+	stream->balanced = stream->balanced && depth == stream->open;
+}
+
+static void test_stream_node_end(
+		void *user_data,
+		const size_t depth)
+{
+	struct test_stream_t *stream = user_data;
+
+	stream->balanced = stream->balanced && depth == stream->open;
+	stream->ends++;
+	stream->open--;
+}
+
+static bool test_diff_count(
+		void *user_data,
+		const struct ndm_xml_diff_t *diff)
+{
+	size_t *count = user_data;
+
+	(*count)++;
+
+	return true;
+}
+
+static void test_request_hook(
+		void *user_data,
+		const struct ndm_core_request_stats_t *stats)
+{
+	struct ndm_core_request_stats_t *last = user_data;
+
+	*last = *stats;
+}
+
+static void test_cache_entry(
+		void *user_data,
+		const struct ndm_core_response_t *response,
+		const uint64_t hits,
+		const size_t size)
+{
+	uint64_t *total_hits = user_data;
+
+	if (response != NULL && size > 0) {
+		*total_hits += hits;
+	}
+}
+
+/* pthread barriers are optional in POSIX and missing on Darwin */
+struct test_rendezvous_t
+{
+	pthread_mutex_t lock;
+	pthread_cond_t arrived;
+	size_t count;
+};
+
+static void test_rendezvous_wait(
+		struct test_rendezvous_t *rendezvous)
+{
+	pthread_mutex_lock(&rendezvous->lock);
+
+	if (--rendezvous->count == 0) {
+		pthread_cond_broadcast(&rendezvous->arrived);
+	}
+
+	while (rendezvous->count > 0) {
+		pthread_cond_wait(&rendezvous->arrived, &rendezvous->lock);
+	}
+
+	pthread_mutex_unlock(&rendezvous->lock);
+}
+
+struct test_flight_t
+{
+	struct ndm_core_pool_t *pool;
+	struct test_rendezvous_t *rendezvous;
+	struct ndm_core_response_t *response;
+	struct ndm_core_stats_t stats;
+};
+
+static void *test_flight(
+		void *data)
+{
+	struct test_flight_t *flight = data;
+	struct ndm_core_t *core = ndm_core_pool_checkout(flight->pool);
+
+	test_rendezvous_wait(flight->rendezvous);
+
+	if (core != NULL) {
+		ndm_core_set_stats(core, true);
+		flight->response = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show system");
+		ndm_core_get_stats(core, &flight->stats);
+		ndm_core_set_stats(core, false);
+		ndm_core_pool_checkin(flight->pool, core);
+	}
+
+	return NULL;
+}
+
 int main()
 {
 	struct ndm_core_t *core = ndm_core_open("test/ci",
@@ -172,6 +293,598 @@ int main()
 		ndm_core_response_free(&r);
 	} while (0);
 
+	do {
+		/* a binary request is larger than a static request buffer,
+		 * a read-only command with an unknown interface fails */
+		char name[4096];
+
+		memset(name, 'x', sizeof(name) - 1);
+		name[sizeof(name) - 1] = '\0';
+
+		for (size_t i = 0; i < 2; i++) {
+			r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+				NDM_CORE_MODE_NO_CACHE, NULL,
+				"show interface %s", name);
+
+			NDM_TEST_BREAK_IF(r == NULL);
+			NDM_TEST(!ndm_core_response_is_ok(r));
+
+			ndm_core_response_free(&r);
+		}
+	} while (0);
+
+	do {
+		/* distinct cached requests are found through a hash index */
+		for (size_t pass = 0; pass < 2; pass++) {
+			for (size_t i = 0; i < 200; i++) {
+				r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+					NDM_CORE_MODE_CACHE, NULL,
+					"show interface Home%zu", i);
+
+				NDM_TEST_BREAK_IF(r == NULL);
+
+				ndm_core_response_free(&r);
+			}
+		}
+
+		ndm_core_cache_clear(core, false);
+	} while (0);
+
+	do {
+		/* a streamed response is not built as a document */
+		const struct ndm_core_response_handler_t handler =
+		{
+			.node_start = test_stream_node_start,
+			.node_end = test_stream_node_end
+		};
+		struct test_stream_t stream =
+		{
+			.starts = 0,
+			.ends = 0,
+			.open = 0,
+			.balanced = true
+		};
+
+		NDM_TEST(ndm_core_request_stream(core, NDM_CORE_REQUEST_PARSE,
+			&handler, &stream, NULL, "show interface"));
+		NDM_TEST(stream.starts > 0);
+		NDM_TEST(stream.starts == stream.ends);
+		NDM_TEST(stream.balanced);
+	} while (0);
+
+	do {
+		/* pipelined requests are matched by identifiers */
+		ndm_core_response_id_t ids[4];
+		size_t completed = 0;
+
+		for (size_t i = 0; i < NDM_ARRAY_SIZE(ids); i++) {
+			NDM_TEST_BREAK_IF(!ndm_core_request_submit(core,
+				NDM_CORE_REQUEST_PARSE, NDM_CORE_MODE_NO_CACHE,
+				&ids[i], NULL, "show interface"));
+		}
+
+		NDM_TEST(ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_NO_CACHE, NULL, "show version") == NULL);
+		NDM_TEST(errno == EBUSY);
+		NDM_TEST(ndm_core_request_poll(core, &completed));
+
+		for (size_t i = NDM_ARRAY_SIZE(ids); i > 0; i--) {
+			r = ndm_core_request_complete(core, ids[i - 1]);
+
+			NDM_TEST(r != NULL);
+
+			ndm_core_response_free(&r);
+		}
+
+		NDM_TEST(ndm_core_request_complete(core, ids[0]) == NULL);
+		NDM_TEST(errno == ENOENT);
+	} while (0);
+
+	do {
+		/* pooled connections share one cache */
+		struct ndm_core_pool_t *pool = ndm_core_pool_open("test/ci", 2,
+			NDM_CORE_DEFAULT_CACHE_TTL, NDM_CORE_DEFAULT_CACHE_MAX_SIZE);
+		struct ndm_core_t *c[2] = {NULL, NULL};
+		struct ndm_core_response_t *h = NULL;
+
+		NDM_TEST_BREAK_IF(pool == NULL);
+		NDM_TEST(ndm_core_pool_size(pool) == 2);
+
+		c[0] = ndm_core_pool_checkout(pool);
+		c[1] = ndm_core_pool_checkout(pool);
+
+		NDM_TEST(c[0] != NULL && c[1] != NULL && c[0] != c[1]);
+		NDM_TEST(ndm_core_pool_checkout(pool) == NULL);
+		NDM_TEST(errno == EAGAIN);
+		NDM_TEST(!ndm_core_pool_checkin(pool, core));
+		NDM_TEST(!ndm_core_close(&c[0]) && c[0] != NULL);
+
+		r = ndm_core_request(c[0], NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show version");
+		h = ndm_core_request(c[1], NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show version");
+
+		NDM_TEST(r != NULL && h == r);
+
+		ndm_core_response_free(&r);
+		ndm_core_response_free(&h);
+
+		NDM_TEST(ndm_core_pool_checkin(pool, c[1]));
+		NDM_TEST(ndm_core_pool_checkout(pool) == c[1]);
+		NDM_TEST(ndm_core_pool_checkin(pool, c[0]));
+		NDM_TEST(ndm_core_pool_checkin(pool, c[1]));
+		NDM_TEST(!ndm_core_pool_checkin(pool, c[1]));
+		NDM_TEST(errno == EINVAL);
+		NDM_TEST(ndm_core_pool_checkout(pool) != NULL);
+		NDM_TEST(ndm_core_pool_checkout(pool) != NULL);
+		NDM_TEST(ndm_core_pool_checkout(pool) == NULL);
+		NDM_TEST(ndm_core_pool_close(&pool));
+		NDM_TEST(pool == NULL);
+	} while (0);
+
+	do {
+		/* a compiled path finds the same values as a formatted one */
+		struct ndm_core_path_t *path = ndm_core_path_compile("a@b/c");
+		const char *value = NULL;
+		const char *path_value = NULL;
+		bool found_path = false;
+
+		NDM_TEST(path == NULL && errno == EINVAL);
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show interface");
+
+		NDM_TEST_BREAK_IF(r == NULL);
+
+		path = ndm_core_path_compile("/%s//@%s", "interface", "name");
+
+		NDM_TEST(path != NULL);
+
+		if (path != NULL) {
+			const struct ndm_xml_node_t *root = ndm_core_response_root(r);
+			const struct ndm_xml_node_t *node = NULL;
+
+			NDM_TEST(
+				ndm_core_path_first_str(path, root, &path_value) ==
+				ndm_core_response_first_str(root, &value,
+					"/%s//@%s", "interface", "name"));
+			NDM_TEST(path_value == value);
+			NDM_TEST(ndm_core_path_first_node(path, root, &node) ==
+				NDM_CORE_RESPONSE_ERROR_SYNTAX);
+			NDM_TEST(ndm_core_path_first_bool(
+				path, root, false, &found_path) ==
+				NDM_CORE_RESPONSE_ERROR_OK);
+			NDM_TEST(found_path == (value != NULL));
+
+			ndm_core_path_free(&path);
+			NDM_TEST(path == NULL);
+		}
+
+		ndm_core_response_free(&r);
+	} while (0);
+
+	do {
+		/* measured requests are accumulated and passed to a hook */
+		struct ndm_core_request_stats_t last;
+		struct ndm_core_stats_t stats;
+
+		memset(&last, 0, sizeof(last));
+		ndm_core_cache_clear(core, true);
+		ndm_core_set_stats(core, true);
+		ndm_core_clear_stats(core);
+		ndm_core_set_request_hook(core, test_request_hook, &last);
+
+		for (size_t i = 0; i < 2; i++) {
+			r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+				NDM_CORE_MODE_CACHE, NULL, "show version");
+
+			NDM_TEST(r != NULL);
+			NDM_TEST(!last.failed);
+			NDM_TEST(last.cache_hit == (i > 0));
+			NDM_TEST(last.bytes_sent > 0 || last.cache_hit);
+			NDM_TEST(last.bytes_received > 0 || last.cache_hit);
+			NDM_TEST(last.node_count > 0 || last.cache_hit);
+
+			ndm_core_response_free(&r);
+		}
+
+		ndm_core_get_stats(core, &stats);
+
+		NDM_TEST(stats.requests == 2);
+		NDM_TEST(stats.cache_hits == 1);
+		NDM_TEST(stats.failures == 0);
+		NDM_TEST(stats.bytes_received > 0);
+		NDM_TEST(stats.node_count > 0);
+
+		ndm_core_set_request_hook(core, NULL, NULL);
+		ndm_core_set_stats(core, false);
+	} while (0);
+
+	do {
+		/* a path cursor yields every match in a document order */
+		struct ndm_core_path_t *path = ndm_core_path_compile("interface");
+		const struct ndm_xml_node_t *n = NULL;
+		const struct ndm_xml_node_t *m = NULL;
+
+		NDM_TEST_BREAK_IF(path == NULL);
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show interface");
+
+		if (r != NULL) {
+			const struct ndm_xml_node_t *root = ndm_core_response_root(r);
+
+			m = ndm_xml_node_first_child(root, "interface");
+
+			while (ndm_core_path_next_node(path, root, &n) ==
+				NDM_CORE_RESPONSE_ERROR_OK)
+			{
+				NDM_TEST_BREAK_IF(n != m);
+				m = ndm_xml_node_next_sibling(m, "interface");
+			}
+
+			NDM_TEST(n == NULL && m == NULL);
+
+			ndm_core_response_free(&r);
+		}
+
+		ndm_core_path_free(&path);
+	} while (0);
+
+	do {
+		/* a schema extracts the same values as separate lookups */
+		struct test_schema_t
+		{
+			const char *name;
+			const struct ndm_xml_node_t *interface;
+			bool present;
+		} v = {NULL, NULL, false};
+		static const struct ndm_core_field_t fields[] =
+		{
+			{
+				"interface@name",
+				NDM_CORE_FIELD_STR,
+				offsetof(struct test_schema_t, name)
+			}, {
+				"interface",
+				NDM_CORE_FIELD_NODE,
+				offsetof(struct test_schema_t, interface)
+			}, {
+				"interface",
+				NDM_CORE_FIELD_PRESENT,
+				offsetof(struct test_schema_t, present)
+			}
+		};
+		struct ndm_core_schema_t *schema =
+			ndm_core_schema_compile(fields, NDM_ARRAY_SIZE(fields));
+		enum ndm_core_response_error_t errors[NDM_ARRAY_SIZE(fields)];
+		const struct ndm_xml_node_t *interface = NULL;
+		const char *name = NULL;
+
+		NDM_TEST_BREAK_IF(schema == NULL);
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show interface");
+
+		if (r != NULL) {
+			const struct ndm_xml_node_t *root = ndm_core_response_root(r);
+
+			NDM_TEST(ndm_core_schema_extract(schema, root, &v, errors) ==
+				ndm_core_response_first_str(root, &name, "interface@name"));
+			NDM_TEST(errors[1] ==
+				ndm_core_response_first_node(root, &interface, "interface"));
+			NDM_TEST(errors[2] == NDM_CORE_RESPONSE_ERROR_OK);
+			NDM_TEST(v.name == name);
+			NDM_TEST(v.interface == interface);
+			NDM_TEST(v.present == (interface != NULL));
+
+			ndm_core_response_free(&r);
+		}
+
+		ndm_core_schema_free(&schema);
+		NDM_TEST(schema == NULL);
+	} while (0);
+
+	do {
+		/* cache counters follow lookups, evictions and limits */
+		struct ndm_core_cache_stats_t stats;
+		uint64_t entry_hits = 0;
+
+		ndm_core_cache_clear(core, true);
+		ndm_core_cache_clear_stats(core);
+
+		for (size_t i = 0; i < 3; i++) {
+			r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+				NDM_CORE_MODE_CACHE, NULL, "show version");
+
+			NDM_TEST(r != NULL);
+
+			ndm_core_response_free(&r);
+		}
+
+		ndm_core_cache_get_stats(core, &stats);
+
+		NDM_TEST(stats.hits == 2);
+		NDM_TEST(stats.misses == 1);
+		NDM_TEST(stats.count == 1);
+		NDM_TEST(stats.size > 0);
+		NDM_TEST(stats.ttl_msec == CACHE_TTL_MS);
+
+		ndm_core_cache_foreach(core, test_cache_entry, &entry_hits);
+		NDM_TEST(entry_hits == 2);
+
+		ndm_core_cache_set_ttl(core, 2*CACHE_TTL_MS);
+		ndm_core_cache_set_max_size(core, 1);
+		ndm_core_cache_get_stats(core, &stats);
+
+		NDM_TEST(stats.evictions == 1);
+		NDM_TEST(stats.count == 0);
+		NDM_TEST(stats.max_size == 1);
+		NDM_TEST(stats.ttl_msec == 2*CACHE_TTL_MS);
+
+		ndm_core_cache_set_adaptive(core, true,
+			NDM_CORE_DEFAULT_CACHE_MAX_SIZE/4,
+			NDM_CORE_DEFAULT_CACHE_MAX_SIZE);
+		ndm_core_cache_get_stats(core, &stats);
+
+		NDM_TEST(stats.max_size == NDM_CORE_DEFAULT_CACHE_MAX_SIZE/4);
+
+		ndm_core_cache_set_adaptive(core, false, 0, 0);
+		ndm_core_cache_set_max_size(core, NDM_CORE_DEFAULT_CACHE_MAX_SIZE);
+		ndm_core_cache_set_ttl(core, CACHE_TTL_MS);
+	} while (0);
+
+	do {
+		/* per-command policies set a response lifetime and cacheability */
+		struct ndm_core_cache_stats_t stats;
+
+		ndm_core_cache_clear(core, true);
+		NDM_TEST(ndm_core_cache_set_policy(core, "show", true, 60000));
+		NDM_TEST(ndm_core_cache_set_policy(core, "show version", false, 0));
+		NDM_TEST(ndm_core_cache_set_policy(core, "show vers", true, 60000));
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show version");
+		NDM_TEST(r != NULL);
+		ndm_core_response_free(&r);
+
+		ndm_core_cache_get_stats(core, &stats);
+		NDM_TEST(stats.count == 0);
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show system");
+		NDM_TEST(r != NULL);
+		ndm_core_response_free(&r);
+
+		/* a policy lifetime is kept when a default one changes */
+		ndm_core_cache_set_ttl(core, 0);
+		ndm_core_cache_clear(core, false);
+		ndm_core_cache_get_stats(core, &stats);
+		NDM_TEST(stats.count == 1);
+
+		ndm_core_cache_set_ttl(core, CACHE_TTL_MS);
+		ndm_core_cache_clear_policies(core);
+		ndm_core_cache_clear(core, true);
+	} while (0);
+
+	do {
+		/* a lookup expires only a response it finds */
+		struct ndm_core_cache_stats_t stats;
+
+		ndm_core_cache_clear(core, true);
+		ndm_core_cache_clear_stats(core);
+		ndm_core_cache_set_ttl(core, 0);
+		NDM_TEST(ndm_core_cache_set_policy(core, "show version", false, 0));
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show system");
+		NDM_TEST(r != NULL);
+		ndm_core_response_free(&r);
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show version");
+		NDM_TEST(r != NULL);
+		ndm_core_response_free(&r);
+
+		ndm_core_cache_get_stats(core, &stats);
+		NDM_TEST(stats.count == 1);
+		NDM_TEST(stats.expirations == 0);
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show system");
+		NDM_TEST(r != NULL);
+		ndm_core_response_free(&r);
+
+		ndm_core_cache_get_stats(core, &stats);
+		NDM_TEST(stats.count == 1);
+		NDM_TEST(stats.hits == 0);
+		NDM_TEST(stats.expirations == 1);
+
+		ndm_core_cache_set_ttl(core, CACHE_TTL_MS);
+		ndm_core_cache_clear_policies(core);
+		ndm_core_cache_clear(core, true);
+	} while (0);
+
+	do {
+		/* a compacting cache returns compact copies of responses */
+		struct ndm_core_cache_stats_t stats;
+		struct ndm_core_response_t *z = NULL;
+		size_t full_size = 0;
+		size_t diffs = 0;
+
+		/* a large response is not cached with a default limit */
+		ndm_core_cache_set_max_size(core, 64*NDM_CORE_DEFAULT_CACHE_MAX_SIZE);
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show interface");
+		NDM_TEST(r != NULL);
+		ndm_core_response_free(&r);
+
+		ndm_core_cache_get_stats(core, &stats);
+		NDM_TEST(stats.count == 1);
+		full_size = stats.size;
+
+		ndm_core_cache_clear(core, true);
+		ndm_core_cache_set_compact(core, true);
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show interface");
+		z = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show interface");
+
+		NDM_TEST(r != NULL);
+		NDM_TEST(z != NULL);
+
+		ndm_core_cache_get_stats(core, &stats);
+		NDM_TEST(stats.count == 1);
+		NDM_TEST(stats.hits > 0);
+		NDM_TEST(stats.size < full_size);
+
+		if (r != NULL && z != NULL) {
+			NDM_TEST(ndm_xml_node_diff(
+				ndm_core_response_root(r), ndm_core_response_root(z),
+				test_diff_count, &diffs));
+			NDM_TEST(diffs == 0);
+			NDM_TEST(ndm_core_response_is_ok(z));
+		}
+
+		ndm_core_response_free(&r);
+		ndm_core_response_free(&z);
+		ndm_core_cache_set_compact(core, false);
+		ndm_core_cache_set_max_size(core, NDM_CORE_DEFAULT_CACHE_MAX_SIZE);
+		ndm_core_cache_clear(core, true);
+	} while (0);
+
+	do {
+		/* concurrent identical pooled requests share one response */
+		struct ndm_core_pool_t *pool = ndm_core_pool_open("test/ci", 4,
+			NDM_CORE_DEFAULT_CACHE_TTL, NDM_CORE_DEFAULT_CACHE_MAX_SIZE);
+		struct test_flight_t flights[4];
+		pthread_t threads[NDM_ARRAY_SIZE(flights)];
+		struct test_rendezvous_t rendezvous;
+		struct ndm_core_cache_stats_t stats;
+		struct ndm_core_t *c = NULL;
+		uint64_t cache_hits = 0;
+
+		NDM_TEST_BREAK_IF(pool == NULL);
+
+		pthread_mutex_init(&rendezvous.lock, NULL);
+		pthread_cond_init(&rendezvous.arrived, NULL);
+		rendezvous.count = NDM_ARRAY_SIZE(flights);
+
+		for (size_t i = 0; i < NDM_ARRAY_SIZE(flights); i++) {
+			flights[i].pool = pool;
+			flights[i].rendezvous = &rendezvous;
+			flights[i].response = NULL;
+			memset(&flights[i].stats, 0, sizeof(flights[i].stats));
+			pthread_create(&threads[i], NULL, test_flight, &flights[i]);
+		}
+
+		for (size_t i = 0; i < NDM_ARRAY_SIZE(flights); i++) {
+			pthread_join(threads[i], NULL);
+			cache_hits += flights[i].stats.cache_hits;
+		}
+
+		pthread_cond_destroy(&rendezvous.arrived);
+		pthread_mutex_destroy(&rendezvous.lock);
+
+		c = ndm_core_pool_checkout(pool);
+		NDM_TEST(c != NULL);
+
+		if (c != NULL) {
+			ndm_core_cache_get_stats(c, &stats);
+			NDM_TEST(stats.hits + stats.coalesced == 3);
+
+			/* a coalesced response is not a cache hit of a request */
+			NDM_TEST(cache_hits == stats.hits);
+			NDM_TEST(ndm_core_pool_checkin(pool, c));
+		}
+
+		r = flights[0].response;
+
+		for (size_t i = 0; i < NDM_ARRAY_SIZE(flights); i++) {
+			NDM_TEST(flights[i].response != NULL);
+			NDM_TEST(flights[i].response == r);
+			ndm_core_response_free(&flights[i].response);
+		}
+
+		r = NULL;
+
+		NDM_TEST(ndm_core_pool_close(&pool));
+	} while (0);
+
+	do {
+		/* cache hits share an immutable response */
+		struct ndm_core_response_t *h = NULL;
+
+		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show version");
+		h = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+			NDM_CORE_MODE_CACHE, NULL, "show version");
+
+		NDM_TEST(r != NULL);
+		NDM_TEST(h == r);
+
+		ndm_core_response_free(&r);
+		ndm_core_cache_clear(core, true);
+
+		NDM_TEST(h != NULL && ndm_core_response_root(h) != NULL);
+
+		ndm_core_response_free(&h);
+	} while (0);
+
+	do {
+		/* strings of a zero-copy response refer to a received frame */
+		ndm_core_set_zero_copy(core, true);
+		NDM_TEST(ndm_core_get_zero_copy(core));
+
+		for (size_t i = 0; i < 2; i++) {
+			r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+				NDM_CORE_MODE_CACHE, NULL, "show version");
+
+			NDM_TEST(r != NULL);
+
+			ndm_core_response_free(&r);
+		}
+
+		ndm_core_set_zero_copy(core, false);
+	} while (0);
+
+	do {
+		/* records of a response larger than a receive buffer are split
+		 * across the buffer boundary, a response received as a whole
+		 * frame is decoded without a buffer */
+		const char *commands[] =
+		{
+			"show interface",
+			"show running-config"
+		};
+
+		for (size_t i = 0; i < NDM_ARRAY_SIZE(commands); i++) {
+			struct ndm_core_response_t *z = NULL;
+			size_t diffs = 0;
+
+			r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+				NDM_CORE_MODE_NO_CACHE, NULL, "%s", commands[i]);
+			ndm_core_set_zero_copy(core, true);
+			z = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
+				NDM_CORE_MODE_NO_CACHE, NULL, "%s", commands[i]);
+			ndm_core_set_zero_copy(core, false);
+
+			NDM_TEST(r != NULL && z != NULL);
+
+			if (r != NULL && z != NULL) {
+				NDM_TEST(ndm_xml_node_diff(
+					ndm_core_response_root(r), ndm_core_response_root(z),
+					test_diff_count, &diffs));
+				NDM_TEST(diffs == 0);
+			}
+
+			ndm_core_response_free(&r);
+			ndm_core_response_free(&z);
+		}
+	} while (0);
+
 	do {
 		r = ndm_core_request(core, NDM_CORE_REQUEST_PARSE,
 			NDM_CORE_MODE_CACHE, NULL, "show interface");
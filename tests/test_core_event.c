@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -13,18 +14,54 @@
 #define MAX_HANDLED_EVENTS		10
 
 #define KEY_ESC					27
+#define KEY_BATCH				'b'
 
-int main()
+static void print_event(
+		const struct ndm_core_event_t *e)
+{
+	const struct timespec raise_time = ndm_core_event_raise_time(e);
+	const struct ndm_xml_node_t *r = ndm_core_event_root(e);
+	const struct ndm_xml_node_t *v = ndm_xml_node_first_child(r, NULL);
+
+	printf("event: \"%s\" at %li.%06li%s\n",
+		ndm_core_event_type(e),
+		(long) raise_time.tv_sec,
+		(long) raise_time.tv_nsec/NDM_TIME_MSEC,
+		(v == NULL) ? "." : ", first level tags:");
+
+	while (v != NULL) {
+		printf("\t%s: \"%s\"\n",
+			ndm_xml_node_name(v),
+			ndm_xml_node_value(v));
+		v = ndm_xml_node_next_sibling(v, NULL);
+	}
+}
+
+int main(int argc, char *argv[])
 {
 	struct ndm_core_event_connection_t *econn =
 		ndm_core_event_connection_open(NDM_CORE_DEFAULT_TIMEOUT);
 	char key = 0;
+	bool batch = false;
 	ssize_t n = 0;
 	struct termios old_term;
 	struct termios new_term;
 
 	NDM_TEST_BREAK_IF(econn == NULL);
 
+	/* "class" arguments are exact filters, "class*" are prefix ones */
+	for (int i = 1; i < argc; i++) {
+		const size_t size = strlen(argv[i]);
+		const bool prefix = (size > 0 && argv[i][size - 1] == '*');
+
+		if (prefix) {
+			argv[i][size - 1] = '\0';
+		}
+
+		NDM_TEST_BREAK_IF(
+			!ndm_core_event_connection_filter_add(econn, argv[i], prefix));
+	}
+
 	tcgetattr(STDIN_FILENO, &old_term);
 	new_term = old_term;
 	new_term.c_lflag &= (unsigned char) ~(ICANON | ECHO | ISIG);
@@ -32,7 +69,8 @@ int main()
 	new_term.c_cc[VTIME] = 0;
 	tcsetattr(STDIN_FILENO, TCSANOW, &new_term);
 
-	printf("waiting for core events, press ESC to terminate...\n");
+	printf("waiting for core events, press ESC to terminate, "
+		"\"b\" to toggle batched reading...\n");
 
 	do {
 		struct pollfd pfd[2];
@@ -50,48 +88,58 @@ int main()
 		if (n > 0) {
 			if (pfd[0].revents & POLLIN) {
 				n = read(STDIN_FILENO, &key, sizeof(key));
+
+				if (n > 0 && key == KEY_BATCH) {
+					batch = !batch;
+					printf("batched reading is %s.\n", batch ? "on" : "off");
+				}
 			}
 
 			if (key != KEY_ESC && n >= 0) {
 				if (ndm_core_event_connection_has_events(econn) ||
 					pfd[1].revents & POLLIN)
 				{
-					size_t events_handled = 0;
-
-					do {
-						struct ndm_core_event_t *e =
-							ndm_core_event_connection_get(econn);
-
-						if (e == NULL) {
+					if (batch) {
+						struct ndm_core_event_t *events[MAX_HANDLED_EVENTS];
+						size_t count = 0;
+						size_t i;
+
+						if (!ndm_core_event_connection_get_batch(econn,
+								events, NDM_ARRAY_SIZE(events), &count))
+						{
 							NDM_TEST(false);
 							n = -1;
-						} else {
-							const struct timespec raise_time =
-								ndm_core_event_raise_time(e);
-							const struct ndm_xml_node_t *r =
-								ndm_core_event_root(e);
-							const struct ndm_xml_node_t *v =
-								ndm_xml_node_first_child(r, NULL);
-
-							printf("event: \"%s\" at %li.%06li%s\n",
-								ndm_core_event_type(e),
-								(long) raise_time.tv_sec,
-								(long) raise_time.tv_nsec/NDM_TIME_MSEC,
-								(v == NULL) ? "." : ", first level tags:");
-
-							while (v != NULL) {
-								printf("\t%s: \"%s\"\n",
-									ndm_xml_node_name(v),
-									ndm_xml_node_value(v));
-								v = ndm_xml_node_next_sibling(v, NULL);
-							}
+						}
 
-							ndm_core_event_free(&e);
-							++events_handled;
+						for (i = 0; i < count; i++) {
+							print_event(events[i]);
 						}
-					} while (
-						events_handled < MAX_HANDLED_EVENTS &&
-						ndm_core_event_connection_has_events(econn));
+
+						ndm_core_event_connection_put_batch(
+							econn, events, count);
+					} else {
+						size_t events_handled = 0;
+
+						do {
+							struct ndm_core_event_t *e =
+								ndm_core_event_connection_get(econn);
+
+							if (e == NULL && errno == ENOMSG) {
+								/* buffered events are filtered out */
+								break;
+							} else
+							if (e == NULL) {
+								NDM_TEST(false);
+								n = -1;
+							} else {
+								print_event(e);
+								ndm_core_event_free(&e);
+								++events_handled;
+							}
+						} while (
+							events_handled < MAX_HANDLED_EVENTS &&
+							ndm_core_event_connection_has_events(econn));
+					}
 				} else
 				if (pfd[0].revents & (POLLERR | POLLNVAL | POLLHUP)) {
 					NDM_TEST(false);
@@ -1,12 +1,48 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ndm/xml.h>
+#include <ndm/macro.h>
 #include "test.h"
 
 #define STATIC_BUFFER_SIZE			4096
 #define DYNAMIC_BUFFER_SIZE			4096
 
+#define SKIP_TEST_ROUNDS			3000
+#define SKIP_TEST_MAX_PIECES		48
+
+/* a plain reference for vectorized parser skips */
+static void test_skip_expected(
+		const char *raw,
+		const bool expand,
+		const bool normalize,
+		char *expected)
+{
+	while (*raw != '\0') {
+		const bool space =
+			*raw == ' ' || *raw == '\n' || *raw == '\r' || *raw == '\t';
+
+		if (expand && strncmp(raw, "&amp;", 5) == 0) {
+			*expected++ = '&';
+			raw += 5;
+		} else
+		if (normalize && space) {
+			*expected++ = ' ';
+
+			while (*raw == ' ' || *raw == '\n' ||
+				   *raw == '\r' || *raw == '\t')
+			{
+				++raw;
+			}
+		} else {
+			*expected++ = *raw++;
+		}
+	}
+
+	*expected = '\0';
+}
+
 int main()
 {
 	char buffer[STATIC_BUFFER_SIZE];
@@ -23,6 +59,7 @@ int main()
 	struct ndm_xml_node_t *p[6];
 	struct ndm_xml_attr_t *q[6];
 	char *s = NULL;
+	struct ndm_xml_document_parser_t parser;
 	FILE *fp = NULL;
 	long fsize = 0;
 
@@ -276,6 +313,578 @@ int main()
 
 	NDM_TEST(ndm_xml_node_first_attr(n, NULL) == NULL);
 
+	do {
+		/* parsed text is a data node value and the first text
+		 * of an element is the element value */
+		char text[] = "<a>x<b/>y</a>";
+		char plain[] = "<a>x</a>";
+
+		NDM_TEST_BREAK_IF(ndm_xml_document_parse(&copy, text,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) !=
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+
+		n = ndm_xml_node_first_child(ndm_xml_document_root(&copy), "a");
+
+		NDM_TEST_BREAK_IF(n == NULL);
+		NDM_TEST(strcmp(ndm_xml_node_value(n), "x") == 0);
+
+		c = ndm_xml_node_first_child(n, NULL);
+
+		NDM_TEST(c != NULL &&
+			ndm_xml_node_type(c) == NDM_XML_NODE_TYPE_DATA &&
+			strcmp(ndm_xml_node_value(c), "x") == 0);
+
+		c = ndm_xml_node_last_child(n, NULL);
+
+		NDM_TEST(c != NULL &&
+			ndm_xml_node_type(c) == NDM_XML_NODE_TYPE_DATA &&
+			strcmp(ndm_xml_node_value(c), "y") == 0);
+
+		NDM_TEST_BREAK_IF(ndm_xml_document_parse(&copy, plain,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_NO_ELEMENT_VALUES) !=
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+
+		n = ndm_xml_node_first_child(ndm_xml_document_root(&copy), "a");
+
+		NDM_TEST_BREAK_IF(n == NULL);
+		NDM_TEST(*ndm_xml_node_value(n) == '\0');
+		NDM_TEST(strcmp(ndm_xml_node_value(
+			ndm_xml_node_first_child(n, NULL)), "x") == 0);
+
+		ndm_xml_document_clear(&copy);
+	} while (0);
+
+	do {
+		/* an unclosed streamed element is an error */
+		const char *const chunks[] = {"<a x='1&am", "p;2'>b", "</a><c>"};
+
+		ndm_xml_document_parser_init(&parser, &copy,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT);
+
+		for (size_t i = 0; i < NDM_ARRAY_SIZE(chunks); i++) {
+			NDM_TEST(ndm_xml_document_parser_feed(&parser,
+				chunks[i], strlen(chunks[i])) ==
+					NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+		}
+
+		n = ndm_xml_node_first_child(ndm_xml_document_root(&copy), "a");
+
+		NDM_TEST(n != NULL &&
+			strcmp(ndm_xml_attr_value(
+				ndm_xml_node_first_attr(n, "x")), "1&2") == 0);
+		NDM_TEST(ndm_xml_document_parser_finish(&parser) ==
+			NDM_XML_DOCUMENT_PARSE_ERROR_UNEXPECTED_STREAM_END);
+		NDM_TEST(ndm_xml_document_root(&copy) == NULL);
+	} while (0);
+
+	do {
+		/* a document is printed in compact and indented modes */
+		char text[] =
+			"<?xml version=\"1.0\"?><!--c--><a x=\"1&amp;&quot;2\">"
+			"<b>t &lt;&gt;</b><c/><d><![CDATA[<&>]]><e/></d></a>";
+		static const char compact[] =
+			"<?xml version=\"1.0\"?><!--c--><a x=\"1&amp;&quot;2\">"
+			"<b>t &lt;&gt;</b><c/><d><![CDATA[<&>]]><e/></d></a>";
+		static const char indented[] =
+			"<?xml version=\"1.0\"?>\n"
+			"<!--c-->\n"
+			"<a x=\"1&amp;&quot;2\">\n"
+			"  <b>t &lt;&gt;</b>\n"
+			"  <c/>\n"
+			"  <d>\n"
+			"    <![CDATA[<&>]]>\n"
+			"    <e/>\n"
+			"  </d>\n"
+			"</a>";
+		char out[sizeof(compact)];
+		size_t size = 0;
+
+		NDM_TEST_BREAK_IF(ndm_xml_document_parse(&copy, text,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) !=
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+
+		s = ndm_xml_document_print(&copy,
+			NDM_XML_PRINT_FLAGS_COMPACT, &size);
+
+		NDM_TEST(s != NULL && strcmp(s, compact) == 0);
+		NDM_TEST(size == sizeof(compact) - 1);
+
+		free(s);
+
+		s = ndm_xml_document_print(&copy, 0, &size);
+
+		NDM_TEST(s != NULL && strcmp(s, indented) == 0);
+		NDM_TEST(size == sizeof(indented) - 1);
+
+		free(s);
+
+		n = ndm_xml_node_first_child(
+			ndm_xml_node_first_child(ndm_xml_document_root(&copy), "a"),
+			"b");
+		s = ndm_xml_node_print(n, NDM_XML_PRINT_FLAGS_DEFAULT, NULL);
+
+		NDM_TEST(s != NULL && strcmp(s, "<b>t &lt;&gt;</b>") == 0);
+
+		free(s);
+
+		/* a short buffer reports a required size */
+		NDM_TEST(!ndm_xml_document_print_buffer(&copy,
+			NDM_XML_PRINT_FLAGS_COMPACT, out, sizeof(out) - 1, &size));
+		NDM_TEST(errno == ENOBUFS);
+		NDM_TEST(size == sizeof(compact) - 1);
+		NDM_TEST(ndm_xml_document_print_buffer(&copy,
+			NDM_XML_PRINT_FLAGS_COMPACT, out, sizeof(out), &size));
+		NDM_TEST(strcmp(out, compact) == 0);
+
+		FILE *tmp = tmpfile();
+
+		NDM_TEST_BREAK_IF(tmp == NULL);
+		NDM_TEST(ndm_xml_document_print_fd(&copy,
+			NDM_XML_PRINT_FLAGS_COMPACT, fileno(tmp)));
+		NDM_TEST(fseek(tmp, 0, SEEK_SET) == 0);
+		NDM_TEST(fread(out, sizeof(compact) - 1, 1, tmp) == 1);
+		NDM_TEST(memcmp(out, compact, sizeof(compact) - 1) == 0);
+		NDM_TEST(fread(out, 1, 1, tmp) == 0);
+
+		fclose(tmp);
+		ndm_xml_document_clear(&copy);
+	} while (0);
+
+	do {
+		/* a long output spans many print buffer flushes */
+		static const char item[] = "<b c=\"d\">0123456789abcdef</b>";
+		const size_t items = 4096;
+		const size_t long_size = 3 + items * (sizeof(item) - 1) + 4;
+		char *text = malloc(long_size + 1);
+		char *expected = malloc(long_size + 1);
+		size_t size = 0;
+		size_t i;
+
+		if (text == NULL || expected == NULL) {
+			free(text);
+			free(expected);
+			NDM_TEST_BREAK_IF(true);
+		}
+
+		strcpy(expected, "<a>");
+
+		for (i = 0; i < items; i++) {
+			memcpy(expected + 3 + i * (sizeof(item) - 1), item, sizeof(item));
+		}
+
+		strcat(expected, "</a>");
+		memcpy(text, expected, long_size + 1);
+
+		if (ndm_xml_document_parse(&copy, text,
+				NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) ==
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK)
+		{
+			s = ndm_xml_document_print(&copy,
+				NDM_XML_PRINT_FLAGS_COMPACT, &size);
+
+			NDM_TEST(s != NULL && strcmp(s, expected) == 0);
+			NDM_TEST(size == long_size);
+
+			free(s);
+		} else {
+			NDM_TEST(false);
+		}
+
+		ndm_xml_document_clear(&copy);
+		free(expected);
+		free(text);
+	} while (0);
+
+	do {
+		/* an own value of an element with children is leading text */
+		char text[] = "<a>v<b>w</b></a>";
+
+		NDM_TEST_BREAK_IF(ndm_xml_document_parse(&copy, text,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT |
+			NDM_XML_DOCUMENT_PARSE_FLAGS_NO_DATA_NODES) !=
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+
+		s = ndm_xml_document_print(&copy, NDM_XML_PRINT_FLAGS_COMPACT, NULL);
+
+		NDM_TEST(s != NULL && strcmp(s, "<a>v<b>w</b></a>") == 0);
+
+		free(s);
+
+		s = ndm_xml_document_print(&copy, 0, NULL);
+
+		NDM_TEST(s != NULL && strcmp(s, "<a>v\n  <b>w</b>\n</a>") == 0);
+
+		free(s);
+		ndm_xml_document_clear(&copy);
+	} while (0);
+
+	do {
+		/* interned names are looked up by atoms */
+		char text[] =
+			"<a><b x='1' y='2'/><c/><b y='3'/><d>e</d><b/></a>";
+		ndm_xml_atom_t b = NDM_XML_ATOM_NONE;
+		ndm_xml_atom_t y = NDM_XML_ATOM_NONE;
+		size_t count = 0;
+
+		NDM_TEST(ndm_xml_document_atom(&copy, "b") == NDM_XML_ATOM_NONE);
+		NDM_TEST_BREAK_IF(ndm_xml_document_parse(&copy, text,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) !=
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+
+		/* a parsed document is interned on demand */
+		NDM_TEST(ndm_xml_document_intern_names(&copy));
+
+		b = ndm_xml_document_atom(&copy, "b");
+		y = ndm_xml_document_atom(&copy, "y");
+
+		NDM_TEST(b != NDM_XML_ATOM_NONE);
+		NDM_TEST(y != NDM_XML_ATOM_NONE && y != b);
+		NDM_TEST(ndm_xml_document_atom(&copy, "z") == NDM_XML_ATOM_NONE);
+
+		n = ndm_xml_node_first_child(ndm_xml_document_root(&copy), "a");
+
+		NDM_TEST_BREAK_IF(n == NULL);
+		NDM_TEST(ndm_xml_node_first_child(n, "z") == NULL);
+		NDM_TEST(ndm_xml_node_first_child_atom(n,
+			NDM_XML_ATOM_NONE) == NULL);
+
+		c = ndm_xml_node_first_child_atom(n, b);
+
+		NDM_TEST(c == ndm_xml_node_first_child(n, "b"));
+		NDM_TEST(ndm_xml_node_atom(c) == b);
+		NDM_TEST(ndm_xml_node_last_child_atom(n, b) ==
+			ndm_xml_node_last_child(n, "b"));
+
+		while (c != NULL) {
+			++count;
+			c = ndm_xml_node_next_sibling_atom(c, b);
+		}
+
+		NDM_TEST(count == 3);
+
+		c = ndm_xml_node_last_child(n, NULL);
+
+		NDM_TEST(ndm_xml_node_prev_sibling_atom(c,
+			ndm_xml_document_atom(&copy, "c")) ==
+				ndm_xml_node_prev_sibling(c, "c"));
+
+		a = ndm_xml_node_first_attr_atom(
+			ndm_xml_node_first_child(n, NULL), y);
+
+		NDM_TEST(a != NULL && strcmp(ndm_xml_attr_value(a), "2") == 0);
+		NDM_TEST(ndm_xml_attr_atom(a) == y);
+		NDM_TEST(ndm_xml_attr_prev_atom(a,
+			ndm_xml_document_atom(&copy, "x")) ==
+				ndm_xml_node_first_attr(
+					ndm_xml_node_first_child(n, NULL), "x"));
+
+		/* new and renamed nodes are interned */
+		NDM_TEST_BREAK_IF((c = ndm_xml_node_append_child_str(
+			n, "f", NULL)) == NULL);
+		NDM_TEST(ndm_xml_node_atom(c) ==
+			ndm_xml_document_atom(&copy, "f"));
+
+		ndm_xml_node_set_name(c, "b");
+
+		NDM_TEST(ndm_xml_node_atom(c) == b);
+		NDM_TEST(ndm_xml_node_last_child(n, "b") == c);
+		NDM_TEST(ndm_xml_node_last_child(n, "f") == NULL);
+
+		/* interning persists after a document clear */
+		ndm_xml_document_clear(&copy);
+
+		NDM_TEST(ndm_xml_document_atom(&copy, "b") == NDM_XML_ATOM_NONE);
+		NDM_TEST_BREAK_IF(ndm_xml_document_alloc_root(&copy) == NULL);
+		NDM_TEST(ndm_xml_node_atom(ndm_xml_node_append_child_str(
+			ndm_xml_document_root(&copy), "b", NULL)) ==
+				ndm_xml_document_atom(&copy, "b"));
+
+		ndm_xml_document_clear(&copy);
+	} while (0);
+
+	do {
+		/* a compact document keeps the read-only node interface */
+		char text[] =
+			"<a k='v'><b x='1' y='2'/><c>t</c><b y='3'/><d/><b/></a>";
+		struct ndm_xml_document_t compact =
+			NDM_XML_DOCUMENT_INITIALIZER(NULL, 0, DYNAMIC_BUFFER_SIZE);
+		ndm_xml_atom_t b = NDM_XML_ATOM_NONE;
+		char *t = NULL;
+		size_t count = 0;
+
+		NDM_TEST(ndm_xml_document_compact(&compact, &copy));
+		NDM_TEST(ndm_xml_document_is_empty(&compact));
+		NDM_TEST(!ndm_xml_document_is_compact(&compact));
+		NDM_TEST_BREAK_IF(ndm_xml_document_parse(&copy, text,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) !=
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+		NDM_TEST(!ndm_xml_document_is_compact(&copy));
+		NDM_TEST_BREAK_IF(!ndm_xml_document_compact(&compact, &copy));
+		NDM_TEST(ndm_xml_document_is_compact(&compact));
+		NDM_TEST(ndm_xml_document_is_equal(&compact, &copy));
+
+		root = ndm_xml_document_root(&compact);
+
+		NDM_TEST(ndm_xml_node_type(root) == NDM_XML_NODE_TYPE_DOCUMENT);
+		NDM_TEST(ndm_xml_node_parent(root) == NULL);
+		NDM_TEST(ndm_xml_node_document(root) == &compact);
+
+		n = ndm_xml_node_first_child(root, "a");
+
+		NDM_TEST_BREAK_IF(n == NULL);
+		NDM_TEST(ndm_xml_node_parent(n) == root);
+		NDM_TEST(ndm_xml_node_name_size(n) == 1);
+		NDM_TEST(ndm_xml_node_first_child(n, "z") == NULL);
+		NDM_TEST(ndm_xml_node_first_child(n, NULL) ==
+			ndm_xml_node_first_child(n, "b"));
+		NDM_TEST(ndm_xml_node_first_child_atom(n,
+			NDM_XML_ATOM_NONE) == NULL);
+
+		b = ndm_xml_document_atom(&compact, "b");
+
+		NDM_TEST(b != NDM_XML_ATOM_NONE);
+		NDM_TEST(ndm_xml_document_atom(&compact, "z") == NDM_XML_ATOM_NONE);
+
+		c = ndm_xml_node_first_child_atom(n, b);
+
+		while (c != NULL) {
+			NDM_TEST(ndm_xml_node_parent(c) == n);
+			NDM_TEST(ndm_xml_node_atom(c) == b);
+			++count;
+			c = ndm_xml_node_next_sibling_atom(c, b);
+		}
+
+		NDM_TEST(count == 3);
+
+		c = ndm_xml_node_last_child(n, NULL);
+
+		NDM_TEST(c == ndm_xml_node_last_child_atom(n, b));
+		NDM_TEST(ndm_xml_node_next_sibling(c, NULL) == NULL);
+		NDM_TEST(ndm_xml_node_prev_sibling(c, "c") ==
+			ndm_xml_node_first_child(n, "c"));
+		NDM_TEST(ndm_xml_node_prev_sibling_atom(c, b) ==
+			ndm_xml_node_prev_sibling(ndm_xml_node_prev_sibling(
+				c, NULL), NULL));
+		NDM_TEST(strcmp(ndm_xml_node_value(
+			ndm_xml_node_first_child(n, "c")), "t") == 0);
+		NDM_TEST(ndm_xml_node_value_size(
+			ndm_xml_node_first_child(n, "c")) == 1);
+
+		a = ndm_xml_node_first_attr(ndm_xml_node_first_child(n, NULL), "y");
+
+		NDM_TEST_BREAK_IF(a == NULL);
+		NDM_TEST(strcmp(ndm_xml_attr_value(a), "2") == 0);
+		NDM_TEST(ndm_xml_attr_value_size(a) == 1);
+		NDM_TEST(ndm_xml_attr_name_size(a) == 1);
+		NDM_TEST(ndm_xml_attr_node(a) == ndm_xml_node_first_child(n, NULL));
+		NDM_TEST(ndm_xml_attr_document(a) == &compact);
+		NDM_TEST(ndm_xml_attr_next(a, NULL) == NULL);
+		NDM_TEST(ndm_xml_attr_prev(a, NULL) ==
+			ndm_xml_node_first_attr(ndm_xml_node_first_child(n, NULL), "x"));
+		NDM_TEST(ndm_xml_attr_prev_atom(a, ndm_xml_attr_atom(a)) == NULL);
+		NDM_TEST(ndm_xml_node_last_attr(n, NULL) ==
+			ndm_xml_node_first_attr_atom(n,
+				ndm_xml_document_atom(&compact, "k")));
+
+		/* a compact document is printed and copied as a regular one */
+		s = ndm_xml_document_print(&compact, 0, NULL);
+		t = ndm_xml_document_print(&copy, 0, NULL);
+
+		NDM_TEST(s != NULL && t != NULL && strcmp(s, t) == 0);
+
+		free(s);
+		free(t);
+		ndm_xml_document_clear(&copy);
+
+		NDM_TEST(ndm_xml_document_copy(&copy, &compact));
+		NDM_TEST(!ndm_xml_document_is_compact(&copy));
+		NDM_TEST(ndm_xml_document_is_equal(&copy, &compact));
+
+		ndm_xml_document_clear(&compact);
+		ndm_xml_document_clear(&copy);
+	} while (0);
+
+	do {
+		/* wide nodes are indexed by names and positions */
+		char name[16];
+		bool matches = true;
+		size_t size;
+
+		NDM_TEST_BREAK_IF((root = ndm_xml_document_alloc_root(&copy)) == NULL);
+		NDM_TEST_BREAK_IF((n = ndm_xml_node_append_child_str(
+			root, "w", NULL)) == NULL);
+
+		for (size_t i = 0; i < 100; i++) {
+			snprintf(name, sizeof(name), "c%zu", i % 40);
+			NDM_TEST_BREAK_IF(ndm_xml_node_append_child_str(
+				n, name, NULL) == NULL);
+		}
+
+		NDM_TEST(ndm_xml_node_child_count(n) == 100);
+
+		/* children are indexed on request only */
+		size = ndm_xml_document_allocated_size(&copy);
+
+		NDM_TEST(ndm_xml_node_first_child(n, "c39") ==
+			ndm_xml_node_nth_child(n, 39));
+		NDM_TEST(ndm_xml_document_allocated_size(&copy) == size);
+		NDM_TEST(ndm_xml_node_index_children(n));
+		NDM_TEST(ndm_xml_document_allocated_size(&copy) > size);
+
+		NDM_TEST(ndm_xml_node_nth_child(n, 100) == NULL);
+		NDM_TEST(ndm_xml_node_nth_child(n, 0) ==
+			ndm_xml_node_first_child(n, NULL));
+
+		for (size_t i = 0; i < 100; i++) {
+			snprintf(name, sizeof(name), "c%zu", i % 40);
+			c = ndm_xml_node_nth_child(n, i);
+			matches = matches &&
+				c != NULL &&
+				strcmp(ndm_xml_node_name(c), name) == 0 &&
+				ndm_xml_node_first_child(n, name) ==
+					ndm_xml_node_nth_child(n, i % 40);
+		}
+
+		NDM_TEST(matches);
+		NDM_TEST(ndm_xml_node_first_child(n, "c40") == NULL);
+
+		/* an index follows mutations */
+		c = ndm_xml_node_nth_child(n, 5);
+		ndm_xml_node_remove_child(n, c);
+
+		NDM_TEST(ndm_xml_node_child_count(n) == 99);
+
+		/* lookups rebuild a stale index and never allocate */
+		size = ndm_xml_document_allocated_size(&copy);
+
+		NDM_TEST(ndm_xml_node_first_child(n, "c5") ==
+			ndm_xml_node_nth_child(n, 44));
+		NDM_TEST(ndm_xml_node_first_child(n, "c39") ==
+			ndm_xml_node_nth_child(n, 38));
+		NDM_TEST(ndm_xml_document_is_valid(&copy));
+		NDM_TEST(ndm_xml_document_allocated_size(&copy) == size);
+
+		ndm_xml_node_insert_child(n, ndm_xml_node_nth_child(n, 0), c);
+
+		NDM_TEST(ndm_xml_node_nth_child(n, 0) == c);
+		NDM_TEST(ndm_xml_node_first_child(n, "c5") == c);
+
+		ndm_xml_node_set_name(ndm_xml_node_nth_child(n, 1), "renamed");
+
+		NDM_TEST(ndm_xml_node_first_child(n, "renamed") ==
+			ndm_xml_node_nth_child(n, 1));
+		NDM_TEST(ndm_xml_node_first_child(n, "c0") ==
+			ndm_xml_node_nth_child(n, 40));
+
+		/* prepends past a capacity grow an index */
+		for (size_t i = 0; i < 40; i++) {
+			NDM_TEST_BREAK_IF((c = ndm_xml_document_alloc_node(&copy,
+				NDM_XML_NODE_TYPE_ELEMENT, "p", NULL)) == NULL);
+			ndm_xml_node_prepend_child(n, c);
+		}
+
+		NDM_TEST(ndm_xml_node_child_count(n) == 140);
+		NDM_TEST(ndm_xml_node_first_child(n, "p") ==
+			ndm_xml_node_nth_child(n, 0));
+		NDM_TEST(ndm_xml_node_first_child(n, "renamed") ==
+			ndm_xml_node_nth_child(n, 41));
+
+		while (ndm_xml_node_first_child(n, "p") != NULL) {
+			ndm_xml_node_remove_first_child(n);
+		}
+
+		ndm_xml_node_remove_all_children(n, ndm_xml_node_nth_child(n, 50));
+
+		NDM_TEST(ndm_xml_node_child_count(n) == 50);
+		NDM_TEST(ndm_xml_node_last_child(n, NULL) ==
+			ndm_xml_node_nth_child(n, 49));
+		NDM_TEST(ndm_xml_node_next_sibling(
+			ndm_xml_node_nth_child(n, 49), NULL) == NULL);
+		NDM_TEST(ndm_xml_node_first_child(n, "c15") ==
+			ndm_xml_node_nth_child(n, 15));
+
+		NDM_TEST(ndm_xml_document_intern_names(&copy));
+		NDM_TEST(ndm_xml_node_first_child_atom(n,
+			ndm_xml_document_atom(&copy, "c39")) ==
+				ndm_xml_node_nth_child(n, 39));
+
+		ndm_xml_document_clear(&copy);
+	} while (0);
+
+	do {
+		/* vectorized skips give the same values as a plain scan
+		 * for random text at any block alignment */
+		static const char *const pieces[] =
+		{
+			"a", "bc", " ", "\n", "\r", "\t", "&amp;", "\"", "d e"
+		};
+		static const enum ndm_xml_document_parse_flags_t flags[] =
+		{
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT |
+			NDM_XML_DOCUMENT_PARSE_FLAGS_NORMALIZE_WHITESPACE,
+			NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT |
+			NDM_XML_DOCUMENT_PARSE_FLAGS_NO_ENTITY_TRANSLATION
+		};
+		char raw[SKIP_TEST_MAX_PIECES * 8];
+		char expected[sizeof(raw)];
+		char text[4 * sizeof(raw)];
+		unsigned int seed = 1;
+		size_t mismatches = 0;
+
+		for (size_t i = 0; i < SKIP_TEST_ROUNDS; i++) {
+			const enum ndm_xml_document_parse_flags_t f =
+				flags[i % NDM_ARRAY_SIZE(flags)];
+			const bool expand =
+				!(f & NDM_XML_DOCUMENT_PARSE_FLAGS_NO_ENTITY_TRANSLATION);
+			const size_t count = (seed = seed * 1103515245 + 12345) %
+				SKIP_TEST_MAX_PIECES;
+			const size_t pad = (seed = seed * 1103515245 + 12345) % 40;
+			const char *attr;
+
+			*raw = '\0';
+
+			for (size_t j = 0; j < count; j++) {
+				seed = seed * 1103515245 + 12345;
+				strcat(raw, pieces[(seed >> 16) % NDM_ARRAY_SIZE(pieces)]);
+			}
+
+			/* a whitespace run of @c pad characters precedes
+			 * an attribute, so values start at any alignment */
+			snprintf(text, sizeof(text), "<r%*s v='%s'>%s</r>",
+				(int) pad + 1, "", raw, raw);
+
+			if (ndm_xml_document_parse(&copy, text, f) !=
+					NDM_XML_DOCUMENT_PARSE_ERROR_OK ||
+				(n = ndm_xml_node_first_child(
+					ndm_xml_document_root(&copy), "r")) == NULL ||
+				(attr = ndm_xml_attr_value(
+					ndm_xml_node_first_attr(n, "v"))) == NULL)
+			{
+				++mismatches;
+				continue;
+			}
+
+			test_skip_expected(raw, expand, false, expected);
+
+			if (strcmp(attr, expected) != 0) {
+				++mismatches;
+			}
+
+			test_skip_expected(raw, expand,
+				(f & NDM_XML_DOCUMENT_PARSE_FLAGS_NORMALIZE_WHITESPACE) != 0,
+				expected);
+
+			if (strcmp(ndm_xml_node_value(n), expected) != 0) {
+				++mismatches;
+			}
+		}
+
+		NDM_TEST(mismatches == 0);
+
+		ndm_xml_document_clear(&copy);
+	} while (0);
+
 	fp = fopen("test.xml", "r");
 
 	if (fp == NULL) {
@@ -300,14 +909,51 @@ int main()
 			NDM_TEST(fread(text, (size_t) fsize, 1, fp) == 1);
 
 			text[fsize] = '\0';
+
+			/* a streamed document is fed by 7-byte chunks
+			 * split in the middle of tags and entities */
+			ndm_xml_document_parser_init(&parser, &copy,
+				NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT);
+
+			for (long i = 0; i < fsize; i += 7) {
+				NDM_TEST(ndm_xml_document_parser_feed(&parser, text + i,
+					(size_t) ((fsize - i < 7) ? fsize - i : 7)) ==
+						NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+			}
+
+			NDM_TEST(ndm_xml_document_parser_finish(&parser) ==
+				NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+
 			NDM_TEST(ndm_xml_document_parse(&d, text,
 				NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) ==
 					NDM_XML_DOCUMENT_PARSE_ERROR_OK);
 
+			NDM_TEST(ndm_xml_document_is_equal(&copy, &d));
+
+			ndm_xml_document_clear(&copy);
+
+			/* a compact output is parsed back to the same document */
+			s = ndm_xml_document_print(&d, NDM_XML_PRINT_FLAGS_COMPACT, NULL);
+
+			NDM_TEST_BREAK_IF(s == NULL);
+			NDM_TEST(ndm_xml_document_parse(&copy, s,
+				NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) ==
+					NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+			NDM_TEST(ndm_xml_document_is_equal(&copy, &d));
+
+			ndm_xml_document_clear(&copy);
+			free(s);
+
 			NDM_TEST(ndm_xml_document_copy(&copy, &d));
 			NDM_TEST(ndm_xml_document_is_equal(&copy, &d));
 
 			ndm_xml_document_clear(&copy);
+
+			NDM_TEST(ndm_xml_document_compact(&copy, &d));
+			NDM_TEST(ndm_xml_document_is_compact(&copy));
+			NDM_TEST(ndm_xml_document_is_equal(&copy, &d));
+
+			ndm_xml_document_clear(&copy);
 		}
 
 		free(text);
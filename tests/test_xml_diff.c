@@ -0,0 +1,278 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ndm/xml.h>
+#include <ndm/xml_diff.h>
+#include "test.h"
+
+#define DYNAMIC_BUFFER_SIZE			4096
+
+#define DATA_NODES					NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT
+#define NO_DATA_NODES				\
+	(NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT |	\
+	 NDM_XML_DOCUMENT_PARSE_FLAGS_NO_DATA_NODES)
+
+struct test_diff_t
+{
+	char out[512];
+	size_t size;
+	size_t limit;
+};
+
+static const char *test_label(
+		const struct ndm_xml_node_t *node)
+{
+	static char label[64];
+	const struct ndm_xml_attr_t *id = NULL;
+
+	/* a data node is labeled as "parent/text()" */
+	if (ndm_xml_node_type(node) == NDM_XML_NODE_TYPE_DATA) {
+		snprintf(label, sizeof(label), "%s/text()",
+			test_label(ndm_xml_node_parent(node)));
+
+		return label;
+	}
+
+	id = ndm_xml_node_first_attr(node, "id");
+
+	return (id != NULL) ? ndm_xml_attr_value(id) : ndm_xml_node_name(node);
+}
+
+/* differences are joined by commas: "+node", "-node", "~node:old>new",
+ * "+node@attr=value", "-node@attr" and "~node@attr:old>new" */
+static bool test_diff_cb(
+		void *user_data,
+		const struct ndm_xml_diff_t *diff)
+{
+	struct test_diff_t *t = user_data;
+	char item[128];
+
+	switch (diff->type) {
+		case NDM_XML_DIFF_TYPE_NODE_ADDED:
+			snprintf(item, sizeof(item), "+%s", test_label(diff->new_node));
+			break;
+
+		case NDM_XML_DIFF_TYPE_NODE_REMOVED:
+			snprintf(item, sizeof(item), "-%s", test_label(diff->old_node));
+			break;
+
+		case NDM_XML_DIFF_TYPE_NODE_CHANGED:
+			snprintf(item, sizeof(item), "~%s:%s>%s",
+				test_label(diff->new_node),
+				ndm_xml_node_value(diff->old_node),
+				ndm_xml_node_value(diff->new_node));
+			break;
+
+		case NDM_XML_DIFF_TYPE_ATTR_ADDED:
+			snprintf(item, sizeof(item), "+%s@%s=%s",
+				test_label(diff->new_node),
+				ndm_xml_attr_name(diff->new_attr),
+				ndm_xml_attr_value(diff->new_attr));
+			break;
+
+		case NDM_XML_DIFF_TYPE_ATTR_REMOVED:
+			snprintf(item, sizeof(item), "-%s@%s",
+				test_label(diff->old_node),
+				ndm_xml_attr_name(diff->old_attr));
+			break;
+
+		case NDM_XML_DIFF_TYPE_ATTR_CHANGED:
+			snprintf(item, sizeof(item), "~%s@%s:%s>%s",
+				test_label(diff->new_node),
+				ndm_xml_attr_name(diff->old_attr),
+				ndm_xml_attr_value(diff->old_attr),
+				ndm_xml_attr_value(diff->new_attr));
+			break;
+	}
+
+	t->size += (size_t) snprintf(t->out + t->size, sizeof(t->out) - t->size,
+		"%s%s", (t->size == 0) ? "" : ",", item);
+
+	return t->limit == 0 || --t->limit > 0;
+}
+
+static const char *test_diff(
+		const char *const old_text,
+		const char *const new_text,
+		const bool compact,
+		const enum ndm_xml_document_parse_flags_t flags)
+{
+	static struct test_diff_t t;
+	struct ndm_xml_document_t o = NDM_XML_DOCUMENT_INITIALIZER(
+		NULL, 0, DYNAMIC_BUFFER_SIZE);
+	struct ndm_xml_document_t n = NDM_XML_DOCUMENT_INITIALIZER(
+		NULL, 0, DYNAMIC_BUFFER_SIZE);
+	struct ndm_xml_document_t c = NDM_XML_DOCUMENT_INITIALIZER(
+		NULL, 0, DYNAMIC_BUFFER_SIZE);
+	char *old_copy = strdup(old_text);
+	char *new_copy = strdup(new_text);
+
+	memset(&t, 0, sizeof(t));
+
+	if (old_copy == NULL || new_copy == NULL ||
+		ndm_xml_document_parse(&o, old_copy, flags) !=
+			NDM_XML_DOCUMENT_PARSE_ERROR_OK ||
+		ndm_xml_document_parse(&n, new_copy, flags) !=
+			NDM_XML_DOCUMENT_PARSE_ERROR_OK)
+	{
+		snprintf(t.out, sizeof(t.out), "(invalid)");
+	} else
+	if (compact && !ndm_xml_document_compact(&c, &n)) {
+		snprintf(t.out, sizeof(t.out), "(compact)");
+	} else
+	if (!ndm_xml_document_diff(&o, compact ? &c : &n, test_diff_cb, &t)) {
+		snprintf(t.out, sizeof(t.out), "(failed)");
+	}
+
+	ndm_xml_document_clear(&c);
+	ndm_xml_document_clear(&n);
+	ndm_xml_document_clear(&o);
+	free(new_copy);
+	free(old_copy);
+
+	return t.out;
+}
+
+int main()
+{
+	struct ndm_xml_document_t d = NDM_XML_DOCUMENT_INITIALIZER(
+		NULL, 0, DYNAMIC_BUFFER_SIZE);
+	struct ndm_xml_document_t e = NDM_XML_DOCUMENT_INITIALIZER(
+		NULL, 0, DYNAMIC_BUFFER_SIZE);
+	struct ndm_xml_node_t *config = NULL;
+	struct test_diff_t t;
+	const char *text_config =
+		"<config>"
+			"<interface name='Gi0/0' id='i0'><mtu>1500</mtu></interface>"
+			"<interface name='Gi0/1' id='i1'><mtu>1500</mtu></interface>"
+			"<interface name='Gi0/2' id='i2'><mtu>1500</mtu></interface>"
+			"<hostname>router</hostname>"
+		"</config>";
+	char text[] = "<config><a/><b/></config>";
+
+	/* identical documents */
+	NDM_TEST(strcmp(test_diff(text_config, text_config,
+		false, DATA_NODES), "") == 0);
+	NDM_TEST(strcmp(test_diff(text_config, text_config,
+		true, DATA_NODES), "") == 0);
+
+	/* values and attributes */
+	NDM_TEST(strcmp(test_diff(text_config,
+		"<config>"
+			"<interface name='Gi0/0' id='i0'><mtu>1500</mtu></interface>"
+			"<interface name='Gi0/1' id='i1' up='1'><mtu>9000</mtu></interface>"
+			"<interface name='Gi0/2' id='i2'><mtu>1500</mtu></interface>"
+			"<hostname>gateway</hostname>"
+		"</config>", false, DATA_NODES),
+		"+i1@up=1,~mtu/text():1500>9000,"
+		"~hostname/text():router>gateway") == 0);
+	NDM_TEST(strcmp(test_diff(
+		"<a id='1' x='1' y='2' y='3'/>",
+		"<a id='1' y='2' y='4' z='5'/>", false, DATA_NODES),
+		"-1@x,~1@y:3>4,+1@z=5") == 0);
+
+	/* a text change is reported once, by a data node if there is one */
+	NDM_TEST(strcmp(test_diff(
+		"<c><mtu>1500</mtu></c>", "<c><mtu>9000</mtu></c>",
+		false, DATA_NODES), "~mtu/text():1500>9000") == 0);
+	NDM_TEST(strcmp(test_diff(
+		"<c><mtu>1500</mtu></c>", "<c><mtu>9000</mtu></c>",
+		true, DATA_NODES), "~mtu/text():1500>9000") == 0);
+	NDM_TEST(strcmp(test_diff(
+		"<c><mtu>1500</mtu></c>", "<c><mtu>9000</mtu></c>",
+		false, NO_DATA_NODES), "~mtu:1500>9000") == 0);
+	NDM_TEST(strcmp(test_diff(
+		"<c><mtu>1500</mtu></c>", "<c><mtu/></c>",
+		false, DATA_NODES), "-mtu/text()") == 0);
+	NDM_TEST(strcmp(test_diff(
+		"<c><mtu/></c>", "<c><mtu>9000</mtu></c>",
+		false, DATA_NODES), "+mtu/text()") == 0);
+
+	/* inserted, removed and replaced nodes */
+	NDM_TEST(strcmp(test_diff(text_config,
+		"<config>"
+			"<interface name='Gi0/0' id='i0'><mtu>1500</mtu></interface>"
+			"<interface name='Gi0/9' id='i9'><mtu>1500</mtu></interface>"
+			"<interface name='Gi0/2' id='i2'><mtu>1500</mtu></interface>"
+			"<hostname>router</hostname>"
+			"<domain>local</domain>"
+		"</config>", false, DATA_NODES),
+		"-i1,+i9,+domain") == 0);
+	NDM_TEST(strcmp(test_diff("<a><b/><c/></a>", "<a><c/><d/></a>",
+		false, DATA_NODES), "-b,+d") == 0);
+	NDM_TEST(strcmp(test_diff("<a/>", "<b/>",
+		false, DATA_NODES), "-a,+b") == 0);
+
+	/* list items are matched by their keys wherever they are */
+	NDM_TEST(strcmp(test_diff(text_config,
+		"<config>"
+			"<hostname>router</hostname>"
+			"<interface name='Gi0/2' id='i2'><mtu>1500</mtu></interface>"
+			"<interface name='Gi0/1' id='i1'><mtu>1400</mtu></interface>"
+			"<interface name='Gi0/0' id='i0'><mtu>1500</mtu></interface>"
+		"</config>", false, DATA_NODES), "~mtu/text():1500>1400") == 0);
+
+	/* a first attribute is a key of a list item */
+	NDM_TEST(strcmp(test_diff(text_config,
+		"<config>"
+			"<interface name='Gi0/0' id='i0'><mtu>1500</mtu></interface>"
+			"<interface name='Gi0/7' id='i7'><mtu>1500</mtu></interface>"
+			"<interface name='Gi0/2' id='i2' up='1'><mtu>1500</mtu></interface>"
+			"<hostname>router</hostname>"
+		"</config>", true, DATA_NODES), "-i1,+i7,+i2@up=1") == 0);
+	NDM_TEST(strcmp(test_diff(
+		"<a><b>1</b><c/></a>", "<a><c/><b x='1'>2</b></a>",
+		false, DATA_NODES), "+b@x=1,~b/text():1>2") == 0);
+	NDM_TEST(strcmp(test_diff(
+		"<a><b>1</b><c/></a>", "<a><c/><b x='1'>2</b></a>",
+		false, NO_DATA_NODES), "~b:1>2,+b@x=1") == 0);
+
+	/* duplicate siblings */
+	NDM_TEST(strcmp(test_diff(
+		"<a><b>1</b><b>1</b><b>2</b></a>",
+		"<a><b>1</b><b>2</b><b>2</b></a>", false, DATA_NODES),
+		"~b/text():1>2") == 0);
+
+	/* an empty document */
+	NDM_TEST(ndm_xml_document_parse(&d, text,
+		NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) ==
+			NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+
+	memset(&t, 0, sizeof(t));
+	NDM_TEST(ndm_xml_document_diff(&e, &d, test_diff_cb, &t));
+	NDM_TEST(strcmp(t.out, "+config") == 0);
+
+	memset(&t, 0, sizeof(t));
+	NDM_TEST(ndm_xml_document_diff(&d, &e, test_diff_cb, &t));
+	NDM_TEST(strcmp(t.out, "-config") == 0);
+
+	memset(&t, 0, sizeof(t));
+	NDM_TEST(ndm_xml_document_diff(&e, &e, test_diff_cb, &t));
+	NDM_TEST(strcmp(t.out, "") == 0);
+
+	/* subtrees and a callback which stops a diff */
+	config = ndm_xml_node_first_child(ndm_xml_document_root(&d), "config");
+
+	memset(&t, 0, sizeof(t));
+	NDM_TEST(ndm_xml_node_diff(
+		ndm_xml_node_first_child(config, "a"),
+		ndm_xml_node_first_child(config, "b"), test_diff_cb, &t));
+	NDM_TEST(strcmp(t.out, "-a,+b") == 0);
+
+	memset(&t, 0, sizeof(t));
+	t.limit = 1;
+	NDM_TEST(!ndm_xml_node_diff(
+		ndm_xml_node_first_child(config, "a"),
+		ndm_xml_node_first_child(config, "b"), test_diff_cb, &t));
+	NDM_TEST(errno == ECANCELED);
+	NDM_TEST(strcmp(t.out, "-a") == 0);
+
+	NDM_TEST(!ndm_xml_node_diff(NULL, ndm_xml_document_root(&d),
+		test_diff_cb, &t));
+	NDM_TEST(errno == EINVAL);
+
+	ndm_xml_document_clear(&d);
+
+	return NDM_TEST_RESULT;
+}
@@ -0,0 +1,213 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ndm/xml.h>
+#include <ndm/xml_query.h>
+#include "test.h"
+
+#define STATIC_BUFFER_SIZE			4096
+#define DYNAMIC_BUFFER_SIZE			4096
+
+/* results are joined by commas: attribute values,
+ * element "id" attributes, values or names */
+static const char *test_query(
+		const struct ndm_xml_node_t *context,
+		const char *const expr)
+{
+	static char out[256];
+	struct ndm_xml_query_t *query = ndm_xml_query_alloc(expr);
+	struct ndm_xml_query_iter_t iter;
+	size_t size = 0;
+
+	out[0] = '\0';
+
+	if (query == NULL) {
+		return "(invalid)";
+	}
+
+	ndm_xml_query_iter_init(&iter, query, context);
+
+	while (ndm_xml_query_iter_next(&iter)) {
+		const struct ndm_xml_node_t *node = ndm_xml_query_iter_node(&iter);
+		const struct ndm_xml_attr_t *id = ndm_xml_node_first_attr(node, "id");
+		const char *item = ndm_xml_node_value(node);
+
+		if (ndm_xml_query_iter_attr(&iter) != NULL) {
+			item = ndm_xml_attr_value(ndm_xml_query_iter_attr(&iter));
+		} else
+		if (id != NULL) {
+			item = ndm_xml_attr_value(id);
+		} else
+		if (*item == '\0') {
+			item = ndm_xml_node_name(node);
+		}
+
+		size += (size_t) snprintf(out + size, sizeof(out) - size,
+			"%s%s", (size == 0) ? "" : ",", item);
+	}
+
+	/* a finished iterator stays finished */
+	if (ndm_xml_query_iter_next(&iter)) {
+		snprintf(out, sizeof(out), "(restarted)");
+	}
+
+	ndm_xml_query_free(&query);
+
+	return out;
+}
+
+int main()
+{
+	char buffer[STATIC_BUFFER_SIZE];
+	struct ndm_xml_document_t d = NDM_XML_DOCUMENT_INITIALIZER(
+		buffer, sizeof(buffer), DYNAMIC_BUFFER_SIZE);
+	struct ndm_xml_document_t c = NDM_XML_DOCUMENT_INITIALIZER(
+		NULL, 0, DYNAMIC_BUFFER_SIZE);
+	struct ndm_xml_document_t n = NDM_XML_DOCUMENT_INITIALIZER(
+		NULL, 0, DYNAMIC_BUFFER_SIZE);
+	struct ndm_xml_query_t *query = NULL;
+	struct ndm_xml_node_t *root = NULL;
+	struct ndm_xml_node_t *config = NULL;
+	char text[] =
+		"<config>"
+			"<interface name='Gi0/0' id='i0'>"
+				"<ip><address>10.0.0.1</address></ip><mtu>1500</mtu>"
+			"</interface>"
+			"<interface name='Gi0/1' id='i1'>"
+				"<ip>"
+					"<address>10.0.1.1</address>"
+					"<address>10.0.1.2</address>"
+				"</ip>"
+				"<mtu>9000</mtu>"
+			"</interface>"
+			"<interface name='Gi0/2' id='i2'><mtu>x</mtu></interface>"
+			"<routes>"
+				"<route id='r1'><metric>5</metric></route>"
+				"<route id='r2'><metric>20</metric></route>"
+				"<route id='r3'>"
+					"<metric>11</metric>"
+					"<route id='r4'><metric>100</metric></route>"
+				"</route>"
+			"</routes>"
+		"</config>";
+	char nested[] =
+		"<r>"
+			"<a id='a1'>"
+				"<x><a id='a2'><x><b id='b1'/></x></a></x>"
+				"<y><a id='a3'><x><b id='b2'/></x></a></y>"
+			"</a>"
+		"</r>";
+
+	NDM_TEST_BREAK_IF(ndm_xml_document_parse(&d, text,
+		NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) !=
+			NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+
+	root = ndm_xml_document_root(&d);
+	config = ndm_xml_node_first_child(root, "config");
+
+	NDM_TEST_BREAK_IF(config == NULL);
+
+	/* child, attribute and equality steps */
+	NDM_TEST(strcmp(test_query(config,
+		"interface[@name='Gi0/1']/ip/address"),
+		"10.0.1.1,10.0.1.2") == 0);
+	NDM_TEST(strcmp(test_query(config,
+		"interface[@name != \"Gi0/0\"]/mtu"), "9000,x") == 0);
+	NDM_TEST(strcmp(test_query(config, "interface[ip]"), "i0,i1") == 0);
+	NDM_TEST(strcmp(test_query(config, "*/ip"), "ip,ip") == 0);
+	NDM_TEST(strcmp(test_query(config, "interface/@name"),
+		"Gi0/0,Gi0/1,Gi0/2") == 0);
+	NDM_TEST(strcmp(test_query(config, "interface[@name='Gi0/9']"), "") == 0);
+	NDM_TEST(strcmp(test_query(config, "."), "config") == 0);
+	NDM_TEST(strcmp(test_query(config, "interface/.."),
+		"config,config,config") == 0);
+
+	/* absolute and descendant steps */
+	NDM_TEST(strcmp(test_query(root, "/config/interface[2]"), "i1") == 0);
+	NDM_TEST(strcmp(test_query(config, "/config/routes/route/@id"),
+		"r1,r2,r3") == 0);
+	NDM_TEST(strcmp(test_query(config, "//route[metric>10]"),
+		"r2,r3,r4") == 0);
+	NDM_TEST(strcmp(test_query(config, "//route[metric<=5]"), "r1") == 0);
+	NDM_TEST(strcmp(test_query(config, "//metric[.>10]/.."),
+		"r2,r3,r4") == 0);
+	NDM_TEST(strcmp(test_query(config, "//@id"),
+		"i0,i1,i2,r1,r2,r3,r4") == 0);
+
+	/* nested descendant steps do not repeat nodes */
+	NDM_TEST(strcmp(test_query(config, "//route//metric"),
+		"5,20,11,100") == 0);
+	NDM_TEST(strcmp(test_query(root, "//config//routes//route"),
+		"r1,r2,r3,r4") == 0);
+
+	/* positions are counted after preceding predicates only */
+	NDM_TEST(strcmp(test_query(config, "interface[mtu>=1500][2]"), "i1") == 0);
+	NDM_TEST(strcmp(test_query(config, "interface[2][mtu>=1500]"), "i1") == 0);
+	NDM_TEST(strcmp(test_query(config, "interface[3][mtu>=1500]"), "") == 0);
+	NDM_TEST(strcmp(test_query(config, "interface[4]"), "") == 0);
+	NDM_TEST(strcmp(test_query(config, "//route[1]"), "r1,r4") == 0);
+	NDM_TEST(strcmp(test_query(config, "//route[@id!='r1'][1]"),
+		"r2,r4") == 0);
+
+	/* invalid expressions */
+	NDM_TEST(strcmp(test_query(config, ""), "(invalid)") == 0);
+	NDM_TEST(strcmp(test_query(config, "a["), "(invalid)") == 0);
+	NDM_TEST(strcmp(test_query(config, "a[@]"), "(invalid)") == 0);
+	NDM_TEST(strcmp(test_query(config, "a[b>'1']"), "(invalid)") == 0);
+	NDM_TEST(strcmp(test_query(config, "a[b=c]"), "(invalid)") == 0);
+	NDM_TEST(strcmp(test_query(config, "a[0]"), "(invalid)") == 0);
+	NDM_TEST(strcmp(test_query(config, "a[1][2]"), "(invalid)") == 0);
+	NDM_TEST(strcmp(test_query(config, "@a/b"), "(invalid)") == 0);
+	NDM_TEST(strcmp(test_query(config, "@a[1]"), "(invalid)") == 0);
+	NDM_TEST(strcmp(test_query(config, "a//.."), "(invalid)") == 0);
+	NDM_TEST(strcmp(test_query(config, "a/"), "(invalid)") == 0);
+
+	NDM_TEST(ndm_xml_query_alloc("a/b/c/d/e/f/g/h/i/j/k/l/m/n/o/p/q") == NULL);
+	NDM_TEST(errno == E2BIG);
+	NDM_TEST(ndm_xml_query_alloc("a]") == NULL);
+	NDM_TEST(errno == EINVAL);
+
+	query = ndm_xml_query_alloc("/config/routes/route[metric>10]/@id");
+
+	NDM_TEST_BREAK_IF(query == NULL);
+	NDM_TEST(strcmp(ndm_xml_query_expr(query),
+		"/config/routes/route[metric>10]/@id") == 0);
+	NDM_TEST(ndm_xml_query_selects_attr(query));
+	NDM_TEST(ndm_xml_query_first(query, config) ==
+		ndm_xml_node_nth_child(ndm_xml_node_first_child(config, "routes"), 1));
+
+	ndm_xml_query_free(&query);
+
+	NDM_TEST(query == NULL);
+
+	/* a compact document is queried the same way */
+	NDM_TEST_BREAK_IF(!ndm_xml_document_compact(&c, &d));
+
+	config = ndm_xml_node_first_child(ndm_xml_document_root(&c), "config");
+
+	NDM_TEST(strcmp(test_query(config, "//route[metric>10]"),
+		"r2,r3,r4") == 0);
+	NDM_TEST(strcmp(test_query(config,
+		"interface[@name='Gi0/1']/ip/address[2]"), "10.0.1.2") == 0);
+
+	/* nodes reached through nested bindings of an earlier
+	 * descendant step are selected once */
+	NDM_TEST_BREAK_IF(ndm_xml_document_parse(&n, nested,
+		NDM_XML_DOCUMENT_PARSE_FLAGS_DEFAULT) !=
+			NDM_XML_DOCUMENT_PARSE_ERROR_OK);
+
+	root = ndm_xml_document_root(&n);
+
+	NDM_TEST(strcmp(test_query(root, "//a/x//b"), "b1,b2") == 0);
+	NDM_TEST(strcmp(test_query(root, "//a/*//b"), "b1,b2") == 0);
+	NDM_TEST(strcmp(test_query(root, "//a//x//b"), "b1,b2") == 0);
+	NDM_TEST(strcmp(test_query(root, "//a//@id"), "a1,a2,b1,a3,b2") == 0);
+	NDM_TEST(strcmp(test_query(root, "//x/a/x//b"), "b1") == 0);
+
+	ndm_xml_document_clear(&n);
+	ndm_xml_document_clear(&c);
+	ndm_xml_document_clear(&d);
+
+	return NDM_TEST_RESULT;
+}